@@ -1,6 +1,7 @@
 #include "config.h"
 
 #include "broadway-buffer.h"
+#include "gdkpixelconvertprivate.h"
 
 #include <string.h>
 
@@ -36,6 +37,7 @@ struct entry {
 };
 
 struct _BroadwayBuffer {
+  int ref_count;
   guint8 *data;
   struct entry *table;
   int width, height, stride;
@@ -278,9 +280,19 @@ encode_block (struct encoder *encoder, struct entry *entry, int x, int y)
   emit (encoder, (x << 16) | y);
 }
 
+BroadwayBuffer *
+broadway_buffer_ref (BroadwayBuffer *buffer)
+{
+  g_atomic_int_inc (&buffer->ref_count);
+  return buffer;
+}
+
 void
-broadway_buffer_destroy (BroadwayBuffer *buffer)
+broadway_buffer_unref (BroadwayBuffer *buffer)
 {
+  if (!g_atomic_int_dec_and_test (&buffer->ref_count))
+    return;
+
   g_free (buffer->data);
   g_free (buffer->table);
   g_free (buffer);
@@ -298,35 +310,6 @@ broadway_buffer_get_height (BroadwayBuffer *buffer)
   return buffer->height;
 }
 
-static void
-unpremultiply_line (void *destp, void *srcp, int width)
-{
-  guint32 *src = srcp;
-  guint32 *dest = destp;
-  guint32 *end = src + width;
-  while (src < end)
-    {
-      guint32 pixel;
-      guint8 alpha, r, g, b;
-
-      pixel = *src++;
-
-      alpha = (pixel & 0xff000000) >> 24;
-
-      if (alpha == 0xff)
-        *dest++ = pixel;
-      else if (alpha == 0)
-        *dest++ = 0;
-      else
-        {
-          r = (((pixel & 0xff0000) >> 16) * 255 + alpha / 2) / alpha;
-          g = (((pixel & 0x00ff00) >>  8) * 255 + alpha / 2) / alpha;
-          b = (((pixel & 0x0000ff) >>  0) * 255 + alpha / 2) / alpha;
-          *dest++ = (guint32)alpha << 24 | (guint32)r << 16 | (guint32)g << 8 | (guint32)b;
-        }
-    }
-}
-
 BroadwayBuffer *
 broadway_buffer_create (int width, int height, guint8 *data, int stride)
 {
@@ -334,6 +317,7 @@ broadway_buffer_create (int width, int height, guint8 *data, int stride)
   int y, bits_required;
 
   buffer = g_new0 (BroadwayBuffer, 1);
+  buffer->ref_count = 1;
   buffer->width = width;
   buffer->stride = width * 4;
   buffer->height = height;
@@ -353,7 +337,8 @@ broadway_buffer_create (int width, int height, guint8 *data, int stride)
   buffer->data = g_malloc (buffer->stride * height);
 
   for (y = 0; y < height; y++)
-    unpremultiply_line (buffer->data + y * buffer->stride, data + y * stride, width);
+    gdk_pixel_unpremultiply ((guint32 *)(buffer->data + y * buffer->stride),
+                             (guint32 *)(data + y * stride), width);
 
   return buffer;
 }
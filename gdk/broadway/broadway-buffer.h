@@ -10,7 +10,8 @@ BroadwayBuffer *broadway_buffer_create     (int             width,
                                             int             height,
                                             guint8         *data,
                                             int             stride);
-void            broadway_buffer_destroy    (BroadwayBuffer *buffer);
+BroadwayBuffer *broadway_buffer_ref        (BroadwayBuffer *buffer);
+void            broadway_buffer_unref      (BroadwayBuffer *buffer);
 void            broadway_buffer_encode     (BroadwayBuffer *buffer,
                                             BroadwayBuffer *prev,
                                             GString        *dest);
@@ -11,25 +11,105 @@
  *                Basic I/O primitives                                  *
  ************************************************************************/
 
-struct BroadwayOutput {
+/* Buffers are encoded and compressed once, on a separate thread, and the
+ * result is sent to every viewer. Everything written to the output is
+ * kept as a list of chunks in stream order, and a chunk is only sent once
+ * all chunks in front of it are ready, so viewers see commands in the
+ * order they were written.
+ *
+ * A viewer that joins later gets a private chunk with its own copy of
+ * the window state and keyframes. The compressor is reset around it, so
+ * neither the new viewer nor the existing ones ever need deflate history
+ * they did not receive.
+ */
+#define MAX_QUEUED_BUFFERS 8
+
+/* A viewer that can't keep up with this much unsent data is dropped */
+#define MAX_VIEWER_BACKLOG (64 * 1024 * 1024)
+
+typedef enum {
+  CHUNK_COMMANDS,
+  CHUNK_BUFFER,
+  CHUNK_JOIN
+} BroadwayChunkKind;
+
+typedef enum {
+  CHUNK_QUEUED,
+  CHUNK_ENCODING,
+  CHUNK_DONE,
+  CHUNK_SUPERSEDED
+} BroadwayChunkState;
+
+typedef struct {
+  GString *header;
+  BroadwayBuffer *buffer;
+} BroadwayKeyframe;
+
+typedef struct {
+  BroadwayChunkKind kind;
+  BroadwayChunkState state;
+  GString *data;
+
+  /* CHUNK_BUFFER */
+  int id;
+  BroadwayBuffer *prev_buffer;
+  BroadwayBuffer *buffer;
+
+  /* CHUNK_JOIN */
+  BroadwayViewer *viewer;
+  GList *keyframes;
+} BroadwayChunk;
+
+struct BroadwayViewer {
   GOutputStream *out;
+  GQueue backlog;
+  gsize backlog_offset;
+  gsize backlog_size;
+  GSource *source;
+  gboolean joined;
+  gboolean error;
+};
+
+struct BroadwayOutput {
   GString *buf;
-  int error;
   guint32 serial;
+  GList *viewers;
+  BroadwayChunk *joining;
+
+  GMutex mutex;
+  GCond cond;
+  GThread *thread;
+  GMainContext *context;
+  GSource *flush_source;
+  GQueue chunks;
+  int n_queued;
+  gboolean quit;
+
+  /* Only touched by the encoder thread */
+  GConverter *compressor;
+  GString *encoded;
+
+  gboolean print_stats;
+  guint64 stats_frames;
+  guint64 stats_dropped;
+  guint64 stats_raw_bytes;
+  guint64 stats_bytes;
+  gint64 stats_time;
 };
 
-static void
-broadway_output_send_cmd (BroadwayOutput *output,
-			  gboolean fin, BroadwayWSOpCode code,
-			  const void *buf, gsize count)
+static GBytes *
+make_frame (gboolean fin, BroadwayWSOpCode code,
+            const void *buf, gsize count)
 {
   gboolean mask = FALSE;
-  guchar header[16];
+  guchar *header;
   size_t p;
 
   gboolean mid_header = count > 125 && count <= 65535;
   gboolean long_header = count > 65535;
 
+  header = g_malloc (10 + count);
+
   /* NB. big-endian spec => bit 0 == MSB */
   header[0] = ( (fin ? 0x80 : 0) | (code & 0x0f) );
   header[1] = ( (mask ? 0x80 : 0) |
@@ -37,58 +117,662 @@ broadway_output_send_cmd (BroadwayOutput *output,
   p = 2;
   if (mid_header)
     {
-      *(guint16 *)(header + p) = GUINT16_TO_BE( (guint16)count );
+      guint16 v = GUINT16_TO_BE( (guint16)count );
+      memcpy (header + p, &v, 2);
       p += 2;
     }
   else if (long_header)
     {
-      *(guint64 *)(header + p) = GUINT64_TO_BE( count );
+      guint64 v = GUINT64_TO_BE( count );
+      memcpy (header + p, &v, 8);
       p += 8;
     }
   // FIXME: if we are paranoid we should 'mask' the data
-  // FIXME: we should really emit these as a single write
-  g_output_stream_write_all (output->out, header, p, NULL, NULL, NULL);
-  g_output_stream_write_all (output->out, buf, count, NULL, NULL, NULL);
+  if (count > 0)
+    memcpy (header + p, buf, count);
+
+  return g_bytes_new_take (header, p + count);
+}
+
+static void
+viewer_clear_backlog (BroadwayViewer *viewer)
+{
+  GBytes *bytes;
+
+  while ((bytes = g_queue_pop_head (&viewer->backlog)) != NULL)
+    g_bytes_unref (bytes);
+  viewer->backlog_offset = 0;
+  viewer->backlog_size = 0;
+}
+
+static gboolean viewer_writable_cb (GObject *stream, gpointer data);
+
+/* Writes as much of the backlog as the socket takes without blocking,
+ * so that one slow viewer doesn't hold up the others.
+ */
+static void
+viewer_drain (BroadwayViewer *viewer)
+{
+  GBytes *bytes;
+  const guint8 *data;
+  gsize size;
+  gssize res;
+  GError *error = NULL;
+
+  while ((bytes = g_queue_peek_head (&viewer->backlog)) != NULL)
+    {
+      data = g_bytes_get_data (bytes, &size);
+
+      if (!G_IS_POLLABLE_OUTPUT_STREAM (viewer->out) ||
+          !g_pollable_output_stream_can_poll (G_POLLABLE_OUTPUT_STREAM (viewer->out)))
+        {
+          if (!g_output_stream_write_all (viewer->out,
+                                          data + viewer->backlog_offset,
+                                          size - viewer->backlog_offset,
+                                          NULL, NULL, NULL))
+            {
+              viewer->error = TRUE;
+              viewer_clear_backlog (viewer);
+              return;
+            }
+          res = size - viewer->backlog_offset;
+        }
+      else
+        {
+          res = g_pollable_output_stream_write_nonblocking (G_POLLABLE_OUTPUT_STREAM (viewer->out),
+                                                            data + viewer->backlog_offset,
+                                                            size - viewer->backlog_offset,
+                                                            NULL, &error);
+          if (res < 0)
+            {
+              if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+                {
+                  if (viewer->source == NULL)
+                    {
+                      viewer->source = g_pollable_output_stream_create_source (G_POLLABLE_OUTPUT_STREAM (viewer->out), NULL);
+                      g_source_set_callback (viewer->source, (GSourceFunc)viewer_writable_cb, viewer, NULL);
+                      g_source_attach (viewer->source, NULL);
+                    }
+                }
+              else
+                {
+                  viewer->error = TRUE;
+                  viewer_clear_backlog (viewer);
+                }
+              g_error_free (error);
+              return;
+            }
+        }
+
+      viewer->backlog_offset += res;
+      viewer->backlog_size -= res;
+      if (viewer->backlog_offset == size)
+        {
+          g_bytes_unref (g_queue_pop_head (&viewer->backlog));
+          viewer->backlog_offset = 0;
+        }
+    }
+}
+
+static gboolean
+viewer_writable_cb (GObject  *stream,
+                    gpointer  data)
+{
+  BroadwayViewer *viewer = data;
+
+  viewer_drain (viewer);
+
+  if (viewer->error || g_queue_is_empty (&viewer->backlog))
+    {
+      g_source_unref (viewer->source);
+      viewer->source = NULL;
+      return G_SOURCE_REMOVE;
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+viewer_write (BroadwayViewer *viewer,
+              GBytes         *bytes)
+{
+  if (viewer->error)
+    return;
+
+  g_queue_push_tail (&viewer->backlog, g_bytes_ref (bytes));
+  viewer->backlog_size += g_bytes_get_size (bytes);
+
+  if (viewer->backlog_size > MAX_VIEWER_BACKLOG)
+    {
+      viewer->error = TRUE;
+      viewer_clear_backlog (viewer);
+      return;
+    }
+
+  if (viewer->source == NULL)
+    viewer_drain (viewer);
+}
+
+void
+broadway_output_pong (BroadwayOutput *output,
+                      BroadwayViewer *viewer)
+{
+  GBytes *bytes;
+
+  bytes = make_frame (TRUE, BROADWAY_WS_CNX_PONG, NULL, 0);
+  viewer_write (viewer, bytes);
+  g_bytes_unref (bytes);
+}
+
+gboolean
+broadway_output_viewer_has_error (BroadwayOutput *output,
+                                  BroadwayViewer *viewer)
+{
+  return viewer->error;
+}
+
+static void
+keyframe_free (BroadwayKeyframe *keyframe)
+{
+  g_string_free (keyframe->header, TRUE);
+  broadway_buffer_unref (keyframe->buffer);
+  g_free (keyframe);
+}
+
+static void
+chunk_free (BroadwayChunk *chunk)
+{
+  if (chunk->prev_buffer)
+    broadway_buffer_unref (chunk->prev_buffer);
+  if (chunk->buffer)
+    broadway_buffer_unref (chunk->buffer);
+  g_list_free_full (chunk->keyframes, (GDestroyNotify)keyframe_free);
+  g_string_free (chunk->data, TRUE);
+  g_free (chunk);
+}
+
+static BroadwayChunk *
+chunk_new (BroadwayChunkKind  kind,
+           BroadwayChunkState state,
+           GString           *data)
+{
+  BroadwayChunk *chunk;
+
+  chunk = g_new0 (BroadwayChunk, 1);
+  chunk->kind = kind;
+  chunk->state = state;
+  chunk->data = data;
+
+  return chunk;
+}
+
+static void
+chunk_supersede (BroadwayOutput *output,
+                 BroadwayChunk  *chunk)
+{
+  g_clear_pointer (&chunk->prev_buffer, broadway_buffer_unref);
+  g_clear_pointer (&chunk->buffer, broadway_buffer_unref);
+  /* The data is the start of a put_buffer command that will never
+   * be completed, it must not reach the client.
+   */
+  g_string_set_size (chunk->data, 0);
+  chunk->state = CHUNK_SUPERSEDED;
+  output->n_queued--;
+  output->stats_dropped++;
+}
+
+static void
+push_chunk (BroadwayOutput *output,
+            BroadwayChunk  *chunk)
+{
+  if (chunk->state == CHUNK_QUEUED)
+    {
+      while (output->n_queued >= MAX_QUEUED_BUFFERS)
+        g_cond_wait (&output->cond, &output->mutex);
+      output->n_queued++;
+    }
+
+  g_queue_push_tail (&output->chunks, chunk);
+  g_cond_broadcast (&output->cond);
+}
+
+/* Moves the commands written so far into the chunk list */
+static void
+queue_commands (BroadwayOutput *output)
+{
+  BroadwayChunk *chunk;
+
+  if (output->joining != NULL || output->buf->len == 0)
+    return;
+
+  g_mutex_lock (&output->mutex);
+
+  chunk = g_queue_peek_tail (&output->chunks);
+  if (chunk != NULL && chunk->kind == CHUNK_COMMANDS)
+    {
+      g_string_append_len (chunk->data, output->buf->str, output->buf->len);
+      g_string_set_size (output->buf, 0);
+    }
+  else
+    {
+      push_chunk (output, chunk_new (CHUNK_COMMANDS, CHUNK_DONE, output->buf));
+      output->buf = g_string_new ("");
+    }
+
+  g_mutex_unlock (&output->mutex);
+}
+
+static void
+send_to_viewers (BroadwayOutput *output,
+                 GString        *data)
+{
+  GBytes *bytes;
+  GList *l;
+
+  if (data->len == 0)
+    return;
+
+  bytes = make_frame (TRUE, BROADWAY_WS_BINARY, data->str, data->len);
+
+  for (l = output->viewers; l != NULL; l = l->next)
+    {
+      BroadwayViewer *viewer = l->data;
+
+      if (viewer->joined)
+        viewer_write (viewer, bytes);
+    }
+
+  g_bytes_unref (bytes);
+}
+
+/* Sends all chunks up to the first one that is not encoded yet */
+static void
+write_ready_chunks (BroadwayOutput *output)
+{
+  BroadwayChunk *chunk;
+  GList *ready = NULL, *l;
+  GString *data;
+  GBytes *bytes;
+
+  g_mutex_lock (&output->mutex);
+  while ((chunk = g_queue_peek_head (&output->chunks)) != NULL &&
+         (chunk->state == CHUNK_DONE ||
+          chunk->state == CHUNK_SUPERSEDED))
+    ready = g_list_prepend (ready, g_queue_pop_head (&output->chunks));
+  g_mutex_unlock (&output->mutex);
+
+  if (ready == NULL)
+    return;
+
+  ready = g_list_reverse (ready);
+
+  data = g_string_new ("");
+  for (l = ready; l != NULL; l = l->next)
+    {
+      chunk = l->data;
+
+      /* Dropped buffers have nothing to send */
+      if (chunk->state == CHUNK_SUPERSEDED)
+        continue;
+
+      if (chunk->kind != CHUNK_JOIN)
+        {
+          g_string_append_len (data, chunk->data->str, chunk->data->len);
+          continue;
+        }
+
+      /* Everything before this goes to the viewers we had already */
+      send_to_viewers (output, data);
+      g_string_set_size (data, 0);
+
+      if (chunk->viewer != NULL)
+        {
+          bytes = make_frame (TRUE, BROADWAY_WS_BINARY,
+                              chunk->data->str, chunk->data->len);
+          viewer_write (chunk->viewer, bytes);
+          g_bytes_unref (bytes);
+          chunk->viewer->joined = TRUE;
+        }
+    }
+  send_to_viewers (output, data);
+
+  g_string_free (data, TRUE);
+  g_list_free_full (ready, (GDestroyNotify)chunk_free);
 }
 
-void broadway_output_pong (BroadwayOutput *output)
+static gboolean
+flush_idle_cb (gpointer data)
 {
-  broadway_output_send_cmd (output, TRUE, BROADWAY_WS_CNX_PONG, NULL, 0);
+  BroadwayOutput *output = data;
+  GSource *source;
+
+  g_mutex_lock (&output->mutex);
+  source = output->flush_source;
+  output->flush_source = NULL;
+  g_mutex_unlock (&output->mutex);
+
+  g_source_unref (source);
+
+  write_ready_chunks (output);
+
+  return G_SOURCE_REMOVE;
 }
 
 int
 broadway_output_flush (BroadwayOutput *output)
 {
-  if (output->buf->len == 0)
-    return TRUE;
+  queue_commands (output);
+  write_ready_chunks (output);
 
-  broadway_output_send_cmd (output, TRUE, BROADWAY_WS_BINARY,
-                            output->buf->str, output->buf->len);
+  return TRUE;
+}
+
+/* Starts sending to a new viewer. Until broadway_output_end_join() is
+ * called, all output goes to this viewer only, so the caller can send it
+ * the current state of all windows.
+ */
+BroadwayViewer *
+broadway_output_begin_join (BroadwayOutput *output,
+                            GOutputStream  *out)
+{
+  BroadwayViewer *viewer;
+  BroadwayChunk *chunk;
+
+  g_return_val_if_fail (output->joining == NULL, NULL);
 
-  g_string_set_size (output->buf, 0);
+  queue_commands (output);
 
-  return !output->error;
+  viewer = g_new0 (BroadwayViewer, 1);
+  viewer->out = g_object_ref (out);
+  g_queue_init (&viewer->backlog);
+  output->viewers = g_list_append (output->viewers, viewer);
 
+  /* Commands are written straight into the join chunk */
+  chunk = chunk_new (CHUNK_JOIN, CHUNK_QUEUED, output->buf);
+  chunk->viewer = viewer;
+  output->joining = chunk;
+
+  return viewer;
+}
+
+void
+broadway_output_end_join (BroadwayOutput *output)
+{
+  BroadwayChunk *chunk = output->joining;
+
+  g_return_if_fail (chunk != NULL);
+
+  chunk->keyframes = g_list_reverse (chunk->keyframes);
+  if (chunk->keyframes == NULL)
+    chunk->state = CHUNK_DONE;
+  output->joining = NULL;
+  output->buf = g_string_new ("");
+
+  g_mutex_lock (&output->mutex);
+  push_chunk (output, chunk);
+  g_mutex_unlock (&output->mutex);
+}
+
+void
+broadway_output_remove_viewer (BroadwayOutput *output,
+                               BroadwayViewer *viewer)
+{
+  GList *l;
+
+  g_mutex_lock (&output->mutex);
+  for (l = output->chunks.head; l != NULL; l = l->next)
+    {
+      BroadwayChunk *chunk = l->data;
+
+      if (chunk->viewer == viewer)
+        chunk->viewer = NULL;
+    }
+  g_mutex_unlock (&output->mutex);
+
+  output->viewers = g_list_remove (output->viewers, viewer);
+
+  if (viewer->source)
+    {
+      g_source_destroy (viewer->source);
+      g_source_unref (viewer->source);
+    }
+  viewer_clear_backlog (viewer);
+  g_object_unref (viewer->out);
+  g_free (viewer);
+}
+
+/* Compresses @in_len bytes with a sync flush, so that the result ends on a
+ * byte boundary and the client can decode it without waiting for more data,
+ * while keeping the deflate window for the next buffer.
+ */
+static void
+compress_sync_flush (GConverter *compressor,
+                     const char *in,
+                     gsize       in_len,
+                     GString    *dest)
+{
+  GConverterResult res;
+  gsize out_len, read, written;
+  GError *error = NULL;
+
+  do
+    {
+      out_len = dest->len;
+      g_string_set_size (dest, out_len + in_len + 4096);
+
+      res = g_converter_convert (compressor,
+                                 in, in_len,
+                                 dest->str + out_len, dest->len - out_len,
+                                 G_CONVERTER_FLUSH,
+                                 &read, &written, &error);
+      if (res == G_CONVERTER_ERROR)
+        {
+          g_warning ("compression failed: %s", error->message);
+          g_error_free (error);
+          g_string_set_size (dest, out_len);
+          return;
+        }
+
+      g_string_set_size (dest, out_len + written);
+      in += read;
+      in_len -= read;
+    }
+  while (res != G_CONVERTER_FLUSHED);
+}
+
+/* Appends the compressed size and data of @buffer to @dest, which
+ * already holds the put-buffer header */
+static void
+encode_buffer (BroadwayOutput *output,
+               BroadwayBuffer *prev_buffer,
+               BroadwayBuffer *buffer,
+               GString        *dest)
+{
+  gsize len_offset, len;
+  gint64 start;
+  guint8 *p;
+
+  start = g_get_monotonic_time ();
+
+  g_string_set_size (output->encoded, 0);
+  broadway_buffer_encode (buffer, prev_buffer, output->encoded);
+
+  len_offset = dest->len;
+  g_string_set_size (dest, len_offset + 4);
+  compress_sync_flush (output->compressor,
+                       output->encoded->str, output->encoded->len,
+                       dest);
+
+  len = dest->len - len_offset - 4;
+  p = (guint8 *)dest->str + len_offset;
+  p[0] = (len >> 0) & 0xff;
+  p[1] = (len >> 8) & 0xff;
+  p[2] = (len >> 16) & 0xff;
+  p[3] = (len >> 24) & 0xff;
+
+  output->stats_frames++;
+  output->stats_raw_bytes += output->encoded->len;
+  output->stats_bytes += len;
+  output->stats_time += g_get_monotonic_time () - start;
+}
+
+static void
+encode_chunk (BroadwayOutput *output,
+              BroadwayChunk  *chunk)
+{
+  GList *l;
+
+  if (chunk->kind == CHUNK_BUFFER)
+    {
+      encode_buffer (output, chunk->prev_buffer, chunk->buffer, chunk->data);
+      return;
+    }
+
+  /* The new viewer has none of the history, and the other viewers
+   * won't get these keyframes */
+  g_converter_reset (output->compressor);
+
+  for (l = chunk->keyframes; l != NULL; l = l->next)
+    {
+      BroadwayKeyframe *keyframe = l->data;
+
+      g_string_append_len (chunk->data, keyframe->header->str, keyframe->header->len);
+      encode_buffer (output, NULL, keyframe->buffer, chunk->data);
+    }
+
+  g_converter_reset (output->compressor);
+}
+
+static void
+print_stats (BroadwayOutput *output)
+{
+  if (output->stats_frames == 0)
+    return;
+
+  g_print ("broadway output: %" G_GUINT64_FORMAT " frames (%" G_GUINT64_FORMAT " dropped), "
+           "%" G_GUINT64_FORMAT " bytes/frame (%" G_GUINT64_FORMAT " before compression), "
+           "%.2f ms/frame, %u viewers\n",
+           output->stats_frames, output->stats_dropped,
+           output->stats_bytes / output->stats_frames,
+           output->stats_raw_bytes / output->stats_frames,
+           output->stats_time / 1000.0 / output->stats_frames,
+           g_list_length (output->viewers));
+}
+
+static BroadwayChunk *
+find_queued_chunk (BroadwayOutput *output)
+{
+  GList *l;
+
+  for (l = output->chunks.head; l != NULL; l = l->next)
+    {
+      BroadwayChunk *chunk = l->data;
+
+      if (chunk->state == CHUNK_QUEUED)
+        return chunk;
+    }
+
+  return NULL;
+}
+
+static gpointer
+encode_thread (gpointer data)
+{
+  BroadwayOutput *output = data;
+  BroadwayChunk *chunk;
+
+  g_mutex_lock (&output->mutex);
+  while (TRUE)
+    {
+      chunk = NULL;
+      while (!output->quit &&
+             (chunk = find_queued_chunk (output)) == NULL)
+        g_cond_wait (&output->cond, &output->mutex);
+
+      if (output->quit)
+        break;
+
+      chunk->state = CHUNK_ENCODING;
+      output->n_queued--;
+      g_cond_broadcast (&output->cond);
+      g_mutex_unlock (&output->mutex);
+
+      encode_chunk (output, chunk);
+
+      g_mutex_lock (&output->mutex);
+      chunk->state = CHUNK_DONE;
+
+      if (output->print_stats && output->stats_frames % 100 == 0)
+        print_stats (output);
+
+      if (output->flush_source == NULL)
+        {
+          output->flush_source = g_idle_source_new ();
+          g_source_set_callback (output->flush_source, flush_idle_cb, output, NULL);
+          g_source_attach (output->flush_source, output->context);
+        }
+    }
+  g_mutex_unlock (&output->mutex);
+
+  return NULL;
 }
 
 BroadwayOutput *
-broadway_output_new (GOutputStream *out, guint32 serial)
+broadway_output_new (guint32 serial)
 {
   BroadwayOutput *output;
 
   output = g_new0 (BroadwayOutput, 1);
 
-  output->out = g_object_ref (out);
   output->buf = g_string_new ("");
   output->serial = serial;
 
+  g_mutex_init (&output->mutex);
+  g_cond_init (&output->cond);
+  g_queue_init (&output->chunks);
+  output->context = g_main_context_ref_thread_default ();
+  output->compressor = G_CONVERTER (g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW, -1));
+  output->encoded = g_string_new ("");
+  output->print_stats = g_getenv ("BROADWAY_OUTPUT_STATS") != NULL;
+
+  output->thread = g_thread_new ("broadway-encoder", encode_thread, output);
+
   return output;
 }
 
 void
 broadway_output_free (BroadwayOutput *output)
 {
-  g_object_unref (output->out);
+  BroadwayChunk *chunk;
+
+  g_mutex_lock (&output->mutex);
+  output->quit = TRUE;
+  g_cond_broadcast (&output->cond);
+  g_mutex_unlock (&output->mutex);
+
+  g_thread_join (output->thread);
+
+  if (output->flush_source)
+    {
+      g_source_destroy (output->flush_source);
+      g_source_unref (output->flush_source);
+    }
+
+  if (output->print_stats)
+    print_stats (output);
+
+  while (output->viewers != NULL)
+    broadway_output_remove_viewer (output, output->viewers->data);
+
+  while ((chunk = g_queue_pop_head (&output->chunks)) != NULL)
+    chunk_free (chunk);
+
+  g_object_unref (output->compressor);
+  g_string_free (output->encoded, TRUE);
+  g_string_free (output->buf, TRUE);
+  g_main_context_unref (output->context);
+  g_cond_clear (&output->cond);
+  g_mutex_clear (&output->mutex);
   free (output);
 }
 
@@ -196,12 +880,6 @@ broadway_output_new_surface(BroadwayOutput *output,
   append_bool (output, is_temp);
 }
 
-void
-broadway_output_disconnected (BroadwayOutput *output)
-{
-  write_header (output, BROADWAY_OP_DISCONNECTED);
-}
-
 void
 broadway_output_show_surface(BroadwayOutput *output,  int id)
 {
@@ -292,41 +970,79 @@ broadway_output_put_buffer (BroadwayOutput *output,
                             BroadwayBuffer *prev_buffer,
                             BroadwayBuffer *buffer)
 {
-  gsize len;
-  int w, h;
-  GZlibCompressor *compressor;
-  GOutputStream *out, *out_mem;
-  GString *encoded;
+  BroadwayChunk *chunk;
+  BroadwayKeyframe *keyframe;
+  GString *header;
+  GList *l;
 
-  write_header (output, BROADWAY_OP_PUT_BUFFER);
+  /* Keep everything written so far in front of this buffer */
+  queue_commands (output);
 
-  w = broadway_buffer_get_width (buffer);
-  h = broadway_buffer_get_height (buffer);
+  header = output->buf;
+  output->buf = g_string_new ("");
 
+  write_header (output, BROADWAY_OP_PUT_BUFFER);
   append_uint16 (output, id);
-  append_uint16 (output, w);
-  append_uint16 (output, h);
+  append_uint16 (output, broadway_buffer_get_width (buffer));
+  append_uint16 (output, broadway_buffer_get_height (buffer));
 
-  encoded = g_string_new ("");
-  broadway_buffer_encode (buffer, prev_buffer, encoded);
+  /* Joining viewers get everything as keyframes, after the commands */
+  if (output->joining != NULL)
+    {
+      keyframe = g_new0 (BroadwayKeyframe, 1);
+      keyframe->header = output->buf;
+      keyframe->buffer = broadway_buffer_ref (buffer);
+      output->joining->keyframes = g_list_prepend (output->joining->keyframes, keyframe);
+      output->buf = header;
+      return;
+    }
 
-  compressor = g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW, -1);
-  out_mem = g_memory_output_stream_new_resizable ();
-  out = g_converter_output_stream_new (out_mem, G_CONVERTER (compressor));
-  g_object_unref (compressor);
+  g_string_free (header, TRUE);
 
-  if (!g_output_stream_write_all (out, encoded->str, encoded->len,
-                                  NULL, NULL, NULL) ||
-      !g_output_stream_close (out, NULL, NULL))
-    g_warning ("compression failed\n");
+  chunk = chunk_new (CHUNK_BUFFER, CHUNK_QUEUED, output->buf);
+  chunk->id = id;
+  chunk->buffer = broadway_buffer_ref (buffer);
+  if (prev_buffer)
+    chunk->prev_buffer = broadway_buffer_ref (prev_buffer);
+  output->buf = g_string_new ("");
+
+  g_mutex_lock (&output->mutex);
+
+  /* If the previous buffer for this window was not picked up by the
+   * encoder yet, the viewers never need to see it. Drop it and encode
+   * this one against whatever they will have at that point. Viewers that
+   * joined in between have the old one as their keyframe, so stop there.
+   */
+  for (l = output->chunks.tail; l != NULL; l = l->prev)
+    {
+      BroadwayChunk *old = l->data;
 
+      if (old->kind == CHUNK_JOIN)
+        break;
 
-  len = g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (out_mem));
-  append_uint32 (output, len);
+      if (old->kind != CHUNK_BUFFER ||
+          old->state == CHUNK_SUPERSEDED ||
+          old->id != id)
+        continue;
+
+      if (old->state == CHUNK_QUEUED)
+        {
+          if (chunk->prev_buffer != NULL &&
+              chunk->prev_buffer == old->buffer)
+            {
+              broadway_buffer_unref (chunk->prev_buffer);
+              chunk->prev_buffer = old->prev_buffer;
+              old->prev_buffer = NULL;
+              chunk_supersede (output, old);
+            }
+          else if (chunk->prev_buffer == NULL)
+            chunk_supersede (output, old);
+        }
+
+      break;
+    }
 
-  g_string_append_len (output->buf, g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (out_mem)), len);
+  push_chunk (output, chunk);
 
-  g_string_free (encoded, TRUE);
-  g_object_unref (out);
-  g_object_unref (out_mem);
+  g_mutex_unlock (&output->mutex);
 }
@@ -7,6 +7,7 @@
 #include "broadway-buffer.h"
 
 typedef struct BroadwayOutput BroadwayOutput;
+typedef struct BroadwayViewer BroadwayViewer;
 
 typedef enum {
   BROADWAY_WS_CONTINUATION = 0,
@@ -17,11 +18,16 @@ typedef enum {
   BROADWAY_WS_CNX_PONG = 0xa
 } BroadwayWSOpCode;
 
-BroadwayOutput *broadway_output_new             (GOutputStream  *out,
-						 guint32         serial);
+BroadwayOutput *broadway_output_new             (guint32         serial);
 void            broadway_output_free            (BroadwayOutput *output);
 int             broadway_output_flush           (BroadwayOutput *output);
-int             broadway_output_has_error       (BroadwayOutput *output);
+BroadwayViewer *broadway_output_begin_join      (BroadwayOutput *output,
+						 GOutputStream  *out);
+void            broadway_output_end_join        (BroadwayOutput *output);
+void            broadway_output_remove_viewer   (BroadwayOutput *output,
+						 BroadwayViewer *viewer);
+gboolean        broadway_output_viewer_has_error (BroadwayOutput *output,
+						  BroadwayViewer *viewer);
 void            broadway_output_set_next_serial (BroadwayOutput *output,
 						 guint32         serial);
 guint32         broadway_output_get_next_serial (BroadwayOutput *output);
@@ -32,7 +38,6 @@ void            broadway_output_new_surface     (BroadwayOutput *output,
 						 int             w,
 						 int             h,
 						 gboolean        is_temp);
-void            broadway_output_disconnected    (BroadwayOutput *output);
 void            broadway_output_show_surface    (BroadwayOutput *output,
 						 int             id);
 void            broadway_output_hide_surface    (BroadwayOutput *output,
@@ -62,7 +67,8 @@ void            broadway_output_grab_pointer    (BroadwayOutput *output,
 						 int id,
 						 gboolean owner_event);
 guint32         broadway_output_ungrab_pointer  (BroadwayOutput *output);
-void            broadway_output_pong            (BroadwayOutput *output);
+void            broadway_output_pong            (BroadwayOutput *output,
+						 BroadwayViewer *viewer);
 void            broadway_output_set_show_keyboard (BroadwayOutput *output,
                                                    gboolean show);
 
@@ -23,7 +23,9 @@ typedef enum {
   BROADWAY_EVENT_CONFIGURE_NOTIFY = 'w',
   BROADWAY_EVENT_DELETE_NOTIFY = 'W',
   BROADWAY_EVENT_SCREEN_SIZE_CHANGED = 'd',
-  BROADWAY_EVENT_FOCUS = 'f'
+  BROADWAY_EVENT_FOCUS = 'f',
+  BROADWAY_EVENT_FRAME_ACK = 'A',
+  BROADWAY_EVENT_FRAME_DONE = 'F'
 } BroadwayEventType;
 
 typedef enum {
@@ -128,6 +130,12 @@ typedef struct {
   gint32 old_id;
 } BroadwayInputFocusMsg;
 
+typedef struct {
+  BroadwayInputBaseMsg base;
+  gint32 id;
+  guint32 round_trip; /* in usec, 0 if there is no client */
+} BroadwayInputFrameDoneMsg;
+
 typedef union {
   BroadwayInputBaseMsg base;
   BroadwayInputPointerMsg pointer;
@@ -141,6 +149,7 @@ typedef union {
   BroadwayInputDeleteNotify delete_notify;
   BroadwayInputScreenResizeNotify screen_resize_notify;
   BroadwayInputFocusMsg focus;
+  BroadwayInputFrameDoneMsg frame_done;
 } BroadwayInputMsg;
 
 typedef enum {
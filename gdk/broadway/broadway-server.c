@@ -35,8 +35,14 @@
 #include <string.h>
 #endif
 
+/* The number of buffers we send to the browser before waiting for it
+   to acknowledge them. Updates that arrive while this many are in flight
+   are held back and only the newest one for each window is sent. */
+#define MAX_FRAMES_IN_FLIGHT 2
+
 typedef struct BroadwayInput BroadwayInput;
 typedef struct BroadwayWindow BroadwayWindow;
+typedef struct BroadwayFrame BroadwayFrame;
 struct _BroadwayServer {
   GObject parent_instance;
 
@@ -49,10 +55,14 @@ struct _BroadwayServer {
   guint32 id_counter;
   guint32 saved_serial;
   guint64 last_seen_time;
-  BroadwayInput *input;
+  GList *inputs;
+  BroadwayInput *input; /* The one in control, others just watch */
   GList *input_messages;
   guint process_input_idle;
 
+  GQueue frames_in_flight;
+  gint64 frame_round_trip;
+
   GHashTable *id_ht;
   GList *toplevels;
   BroadwayWindow *root;
@@ -95,13 +105,20 @@ typedef struct HttpRequest {
 
 struct BroadwayInput {
   BroadwayServer *server;
-  BroadwayOutput *output;
+  BroadwayViewer *viewer;
   GIOStream *connection;
   GByteArray *buffer;
   GSource *source;
   gboolean seen_time;
   gint64 time_base;
   gboolean active;
+  guint remove_idle;
+};
+
+struct BroadwayFrame {
+  guint32 serial;
+  gint32 id;
+  gint64 sent_time;
 };
 
 struct BroadwayWindow {
@@ -116,12 +133,19 @@ struct BroadwayWindow {
 
   BroadwayBuffer *buffer;
   gboolean buffer_synced;
+  BroadwayBuffer *pending_buffer;
+  gboolean frame_pending;
 
   char *cached_surface_name;
   cairo_surface_t *cached_surface;
 };
 
 static void broadway_server_resync_windows (BroadwayServer *server);
+static void broadway_server_frames_acked (BroadwayServer *server,
+                                          guint32         serial);
+static void broadway_server_release_frames (BroadwayServer *server);
+static void broadway_server_remove_input (BroadwayServer *server,
+                                          BroadwayInput  *input);
 
 static GType broadway_server_get_type (void);
 
@@ -138,6 +162,7 @@ broadway_server_init (BroadwayServer *server)
   server->last_seen_time = 1;
   server->id_ht = g_hash_table_new (NULL, NULL);
   server->id_counter = 0;
+  g_queue_init (&server->frames_in_flight);
 
   root = g_new0 (BroadwayWindow, 1);
   root->id = server->id_counter++;
@@ -187,6 +212,8 @@ http_request_free (HttpRequest *request)
 static void
 broadway_input_free (BroadwayInput *input)
 {
+  if (input->remove_idle)
+    g_source_remove (input->remove_idle);
   g_object_unref (input->connection);
   g_byte_array_free (input->buffer, FALSE);
   g_source_destroy (input->source);
@@ -427,6 +454,11 @@ parse_input_message (BroadwayInput *input, const unsigned char *message)
   guint32 *p;
   gint64 time_;
 
+  /* Viewers that are not in control can't send events, and
+     frames are only paced on the one that is */
+  if (input != server->input)
+    return;
+
   memset (&msg, 0, sizeof (msg));
 
   p = (guint32 *) message;
@@ -452,6 +484,13 @@ parse_input_message (BroadwayInput *input, const unsigned char *message)
 
   msg.base.time = time_;
 
+  if (msg.base.type == BROADWAY_EVENT_FRAME_ACK)
+    {
+      /* Only used for flow control, not passed on to the clients */
+      broadway_server_frames_acked (server, msg.base.serial);
+      return;
+    }
+
   switch (msg.base.type) {
   case BROADWAY_EVENT_ENTER:
   case BROADWAY_EVENT_LEAVE:
@@ -627,7 +666,8 @@ parse_input (BroadwayInput *input)
           }
         break;
       case BROADWAY_WS_CNX_PING:
-        broadway_output_pong (input->output);
+        if (input->viewer)
+          broadway_output_pong (input->server->output, input->viewer);
         break;
       case BROADWAY_WS_CNX_PONG:
         break; /* we never send pings, but tolerate pongs */
@@ -686,9 +726,7 @@ broadway_server_read_all_input_nonblocking (BroadwayInput *input)
 	  return TRUE;
 	}
 
-      if (input->server->input == input)
-	input->server->input = NULL;
-      broadway_input_free (input);
+      broadway_server_remove_input (input->server, input);
       if (res < 0)
 	{
 	  g_printerr ("input error %s\n", error->message);
@@ -749,16 +787,68 @@ broadway_server_get_screen_size (BroadwayServer   *server,
 }
 
 
-void
-broadway_server_flush (BroadwayServer *server)
+static void
+broadway_server_remove_input (BroadwayServer *server,
+                              BroadwayInput  *input)
 {
-  if (server->output &&
-      !broadway_output_flush (server->output))
+  server->inputs = g_list_remove (server->inputs, input);
+
+  if (server->output && input->viewer)
+    broadway_output_remove_viewer (server->output, input->viewer);
+  input->viewer = NULL;
+
+  if (server->inputs == NULL && server->output)
     {
       server->saved_serial = broadway_output_get_next_serial (server->output);
       broadway_output_free (server->output);
       server->output = NULL;
     }
+
+  if (server->input == input)
+    {
+      /* The next viewer takes over */
+      server->input = server->inputs ? server->inputs->data : NULL;
+      if (server->input)
+        server->input->active = TRUE;
+
+      /* Nothing sent to the old one will be acknowledged anymore */
+      broadway_server_release_frames (server);
+    }
+
+  broadway_input_free (input);
+}
+
+static gboolean
+remove_input_idle_cb (gpointer data)
+{
+  BroadwayInput *input = data;
+
+  input->remove_idle = 0;
+  broadway_server_remove_input (input->server, input);
+
+  return G_SOURCE_REMOVE;
+}
+
+void
+broadway_server_flush (BroadwayServer *server)
+{
+  GList *l;
+
+  if (server->output == NULL)
+    return;
+
+  broadway_output_flush (server->output);
+
+  /* This can be called while handling input, so drop broken
+     viewers later */
+  for (l = server->inputs; l != NULL; l = l->next)
+    {
+      BroadwayInput *input = l->data;
+
+      if (input->remove_idle == 0 &&
+          broadway_output_viewer_has_error (server->output, input->viewer))
+        input->remove_idle = g_idle_add (remove_input_idle_cb, input);
+    }
 }
 
 #if 0
@@ -1051,9 +1141,6 @@ start_input (HttpRequest *request)
   input->buffer = g_byte_array_sized_new (data_buffer_size);
   g_byte_array_append (input->buffer, data_buffer, data_buffer_size);
 
-  input->output =
-    broadway_output_new (g_io_stream_get_output_stream (request->connection), 0);
-
   /* This will free and close the data input stream, but we got all the buffered content already */
   http_request_free (request);
 
@@ -1076,33 +1163,18 @@ start (BroadwayInput *input)
 {
   BroadwayServer *server;
 
-  input->active = TRUE;
-
   server = BROADWAY_SERVER (input->server);
 
-  if (server->output)
-    {
-      broadway_output_disconnected (server->output);
-      broadway_output_flush (server->output);
-    }
-
-  if (server->input != NULL)
-    {
-      broadway_input_free (server->input);
-      server->input = NULL;
-    }
-
-  server->input = input;
+  /* All viewers share one output, so each update is only encoded once */
+  if (server->output == NULL)
+    server->output = broadway_output_new (server->saved_serial);
 
-  if (server->output)
-    {
-      server->saved_serial = broadway_output_get_next_serial (server->output);
-      broadway_output_free (server->output);
-    }
-  server->output = input->output;
+  server->inputs = g_list_append (server->inputs, input);
 
-  broadway_output_set_next_serial (server->output, server->saved_serial);
-  broadway_output_flush (server->output);
+  /* Bring the new viewer up to date without sending anything to the others */
+  input->viewer =
+    broadway_output_begin_join (server->output,
+                                g_io_stream_get_output_stream (input->connection));
 
   broadway_server_resync_windows (server);
 
@@ -1111,6 +1183,16 @@ start (BroadwayInput *input)
 				  server->pointer_grab_window_id,
 				  server->pointer_grab_owner_events);
 
+  broadway_output_end_join (server->output);
+
+  if (server->input == NULL)
+    {
+      input->active = TRUE;
+      server->input = input;
+    }
+
+  broadway_server_flush (server);
+
   process_input_messages (server);
 }
 
@@ -1460,6 +1542,10 @@ broadway_server_destroy_window (BroadwayServer *server,
       g_free (window->cached_surface_name);
       if (window->cached_surface != NULL)
 	cairo_surface_destroy (window->cached_surface);
+      if (window->buffer != NULL)
+        broadway_buffer_unref (window->buffer);
+      if (window->pending_buffer != NULL)
+        broadway_buffer_unref (window->pending_buffer);
 
       g_free (window);
     }
@@ -1594,6 +1680,144 @@ broadway_server_has_client (BroadwayServer *server)
   return server->output != NULL;
 }
 
+static void
+send_frame_done (BroadwayServer *server,
+                 BroadwayWindow *window)
+{
+  BroadwayInputMsg ev = { {0} };
+
+  if (!window->frame_pending)
+    return;
+
+  window->frame_pending = FALSE;
+
+  ev.base.type = BROADWAY_EVENT_FRAME_DONE;
+  ev.base.serial = broadway_server_get_next_serial (server) - 1;
+  ev.base.time = server->last_seen_time;
+  ev.frame_done.id = window->id;
+  ev.frame_done.round_trip = server->output ? server->frame_round_trip : 0;
+
+  broadway_events_got_input (&ev, -1);
+}
+
+static void
+send_buffer (BroadwayServer *server,
+             BroadwayWindow *window,
+             BroadwayBuffer *prev_buffer,
+             BroadwayBuffer *buffer)
+{
+  BroadwayFrame *frame;
+
+  frame = g_new0 (BroadwayFrame, 1);
+  frame->serial = broadway_output_get_next_serial (server->output);
+  frame->id = window->id;
+  frame->sent_time = g_get_monotonic_time ();
+  g_queue_push_tail (&server->frames_in_flight, frame);
+
+  window->buffer_synced = TRUE;
+  broadway_output_put_buffer (server->output, window->id,
+                              prev_buffer, buffer);
+}
+
+static void
+send_pending_buffers (BroadwayServer *server)
+{
+  GList *l;
+
+  for (l = server->toplevels;
+       l != NULL &&
+       server->frames_in_flight.length < MAX_FRAMES_IN_FLIGHT;
+       l = l->next)
+    {
+      BroadwayWindow *window = l->data;
+
+      if (window->pending_buffer == NULL)
+        continue;
+
+      send_buffer (server, window, window->buffer, window->pending_buffer);
+
+      if (window->buffer)
+        broadway_buffer_unref (window->buffer);
+      window->buffer = window->pending_buffer;
+      window->pending_buffer = NULL;
+    }
+}
+
+/* Called when the browser has handled everything up to @serial */
+static void
+broadway_server_frames_acked (BroadwayServer *server,
+                              guint32         serial)
+{
+  BroadwayFrame *frame;
+  BroadwayWindow *window;
+  gint64 now, round_trip;
+
+  now = g_get_monotonic_time ();
+
+  while ((frame = g_queue_peek_head (&server->frames_in_flight)) != NULL &&
+         (gint32)(serial - frame->serial) >= 0)
+    {
+      g_queue_pop_head (&server->frames_in_flight);
+
+      round_trip = now - frame->sent_time;
+      if (server->frame_round_trip == 0)
+        server->frame_round_trip = round_trip;
+      else
+        server->frame_round_trip = (7 * server->frame_round_trip + round_trip) / 8;
+
+      window = g_hash_table_lookup (server->id_ht,
+                                    GINT_TO_POINTER (frame->id));
+      if (window != NULL)
+        send_frame_done (server, window);
+
+      g_free (frame);
+    }
+
+  if (server->output)
+    {
+      send_pending_buffers (server);
+      broadway_server_flush (server);
+    }
+}
+
+/* Forgets about all frames in flight, and lets all clients waiting
+   for one draw again */
+static void
+broadway_server_release_frames (BroadwayServer *server)
+{
+  BroadwayFrame *frame;
+  GList *l;
+
+  while ((frame = g_queue_pop_head (&server->frames_in_flight)) != NULL)
+    g_free (frame);
+
+  server->frame_round_trip = 0;
+
+  if (server->output)
+    {
+      send_pending_buffers (server);
+      broadway_server_flush (server);
+    }
+  else
+    {
+      for (l = server->toplevels; l != NULL; l = l->next)
+        {
+          BroadwayWindow *window = l->data;
+
+          if (window->pending_buffer == NULL)
+            continue;
+
+          if (window->buffer)
+            broadway_buffer_unref (window->buffer);
+          window->buffer = window->pending_buffer;
+          window->pending_buffer = NULL;
+        }
+    }
+
+  for (l = server->toplevels; l != NULL; l = l->next)
+    send_frame_done (server, l->data);
+}
+
 void
 broadway_server_window_update (BroadwayServer *server,
 			       gint id,
@@ -1617,17 +1841,33 @@ broadway_server_window_update (BroadwayServer *server,
                                    cairo_image_surface_get_data (surface),
                                    cairo_image_surface_get_stride (surface));
 
-  if (server->output != NULL)
+  window->frame_pending = TRUE;
+
+  if (window->pending_buffer)
+    {
+      broadway_buffer_unref (window->pending_buffer);
+      window->pending_buffer = NULL;
+    }
+
+  if (server->output != NULL &&
+      server->frames_in_flight.length >= MAX_FRAMES_IN_FLIGHT)
     {
-      window->buffer_synced = TRUE;
-      broadway_output_put_buffer (server->output, window->id,
-                                  window->buffer, buffer);
+      /* The browser is behind, hold on to this until it catches up */
+      window->buffer_synced = FALSE;
+      window->pending_buffer = buffer;
+      return;
     }
 
+  if (server->output != NULL)
+    send_buffer (server, window, window->buffer, buffer);
+
   if (window->buffer)
-    broadway_buffer_destroy (window->buffer);
+    broadway_buffer_unref (window->buffer);
 
   window->buffer = buffer;
+
+  if (server->output == NULL)
+    send_frame_done (server, window);
 }
 
 gboolean
@@ -1887,7 +2127,6 @@ broadway_server_resync_windows (BroadwayServer *server)
       if (window->id == 0)
 	continue; /* Skip root */
 
-      window->buffer_synced = FALSE;
       broadway_output_new_surface (server->output,
 				   window->id,
 				   window->x,
@@ -1911,17 +2150,13 @@ broadway_server_resync_windows (BroadwayServer *server)
 	{
 	  broadway_output_show_surface (server->output, window->id);
 
+	  /* Held back buffers go out later, on top of this */
 	  if (window->buffer != NULL)
-	    {
-	      window->buffer_synced = TRUE;
-              broadway_output_put_buffer (server->output, window->id,
-                                          NULL, window->buffer);
-	    }
+            broadway_output_put_buffer (server->output, window->id,
+                                        NULL, window->buffer);
 	}
     }
 
   if (server->show_keyboard)
     broadway_output_set_show_keyboard (server->output, TRUE);
-
-  broadway_server_flush (server);
 }
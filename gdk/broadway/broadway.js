@@ -102,6 +102,7 @@ var surfaces = {};
 var stackingOrder = [];
 var outstandingCommands = new Array();
 var inputSocket = null;
+var inflater = null;
 var debugDecoding = false;
 var fakeInput = null;
 var showKeyboard = false;
@@ -516,8 +517,7 @@ function cmdPutBuffer(id, w, h, compressed)
     var surface = surfaces[id];
     var context = surface.canvas.getContext("2d");
 
-    var inflate = new Zlib.RawInflate(compressed);
-    var data = inflate.decompress();
+    var data = inflater.inflate(compressed);
 
     var imageData = decodeBuffer (context, surface.imageData, w, h, data, debugDecoding);
     context.putImageData(imageData, 0, 0);
@@ -549,6 +549,8 @@ function handleCommands(cmd)
         active = true;
     }
 
+    var gotBuffer = false;
+
     while (cmd.pos < cmd.length) {
 	var id, x, y, w, h, q;
 	var command = cmd.get_char();
@@ -622,6 +624,7 @@ function handleCommands(cmd)
 	    h = cmd.get_16();
             var data = cmd.get_data();
             cmdPutBuffer(id, w, h, data);
+            gotBuffer = true;
             break;
 
 	case 'g': // Grab
@@ -644,6 +647,12 @@ function handleCommands(cmd)
 	    alert("Unknown op " + command);
 	}
     }
+
+    /* Let the server know we're done with everything up to lastSerial,
+       it holds back new frames until we catch up */
+    if (gotBuffer)
+        sendInput ("A", []);
+
     return true;
 }
 
@@ -2616,6 +2625,7 @@ function connect()
     loc = loc.substr(0, loc.lastIndexOf('/')) + "/socket";
     ws = new WebSocket(loc, "broadway");
     ws.binaryType = "arraybuffer";
+    inflater = new Inflater();
 
     ws.onopen = function() {
 	inputSocket = ws;
@@ -564,6 +564,8 @@ get_event_size (int type)
       return sizeof (BroadwayInputScreenResizeNotify);
     case BROADWAY_EVENT_FOCUS:
       return sizeof (BroadwayInputFocusMsg);
+    case BROADWAY_EVENT_FRAME_DONE:
+      return sizeof (BroadwayInputFrameDoneMsg);
     default:
       g_assert_not_reached ();
     }
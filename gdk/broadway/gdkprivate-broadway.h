@@ -49,6 +49,8 @@ void     _gdk_broadway_window_translate         (GdkWindow *window,
 						 cairo_region_t *area,
 						 gint       dx,
 						 gint       dy);
+void     _gdk_broadway_window_frame_done        (GdkWindow *window,
+                                                 guint32    round_trip);
 gboolean _gdk_broadway_window_get_property (GdkWindow   *window,
 					    GdkAtom      property,
 					    GdkAtom      type,
@@ -37,6 +37,7 @@
 #include "gdkinternals.h"
 #include "gdkdeviceprivate.h"
 #include "gdkeventsource.h"
+#include "gdkframeclockprivate.h"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -127,6 +128,17 @@ update_dirty_windows_and_sync (void)
 	  _gdk_broadway_server_window_update (display->server,
 					      impl->id,
 					      impl->surface);
+
+          /* broadwayd replies with a frame-done once the browser has
+             caught up, don't paint again before that */
+          if (impl->surface != NULL && !impl->awaiting_frame)
+            {
+              GdkFrameClock *clock = gdk_window_get_frame_clock (impl->wrapper);
+
+              impl->awaiting_frame = TRUE;
+              impl->pending_frame_counter = gdk_frame_clock_get_frame_counter (clock);
+              _gdk_frame_clock_freeze (clock);
+            }
 	}
     }
 
@@ -238,6 +250,57 @@ _gdk_broadway_screen_init_root_window (GdkScreen * screen)
   _gdk_window_update_size (broadway_screen->root_window);
 }
 
+void
+_gdk_broadway_window_frame_done (GdkWindow *window,
+                                 guint32    round_trip)
+{
+  GdkWindowImplBroadway *impl = GDK_WINDOW_IMPL_BROADWAY (window->impl);
+  GdkFrameClock *clock;
+  GdkFrameTimings *timings;
+
+  if (GDK_WINDOW_DESTROYED (window) || !impl->awaiting_frame)
+    return;
+
+  clock = gdk_window_get_frame_clock (window);
+
+  impl->awaiting_frame = FALSE;
+  _gdk_frame_clock_thaw (clock);
+
+  timings = gdk_frame_clock_get_timings (clock, impl->pending_frame_counter);
+  impl->pending_frame_counter = 0;
+
+  if (timings == NULL)
+    return;
+
+  /* The browser showed the frame when it acknowledged it, and over a slow
+   * link the acknowledgement round trip, not the monitor, is what limits
+   * how often we can usefully draw.
+   */
+  timings->refresh_interval = MAX (round_trip, 16667);
+  timings->presentation_time = g_get_monotonic_time () - round_trip / 2;
+  timings->complete = TRUE;
+
+#ifdef G_ENABLE_DEBUG
+  if ((_gdk_debug_flags & GDK_DEBUG_FRAMES) != 0)
+    _gdk_frame_clock_debug_print_timings (clock, timings);
+#endif
+}
+
+static void
+on_frame_clock_before_paint (GdkFrameClock *clock,
+                             GdkWindow     *window)
+{
+  GdkFrameTimings *timings = gdk_frame_clock_get_current_timings (clock);
+  gint64 presentation_time;
+  gint64 refresh_interval;
+
+  gdk_frame_clock_get_refresh_info (clock,
+                                    timings->frame_time,
+                                    &refresh_interval, &presentation_time);
+
+  timings->predicted_presentation_time = timings->frame_time + refresh_interval;
+}
+
 static void
 on_frame_clock_after_paint (GdkFrameClock *clock,
                             GdkWindow     *window)
@@ -252,6 +315,8 @@ connect_frame_clock (GdkWindow *window)
     {
       GdkFrameClock *frame_clock = gdk_window_get_frame_clock (window);
 
+      g_signal_connect (frame_clock, "before-paint",
+                        G_CALLBACK (on_frame_clock_before_paint), window);
       g_signal_connect (frame_clock, "after-paint",
                         G_CALLBACK (on_frame_clock_after_paint), window);
     }
@@ -71,6 +71,10 @@ struct _GdkWindowImplBroadway
   gboolean dirty;
   gboolean last_synced;
 
+  /* Frame clock is frozen until broadwayd says the browser got the update */
+  gboolean awaiting_frame;
+  gint64 pending_frame_counter;
+
   GdkGeometry geometry_hints;
   GdkWindowHints geometry_hints_mask;
 };
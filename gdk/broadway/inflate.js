@@ -0,0 +1,254 @@
+/* Streaming raw inflate
+ *
+ * The server keeps a single deflate stream per connection and does a
+ * sync flush after every buffer, so each 'b' command carries a chunk
+ * that ends on a byte boundary but may refer back into the output of
+ * earlier chunks. We keep the last 32k of output as history for that.
+ */
+var inflateLengthBase = [3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                         35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258];
+var inflateLengthExtra = [0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                          3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0];
+var inflateDistBase = [1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                       257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                       8193, 12289, 16385, 24577];
+var inflateDistExtra = [0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13];
+var inflateCodeLengthOrder = [16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15];
+var inflateFixedLit = null;
+var inflateFixedDist = null;
+
+function inflateBuildTable(lengths, offset, n)
+{
+    var count = new Uint16Array(16);
+    var next = new Uint16Array(16);
+    var maxLen = 0;
+    var code, len, i, j;
+
+    for (i = 0; i < n; i++) {
+        len = lengths[offset + i];
+        count[len]++;
+        if (len > maxLen)
+            maxLen = len;
+    }
+    count[0] = 0;
+
+    code = 0;
+    for (len = 1; len < 16; len++) {
+        code = (code + count[len - 1]) << 1;
+        next[len] = code;
+    }
+
+    var table = new Uint32Array(1 << maxLen);
+    for (i = 0; i < n; i++) {
+        len = lengths[offset + i];
+        if (len == 0)
+            continue;
+
+        /* Huffman codes are packed starting with the MSB */
+        code = next[len]++;
+        var reversed = 0;
+        for (j = 0; j < len; j++) {
+            reversed = (reversed << 1) | (code & 1);
+            code >>= 1;
+        }
+        for (j = reversed; j < table.length; j += 1 << len)
+            table[j] = (len << 16) | i;
+    }
+
+    return { table: table, mask: (1 << maxLen) - 1, maxLen: maxLen };
+}
+
+function Inflater()
+{
+    this.history = new Uint8Array(0);
+}
+
+Inflater.prototype.fill = function(n) {
+    while (this.bitcnt < n && this.pos < this.input.length) {
+        this.bitbuf |= this.input[this.pos++] << this.bitcnt;
+        this.bitcnt += 8;
+    }
+};
+
+Inflater.prototype.bits = function(n) {
+    this.fill(n);
+    if (this.bitcnt < n)
+        throw "inflate: truncated input";
+    var v = this.bitbuf & ((1 << n) - 1);
+    this.bitbuf >>>= n;
+    this.bitcnt -= n;
+    return v;
+};
+
+Inflater.prototype.decode = function(t) {
+    this.fill(t.maxLen);
+    var entry = t.table[this.bitbuf & t.mask];
+    var len = entry >>> 16;
+    if (len == 0 || len > this.bitcnt)
+        throw "inflate: invalid code";
+    this.bitbuf >>>= len;
+    this.bitcnt -= len;
+    return entry & 0xffff;
+};
+
+Inflater.prototype.reserve = function(n) {
+    if (this.outPos + n <= this.out.length)
+        return;
+    var size = this.out.length * 2;
+    while (size < this.outPos + n)
+        size *= 2;
+    var out = new Uint8Array(size);
+    out.set(this.out.subarray(0, this.outPos));
+    this.out = out;
+};
+
+Inflater.prototype.stored = function() {
+    /* Skip to the byte boundary and give back any whole bytes we prefetched */
+    this.pos -= this.bitcnt >> 3;
+    this.bitbuf = 0;
+    this.bitcnt = 0;
+
+    if (this.pos + 4 > this.input.length)
+        throw "inflate: truncated stored block";
+    var len = this.input[this.pos] | (this.input[this.pos + 1] << 8);
+    var nlen = this.input[this.pos + 2] | (this.input[this.pos + 3] << 8);
+    if (len != (~nlen & 0xffff))
+        throw "inflate: invalid stored block";
+    this.pos += 4;
+    if (this.pos + len > this.input.length)
+        throw "inflate: truncated stored block";
+
+    this.reserve(len);
+    this.out.set(this.input.subarray(this.pos, this.pos + len), this.outPos);
+    this.outPos += len;
+    this.pos += len;
+};
+
+Inflater.prototype.codes = function(lit, dist) {
+    for (;;) {
+        var sym = this.decode(lit);
+        if (sym < 256) {
+            this.reserve(1);
+            this.out[this.outPos++] = sym;
+        } else if (sym == 256) {
+            return;
+        } else {
+            sym -= 257;
+            if (sym >= 29)
+                throw "inflate: invalid length code";
+            var len = inflateLengthBase[sym] + this.bits(inflateLengthExtra[sym]);
+            sym = this.decode(dist);
+            if (sym >= 30)
+                throw "inflate: invalid distance code";
+            var d = inflateDistBase[sym] + this.bits(inflateDistExtra[sym]);
+            if (d > this.outPos)
+                throw "inflate: distance too far back";
+
+            this.reserve(len);
+            var out = this.out;
+            var p = this.outPos;
+            var end = p + len;
+            while (p < end) {
+                out[p] = out[p - d];
+                p++;
+            }
+            this.outPos = end;
+        }
+    }
+};
+
+Inflater.prototype.fixed = function() {
+    if (inflateFixedLit == null) {
+        var lengths = new Uint8Array(288 + 30);
+        var i;
+        for (i = 0; i < 144; i++)
+            lengths[i] = 8;
+        for (; i < 256; i++)
+            lengths[i] = 9;
+        for (; i < 280; i++)
+            lengths[i] = 7;
+        for (; i < 288; i++)
+            lengths[i] = 8;
+        for (; i < 288 + 30; i++)
+            lengths[i] = 5;
+        inflateFixedLit = inflateBuildTable(lengths, 0, 288);
+        inflateFixedDist = inflateBuildTable(lengths, 288, 30);
+    }
+    this.codes(inflateFixedLit, inflateFixedDist);
+};
+
+Inflater.prototype.dynamic = function() {
+    var nlen = this.bits(5) + 257;
+    var ndist = this.bits(5) + 1;
+    var ncode = this.bits(4) + 4;
+    var lengths = new Uint8Array(nlen + ndist);
+    var clengths = new Uint8Array(19);
+    var i, sym, rep, prev;
+
+    for (i = 0; i < ncode; i++)
+        clengths[inflateCodeLengthOrder[i]] = this.bits(3);
+    var clTable = inflateBuildTable(clengths, 0, 19);
+
+    i = 0;
+    while (i < nlen + ndist) {
+        sym = this.decode(clTable);
+        if (sym < 16) {
+            lengths[i++] = sym;
+            continue;
+        }
+
+        prev = 0;
+        if (sym == 16) {
+            if (i == 0)
+                throw "inflate: repeat with no previous length";
+            prev = lengths[i - 1];
+            rep = 3 + this.bits(2);
+        } else if (sym == 17) {
+            rep = 3 + this.bits(3);
+        } else {
+            rep = 11 + this.bits(7);
+        }
+        if (i + rep > nlen + ndist)
+            throw "inflate: too many lengths";
+        while (rep--)
+            lengths[i++] = prev;
+    }
+
+    this.codes(inflateBuildTable(lengths, 0, nlen),
+               inflateBuildTable(lengths, nlen, ndist));
+};
+
+Inflater.prototype.inflate = function(input) {
+    var history = this.history;
+
+    this.input = input;
+    this.pos = 0;
+    this.bitbuf = 0;
+    this.bitcnt = 0;
+    this.out = new Uint8Array(history.length + Math.max(input.length * 4, 4096));
+    this.out.set(history);
+    this.outPos = history.length;
+
+    /* A sync flush always ends with an empty stored block, so we're
+     * done once every input byte has been consumed. */
+    while (this.pos - (this.bitcnt >> 3) < input.length) {
+        this.bits(1); /* BFINAL, never set since the stream is never finished */
+        var type = this.bits(2);
+        if (type == 0)
+            this.stored();
+        else if (type == 1)
+            this.fixed();
+        else if (type == 2)
+            this.dynamic();
+        else
+            throw "inflate: invalid block type";
+    }
+
+    var data = this.out.subarray(history.length, this.outPos);
+    this.history = new Uint8Array(this.out.subarray(Math.max(0, this.outPos - 32768), this.outPos));
+    this.input = null;
+    this.out = null;
+
+    return data;
+};
@@ -16,7 +16,10 @@ gdk__private__ (void)
     gdk_display_get_rendering_mode,
     gdk_display_set_rendering_mode,
     gdk_display_get_debug_updates,
-    gdk_display_set_debug_updates
+    gdk_display_set_debug_updates,
+    gdk_pixel_recolor_symbolic,
+    gdk_display_set_update_coalescing,
+    gdk_display_get_update_coalescing
   };
 
   return &table;
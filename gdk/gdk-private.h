@@ -3,6 +3,7 @@
 
 #include <gdk/gdk.h>
 #include "gdk/gdkinternals.h"
+#include "gdk/gdkpixelconvertprivate.h"
 
 #define GDK_PRIVATE_CALL(symbol)        (gdk__private__ ()->symbol)
 
@@ -31,6 +32,13 @@ gboolean         gdk_display_get_debug_updates (GdkDisplay *display);
 void             gdk_display_set_debug_updates (GdkDisplay *display,
                                                 gboolean    debug_updates);
 
+void             gdk_display_set_update_coalescing (GdkDisplay *display,
+                                                    guint       overdraw,
+                                                    guint       max_rects);
+void             gdk_display_get_update_coalescing (GdkDisplay *display,
+                                                    guint      *overdraw,
+                                                    guint      *max_rects);
+
 typedef struct {
   /* add all private functions here, initialize them in gdk-private.c */
   gboolean (* gdk_device_grab_info) (GdkDisplay  *display,
@@ -56,6 +64,19 @@ typedef struct {
   gboolean         (* gdk_display_get_debug_updates) (GdkDisplay *display);
   void             (* gdk_display_set_debug_updates) (GdkDisplay *display,
                                                       gboolean    debug_updates);
+
+  void (* gdk_pixel_recolor_symbolic) (guint8       *dest,
+                                       const guint8 *src,
+                                       int           n_pixels,
+                                       const guint8  colors[4][4],
+                                       int           alpha);
+
+  void (* gdk_display_set_update_coalescing) (GdkDisplay *display,
+                                              guint       overdraw,
+                                              guint       max_rects);
+  void (* gdk_display_get_update_coalescing) (GdkDisplay *display,
+                                              guint      *overdraw,
+                                              guint      *max_rects);
 } GdkPrivateVTable;
 
 GDK_AVAILABLE_IN_ALL
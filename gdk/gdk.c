@@ -36,6 +36,7 @@
 #include "gdkkeysyms.h"
 #endif
 
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -270,6 +271,7 @@ void
 gdk_pre_parse (void)
 {
   const char *rendering_mode;
+  const char *update_coalesce;
   const gchar *gl_string;
 
   gdk_initialized = TRUE;
@@ -304,6 +306,21 @@ gdk_pre_parse (void)
       g_unsetenv ("GDK_NATIVE_WINDOWS");
     }
 
+  /* "overdraw,max-rects", see gdk_display_set_update_coalescing().
+   * Update areas are left exactly as invalidated unless this is set.
+   */
+  update_coalesce = g_getenv ("GDK_UPDATE_COALESCE");
+  if (update_coalesce)
+    {
+      guint overdraw, max_rects;
+
+      if (sscanf (update_coalesce, "%u,%u", &overdraw, &max_rects) == 2)
+        {
+          _gdk_update_overdraw = MIN (overdraw, 100);
+          _gdk_update_max_rects = max_rects;
+        }
+    }
+
   rendering_mode = g_getenv ("GDK_RENDERING");
   if (rendering_mode)
     {
@@ -20,6 +20,7 @@
 #include "gdkcairo.h"
 
 #include "gdkinternals.h"
+#include "gdkpixelconvertprivate.h"
 
 #include <math.h>
 
@@ -232,32 +233,7 @@ gdk_cairo_surface_paint_pixbuf (cairo_surface_t *surface,
             }
         }
       else
-        {
-          guchar *end = p + 4 * width;
-          guint t1,t2,t3;
-
-#define MULT(d,c,a,t) G_STMT_START { t = c * a + 0x80; d = ((t >> 8) + t) >> 8; } G_STMT_END
-
-          while (p < end)
-            {
-#if G_BYTE_ORDER == G_LITTLE_ENDIAN
-              MULT(q[0], p[2], p[3], t1);
-              MULT(q[1], p[1], p[3], t2);
-              MULT(q[2], p[0], p[3], t3);
-              q[3] = p[3];
-#else
-              q[0] = p[3];
-              MULT(q[1], p[0], p[3], t1);
-              MULT(q[2], p[1], p[3], t2);
-              MULT(q[3], p[2], p[3], t3);
-#endif
-
-              p += 4;
-              q += 4;
-            }
-
-#undef MULT
-        }
+        gdk_pixel_premultiply ((guint32 *) q, p, width);
 
       gdk_pixels += gdk_rowstride;
       cairo_pixels += cairo_stride;
@@ -225,6 +225,8 @@ gdk_display_init (GdkDisplay *display)
                                                         (GDestroyNotify) g_free);
 
   display->rendering_mode = _gdk_rendering_mode;
+  display->update_overdraw = _gdk_update_overdraw;
+  display->update_max_rects = _gdk_update_max_rects;
 }
 
 static void
@@ -2317,3 +2319,26 @@ gdk_display_get_debug_updates (GdkDisplay *display)
   else
     return _gdk_debug_updates;
 }
+
+/* @overdraw is how much of the bounding box of an update area, in
+ * percent, may be outside the area before it is replaced by the
+ * bounding box. @max_rects limits the number of rectangles in it.
+ * 0 turns either off.
+ */
+void
+gdk_display_set_update_coalescing (GdkDisplay *display,
+                                   guint       overdraw,
+                                   guint       max_rects)
+{
+  display->update_overdraw = MIN (overdraw, 100);
+  display->update_max_rects = max_rects;
+}
+
+void
+gdk_display_get_update_coalescing (GdkDisplay *display,
+                                   guint      *overdraw,
+                                   guint      *max_rects)
+{
+  *overdraw = display->update_overdraw;
+  *max_rects = display->update_max_rects;
+}
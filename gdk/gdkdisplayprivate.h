@@ -125,6 +125,10 @@ struct _GdkDisplay
   guint debug_updates_set : 1;
 
   GdkRenderingMode rendering_mode;
+
+  /* How update areas are simplified, see coalesce_update_area() */
+  guint update_overdraw;
+  guint update_max_rects;
 };
 
 struct _GdkDisplayClass
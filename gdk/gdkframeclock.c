@@ -518,6 +518,10 @@ _gdk_frame_clock_debug_print_timings (GdkFrameClock   *clock,
     g_print (" predicted=%-4.1f", (timings->predicted_presentation_time - timings->frame_time) / 1000.);
   if (timings->refresh_interval != 0)
     g_print (" refresh_interval=%-4.1f", timings->refresh_interval / 1000.);
+  if (timings->update_rects_added != 0)
+    g_print (" update_rects=%u/%u (coalesced %u) update_pixels=%" G_GINT64_FORMAT,
+             timings->update_rects, timings->update_rects_added,
+             timings->update_coalesced, timings->update_pixels);
   g_print ("\n");
 }
 #endif /* G_ENABLE_DEBUG */
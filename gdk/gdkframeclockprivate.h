@@ -98,6 +98,12 @@ struct _GdkFrameTimings
   gint64 layout_start_time;
   gint64 paint_start_time;
   gint64 frame_end_time;
+
+  /* Complexity of the update areas painted in this frame */
+  guint update_rects;
+  guint update_rects_added;
+  guint update_coalesced;
+  gint64 update_pixels;
 #endif /* G_ENABLE_DEBUG */
 
   guint complete : 1;
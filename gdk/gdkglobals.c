@@ -36,3 +36,5 @@ gchar              *_gdk_display_arg_name = NULL;
 gboolean            _gdk_disable_multidevice = FALSE;
 guint               _gdk_gl_flags = 0;
 GdkRenderingMode    _gdk_rendering_mode = GDK_RENDERING_MODE_SIMILAR;
+guint               _gdk_update_overdraw = 0;
+guint               _gdk_update_max_rects = 0;
@@ -109,6 +109,8 @@ extern GdkWindow        *_gdk_parent_root;
 extern guint _gdk_debug_flags;
 extern guint _gdk_gl_flags;
 extern GdkRenderingMode    _gdk_rendering_mode;
+extern guint _gdk_update_overdraw;
+extern guint _gdk_update_max_rects;
 extern gboolean _gdk_debug_updates;
 
 #ifdef G_ENABLE_DEBUG
@@ -305,6 +307,10 @@ struct _GdkWindow
 
   cairo_region_t *update_area;
   guint update_freeze_count;
+  /* Rectangles added to update_area, and how often it was simplified,
+     since the last update */
+  guint update_rects_added;
+  guint update_coalesced;
   /* This is the update_area that was in effect when the current expose
      started. It may be smaller than the expose area if we'e painting
      more than we have to, but it represents the "true" damage. */
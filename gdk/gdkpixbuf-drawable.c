@@ -26,6 +26,7 @@
 
 #include "gdkwindow.h"
 #include "gdkinternals.h"
+#include "gdkpixelconvertprivate.h"
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 
@@ -158,30 +159,12 @@ convert_alpha (guchar *dest_data,
                int     width,
                int     height)
 {
-  int x, y;
+  int y;
 
   src_data += src_stride * src_y + src_x * 4;
 
   for (y = 0; y < height; y++) {
-    guint32 *src = (guint32 *) src_data;
-
-    for (x = 0; x < width; x++) {
-      guint alpha = src[x] >> 24;
-
-      if (alpha == 0)
-        {
-          dest_data[x * 4 + 0] = 0;
-          dest_data[x * 4 + 1] = 0;
-          dest_data[x * 4 + 2] = 0;
-        }
-      else
-        {
-          dest_data[x * 4 + 0] = (((src[x] & 0xff0000) >> 16) * 255 + alpha / 2) / alpha;
-          dest_data[x * 4 + 1] = (((src[x] & 0x00ff00) >>  8) * 255 + alpha / 2) / alpha;
-          dest_data[x * 4 + 2] = (((src[x] & 0x0000ff) >>  0) * 255 + alpha / 2) / alpha;
-        }
-      dest_data[x * 4 + 3] = alpha;
-    }
+    gdk_pixel_unpremultiply_to_rgba (dest_data, (guint32 *) src_data, width);
 
     src_data += src_stride;
     dest_data += dest_stride;
@@ -198,18 +181,12 @@ convert_no_alpha (guchar *dest_data,
                   int     width,
                   int     height)
 {
-  int x, y;
+  int y;
 
   src_data += src_stride * src_y + src_x * 4;
 
   for (y = 0; y < height; y++) {
-    guint32 *src = (guint32 *) src_data;
-
-    for (x = 0; x < width; x++) {
-      dest_data[x * 3 + 0] = src[x] >> 16;
-      dest_data[x * 3 + 1] = src[x] >>  8;
-      dest_data[x * 3 + 2] = src[x];
-    }
+    gdk_pixel_argb_to_rgb (dest_data, (guint32 *) src_data, width);
 
     src_data += src_stride;
     dest_data += dest_stride;
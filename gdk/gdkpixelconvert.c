@@ -0,0 +1,532 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdkpixelconvertprivate.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_SSE2_KERNELS 1
+#include <emmintrin.h>
+#endif
+
+/* The SIMD kernels must give exactly the same results as the generic
+ * ones, bit for bit, for all inputs. testsuite/gdk/pixelconvert.c
+ * checks that.
+ */
+
+typedef struct {
+  const char *name;
+  void (* premultiply)           (guint32 *, const guint8 *, int);
+  void (* unpremultiply)         (guint32 *, const guint32 *, int);
+  void (* unpremultiply_to_rgba) (guint8 *, const guint32 *, int);
+  void (* argb_to_rgb)           (guint8 *, const guint32 *, int);
+  void (* recolor_symbolic)      (guint8 *, const guint8 *, int, const guint8 [4][4], int);
+} PixelKernels;
+
+/************************************************************************
+ *                Generic kernels                                       *
+ ************************************************************************/
+
+#define MULT(d,c,a,t) G_STMT_START { t = c * a + 0x80; d = ((t >> 8) + t) >> 8; } G_STMT_END
+
+static void
+premultiply_generic (guint32      *dest,
+                     const guint8 *src,
+                     int           n_pixels)
+{
+  guint r, g, b, a, t;
+  int i;
+
+  for (i = 0; i < n_pixels; i++)
+    {
+      a = src[3];
+      MULT (r, src[0], a, t);
+      MULT (g, src[1], a, t);
+      MULT (b, src[2], a, t);
+      dest[i] = a << 24 | r << 16 | g << 8 | b;
+      src += 4;
+    }
+}
+
+#undef MULT
+
+static inline guint32
+unpremultiply_pixel (guint32 pixel)
+{
+  guint8 alpha, r, g, b;
+
+  alpha = pixel >> 24;
+
+  if (alpha == 0xff)
+    return pixel;
+  if (alpha == 0)
+    return 0;
+
+  r = (((pixel & 0xff0000) >> 16) * 255 + alpha / 2) / alpha;
+  g = (((pixel & 0x00ff00) >>  8) * 255 + alpha / 2) / alpha;
+  b = (((pixel & 0x0000ff) >>  0) * 255 + alpha / 2) / alpha;
+
+  return (guint32)alpha << 24 | (guint32)r << 16 | (guint32)g << 8 | (guint32)b;
+}
+
+static void
+unpremultiply_generic (guint32       *dest,
+                       const guint32 *src,
+                       int            n_pixels)
+{
+  int i;
+
+  for (i = 0; i < n_pixels; i++)
+    dest[i] = unpremultiply_pixel (src[i]);
+}
+
+static void
+unpremultiply_to_rgba_generic (guint8        *dest,
+                               const guint32 *src,
+                               int            n_pixels)
+{
+  guint32 pixel;
+  int i;
+
+  for (i = 0; i < n_pixels; i++)
+    {
+      pixel = unpremultiply_pixel (src[i]);
+      dest[0] = pixel >> 16;
+      dest[1] = pixel >> 8;
+      dest[2] = pixel;
+      dest[3] = pixel >> 24;
+      dest += 4;
+    }
+}
+
+static void
+argb_to_rgb_generic (guint8        *dest,
+                     const guint32 *src,
+                     int            n_pixels)
+{
+  int i;
+
+  for (i = 0; i < n_pixels; i++)
+    {
+      dest[0] = src[i] >> 16;
+      dest[1] = src[i] >>  8;
+      dest[2] = src[i];
+      dest += 3;
+    }
+}
+
+/* Symbolic icons are rendered with the success, warning and error
+ * colors replaced by pure red, green and blue, and the foreground by
+ * black. This maps each pixel back to a mix of the real colors.
+ */
+static void
+recolor_symbolic_generic (guint8       *dest,
+                          const guint8 *src,
+                          int           n_pixels,
+                          const guint8  colors[4][4],
+                          int           alpha)
+{
+  guint r, g, b, a;
+  int c1, c2, c3, c4;
+  int i;
+
+  for (i = 0; i < n_pixels; i++)
+    {
+      a = src[3];
+      dest[3] = a * alpha / 255;
+
+      if (a == 0)
+        {
+          dest[0] = 0;
+          dest[1] = 0;
+          dest[2] = 0;
+        }
+      else
+        {
+          c2 = src[0];
+          c3 = src[1];
+          c4 = src[2];
+
+          if (c2 == 0 && c3 == 0 && c4 == 0)
+            {
+              dest[0] = colors[0][0];
+              dest[1] = colors[0][1];
+              dest[2] = colors[0][2];
+            }
+          else
+            {
+              c1 = 255 - c2 - c3 - c4;
+
+              r = colors[0][0] * c1 + colors[1][0] * c2 + colors[2][0] * c3 + colors[3][0] * c4;
+              g = colors[0][1] * c1 + colors[1][1] * c2 + colors[2][1] * c3 + colors[3][1] * c4;
+              b = colors[0][2] * c1 + colors[1][2] * c2 + colors[2][2] * c3 + colors[3][2] * c4;
+
+              dest[0] = r / 255;
+              dest[1] = g / 255;
+              dest[2] = b / 255;
+            }
+        }
+
+      src += 4;
+      dest += 4;
+    }
+}
+
+static const PixelKernels generic_kernels = {
+  "generic",
+  premultiply_generic,
+  unpremultiply_generic,
+  unpremultiply_to_rgba_generic,
+  argb_to_rgb_generic,
+  recolor_symbolic_generic
+};
+
+/************************************************************************
+ *                SSE2 kernels                                          *
+ ************************************************************************/
+
+#ifdef HAVE_SSE2_KERNELS
+
+#define SSE2 __attribute__((target ("sse2")))
+
+/* x / 255 for 0 <= x <= 255 * 255, in 32 bit lanes */
+static inline SSE2 __m128i
+div255_epi32 (__m128i x)
+{
+  x = _mm_add_epi32 (x, _mm_set1_epi32 (1));
+  return _mm_srli_epi32 (_mm_add_epi32 (x, _mm_srli_epi32 (x, 8)), 8);
+}
+
+static SSE2 void
+premultiply_sse2 (guint32      *dest,
+                  const guint8 *src,
+                  int           n_pixels)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i bias = _mm_set1_epi16 (0x80);
+  const __m128i alpha_mask = _mm_set_epi16 (-1, 0, 0, 0, -1, 0, 0, 0);
+  __m128i v, lo, hi, a;
+  int i;
+
+  for (i = 0; i + 4 <= n_pixels; i += 4)
+    {
+      v = _mm_loadu_si128 ((const __m128i *)(src + 4 * i));
+
+      /* 16 bits per channel, two pixels per register */
+      lo = _mm_unpacklo_epi8 (v, zero);
+      hi = _mm_unpackhi_epi8 (v, zero);
+
+#define MULT(x) G_STMT_START {                                                  \
+      a = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (x, _MM_SHUFFLE (3, 3, 3, 3)), \
+                               _MM_SHUFFLE (3, 3, 3, 3));                       \
+      a = _mm_add_epi16 (_mm_mullo_epi16 (x, a), bias);                         \
+      a = _mm_srli_epi16 (_mm_add_epi16 (a, _mm_srli_epi16 (a, 8)), 8);         \
+      x = _mm_or_si128 (_mm_andnot_si128 (alpha_mask, a),                       \
+                        _mm_and_si128 (alpha_mask, x));                         \
+      /* RGBA -> BGRA, which is ARGB in a little endian word */                 \
+      x = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (x, _MM_SHUFFLE (3, 0, 1, 2)), \
+                               _MM_SHUFFLE (3, 0, 1, 2));                       \
+    } G_STMT_END
+
+      MULT (lo);
+      MULT (hi);
+
+#undef MULT
+
+      _mm_storeu_si128 ((__m128i *)(dest + i), _mm_packus_epi16 (lo, hi));
+    }
+
+  premultiply_generic (dest + i, src + 4 * i, n_pixels - i);
+}
+
+/* Unpremultiplies 4 pixels into separate channels, with 32 bits each.
+ *
+ * The quotient of two integers below 2^24, rounded to the nearest float,
+ * truncates to the exact integer quotient, so this gives the same
+ * results as the integer division in the generic code. Channels that
+ * are larger than alpha wrap around the same way, too.
+ */
+static inline SSE2 void
+unpremultiply_4 (const guint32 *src,
+                 __m128i       *a,
+                 __m128i       *r,
+                 __m128i       *g,
+                 __m128i       *b)
+{
+  const __m128i mask = _mm_set1_epi32 (0xff);
+  __m128i v, half, zero_alpha;
+  __m128 alpha;
+
+  v = _mm_loadu_si128 ((const __m128i *)src);
+
+  *a = _mm_srli_epi32 (v, 24);
+  half = _mm_srli_epi32 (*a, 1);
+  alpha = _mm_cvtepi32_ps (*a);
+  zero_alpha = _mm_cmpeq_epi32 (*a, _mm_setzero_si128 ());
+
+#define DIV(c, shift) G_STMT_START {                                            \
+      c = _mm_and_si128 (_mm_srli_epi32 (v, shift), mask);                      \
+      c = _mm_add_epi32 (_mm_sub_epi32 (_mm_slli_epi32 (c, 8), c), half);       \
+      c = _mm_cvttps_epi32 (_mm_div_ps (_mm_cvtepi32_ps (c), alpha));           \
+      c = _mm_andnot_si128 (zero_alpha, _mm_and_si128 (c, mask));               \
+    } G_STMT_END
+
+  DIV (*r, 16);
+  DIV (*g, 8);
+  DIV (*b, 0);
+
+#undef DIV
+}
+
+static SSE2 void
+unpremultiply_sse2 (guint32       *dest,
+                    const guint32 *src,
+                    int            n_pixels)
+{
+  __m128i a, r, g, b;
+  int i;
+
+  for (i = 0; i + 4 <= n_pixels; i += 4)
+    {
+      unpremultiply_4 (src + i, &a, &r, &g, &b);
+
+      a = _mm_or_si128 (_mm_or_si128 (_mm_slli_epi32 (a, 24), _mm_slli_epi32 (r, 16)),
+                        _mm_or_si128 (_mm_slli_epi32 (g, 8), b));
+      _mm_storeu_si128 ((__m128i *)(dest + i), a);
+    }
+
+  unpremultiply_generic (dest + i, src + i, n_pixels - i);
+}
+
+static SSE2 void
+unpremultiply_to_rgba_sse2 (guint8        *dest,
+                            const guint32 *src,
+                            int            n_pixels)
+{
+  __m128i a, r, g, b;
+  int i;
+
+  for (i = 0; i + 4 <= n_pixels; i += 4)
+    {
+      unpremultiply_4 (src + i, &a, &r, &g, &b);
+
+      a = _mm_or_si128 (_mm_or_si128 (_mm_slli_epi32 (a, 24), _mm_slli_epi32 (b, 16)),
+                        _mm_or_si128 (_mm_slli_epi32 (g, 8), r));
+      _mm_storeu_si128 ((__m128i *)(dest + 4 * i), a);
+    }
+
+  unpremultiply_to_rgba_generic (dest + 4 * i, src + i, n_pixels - i);
+}
+
+static SSE2 void
+recolor_symbolic_sse2 (guint8       *dest,
+                       const guint8 *src,
+                       int           n_pixels,
+                       const guint8  colors[4][4],
+                       int           alpha)
+{
+  const __m128i mask = _mm_set1_epi32 (0xff);
+  __m128i v, a, c1, c2, c3, c4, r, g, b, zero_alpha;
+  __m128i color[4][3];
+  __m128i alpha_v;
+  int i, j, k;
+
+  if (alpha < 0 || alpha > 255)
+    {
+      recolor_symbolic_generic (dest, src, n_pixels, colors, alpha);
+      return;
+    }
+
+  for (j = 0; j < 4; j++)
+    for (k = 0; k < 3; k++)
+      color[j][k] = _mm_set1_epi32 (colors[j][k]);
+  alpha_v = _mm_set1_epi32 (alpha);
+
+  for (i = 0; i + 4 <= n_pixels; i += 4)
+    {
+      v = _mm_loadu_si128 ((const __m128i *)(src + 4 * i));
+
+      c2 = _mm_and_si128 (v, mask);
+      c3 = _mm_and_si128 (_mm_srli_epi32 (v, 8), mask);
+      c4 = _mm_and_si128 (_mm_srli_epi32 (v, 16), mask);
+      a = _mm_srli_epi32 (v, 24);
+      c1 = _mm_sub_epi32 (_mm_sub_epi32 (mask, c2), _mm_add_epi32 (c3, c4));
+
+      /* Out of range input is rare and wraps around in the generic code */
+      if (_mm_movemask_ps (_mm_castsi128_ps (c1)) != 0)
+        {
+          recolor_symbolic_generic (dest + 4 * i, src + 4 * i, 4, colors, alpha);
+          continue;
+        }
+
+      /* All values fit in 16 bits, so this is an exact 32 bit multiply */
+#define MIX(k) div255_epi32 (_mm_add_epi32 (_mm_add_epi32 (_mm_madd_epi16 (c1, color[0][k]),   \
+                                                           _mm_madd_epi16 (c2, color[1][k])),  \
+                                            _mm_add_epi32 (_mm_madd_epi16 (c3, color[2][k]),   \
+                                                           _mm_madd_epi16 (c4, color[3][k]))))
+
+      r = MIX (0);
+      g = MIX (1);
+      b = MIX (2);
+
+#undef MIX
+
+      zero_alpha = _mm_cmpeq_epi32 (a, _mm_setzero_si128 ());
+      a = div255_epi32 (_mm_madd_epi16 (a, alpha_v));
+
+      v = _mm_or_si128 (_mm_or_si128 (r, _mm_slli_epi32 (g, 8)),
+                        _mm_slli_epi32 (b, 16));
+      v = _mm_or_si128 (_mm_andnot_si128 (zero_alpha, v),
+                        _mm_slli_epi32 (a, 24));
+      _mm_storeu_si128 ((__m128i *)(dest + 4 * i), v);
+    }
+
+  recolor_symbolic_generic (dest + 4 * i, src + 4 * i, n_pixels - i, colors, alpha);
+}
+
+#undef SSE2
+
+static const PixelKernels sse2_kernels = {
+  "sse2",
+  premultiply_sse2,
+  unpremultiply_sse2,
+  unpremultiply_to_rgba_sse2,
+  argb_to_rgb_generic,
+  recolor_symbolic_sse2
+};
+
+static gboolean
+have_sse2 (void)
+{
+#if defined(__x86_64__)
+  return TRUE;
+#else
+  __builtin_cpu_init ();
+  return __builtin_cpu_supports ("sse2");
+#endif
+}
+
+#endif /* HAVE_SSE2_KERNELS */
+
+/************************************************************************
+ *                Dispatch                                              *
+ ************************************************************************/
+
+static const PixelKernels *kernels;
+
+static const PixelKernels *
+get_kernels (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      kernels = &generic_kernels;
+#ifdef HAVE_SSE2_KERNELS
+      if (have_sse2 ())
+        kernels = &sse2_kernels;
+#endif
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return kernels;
+}
+
+/* Converts RGBA pixels to premultiplied ARGB32 */
+void
+gdk_pixel_premultiply (guint32      *dest,
+                       const guint8 *src,
+                       int           n_pixels)
+{
+  get_kernels ()->premultiply (dest, src, n_pixels);
+}
+
+/* Converts premultiplied ARGB32 pixels to non-premultiplied ARGB32.
+ * @dest and @src may be the same.
+ */
+void
+gdk_pixel_unpremultiply (guint32       *dest,
+                         const guint32 *src,
+                         int            n_pixels)
+{
+  get_kernels ()->unpremultiply (dest, src, n_pixels);
+}
+
+/* Converts premultiplied ARGB32 pixels to RGBA */
+void
+gdk_pixel_unpremultiply_to_rgba (guint8        *dest,
+                                 const guint32 *src,
+                                 int            n_pixels)
+{
+  get_kernels ()->unpremultiply_to_rgba (dest, src, n_pixels);
+}
+
+/* Converts RGB24 or opaque ARGB32 pixels to RGB */
+void
+gdk_pixel_argb_to_rgb (guint8        *dest,
+                       const guint32 *src,
+                       int            n_pixels)
+{
+  get_kernels ()->argb_to_rgb (dest, src, n_pixels);
+}
+
+/* Replaces the colors of a rendered symbolic icon. @colors are the
+ * foreground, success, warning and error colors as RGBA, and the alpha
+ * of the result is scaled by @alpha / 255.
+ */
+void
+gdk_pixel_recolor_symbolic (guint8       *dest,
+                            const guint8 *src,
+                            int           n_pixels,
+                            const guint8  colors[4][4],
+                            int           alpha)
+{
+  get_kernels ()->recolor_symbolic (dest, src, n_pixels, colors, alpha);
+}
+
+const char *
+gdk_pixel_get_kernels (void)
+{
+  return get_kernels ()->name;
+}
+
+/* For tests and benchmarks. Returns %FALSE if the kernels don't
+ * exist or don't work on this CPU.
+ */
+gboolean
+gdk_pixel_set_kernels (const char *name)
+{
+  get_kernels ();
+
+  if (strcmp (name, generic_kernels.name) == 0)
+    {
+      kernels = &generic_kernels;
+      return TRUE;
+    }
+
+#ifdef HAVE_SSE2_KERNELS
+  if (strcmp (name, sse2_kernels.name) == 0 && have_sse2 ())
+    {
+      kernels = &sse2_kernels;
+      return TRUE;
+    }
+#endif
+
+  return FALSE;
+}
@@ -0,0 +1,57 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Uninstalled header, internal to GDK.
+ *
+ * This only depends on GLib, so that broadwayd and the tests can build
+ * gdkpixelconvert.c directly.
+ */
+
+#ifndef __GDK_PIXEL_CONVERT_PRIVATE_H__
+#define __GDK_PIXEL_CONVERT_PRIVATE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* ARGB32 pixels are native endian premultiplied cairo pixels, RGBA
+ * pixels are bytes in memory order, as in a GdkPixbuf with alpha.
+ */
+
+void        gdk_pixel_premultiply           (guint32       *dest,
+                                             const guint8  *src,
+                                             int            n_pixels);
+void        gdk_pixel_unpremultiply         (guint32       *dest,
+                                             const guint32 *src,
+                                             int            n_pixels);
+void        gdk_pixel_unpremultiply_to_rgba (guint8        *dest,
+                                             const guint32 *src,
+                                             int            n_pixels);
+void        gdk_pixel_argb_to_rgb           (guint8        *dest,
+                                             const guint32 *src,
+                                             int            n_pixels);
+void        gdk_pixel_recolor_symbolic      (guint8        *dest,
+                                             const guint8  *src,
+                                             int            n_pixels,
+                                             const guint8   colors[4][4],
+                                             int            alpha);
+
+const char *gdk_pixel_get_kernels           (void);
+gboolean    gdk_pixel_set_kernels           (const char    *name);
+
+G_END_DECLS
+
+#endif /* __GDK_PIXEL_CONVERT_PRIVATE_H__ */
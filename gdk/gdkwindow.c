@@ -3664,6 +3664,37 @@ gdk_window_update_native_shapes (GdkWindow *window)
     }
 }
 
+#ifdef G_ENABLE_DEBUG
+static void
+record_update_stats (GdkWindow *window)
+{
+  GdkFrameClock *clock;
+  GdkFrameTimings *timings;
+  cairo_region_t *region = window->active_update_area;
+  cairo_rectangle_int_t r;
+  int i, n;
+
+  clock = gdk_window_get_frame_clock (window);
+  if (clock == NULL)
+    return;
+
+  timings = gdk_frame_clock_get_current_timings (clock);
+  if (timings == NULL)
+    return;
+
+  n = cairo_region_num_rectangles (region);
+
+  timings->update_rects += n;
+  timings->update_rects_added += window->update_rects_added;
+  timings->update_coalesced += window->update_coalesced;
+  for (i = 0; i < n; i++)
+    {
+      cairo_region_get_rectangle (region, i, &r);
+      timings->update_pixels += (gint64) r.width * r.height;
+    }
+}
+#endif
+
 /* Process and remove any invalid area on the native window by creating
  * expose events for the window and all non-native descendants.
  */
@@ -3698,6 +3729,12 @@ gdk_window_process_updates_internal (GdkWindow *window)
       window->active_update_area = window->update_area;
       window->update_area = NULL;
 
+#ifdef G_ENABLE_DEBUG
+      record_update_stats (window);
+#endif
+      window->update_rects_added = 0;
+      window->update_coalesced = 0;
+
       if (gdk_window_is_viewable (window))
 	{
 	  cairo_region_t *expose_region;
@@ -4059,16 +4096,94 @@ draw_ugly_color (GdkWindow       *window,
   cairo_destroy (cr);
 }
 
+/* Update areas made of many small rectangles are expensive to clip to
+ * and to walk when processing updates, and painting a bit more than
+ * needed is usually cheaper. So merge them into their bounding box
+ * when that doesn't add too much area, and keep the number of
+ * rectangles bounded by merging neighbours.
+ */
+static void
+coalesce_update_area (GdkWindow *impl_window)
+{
+  GdkDisplay *display;
+  cairo_region_t *region, *merged;
+  cairo_rectangle_int_t extents, r, box;
+  gint64 area, extents_area;
+  int i, j, n, per_box;
+
+  region = impl_window->update_area;
+  n = cairo_region_num_rectangles (region);
+  if (n <= 1)
+    return;
+
+  display = gdk_window_get_display (impl_window);
+  cairo_region_get_extents (region, &extents);
+
+  if (display->update_overdraw > 0)
+    {
+      extents_area = (gint64) extents.width * extents.height;
+      area = 0;
+      for (i = 0; i < n; i++)
+        {
+          cairo_region_get_rectangle (region, i, &r);
+          area += (gint64) r.width * r.height;
+        }
+
+      if ((extents_area - area) * 100 <= extents_area * display->update_overdraw)
+        {
+          cairo_region_destroy (region);
+          impl_window->update_area = cairo_region_create_rectangle (&extents);
+          impl_window->update_coalesced++;
+          return;
+        }
+    }
+
+  if (display->update_max_rects > 0 &&
+      n > display->update_max_rects)
+    {
+      /* The rectangles are sorted in y-x bands, so runs of them
+       * are close to each other */
+      merged = cairo_region_create ();
+      per_box = (n + display->update_max_rects - 1) / display->update_max_rects;
+      for (i = 0; i < n; i += per_box)
+        {
+          cairo_region_get_rectangle (region, i, &box);
+          for (j = i + 1; j < MIN (i + per_box, n); j++)
+            {
+              cairo_region_get_rectangle (region, j, &r);
+              gdk_rectangle_union (&box, &r, &box);
+            }
+          cairo_region_union_rectangle (merged, &box);
+        }
+
+      if (cairo_region_num_rectangles (merged) > display->update_max_rects)
+        {
+          cairo_region_destroy (merged);
+          merged = cairo_region_create_rectangle (&extents);
+        }
+
+      cairo_region_destroy (region);
+      impl_window->update_area = merged;
+      impl_window->update_coalesced++;
+    }
+}
+
 static void
 impl_window_add_update_area (GdkWindow *impl_window,
 			     cairo_region_t *region)
 {
+  impl_window->update_rects_added += cairo_region_num_rectangles (region);
+
   if (impl_window->update_area)
-    cairo_region_union (impl_window->update_area, region);
+    {
+      cairo_region_union (impl_window->update_area, region);
+      coalesce_update_area (impl_window);
+    }
   else
     {
       gdk_window_add_update_window (impl_window);
       impl_window->update_area = cairo_region_copy (region);
+      coalesce_update_area (impl_window);
       gdk_window_schedule_update (impl_window);
     }
 }
@@ -46,6 +46,7 @@
 #include "deprecated/gtknumerableiconprivate.h"
 #include "gtksettingsprivate.h"
 #include "gtkprivate.h"
+#include "gdk/gdk-private.h"
 
 #undef GDK_DEPRECATED
 #undef GDK_DEPRECATED_FOR
@@ -4278,19 +4279,18 @@ color_symbolic_pixbuf (GdkPixbuf *symbolic,
                        const GdkRGBA  *warning_color,
                        const GdkRGBA  *error_color)
 {
-  int width, height, x, y, src_stride, dst_stride;
+  int width, height, y, src_stride, dst_stride;
   guchar *src_data, *dst_data;
-  guchar *src_row, *dst_row;
   int alpha;
   GdkPixbuf *colored;
-  guint8 fg_pixel[4], success_pixel[4], warning_pixel[4], error_pixel[4];
+  guint8 colors[4][4];
 
   alpha = fg_color->alpha * 255;
 
-  rgba_to_pixel (fg_color, fg_pixel);
-  rgba_to_pixel (success_color, success_pixel);
-  rgba_to_pixel (warning_color, warning_pixel);
-  rgba_to_pixel (error_color, error_pixel);
+  rgba_to_pixel (fg_color, colors[0]);
+  rgba_to_pixel (success_color, colors[1]);
+  rgba_to_pixel (warning_color, colors[2]);
+  rgba_to_pixel (error_color, colors[3]);
 
   width = gdk_pixbuf_get_width (symbolic);
   height = gdk_pixbuf_get_height (symbolic);
@@ -4304,53 +4304,9 @@ color_symbolic_pixbuf (GdkPixbuf *symbolic,
   dst_stride = gdk_pixbuf_get_rowstride (colored);
 
   for (y = 0; y < height; y++)
-    {
-      src_row = src_data + src_stride * y;
-      dst_row = dst_data + dst_stride * y;
-      for (x = 0; x < width; x++)
-        {
-          guint r, g, b, a;
-          int c1, c2, c3, c4;
-
-          a = src_row[3];
-          dst_row[3] = a * alpha / 255;
-
-          if (a == 0)
-            {
-              dst_row[0] = 0;
-              dst_row[1] = 0;
-              dst_row[2] = 0;
-            }
-          else
-            {
-              c2 = src_row[0];
-              c3 = src_row[1];
-              c4 = src_row[2];
-
-              if (c2 == 0 && c3 == 0 && c4 == 0)
-                {
-                  dst_row[0] = fg_pixel[0];
-                  dst_row[1] = fg_pixel[1];
-                  dst_row[2] = fg_pixel[2];
-                }
-              else
-                {
-                  c1 = 255 - c2 - c3 - c4;
-
-                  r = fg_pixel[0] * c1 + success_pixel[0] * c2 +  warning_pixel[0] * c3 +  error_pixel[0] * c4;
-                  g = fg_pixel[1] * c1 + success_pixel[1] * c2 +  warning_pixel[1] * c3 +  error_pixel[1] * c4;
-                  b = fg_pixel[2] * c1 + success_pixel[2] * c2 +  warning_pixel[2] * c3 +  error_pixel[2] * c4;
-
-                  dst_row[0] = r / 255;
-                  dst_row[1] = g / 255;
-                  dst_row[2] = b / 255;
-                }
-            }
-
-          src_row += 4;
-          dst_row += 4;
-        }
-    }
+    GDK_PRIVATE_CALL (gdk_pixel_recolor_symbolic) (dst_data + dst_stride * y,
+                                                   src_data + src_stride * y,
+                                                   width, (const guint8 (*)[4]) colors, alpha);
 
   return colored;
 }
@@ -223,6 +223,21 @@
  * the #GtkLabel::activate-link signal and the gtk_label_get_current_uri() function.
  */
 
+/* The sizes a wrapping label measured for the last few widths during
+ * height-for-width negotiation. Containers ask for the same widths
+ * over and over, e.g. for every row of a GtkListBox in every
+ * allocation pass, and each of them otherwise has to break the text
+ * into lines again.
+ */
+#define N_CACHED_SIZES 4
+
+typedef struct
+{
+  gint width;     /* in Pango units */
+  gint height;    /* in pixels */
+  gint baseline;  /* in pixels */
+} GtkLabelCachedSize;
+
 struct _GtkLabelPrivate
 {
   GtkLabelSelectionInfo *select_info;
@@ -255,9 +270,21 @@ struct _GtkLabelPrivate
   guint    wrap_mode          : 3;
   guint    pattern_set        : 1;
   guint    track_links        : 1;
+  guint    have_preferred_layout_size : 1;
+  guint    markup_pending     : 1;
 
   guint    mnemonic_keyval;
 
+  /* Valid as long as the layout is not cleared and the serial of
+   * the widget's Pango context doesn't change.
+   */
+  guint    size_cache_serial;
+  guint    n_cached_sizes;
+  guint    next_cached_size;
+  GtkLabelCachedSize cached_sizes[N_CACHED_SIZES];
+  PangoRectangle     cached_smallest;
+  PangoRectangle     cached_widest;
+
   gint     width_chars;
   gint     max_width_chars;
   gint     lines;
@@ -424,6 +451,7 @@ static void gtk_label_set_pattern_internal       (GtkLabel      *label,
 static void gtk_label_set_markup_internal        (GtkLabel      *label,
 						  const gchar   *str,
 						  gboolean       with_uline);
+static void gtk_label_ensure_markup              (GtkLabel      *label);
 static void gtk_label_recalculate                (GtkLabel      *label);
 static void gtk_label_hierarchy_changed          (GtkWidget     *widget,
 						  GtkWidget     *old_toplevel);
@@ -437,6 +465,7 @@ static void gtk_label_ensure_select_info  (GtkLabel *label);
 static void gtk_label_clear_select_info   (GtkLabel *label);
 static void gtk_label_update_cursor       (GtkLabel *label);
 static void gtk_label_clear_layout        (GtkLabel *label);
+static void gtk_label_clear_size_cache    (GtkLabel *label);
 static void gtk_label_ensure_layout       (GtkLabel *label);
 static void gtk_label_select_region_index (GtkLabel *label,
                                            gint      anchor_index,
@@ -2177,6 +2206,7 @@ gtk_label_recalculate (GtkLabel *label)
   guint keyval = priv->mnemonic_keyval;
 
   gtk_label_clear_links (label);
+  priv->markup_pending = FALSE;
 
   if (priv->use_markup)
     gtk_label_set_markup_internal (label, priv->label, priv->use_underline);
@@ -2597,10 +2627,78 @@ gtk_label_ensure_has_tooltip (GtkLabel *label)
   gtk_widget_set_has_tooltip (GTK_WIDGET (label), has_tooltip);
 }
 
+/* Parsing the same markup over and over is common in lists, where
+ * many rows have labels with the same formatting. The results of
+ * parsing short markup without mnemonics are kept in a cache shared
+ * by all labels. The attribute lists are not modified after parsing,
+ * so labels can share them.
+ */
+#define MARKUP_CACHE_SIZE 256
+#define MARKUP_CACHE_MAX_LENGTH 256
+
+typedef struct
+{
+  gchar *text;
+  PangoAttrList *attrs;
+} GtkLabelParsedMarkup;
+
+static GHashTable *markup_cache = NULL;
+
 static void
-gtk_label_set_markup_internal (GtkLabel    *label,
-                               const gchar *str,
-                               gboolean     with_uline)
+parsed_markup_free (GtkLabelParsedMarkup *parsed)
+{
+  g_free (parsed->text);
+  if (parsed->attrs)
+    pango_attr_list_unref (parsed->attrs);
+  g_slice_free (GtkLabelParsedMarkup, parsed);
+}
+
+static gboolean
+parse_markup_cached (const gchar    *str,
+                     PangoAttrList **attrs,
+                     gchar         **text,
+                     GError        **error)
+{
+  GtkLabelParsedMarkup *parsed;
+
+  if (G_UNLIKELY (markup_cache == NULL))
+    markup_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                          g_free, (GDestroyNotify) parsed_markup_free);
+
+  parsed = g_hash_table_lookup (markup_cache, str);
+  if (parsed)
+    {
+      *attrs = parsed->attrs ? pango_attr_list_ref (parsed->attrs) : NULL;
+      *text = g_strdup (parsed->text);
+      return TRUE;
+    }
+
+  if (!pango_parse_markup (str, -1, 0, attrs, text, NULL, error))
+    return FALSE;
+
+  if (strlen (str) <= MARKUP_CACHE_MAX_LENGTH)
+    {
+      /* Start over rather than keeping track of which entries are in use */
+      if (g_hash_table_size (markup_cache) >= MARKUP_CACHE_SIZE)
+        g_hash_table_remove_all (markup_cache);
+
+      parsed = g_slice_new (GtkLabelParsedMarkup);
+      parsed->text = g_strdup (*text);
+      parsed->attrs = *attrs ? pango_attr_list_ref (*attrs) : NULL;
+      g_hash_table_insert (markup_cache, g_strdup (str), parsed);
+    }
+
+  return TRUE;
+}
+
+/* When @deferred, the text is updated quietly. The notifications for
+ * the change were sent, or weren't needed, when the markup was set.
+ */
+static void
+gtk_label_parse_markup (GtkLabel    *label,
+                        const gchar *str,
+                        gboolean     with_uline,
+                        gboolean     deferred)
 {
   GtkLabelPrivate *priv = label->priv;
   gchar *text = NULL;
@@ -2611,7 +2709,10 @@ gtk_label_set_markup_internal (GtkLabel    *label,
   gchar *str_for_accel = NULL;
   GList *links = NULL;
 
-  if (!parse_uri_markup (label, str, &str_for_display, &links, &error))
+  /* Only links need the extra pass, Pango checks the markup anyway */
+  if (strstr (str, "<a") == NULL)
+    str_for_display = g_strdup (str);
+  else if (!parse_uri_markup (label, str, &str_for_display, &links, &error))
     {
       g_warning ("Failed to set text '%s' from markup due to error parsing markup: %s",
                  str, error->message);
@@ -2658,13 +2759,17 @@ gtk_label_set_markup_internal (GtkLabel    *label,
     }
 
   /* Extract the text to display */
-  if (!pango_parse_markup (str_for_display,
-                           -1,
-                           with_uline ? '_' : 0,
-                           &attrs,
-                           &text,
-                           NULL,
-                           &error))
+  if (!(with_uline ? pango_parse_markup (str_for_display,
+                                         -1,
+                                         '_',
+                                         &attrs,
+                                         &text,
+                                         NULL,
+                                         &error)
+                   : parse_markup_cached (str_for_display,
+                                          &attrs,
+                                          &text,
+                                          &error)))
     {
       g_warning ("Failed to set text '%s' from markup due to error parsing markup: %s",
                  str_for_display, error->message);
@@ -2694,7 +2799,12 @@ gtk_label_set_markup_internal (GtkLabel    *label,
   g_free (str_for_display);
   g_free (str_for_accel);
 
-  if (text)
+  if (text && deferred)
+    {
+      g_free (priv->text);
+      priv->text = text;
+    }
+  else if (text)
     gtk_label_set_text_internal (label, text);
 
   if (attrs)
@@ -2710,6 +2820,48 @@ gtk_label_set_markup_internal (GtkLabel    *label,
     priv->mnemonic_keyval = GDK_KEY_VoidSymbol;
 }
 
+/* Parsing is put off until the text or the layout is needed when
+ * the markup can't change anything else: it has no links, which need
+ * the selection info, and no mnemonic, which needs the keyval now.
+ * This way labels that are never shown, like those in hidden rows or
+ * on other notebook pages, are never parsed.
+ *
+ * Accessible objects are told about the new text right away, so
+ * labels that have one are parsed right away too. Without a
+ * selection, setting the text has no other side effects.
+ */
+static void
+gtk_label_set_markup_internal (GtkLabel    *label,
+                               const gchar *str,
+                               gboolean     with_uline)
+{
+  GtkLabelPrivate *priv = label->priv;
+
+  if (!with_uline &&
+      priv->select_info == NULL &&
+      strstr (str, "<a") == NULL &&
+      _gtk_widget_peek_accessible (GTK_WIDGET (label)) == NULL)
+    {
+      priv->markup_pending = TRUE;
+      priv->mnemonic_keyval = GDK_KEY_VoidSymbol;
+      return;
+    }
+
+  gtk_label_parse_markup (label, str, with_uline, FALSE);
+}
+
+static void
+gtk_label_ensure_markup (GtkLabel *label)
+{
+  GtkLabelPrivate *priv = label->priv;
+
+  if (!priv->markup_pending)
+    return;
+
+  priv->markup_pending = FALSE;
+  gtk_label_parse_markup (label, priv->label, FALSE, TRUE);
+}
+
 /**
  * gtk_label_set_markup:
  * @label: a #GtkLabel
@@ -2805,6 +2957,8 @@ gtk_label_get_text (GtkLabel *label)
 {
   g_return_val_if_fail (GTK_IS_LABEL (label), NULL);
 
+  gtk_label_ensure_markup (label);
+
   return label->priv->text;
 }
 
@@ -2862,6 +3016,8 @@ gtk_label_set_pattern_internal (GtkLabel    *label,
   if (priv->pattern_set)
     return;
 
+  gtk_label_ensure_markup (label);
+
   if (is_mnemonic)
     {
       g_object_get (gtk_widget_get_settings (GTK_WIDGET (label)),
@@ -3045,6 +3201,7 @@ gtk_label_set_width_chars (GtkLabel *label,
     {
       priv->width_chars = n_chars;
       g_object_notify_by_pspec (G_OBJECT (label), label_props[PROP_WIDTH_CHARS]);
+      gtk_label_clear_size_cache (label);
       gtk_widget_queue_resize (GTK_WIDGET (label));
     }
 }
@@ -3092,6 +3249,7 @@ gtk_label_set_max_width_chars (GtkLabel *label,
       priv->max_width_chars = n_chars;
 
       g_object_notify_by_pspec (G_OBJECT (label), label_props[PROP_MAX_WIDTH_CHARS]);
+      gtk_label_clear_size_cache (label);
       gtk_widget_queue_resize (GTK_WIDGET (label));
     }
 }
@@ -3195,6 +3353,7 @@ gtk_label_set_line_wrap_mode (GtkLabel *label,
       priv->wrap_mode = wrap_mode;
       g_object_notify_by_pspec (G_OBJECT (label), label_props[PROP_WRAP_MODE]);
 
+      gtk_label_clear_size_cache (label);
       gtk_widget_queue_resize (GTK_WIDGET (label));
     }
 }
@@ -3254,6 +3413,55 @@ gtk_label_finalize (GObject *object)
   G_OBJECT_CLASS (gtk_label_parent_class)->finalize (object);
 }
 
+#ifdef G_ENABLE_DEBUG
+static guint size_cache_hits;
+static guint size_cache_misses;
+
+static void
+record_size_cache_lookup (gboolean hit)
+{
+  if (hit)
+    size_cache_hits++;
+  else
+    size_cache_misses++;
+
+  if ((size_cache_hits + size_cache_misses) % 1000 == 0)
+    GTK_NOTE (SIZE_REQUEST,
+              g_message ("GtkLabel size cache: %u hits, %u misses (%.1f%%)",
+                         size_cache_hits, size_cache_misses,
+                         100.0 * size_cache_hits / (size_cache_hits + size_cache_misses)));
+}
+#else
+#define record_size_cache_lookup(hit)
+#endif
+
+static void
+gtk_label_clear_size_cache (GtkLabel *label)
+{
+  GtkLabelPrivate *priv = label->priv;
+
+  priv->n_cached_sizes = 0;
+  priv->next_cached_size = 0;
+  priv->have_preferred_layout_size = FALSE;
+}
+
+/* Drops the cached sizes if anything the layout depends on
+ * changed in the Pango context, like the font or the direction.
+ */
+static void
+gtk_label_check_size_cache (GtkLabel *label)
+{
+  GtkLabelPrivate *priv = label->priv;
+  guint serial;
+
+  serial = pango_context_get_serial (gtk_widget_get_pango_context (GTK_WIDGET (label)));
+  if (serial != priv->size_cache_serial)
+    {
+      gtk_label_clear_size_cache (label);
+      priv->size_cache_serial = serial;
+    }
+}
+
 static void
 gtk_label_clear_layout (GtkLabel *label)
 {
@@ -3264,6 +3472,8 @@ gtk_label_clear_layout (GtkLabel *label)
       g_object_unref (priv->layout);
       priv->layout = NULL;
     }
+
+  gtk_label_clear_size_cache (label);
 }
 
 /**
@@ -3480,18 +3690,25 @@ gtk_label_update_layout_attributes (GtkLabel *label)
 
       gtk_style_context_restore (context);
     }
-  else if (priv->markup_attrs && priv->attrs)
-    attrs = pango_attr_list_new ();
   else
     attrs = NULL;
 
   style_attrs = _gtk_style_context_get_pango_attributes (context);
 
   attrs = _gtk_pango_attr_list_merge (attrs, style_attrs);
-  attrs = _gtk_pango_attr_list_merge (attrs, priv->markup_attrs);
+
+  /* The markup attributes may be shared with other labels through
+   * the markup cache, so they must not end up in the layout as is
+   */
+  if (attrs == NULL && priv->markup_attrs)
+    attrs = pango_attr_list_copy (priv->markup_attrs);
+  else
+    attrs = _gtk_pango_attr_list_merge (attrs, priv->markup_attrs);
+
   attrs = _gtk_pango_attr_list_merge (attrs, priv->attrs);
 
   pango_layout_set_attributes (priv->layout, attrs);
+  gtk_label_clear_size_cache (label);
 
   if (attrs)
     pango_attr_list_unref (attrs);
@@ -3513,7 +3730,11 @@ gtk_label_ensure_layout (GtkLabel *label)
   if (!priv->layout)
     {
       PangoAlignment align = PANGO_ALIGN_LEFT; /* Quiet gcc */
-      gdouble angle = gtk_label_get_angle (label);
+      gdouble angle;
+
+      gtk_label_ensure_markup (label);
+
+      angle = gtk_label_get_angle (label);
 
       if (angle != 0.0 && !priv->select_info)
 	{
@@ -3595,30 +3816,54 @@ get_size_for_allocation (GtkLabel        *label,
 			 gint            *minimum_baseline,
                          gint            *natural_baseline)
 {
+  GtkLabelPrivate *priv = label->priv;
+  GtkLabelCachedSize *cached;
   PangoLayout *layout;
-  gint text_height, baseline;
+  gint width;
+  guint i;
 
-  layout = gtk_label_get_measuring_layout (label, NULL, allocation * PANGO_SCALE);
+  width = allocation * PANGO_SCALE;
 
-  pango_layout_get_pixel_size (layout, NULL, &text_height);
+  gtk_label_check_size_cache (label);
 
-  if (minimum_size)
-    *minimum_size = text_height;
+  cached = NULL;
+  for (i = 0; i < priv->n_cached_sizes; i++)
+    {
+      if (priv->cached_sizes[i].width == width)
+        {
+          cached = &priv->cached_sizes[i];
+          break;
+        }
+    }
 
-  if (natural_size)
-    *natural_size = text_height;
+  record_size_cache_lookup (cached != NULL);
 
-  if (minimum_baseline || natural_baseline)
+  if (cached == NULL)
     {
-      baseline = pango_layout_get_baseline (layout) / PANGO_SCALE;
-      if (minimum_baseline)
-	*minimum_baseline = baseline;
+      cached = &priv->cached_sizes[priv->next_cached_size];
+      priv->next_cached_size = (priv->next_cached_size + 1) % N_CACHED_SIZES;
+      priv->n_cached_sizes = MIN (priv->n_cached_sizes + 1, N_CACHED_SIZES);
 
-      if (natural_baseline)
-	*natural_baseline = baseline;
+      layout = gtk_label_get_measuring_layout (label, NULL, width);
+
+      cached->width = width;
+      pango_layout_get_pixel_size (layout, NULL, &cached->height);
+      cached->baseline = pango_layout_get_baseline (layout) / PANGO_SCALE;
+
+      g_object_unref (layout);
     }
 
-  g_object_unref (layout);
+  if (minimum_size)
+    *minimum_size = cached->height;
+
+  if (natural_size)
+    *natural_size = cached->height;
+
+  if (minimum_baseline)
+    *minimum_baseline = cached->baseline;
+
+  if (natural_baseline)
+    *natural_baseline = cached->baseline;
 }
 
 static gint
@@ -3649,6 +3894,17 @@ gtk_label_get_preferred_layout_size (GtkLabel *label,
   PangoLayout *layout;
   gint char_pixels;
 
+  gtk_label_check_size_cache (label);
+
+  record_size_cache_lookup (priv->have_preferred_layout_size);
+
+  if (priv->have_preferred_layout_size)
+    {
+      *smallest = priv->cached_smallest;
+      *widest = priv->cached_widest;
+      return;
+    }
+
   /* "width-chars" Hard-coded minimum width:
    *    - minimum size should be MAX (width-chars, strlen ("..."));
    *    - natural size should be MAX (width-chars, strlen (priv->text));
@@ -3708,6 +3964,10 @@ gtk_label_get_preferred_layout_size (GtkLabel *label,
     *smallest = *widest;
 
   g_object_unref (layout);
+
+  priv->cached_smallest = *smallest;
+  priv->cached_widest = *widest;
+  priv->have_preferred_layout_size = TRUE;
 }
 
 static void
@@ -5421,6 +5681,9 @@ gtk_label_ensure_select_info (GtkLabel *label)
 
   if (priv->select_info == NULL)
     {
+      /* Selections are kept as indexes into the text */
+      gtk_label_ensure_markup (label);
+
       priv->select_info = g_new0 (GtkLabelSelectionInfo, 1);
 
       gtk_widget_set_can_focus (GTK_WIDGET (label), TRUE);
@@ -105,18 +105,35 @@ typedef struct
   GtkListBoxCreateWidgetFunc create_widget_func;
   gpointer create_widget_func_data;
   GDestroyNotify create_widget_func_data_destroy;
+
+  /* Only set with gtk_list_box_bind_model_recycled(). The children
+   * are then the rows for the model items from first_item on, and
+   * every row gets the same height.
+   */
+  GtkListBoxBindWidgetFunc bind_widget_func;
+  GSList *recycled_rows;
+  guint first_item;
+  gint row_height;
+  gint row_height_width;
+  guint recycle_idle_id;
 } GtkListBoxPrivate;
 
 typedef struct
 {
   GSequenceIter *iter;
   GtkWidget *header;
+  /* The row before this one when the header was last updated,
+   * only valid with header_valid and never dereferenced
+   */
+  GtkListBoxRow *header_before;
   gint y;
   gint height;
-  guint visible     :1;
-  guint selected    :1;
-  guint activatable :1;
-  guint selectable  :1;
+  guint visible      :1;
+  guint selected     :1;
+  guint activatable  :1;
+  guint selectable   :1;
+  guint wraps_item   :1;
+  guint header_valid :1;
 } GtkListBoxRowPrivate;
 
 enum {
@@ -164,6 +181,10 @@ G_DEFINE_TYPE_WITH_PRIVATE (GtkListBoxRow, gtk_list_box_row, GTK_TYPE_BIN)
 static void                 gtk_list_box_apply_filter_all             (GtkListBox          *box);
 static void                 gtk_list_box_update_header                (GtkListBox          *box,
                                                                        GSequenceIter       *iter);
+static void                 gtk_list_box_update_moved_headers         (GtkListBox          *box);
+static void                 gtk_list_box_insert_css_node              (GtkListBox          *box,
+                                                                       GtkWidget           *child,
+                                                                       GSequenceIter       *iter);
 static GSequenceIter *      gtk_list_box_get_next_visible             (GtkListBox          *box,
                                                                        GSequenceIter       *iter);
 static void                 gtk_list_box_apply_filter                 (GtkListBox          *box,
@@ -273,6 +294,10 @@ static void                 gtk_list_box_bound_model_changed            (GListMo
                                                                          gpointer             user_data);
 
 static void                 gtk_list_box_check_model_compat             (GtkListBox          *box);
+static void                 gtk_list_box_update_recycled_rows           (GtkListBox          *box);
+static void                 gtk_list_box_queue_update_recycled_rows     (GtkListBox          *box);
+static void                 gtk_list_box_adjustment_value_changed       (GtkAdjustment       *adjustment,
+                                                                         GtkListBox          *box);
 static GParamSpec *properties[LAST_PROPERTY] = { NULL, };
 static guint signals[LAST_SIGNAL] = { 0 };
 static GParamSpec *row_properties[LAST_ROW_PROPERTY] = { NULL, };
@@ -368,6 +393,13 @@ gtk_list_box_set_property (GObject      *obj,
     }
 }
 
+static void
+gtk_list_box_destroy_recycled_row (GtkWidget *row)
+{
+  gtk_widget_destroy (row);
+  g_object_unref (row);
+}
+
 static void
 gtk_list_box_finalize (GObject *obj)
 {
@@ -380,7 +412,16 @@ gtk_list_box_finalize (GObject *obj)
   if (priv->update_header_func_target_destroy_notify != NULL)
     priv->update_header_func_target_destroy_notify (priv->update_header_func_target);
 
-  g_clear_object (&priv->adjustment);
+  if (priv->recycle_idle_id != 0)
+    g_source_remove (priv->recycle_idle_id);
+  g_slist_free_full (priv->recycled_rows, (GDestroyNotify) gtk_list_box_destroy_recycled_row);
+
+  if (priv->adjustment)
+    {
+      g_signal_handlers_disconnect_by_func (priv->adjustment,
+                                            gtk_list_box_adjustment_value_changed, obj);
+      g_object_unref (priv->adjustment);
+    }
   g_clear_object (&priv->drag_highlighted_row);
   g_clear_object (&priv->multipress_gesture);
 
@@ -659,11 +700,19 @@ GtkListBoxRow *
 gtk_list_box_get_row_at_index (GtkListBox *box,
                                gint        index_)
 {
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
   GSequenceIter *iter;
 
   g_return_val_if_fail (GTK_IS_LIST_BOX (box), NULL);
 
-  iter = g_sequence_get_iter_at_pos (BOX_PRIV (box)->children, index_);
+  if (priv->bind_widget_func != NULL)
+    {
+      if (index_ < (gint) priv->first_item)
+        return NULL;
+      index_ -= priv->first_item;
+    }
+
+  iter = g_sequence_get_iter_at_pos (priv->children, index_);
   if (!g_sequence_iter_is_end (iter))
     return g_sequence_get (iter);
 
@@ -927,6 +976,14 @@ gtk_list_box_set_placeholder (GtkListBox *box,
 }
 
 
+static void
+gtk_list_box_adjustment_value_changed (GtkAdjustment *adjustment,
+                                       GtkListBox    *box)
+{
+  if (BOX_PRIV (box)->bind_widget_func != NULL)
+    gtk_list_box_queue_update_recycled_rows (box);
+}
+
 /**
  * gtk_list_box_set_adjustment:
  * @box: a #GtkListBox
@@ -952,11 +1009,27 @@ gtk_list_box_set_adjustment (GtkListBox    *box,
   g_return_if_fail (GTK_IS_LIST_BOX (box));
   g_return_if_fail (adjustment == NULL || GTK_IS_ADJUSTMENT (adjustment));
 
+  if (priv->adjustment == adjustment)
+    return;
+
   if (adjustment)
-    g_object_ref_sink (adjustment);
+    {
+      g_object_ref_sink (adjustment);
+      g_signal_connect (adjustment, "value-changed",
+                        G_CALLBACK (gtk_list_box_adjustment_value_changed), box);
+      g_signal_connect (adjustment, "changed",
+                        G_CALLBACK (gtk_list_box_adjustment_value_changed), box);
+    }
   if (priv->adjustment)
-    g_object_unref (priv->adjustment);
+    {
+      g_signal_handlers_disconnect_by_func (priv->adjustment,
+                                            gtk_list_box_adjustment_value_changed, box);
+      g_object_unref (priv->adjustment);
+    }
   priv->adjustment = adjustment;
+
+  if (priv->bind_widget_func != NULL)
+    gtk_list_box_queue_update_recycled_rows (box);
 }
 
 /**
@@ -1009,6 +1082,9 @@ gtk_list_box_parent_set (GtkWidget *widget,
     }
   else
     gtk_list_box_set_adjustment (GTK_LIST_BOX (widget), NULL);
+
+  if (BOX_PRIV (widget)->bind_widget_func != NULL)
+    gtk_list_box_queue_update_recycled_rows (GTK_LIST_BOX (widget));
 }
 
 /**
@@ -1154,6 +1230,7 @@ gtk_list_box_set_header_func (GtkListBox                 *box,
   priv->update_header_func = update_header;
   priv->update_header_func_target = user_data;
   priv->update_header_func_target_destroy_notify = destroy;
+  gtk_list_box_check_model_compat (box);
   gtk_list_box_invalidate_headers (box);
 }
 
@@ -1175,7 +1252,7 @@ gtk_list_box_invalidate_filter (GtkListBox *box)
   g_return_if_fail (GTK_IS_LIST_BOX (box));
 
   gtk_list_box_apply_filter_all (box);
-  gtk_list_box_invalidate_headers (box);
+  gtk_list_box_update_moved_headers (box);
   gtk_widget_queue_resize (GTK_WIDGET (box));
 }
 
@@ -1210,6 +1287,27 @@ gtk_list_box_css_node_foreach (gpointer data,
   *previous = row;
 }
 
+static gboolean
+gtk_list_box_is_sorted (GtkListBox *box)
+{
+  GSequenceIter *iter;
+  GSequenceIter *next;
+
+  iter = g_sequence_get_begin_iter (BOX_PRIV (box)->children);
+  if (g_sequence_iter_is_end (iter))
+    return TRUE;
+
+  for (next = g_sequence_iter_next (iter);
+       !g_sequence_iter_is_end (next);
+       iter = next, next = g_sequence_iter_next (next))
+    {
+      if (do_sort (g_sequence_get (iter), g_sequence_get (next), box) > 0)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 /**
  * gtk_list_box_invalidate_sort:
  * @box: a #GtkListBox
@@ -1228,13 +1326,64 @@ gtk_list_box_invalidate_sort (GtkListBox *box)
 
   g_return_if_fail (GTK_IS_LIST_BOX (box));
 
-  g_sequence_sort (priv->children, (GCompareDataFunc)do_sort, box);
-  g_sequence_foreach (priv->children, gtk_list_box_css_node_foreach, &previous);
+  /* Rows are often already in order, for instance when they are only
+   * ever added with gtk_container_add() and changed with
+   * gtk_list_box_row_changed(), which keep them sorted. Checking
+   * that is cheaper than sorting.
+   */
+  if (priv->sort_func != NULL && !gtk_list_box_is_sorted (box))
+    {
+      g_sequence_sort (priv->children, (GCompareDataFunc)do_sort, box);
+      g_sequence_foreach (priv->children, gtk_list_box_css_node_foreach, &previous);
+    }
 
+  /* The headers often depend on the same external factor as the
+   * sorting, so they are updated even if no row moved.
+   */
   gtk_list_box_invalidate_headers (box);
   gtk_widget_queue_resize (GTK_WIDGET (box));
 }
 
+/* Only updates the headers of the rows that have a different row
+ * before them than when their header was last updated, which is all
+ * that changes when rows are reordered, shown or hidden.
+ */
+static void
+gtk_list_box_update_moved_headers (GtkListBox *box)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  GSequenceIter *iter;
+  GtkListBoxRow *row;
+  GtkListBoxRow *before;
+
+  if (!gtk_widget_get_visible (GTK_WIDGET (box)))
+    return;
+
+  if (priv->update_header_func == NULL || priv->bind_widget_func != NULL)
+    return;
+
+  before = NULL;
+  for (iter = g_sequence_get_begin_iter (priv->children);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    {
+      row = g_sequence_get (iter);
+
+      if (!row_is_visible (row))
+        {
+          if (ROW_PRIV (row)->header != NULL)
+            gtk_list_box_update_header (box, iter);
+          continue;
+        }
+
+      if (!ROW_PRIV (row)->header_valid ||
+          ROW_PRIV (row)->header_before != before)
+        gtk_list_box_update_header (box, iter);
+
+      before = row;
+    }
+}
+
 static void
 gtk_list_box_do_reseparate (GtkListBox *box)
 {
@@ -1328,6 +1477,7 @@ gtk_list_box_got_row_changed (GtkListBox    *box,
       g_sequence_sort_changed (row_priv->iter,
                                (GCompareDataFunc)do_sort,
                                box);
+      gtk_list_box_insert_css_node (box, GTK_WIDGET (row), row_priv->iter);
       gtk_widget_queue_resize (GTK_WIDGET (box));
     }
   gtk_list_box_apply_filter (box, row);
@@ -1439,9 +1589,18 @@ ensure_row_visible (GtkListBox    *box,
   if (!priv->adjustment)
     return;
 
-  gtk_widget_get_allocation (GTK_WIDGET (row), &allocation);
-  y = allocation.y;
-  height = allocation.height;
+  if (priv->bind_widget_func != NULL)
+    {
+      /* Recycled rows may not have been allocated yet */
+      y = ROW_PRIV (row)->y;
+      height = ROW_PRIV (row)->height;
+    }
+  else
+    {
+      gtk_widget_get_allocation (GTK_WIDGET (row), &allocation);
+      y = allocation.y;
+      height = allocation.height;
+    }
 
   /* If the row has a header, we want to ensure that it is visible as well. */
   header = ROW_PRIV (row)->header;
@@ -2279,6 +2438,7 @@ gtk_list_box_update_header (GtkListBox    *box,
     }
 
   if (priv->update_header_func != NULL &&
+      priv->bind_widget_func == NULL &&
       row_is_visible (row))
     {
       old_header = ROW_PRIV (row)->header;
@@ -2287,6 +2447,8 @@ gtk_list_box_update_header (GtkListBox    *box,
       priv->update_header_func (row,
                                 before_row,
                                 priv->update_header_func_target);
+      ROW_PRIV (row)->header_before = before_row;
+      ROW_PRIV (row)->header_valid = TRUE;
       if (old_header != ROW_PRIV (row)->header)
         {
           if (old_header != NULL)
@@ -2307,6 +2469,7 @@ gtk_list_box_update_header (GtkListBox    *box,
     }
   else
     {
+      ROW_PRIV (row)->header_valid = FALSE;
       if (ROW_PRIV (row)->header != NULL)
         {
           g_hash_table_remove (priv->header_hash, ROW_PRIV (row)->header);
@@ -2411,6 +2574,9 @@ gtk_list_box_remove (GtkContainer *container,
     gtk_list_box_drag_unhighlight_row (box);
 
   next = gtk_list_box_get_next_visible (box, ROW_PRIV (row)->iter);
+  /* The next row may remember this one as the row before it */
+  if (!g_sequence_iter_is_end (next))
+    ROW_PRIV (g_sequence_get (next))->header_valid = FALSE;
   gtk_widget_unparent (child);
   g_sequence_remove (ROW_PRIV (row)->iter);
   if (gtk_widget_get_visible (widget))
@@ -2490,6 +2656,40 @@ gtk_list_box_get_preferred_height (GtkWidget *widget,
                                                minimum_height, natural_height);
 }
 
+static gint
+gtk_list_box_get_recycled_row_height (GtkListBox *box,
+                                      gint        width)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  GSequenceIter *iter;
+  gint row_height;
+  gint row_min;
+
+  /* Use the tallest row we have seen at this width, so that the
+   * height does not change with every row that scrolls into view.
+   */
+  row_height = width == priv->row_height_width ? priv->row_height : 0;
+
+  for (iter = g_sequence_get_begin_iter (priv->children);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    {
+      GtkListBoxRow *row;
+
+      row = g_sequence_get (iter);
+      if (!row_is_visible (row))
+        continue;
+
+      gtk_widget_get_preferred_height_for_width (GTK_WIDGET (row), width, &row_min, NULL);
+      row_height = MAX (row_height, row_min);
+    }
+
+  if (row_height == 0)
+    row_height = priv->row_height;
+
+  return row_height;
+}
+
 static void
 gtk_list_box_get_preferred_height_for_width (GtkWidget *widget,
                                              gint       width,
@@ -2506,6 +2706,22 @@ gtk_list_box_get_preferred_height_for_width (GtkWidget *widget,
     gtk_widget_get_preferred_height_for_width (priv->placeholder, width,
                                                &minimum_height, NULL);
 
+  if (priv->bind_widget_func != NULL)
+    {
+      gint64 rows_height;
+
+      /* Rows only exist for the items around the visible area,
+       * the others are assumed to be as high as the rows we have.
+       */
+      rows_height = (gint64) g_list_model_get_n_items (priv->bound_model) *
+                    gtk_list_box_get_recycled_row_height (GTK_LIST_BOX (widget), width);
+      minimum_height += MIN (rows_height, G_MAXINT - minimum_height);
+
+      *minimum_height_out = minimum_height;
+      *natural_height_out = minimum_height;
+      return;
+    }
+
   for (iter = g_sequence_get_begin_iter (priv->children);
        !g_sequence_iter_is_end (iter);
        iter = g_sequence_iter_next (iter))
@@ -2601,6 +2817,7 @@ gtk_list_box_size_allocate (GtkWidget     *widget,
   GdkWindow *window;
   GSequenceIter *iter;
   int child_min;
+  int row_height;
 
   child_allocation.x = 0;
   child_allocation.y = 0;
@@ -2636,6 +2853,25 @@ gtk_list_box_size_allocate (GtkWidget     *widget,
       child_allocation.y += child_min;
     }
 
+  /* Recycled rows all get the same height, and are placed
+   * where their items would be if all of them had rows.
+   */
+  row_height = 0;
+  if (priv->bind_widget_func != NULL)
+    {
+      row_height = gtk_list_box_get_recycled_row_height (GTK_LIST_BOX (widget),
+                                                         allocation->width);
+      child_allocation.y += priv->first_item * row_height;
+
+      if (row_height != priv->row_height ||
+          allocation->width != priv->row_height_width)
+        {
+          priv->row_height = row_height;
+          priv->row_height_width = allocation->width;
+          gtk_list_box_queue_update_recycled_rows (GTK_LIST_BOX (widget));
+        }
+    }
+
   for (iter = g_sequence_get_begin_iter (priv->children);
        !g_sequence_iter_is_end (iter);
        iter = g_sequence_iter_next (iter))
@@ -2645,6 +2881,7 @@ gtk_list_box_size_allocate (GtkWidget     *widget,
         {
           ROW_PRIV (row)->y = child_allocation.y;
           ROW_PRIV (row)->height = 0;
+          child_allocation.y += row_height;
           continue;
         }
 
@@ -2660,8 +2897,11 @@ gtk_list_box_size_allocate (GtkWidget     *widget,
 
       ROW_PRIV (row)->y = child_allocation.y;
 
-      gtk_widget_get_preferred_height_for_width (GTK_WIDGET (row),
-                                                 child_allocation.width, &child_min, NULL);
+      if (priv->bind_widget_func != NULL)
+        child_min = row_height;
+      else
+        gtk_widget_get_preferred_height_for_width (GTK_WIDGET (row),
+                                                   child_allocation.width, &child_min, NULL);
       child_allocation.height = child_min;
 
       ROW_PRIV (row)->height = child_allocation.height;
@@ -2694,6 +2934,7 @@ gtk_list_box_insert_css_node (GtkListBox    *box,
                               GSequenceIter *iter)
 {
   GSequenceIter *prev_iter;
+  GSequenceIter *next_iter;
   GtkWidget *sibling;
 
   prev_iter = g_sequence_iter_prev (iter);
@@ -2705,6 +2946,17 @@ gtk_list_box_insert_css_node (GtkListBox    *box,
                                  gtk_widget_get_css_node (child),
                                  gtk_widget_get_css_node (sibling));
     }
+  else
+    {
+      next_iter = g_sequence_iter_next (iter);
+      if (!g_sequence_iter_is_end (next_iter))
+        {
+          sibling = g_sequence_get (next_iter);
+          gtk_css_node_insert_before (gtk_widget_get_css_node (GTK_WIDGET (box)),
+                                      gtk_widget_get_css_node (child),
+                                      gtk_widget_get_css_node (sibling));
+        }
+    }
 }
 
 /**
@@ -2880,6 +3132,17 @@ gtk_list_box_move_cursor (GtkListBox      *box,
   switch (step)
     {
     case GTK_MOVEMENT_BUFFER_ENDS:
+      if (priv->bind_widget_func != NULL && priv->adjustment != NULL)
+        {
+          /* Create the rows at the end we are moving to */
+          if (count < 0)
+            gtk_adjustment_set_value (priv->adjustment,
+                                      gtk_adjustment_get_lower (priv->adjustment));
+          else
+            gtk_adjustment_set_value (priv->adjustment,
+                                      gtk_adjustment_get_upper (priv->adjustment));
+          gtk_list_box_update_recycled_rows (box);
+        }
       if (count < 0)
         row = gtk_list_box_get_first_focusable (box);
       else
@@ -3387,7 +3650,18 @@ gtk_list_box_row_get_index (GtkListBoxRow *row)
   priv = ROW_PRIV (row);
 
   if (priv->iter != NULL)
-    return g_sequence_iter_get_position (priv->iter);
+    {
+      GtkListBox *box;
+      gint index;
+
+      index = g_sequence_iter_get_position (priv->iter);
+
+      box = gtk_list_box_row_get_box (row);
+      if (box != NULL && BOX_PRIV (box)->bind_widget_func != NULL)
+        index += BOX_PRIV (box)->first_item;
+
+      return index;
+    }
 
   return -1;
 }
@@ -3694,6 +3968,250 @@ gtk_list_box_buildable_interface_init (GtkBuildableIface *iface)
   iface->add_child = gtk_list_box_buildable_add_child;
 }
 
+static GtkListBoxRow *
+gtk_list_box_get_row_for_item (GtkListBox *box,
+                               guint       position)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  GtkListBoxRow *row;
+  GtkWidget *widget;
+  GObject *item;
+
+  item = g_list_model_get_item (priv->bound_model, position);
+
+  if (priv->recycled_rows != NULL)
+    {
+      row = priv->recycled_rows->data;
+      priv->recycled_rows = g_slist_delete_link (priv->recycled_rows, priv->recycled_rows);
+
+      if (ROW_PRIV (row)->wraps_item)
+        widget = gtk_bin_get_child (GTK_BIN (row));
+      else
+        widget = GTK_WIDGET (row);
+
+      priv->bind_widget_func (item, widget, priv->create_widget_func_data);
+    }
+  else
+    {
+      widget = priv->create_widget_func (item, priv->create_widget_func_data);
+      if (g_object_is_floating (widget))
+        g_object_ref_sink (widget);
+
+      gtk_widget_show (widget);
+
+      if (GTK_IS_LIST_BOX_ROW (widget))
+        row = GTK_LIST_BOX_ROW (widget);
+      else
+        {
+          row = GTK_LIST_BOX_ROW (g_object_ref_sink (gtk_list_box_row_new ()));
+          gtk_widget_show (GTK_WIDGET (row));
+          gtk_container_add (GTK_CONTAINER (row), widget);
+          ROW_PRIV (row)->wraps_item = TRUE;
+          g_object_unref (widget);
+        }
+    }
+
+  g_object_unref (item);
+
+  return row;
+}
+
+static void
+gtk_list_box_recycle_row (GtkListBox    *box,
+                          GSequenceIter *iter)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  GtkListBoxRow *row;
+
+  row = g_object_ref (g_sequence_get (iter));
+
+  /* The item the row stands for is going away, so it is no
+   * longer selected
+   */
+  gtk_list_box_unselect_row_internal (box, row);
+  gtk_container_remove (GTK_CONTAINER (box), GTK_WIDGET (row));
+  ROW_PRIV (row)->iter = NULL;
+
+  priv->recycled_rows = g_slist_prepend (priv->recycled_rows, row);
+}
+
+static void
+gtk_list_box_insert_row_for_item (GtkListBox *box,
+                                  guint       position,
+                                  gint        index_)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  GtkListBoxRow *row;
+
+  row = gtk_list_box_get_row_for_item (box, position);
+
+  /* Put the row where it will be allocated, so that it can
+   * be scrolled to right away
+   */
+  ROW_PRIV (row)->y = position * priv->row_height;
+  ROW_PRIV (row)->height = priv->row_height;
+
+  gtk_list_box_insert (box, GTK_WIDGET (row), index_);
+  g_object_unref (row);
+}
+
+/* Makes the children the rows for the items from @first up to,
+ * but not including, @last, reusing the rows that are already
+ * there.
+ */
+static void
+gtk_list_box_set_recycled_range (GtkListBox *box,
+                                 guint       first,
+                                 guint       last)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  guint end;
+
+  end = priv->first_item + g_sequence_get_length (priv->children);
+
+  if (end == priv->first_item || last <= priv->first_item || first >= end)
+    {
+      while (g_sequence_get_length (priv->children) > 0)
+        gtk_list_box_recycle_row (box, g_sequence_get_begin_iter (priv->children));
+      priv->first_item = first;
+      end = first;
+    }
+  else
+    {
+      for (; priv->first_item < first; priv->first_item++)
+        gtk_list_box_recycle_row (box, g_sequence_get_begin_iter (priv->children));
+      for (; end > last; end--)
+        gtk_list_box_recycle_row (box, g_sequence_iter_prev (g_sequence_get_end_iter (priv->children)));
+    }
+
+  while (priv->first_item > first)
+    {
+      priv->first_item--;
+      gtk_list_box_insert_row_for_item (box, priv->first_item, 0);
+    }
+  for (; end < last; end++)
+    gtk_list_box_insert_row_for_item (box, end, -1);
+}
+
+static void
+gtk_list_box_update_recycled_rows (GtkListBox *box)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  GtkListBoxRow *row;
+  guint n_items;
+  gdouble value;
+  gdouble page_size;
+  gdouble first;
+  gdouble last;
+
+  n_items = g_list_model_get_n_items (priv->bound_model);
+
+  if (n_items == 0)
+    {
+      gtk_list_box_set_recycled_range (box, 0, 0);
+      return;
+    }
+
+  if (priv->adjustment == NULL)
+    {
+      /* Wait for a scrollable parent if there is no parent yet,
+       * otherwise all rows can be visible
+       */
+      if (gtk_widget_get_parent (GTK_WIDGET (box)) != NULL)
+        gtk_list_box_set_recycled_range (box, 0, n_items);
+      return;
+    }
+
+  if (priv->row_height == 0)
+    {
+      /* Start out with the height of any one row */
+      if (g_sequence_get_length (priv->children) == 0)
+        {
+          first = MIN (priv->first_item, n_items - 1);
+          gtk_list_box_set_recycled_range (box, first, first + 1);
+        }
+
+      row = g_sequence_get (g_sequence_get_begin_iter (priv->children));
+      gtk_widget_get_preferred_height (GTK_WIDGET (row), &priv->row_height, NULL);
+      priv->row_height = MAX (priv->row_height, 1);
+      priv->row_height_width = -1;
+    }
+
+  value = gtk_adjustment_get_value (priv->adjustment);
+  page_size = gtk_adjustment_get_page_size (priv->adjustment);
+  if (page_size <= 0)
+    page_size = gdk_screen_get_height (gtk_widget_get_screen (GTK_WIDGET (box)));
+
+  /* Keep a page of rows above and below the visible ones around,
+   * so that keyboard navigation and scrolling by up to a page find
+   * their rows
+   */
+  first = floor ((value - page_size) / priv->row_height);
+  last = ceil ((value + 2 * page_size) / priv->row_height);
+
+  first = CLAMP (first, 0, n_items);
+  last = CLAMP (last, first, n_items);
+
+  gtk_list_box_set_recycled_range (box, first, last);
+}
+
+static gboolean
+gtk_list_box_update_recycled_rows_idle (gpointer data)
+{
+  GtkListBox *box = data;
+
+  BOX_PRIV (box)->recycle_idle_id = 0;
+  gtk_list_box_update_recycled_rows (box);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gtk_list_box_queue_update_recycled_rows (GtkListBox *box)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+
+  if (priv->recycle_idle_id != 0)
+    return;
+
+  /* This runs before the next frame is laid out and drawn */
+  priv->recycle_idle_id = gdk_threads_add_idle_full (G_PRIORITY_HIGH_IDLE,
+                                                     gtk_list_box_update_recycled_rows_idle,
+                                                     box, NULL);
+  g_source_set_name_by_id (priv->recycle_idle_id, "[gtk+] gtk_list_box_update_recycled_rows");
+}
+
+static void
+gtk_list_box_recycled_items_changed (GtkListBox *box,
+                                     guint       position,
+                                     guint       removed,
+                                     guint       added)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  guint end;
+  guint keep;
+
+  end = priv->first_item + g_sequence_get_length (priv->children);
+
+  if (position + removed <= priv->first_item)
+    {
+      /* The rows we have just moved */
+      priv->first_item = priv->first_item - removed + added;
+    }
+  else if (position < end)
+    {
+      /* The rows from @position on now show the wrong items */
+      keep = position > priv->first_item ? position - priv->first_item : 0;
+      while (g_sequence_get_length (priv->children) > keep)
+        gtk_list_box_recycle_row (box, g_sequence_iter_prev (g_sequence_get_end_iter (priv->children)));
+      if (keep == 0)
+        priv->first_item = position;
+    }
+
+  gtk_list_box_update_recycled_rows (box);
+  gtk_widget_queue_resize (GTK_WIDGET (box));
+}
+
 static void
 gtk_list_box_bound_model_changed (GListModel *list,
                                   guint       position,
@@ -3705,6 +4223,12 @@ gtk_list_box_bound_model_changed (GListModel *list,
   GtkListBoxPrivate *priv = BOX_PRIV (user_data);
   gint i;
 
+  if (priv->bind_widget_func != NULL)
+    {
+      gtk_list_box_recycled_items_changed (box, position, removed, added);
+      return;
+    }
+
   while (removed--)
     {
       GtkListBoxRow *row;
@@ -3747,6 +4271,65 @@ gtk_list_box_check_model_compat (GtkListBox *box)
   if (priv->bound_model &&
       (priv->sort_func || priv->filter_func))
     g_warning ("GtkListBox with a model will ignore sort and filter functions");
+
+  if (priv->bound_model && priv->bind_widget_func &&
+      priv->update_header_func)
+    g_warning ("GtkListBox with a recycled model will ignore header functions");
+}
+
+static void
+gtk_list_box_set_bound_model (GtkListBox                 *box,
+                              GListModel                 *model,
+                              GtkListBoxCreateWidgetFunc  create_widget_func,
+                              GtkListBoxBindWidgetFunc    bind_widget_func,
+                              gpointer                    user_data,
+                              GDestroyNotify              user_data_free_func)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+
+  if (priv->bound_model)
+    {
+      if (priv->create_widget_func_data_destroy)
+        priv->create_widget_func_data_destroy (priv->create_widget_func_data);
+
+      g_signal_handlers_disconnect_by_func (priv->bound_model, gtk_list_box_bound_model_changed, box);
+      g_clear_object (&priv->bound_model);
+    }
+
+  gtk_list_box_forall (GTK_CONTAINER (box), FALSE, (GtkCallback) gtk_widget_destroy, NULL);
+
+  g_slist_free_full (priv->recycled_rows, (GDestroyNotify) gtk_list_box_destroy_recycled_row);
+  priv->recycled_rows = NULL;
+  if (priv->recycle_idle_id != 0)
+    {
+      g_source_remove (priv->recycle_idle_id);
+      priv->recycle_idle_id = 0;
+    }
+  priv->bind_widget_func = NULL;
+  priv->first_item = 0;
+  priv->row_height = 0;
+  priv->row_height_width = -1;
+
+  if (model == NULL)
+    return;
+
+  priv->bound_model = g_object_ref (model);
+  priv->create_widget_func = create_widget_func;
+  priv->bind_widget_func = bind_widget_func;
+  priv->create_widget_func_data = user_data;
+  priv->create_widget_func_data_destroy = user_data_free_func;
+
+  gtk_list_box_check_model_compat (box);
+
+  g_signal_connect (priv->bound_model, "items-changed", G_CALLBACK (gtk_list_box_bound_model_changed), box);
+
+  if (bind_widget_func != NULL)
+    {
+      gtk_list_box_update_recycled_rows (box);
+      gtk_widget_queue_resize (GTK_WIDGET (box));
+    }
+  else
+    gtk_list_box_bound_model_changed (model, 0, 0, g_list_model_get_n_items (model), box);
 }
 
 /**
@@ -3784,33 +4367,58 @@ gtk_list_box_bind_model (GtkListBox                 *box,
                          gpointer                    user_data,
                          GDestroyNotify              user_data_free_func)
 {
-  GtkListBoxPrivate *priv = BOX_PRIV (box);
-
   g_return_if_fail (GTK_IS_LIST_BOX (box));
   g_return_if_fail (model == NULL || G_IS_LIST_MODEL (model));
   g_return_if_fail (model == NULL || create_widget_func != NULL);
 
-  if (priv->bound_model)
-    {
-      if (priv->create_widget_func_data_destroy)
-        priv->create_widget_func_data_destroy (priv->create_widget_func_data);
-
-      g_signal_handlers_disconnect_by_func (priv->bound_model, gtk_list_box_bound_model_changed, box);
-      g_clear_object (&priv->bound_model);
-    }
-
-  gtk_list_box_forall (GTK_CONTAINER (box), FALSE, (GtkCallback) gtk_widget_destroy, NULL);
-
-  if (model == NULL)
-    return;
-
-  priv->bound_model = g_object_ref (model);
-  priv->create_widget_func = create_widget_func;
-  priv->create_widget_func_data = user_data;
-  priv->create_widget_func_data_destroy = user_data_free_func;
+  gtk_list_box_set_bound_model (box, model, create_widget_func, NULL,
+                                user_data, user_data_free_func);
+}
 
-  gtk_list_box_check_model_compat (box);
+/**
+ * gtk_list_box_bind_model_recycled:
+ * @box: a #GtkListBox
+ * @model: (nullable): the #GListModel to be bound to @box
+ * @create_widget_func: (nullable): a function that creates widgets for items
+ *   or %NULL in case you also passed %NULL as @model
+ * @bind_widget_func: (nullable): a function that makes a widget represent
+ *   another item, or %NULL in case you also passed %NULL as @model
+ * @user_data: user data passed to @create_widget_func and @bind_widget_func
+ * @user_data_free_func: function for freeing @user_data
+ *
+ * Binds @model to @box like gtk_list_box_bind_model(), but only
+ * creates rows for the items that are in or close to the visible part
+ * of @box. When @box is scrolled, the rows that are no longer needed are
+ * reused for the items that come into view, and @bind_widget_func is
+ * called to update them.
+ *
+ * This makes binding large models cheap, but it has some limitations.
+ * All rows get the height of the tallest row that has been shown, and
+ * the height of @box is estimated from it. Header functions are ignored.
+ * A row is unselected when it is reused, so only items that have rows
+ * can be selected, and the index of a row, as returned by
+ * gtk_list_box_row_get_index(), is the position of its item in @model.
+ *
+ * Rows are only reused if @box is in a #GtkScrolledWindow, or another
+ * #GtkScrollable, or has an adjustment set with
+ * gtk_list_box_set_adjustment(). Otherwise, a row is created for every
+ * item.
+ *
+ * Since: 3.20
+ */
+void
+gtk_list_box_bind_model_recycled (GtkListBox                 *box,
+                                  GListModel                 *model,
+                                  GtkListBoxCreateWidgetFunc  create_widget_func,
+                                  GtkListBoxBindWidgetFunc    bind_widget_func,
+                                  gpointer                    user_data,
+                                  GDestroyNotify              user_data_free_func)
+{
+  g_return_if_fail (GTK_IS_LIST_BOX (box));
+  g_return_if_fail (model == NULL || G_IS_LIST_MODEL (model));
+  g_return_if_fail (model == NULL || create_widget_func != NULL);
+  g_return_if_fail (model == NULL || bind_widget_func != NULL);
 
-  g_signal_connect (priv->bound_model, "items-changed", G_CALLBACK (gtk_list_box_bound_model_changed), box);
-  gtk_list_box_bound_model_changed (model, 0, 0, g_list_model_get_n_items (model), box);
+  gtk_list_box_set_bound_model (box, model, create_widget_func, bind_widget_func,
+                                user_data, user_data_free_func);
 }
@@ -189,6 +189,23 @@ typedef void (*GtkListBoxUpdateHeaderFunc) (GtkListBoxRow *row,
 typedef GtkWidget * (*GtkListBoxCreateWidgetFunc) (gpointer item,
                                                    gpointer user_data);
 
+/**
+ * GtkListBoxBindWidgetFunc:
+ * @item: (type GObject): the item from the model that @widget should represent
+ * @widget: a widget that was returned by the #GtkListBoxCreateWidgetFunc
+ * @user_data: (closure): user data
+ *
+ * Called for list boxes that are bound to a #GListModel with
+ * gtk_list_box_bind_model_recycled() when a widget that was created
+ * for one item is reused for another one. The function should update
+ * @widget so that it represents @item.
+ *
+ * Since: 3.20
+ */
+typedef void (*GtkListBoxBindWidgetFunc) (gpointer   item,
+                                          GtkWidget *widget,
+                                          gpointer   user_data);
+
 GDK_AVAILABLE_IN_3_10
 GType      gtk_list_box_row_get_type      (void) G_GNUC_CONST;
 GDK_AVAILABLE_IN_3_10
@@ -313,6 +330,14 @@ void           gtk_list_box_bind_model                   (GtkListBox
                                                           gpointer                      user_data,
                                                           GDestroyNotify                user_data_free_func);
 
+GDK_AVAILABLE_IN_3_20
+void           gtk_list_box_bind_model_recycled          (GtkListBox                   *box,
+                                                          GListModel                   *model,
+                                                          GtkListBoxCreateWidgetFunc    create_widget_func,
+                                                          GtkListBoxBindWidgetFunc      bind_widget_func,
+                                                          gpointer                      user_data,
+                                                          GDestroyNotify                user_data_free_func);
+
 G_END_DECLS
 
 #endif
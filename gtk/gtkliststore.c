@@ -21,7 +21,7 @@
 #include <string.h>
 #include <gobject/gvaluecollector.h>
 #include "gtktreemodel.h"
-#include "gtkliststore.h"
+#include "gtkliststoreprivate.h"
 #include "gtktreedatalist.h"
 #include "gtktreednd.h"
 #include "gtkintl.h"
@@ -180,6 +180,7 @@ struct _GtkListStorePrivate
   GDestroyNotify default_sort_destroy;
   GList *sort_list;
   GType *column_headers;
+  GtkTreeDataLayout *layout;
 
   gint stamp;
   gint n_columns;
@@ -192,8 +193,23 @@ struct _GtkListStorePrivate
 
   gpointer default_sort_data;
   gpointer seq;         /* head of the list */
+
+  GSList *rows_inserted_handlers;
+
+  /* Rows appended during a batch that have not been announced yet.
+   * They are kept out of seq and length until the batch is flushed.
+   */
+  GSequence *batch_seq;
+  gint batch_depth;
+  guint emitting_batch : 1;
 };
 
+typedef struct
+{
+  GtkListStoreRowsInsertedFunc func;
+  gpointer data;
+} RowsInsertedHandler;
+
 #define GTK_LIST_STORE_IS_SORTED(list) (((GtkListStore*)(list))->priv->sort_column_id != GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID)
 static void         gtk_list_store_tree_model_init (GtkTreeModelIface *iface);
 static void         gtk_list_store_drag_source_init(GtkTreeDragSourceIface *iface);
@@ -242,6 +258,13 @@ static void gtk_list_store_set_column_type (GtkListStore *list_store,
 
 static void gtk_list_store_increment_stamp (GtkListStore *list_store);
 
+static gboolean gtk_list_store_defer_insert (GtkListStore *list_store,
+                                             GtkTreeIter  *iter,
+                                             gint          position);
+static gboolean gtk_list_store_row_is_pending (GtkListStore  *list_store,
+                                               GSequenceIter *ptr);
+static void     gtk_list_store_flush_batch  (GtkListStore *list_store);
+
 
 /* Drag and Drop */
 static gboolean real_gtk_list_store_row_draggable (GtkTreeDragSource *drag_source,
@@ -378,6 +401,7 @@ gtk_list_store_init (GtkListStore *list_store)
   priv = list_store->priv;
 
   priv->seq = g_sequence_new (NULL);
+  priv->batch_seq = g_sequence_new (NULL);
   priv->sort_list = NULL;
   priv->stamp = g_random_int ();
   priv->sort_column_id = GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID;
@@ -389,11 +413,17 @@ static gboolean
 iter_is_valid (GtkTreeIter  *iter,
                GtkListStore *list_store)
 {
-  return iter != NULL && 
-         iter->user_data != NULL &&
-         list_store->priv->stamp == iter->stamp &&
-         !g_sequence_iter_is_end (iter->user_data) &&
-         g_sequence_iter_get_sequence (iter->user_data) == list_store->priv->seq;
+  GSequence *seq;
+
+  if (iter == NULL ||
+      iter->user_data == NULL ||
+      list_store->priv->stamp != iter->stamp ||
+      g_sequence_iter_is_end (iter->user_data))
+    return FALSE;
+
+  seq = g_sequence_iter_get_sequence (iter->user_data);
+
+  return seq == list_store->priv->seq || seq == list_store->priv->batch_seq;
 }
 
 /**
@@ -556,6 +586,24 @@ gtk_list_store_set_column_type (GtkListStore *list_store,
   priv->column_headers[column] = type;
 }
 
+/* The layout is created when the first row gets data, at which point
+ * the column types can no longer change.
+ */
+static GtkTreeDataLayout *
+gtk_list_store_get_layout (GtkListStore *list_store)
+{
+  GtkListStorePrivate *priv = list_store->priv;
+
+  if (priv->layout == NULL)
+    {
+      priv->layout = _gtk_tree_data_layout_new (priv->n_columns,
+                                                priv->column_headers);
+      priv->columns_dirty = TRUE;
+    }
+
+  return priv->layout;
+}
+
 static void
 gtk_list_store_finalize (GObject *object)
 {
@@ -563,10 +611,18 @@ gtk_list_store_finalize (GObject *object)
   GtkListStorePrivate *priv = list_store->priv;
 
   g_sequence_foreach (priv->seq,
-		      (GFunc) _gtk_tree_data_list_free, priv->column_headers);
+		      (GFunc) _gtk_tree_data_row_free, priv->layout);
 
   g_sequence_free (priv->seq);
 
+  g_sequence_foreach (priv->batch_seq,
+		      (GFunc) _gtk_tree_data_row_free, priv->layout);
+  g_sequence_free (priv->batch_seq);
+
+  _gtk_tree_data_layout_free (priv->layout);
+
+  g_slist_free_full (priv->rows_inserted_handlers, g_free);
+
   _gtk_tree_data_list_header_free (priv->sort_list);
   g_free (priv->column_headers);
 
@@ -654,6 +710,10 @@ gtk_list_store_get_path (GtkTreeModel *tree_model,
 
   if (g_sequence_iter_is_end (iter->user_data))
     return NULL;
+
+  /* Rows of an unfinished batch are not in the model yet */
+  if (gtk_list_store_row_is_pending (list_store, iter->user_data))
+    return NULL;
 	
   path = gtk_tree_path_new ();
   gtk_tree_path_append_index (path, g_sequence_iter_get_position (iter->user_data));
@@ -669,23 +729,17 @@ gtk_list_store_get_value (GtkTreeModel *tree_model,
 {
   GtkListStore *list_store = GTK_LIST_STORE (tree_model);
   GtkListStorePrivate *priv = list_store->priv;
-  GtkTreeDataList *list;
-  gint tmp_column = column;
+  GtkTreeDataRow *row;
 
   g_return_if_fail (column < priv->n_columns);
   g_return_if_fail (iter_is_valid (iter, list_store));
 		    
-  list = g_sequence_get (iter->user_data);
+  row = g_sequence_get (iter->user_data);
 
-  while (tmp_column-- > 0 && list)
-    list = list->next;
-
-  if (list == NULL)
+  if (row == NULL)
     g_value_init (value, priv->column_headers[column]);
   else
-    _gtk_tree_data_list_node_to_value (list,
-				       priv->column_headers[column],
-				       value);
+    _gtk_tree_data_row_get_value (row, priv->layout, column, value);
 }
 
 static gboolean
@@ -819,8 +873,7 @@ gtk_list_store_real_set_value (GtkListStore *list_store,
 			       gboolean      sort)
 {
   GtkListStorePrivate *priv = list_store->priv;
-  GtkTreeDataList *list;
-  GtkTreeDataList *prev;
+  GtkTreeDataRow *row;
   gint old_column = column;
   GValue real_value = G_VALUE_INIT;
   gboolean converted = FALSE;
@@ -850,53 +903,17 @@ gtk_list_store_real_set_value (GtkListStore *list_store,
       converted = TRUE;
     }
 
-  prev = list = g_sequence_get (iter->user_data);
-
-  while (list != NULL)
-    {
-      if (column == 0)
-	{
-	  if (converted)
-	    _gtk_tree_data_list_value_to_node (list, &real_value);
-	  else
-	    _gtk_tree_data_list_value_to_node (list, value);
-	  retval = TRUE;
-	  if (converted)
-	    g_value_unset (&real_value);
-         if (sort && GTK_LIST_STORE_IS_SORTED (list_store))
-            gtk_list_store_sort_iter_changed (list_store, iter, old_column);
-	  return retval;
-	}
-
-      column--;
-      prev = list;
-      list = list->next;
-    }
-
-  if (g_sequence_get (iter->user_data) == NULL)
+  row = g_sequence_get (iter->user_data);
+  if (row == NULL)
     {
-      list = _gtk_tree_data_list_alloc();
-      g_sequence_set (iter->user_data, list);
-      list->next = NULL;
-    }
-  else
-    {
-      list = prev->next = _gtk_tree_data_list_alloc ();
-      list->next = NULL;
-    }
-
-  while (column != 0)
-    {
-      list->next = _gtk_tree_data_list_alloc ();
-      list = list->next;
-      list->next = NULL;
-      column --;
+      row = _gtk_tree_data_row_new (gtk_list_store_get_layout (list_store));
+      g_sequence_set (iter->user_data, row);
     }
 
   if (converted)
-    _gtk_tree_data_list_value_to_node (list, &real_value);
+    _gtk_tree_data_row_set_value (row, priv->layout, column, &real_value);
   else
-    _gtk_tree_data_list_value_to_node (list, value);
+    _gtk_tree_data_row_set_value (row, priv->layout, column, value);
 
   retval = TRUE;
   if (converted)
@@ -935,6 +952,16 @@ gtk_list_store_set_value (GtkListStore *list_store,
   priv = list_store->priv;
   g_return_if_fail (column >= 0 && column < priv->n_columns);
 
+  /* Rows that have not been announced yet are sorted when the batch ends */
+  if (gtk_list_store_row_is_pending (list_store, iter->user_data))
+    {
+      gtk_list_store_real_set_value (list_store, iter, column, value, FALSE);
+      return;
+    }
+
+  if (GTK_LIST_STORE_IS_SORTED (list_store))
+    gtk_list_store_flush_batch (list_store);
+
   if (gtk_list_store_real_set_value (list_store, iter, column, value, TRUE))
     {
       GtkTreePath *path;
@@ -1092,11 +1119,18 @@ gtk_list_store_set_valuesv (GtkListStore *list_store,
 
   priv = list_store->priv;
 
+  if (!gtk_list_store_row_is_pending (list_store, iter->user_data) &&
+      GTK_LIST_STORE_IS_SORTED (list_store))
+    gtk_list_store_flush_batch (list_store);
+
   gtk_list_store_set_vector_internal (list_store, iter,
 				      &emit_signal,
 				      &maybe_need_sort,
 				      columns, values, n_values);
 
+  if (gtk_list_store_row_is_pending (list_store, iter->user_data))
+    return;
+
   if (maybe_need_sort && GTK_LIST_STORE_IS_SORTED (list_store))
     gtk_list_store_sort_iter_changed (list_store, iter, priv->sort_column_id);
 
@@ -1134,11 +1168,18 @@ gtk_list_store_set_valist (GtkListStore *list_store,
 
   priv = list_store->priv;
 
+  if (!gtk_list_store_row_is_pending (list_store, iter->user_data) &&
+      GTK_LIST_STORE_IS_SORTED (list_store))
+    gtk_list_store_flush_batch (list_store);
+
   gtk_list_store_set_valist_internal (list_store, iter, 
 				      &emit_signal, 
 				      &maybe_need_sort,
 				      var_args);
 
+  if (gtk_list_store_row_is_pending (list_store, iter->user_data))
+    return;
+
   if (maybe_need_sort && GTK_LIST_STORE_IS_SORTED (list_store))
     gtk_list_store_sort_iter_changed (list_store, iter, priv->sort_column_id);
 
@@ -1204,12 +1245,14 @@ gtk_list_store_remove (GtkListStore *list_store,
 
   priv = list_store->priv;
 
+  gtk_list_store_flush_batch (list_store);
+
   path = gtk_list_store_get_path (GTK_TREE_MODEL (list_store), iter);
 
   ptr = iter->user_data;
   next = g_sequence_iter_next (ptr);
   
-  _gtk_tree_data_list_free (g_sequence_get (ptr), priv->column_headers);
+  _gtk_tree_data_row_free (g_sequence_get (ptr), priv->layout);
   g_sequence_remove (iter->user_data);
 
   priv->length--;
@@ -1259,6 +1302,9 @@ gtk_list_store_insert (GtkListStore *list_store,
 
   priv = list_store->priv;
 
+  if (gtk_list_store_defer_insert (list_store, iter, position))
+    return;
+
   priv->columns_dirty = TRUE;
 
   seq = priv->seq;
@@ -1311,6 +1357,9 @@ gtk_list_store_insert_before (GtkListStore *list_store,
   if (sibling)
     g_return_if_fail (iter_is_valid (sibling, list_store));
 
+  if (sibling && gtk_list_store_row_is_pending (list_store, sibling->user_data))
+    gtk_list_store_flush_batch (list_store);
+
   if (!sibling)
     after = g_sequence_get_end_iter (priv->seq);
   else
@@ -1347,6 +1396,9 @@ gtk_list_store_insert_after (GtkListStore *list_store,
   if (sibling)
     g_return_if_fail (iter_is_valid (sibling, list_store));
 
+  if (sibling && gtk_list_store_row_is_pending (list_store, sibling->user_data))
+    gtk_list_store_flush_batch (list_store);
+
   if (!sibling)
     after = g_sequence_get_begin_iter (priv->seq);
   else
@@ -1424,6 +1476,8 @@ gtk_list_store_clear (GtkListStore *list_store)
 
   priv = list_store->priv;
 
+  gtk_list_store_flush_batch (list_store);
+
   while (g_sequence_get_length (priv->seq) > 0)
     {
       iter.stamp = priv->stamp;
@@ -1564,33 +1618,12 @@ gtk_list_store_drag_data_received (GtkTreeDragDest   *drag_dest,
        */
       if (retval)
         {
-          GtkTreeDataList *dl = g_sequence_get (src_iter.user_data);
-          GtkTreeDataList *copy_head = NULL;
-          GtkTreeDataList *copy_prev = NULL;
-          GtkTreeDataList *copy_iter = NULL;
+          GtkTreeDataRow *row = g_sequence_get (src_iter.user_data);
 	  GtkTreePath *path;
-          gint col;
-
-          col = 0;
-          while (dl)
-            {
-              copy_iter = _gtk_tree_data_list_node_copy (dl,
-                                                         priv->column_headers[col]);
-
-              if (copy_head == NULL)
-                copy_head = copy_iter;
-
-              if (copy_prev)
-                copy_prev->next = copy_iter;
-
-              copy_prev = copy_iter;
-
-              dl = dl->next;
-              ++col;
-            }
 
 	  dest_iter.stamp = priv->stamp;
-          g_sequence_set (dest_iter.user_data, copy_head);
+          g_sequence_set (dest_iter.user_data,
+                          _gtk_tree_data_row_copy (row, priv->layout));
 
 	  path = gtk_list_store_get_path (tree_model, &dest_iter);
 	  gtk_tree_model_row_changed (tree_model, path, &dest_iter);
@@ -1700,6 +1733,8 @@ gtk_list_store_reorder (GtkListStore *store,
 
   priv = store->priv;
 
+  gtk_list_store_flush_batch (store);
+
   order = g_new (gint, g_sequence_get_length (priv->seq));
   for (i = 0; i < g_sequence_get_length (priv->seq); i++)
     order[new_order[i]] = i;
@@ -1797,6 +1832,8 @@ gtk_list_store_swap (GtkListStore *store,
   if (a->user_data == b->user_data)
     return;
 
+  gtk_list_store_flush_batch (store);
+
   old_positions = save_positions (priv->seq);
   
   g_sequence_swap (a->user_data, b->user_data);
@@ -1821,6 +1858,8 @@ gtk_list_store_move_to (GtkListStore *store,
   GtkTreePath *path;
   gint *order;
 
+  gtk_list_store_flush_batch (store);
+
   old_positions = save_positions (priv->seq);
 
   g_sequence_move (iter->user_data, g_sequence_get_iter_at_pos (priv->seq, new_pos));
@@ -1859,6 +1898,8 @@ gtk_list_store_move_before (GtkListStore *store,
   if (position)
     g_return_if_fail (iter_is_valid (position, store));
 
+  gtk_list_store_flush_batch (store);
+
   if (position)
     pos = g_sequence_iter_get_position (position->user_data);
   else
@@ -1892,6 +1933,8 @@ gtk_list_store_move_after (GtkListStore *store,
   if (position)
     g_return_if_fail (iter_is_valid (position, store));
 
+  gtk_list_store_flush_batch (store);
+
   if (position)
     pos = g_sequence_iter_get_position (position->user_data) + 1;
   else
@@ -1954,6 +1997,74 @@ gtk_list_store_compare_func (GSequenceIter *a,
   return retval;
 }
 
+/* Sorts by the keys of the sort column, if the store sorts by a plain
+ * column, and returns the new order.
+ */
+static gint *
+gtk_list_store_sort_by_keys (GtkListStore *list_store)
+{
+  GtkListStorePrivate *priv = list_store->priv;
+  GtkTreeDataSortHeader *header;
+  GtkTreeDataSortKey *keys;
+  GSequenceIter *siter, *end_siter;
+  GtkTreeDataRow *row;
+  gint *new_order;
+  gint column, n_rows, i;
+  GType type;
+
+  if (priv->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+    return NULL;
+
+  header = _gtk_tree_data_list_get_header (priv->sort_list,
+                                           priv->sort_column_id);
+  if (header == NULL || header->func != _gtk_tree_data_list_compare_func)
+    return NULL;
+
+  column = GPOINTER_TO_INT (header->data);
+  if (column < 0 || column >= priv->n_columns)
+    return NULL;
+
+  type = priv->column_headers[column];
+  if (!_gtk_tree_data_sort_keys_supported (type))
+    return NULL;
+
+  n_rows = g_sequence_get_length (priv->seq);
+  keys = g_new (GtkTreeDataSortKey, n_rows);
+
+  end_siter = g_sequence_get_end_iter (priv->seq);
+  for (siter = g_sequence_get_begin_iter (priv->seq), i = 0;
+       siter != end_siter;
+       siter = g_sequence_iter_next (siter), i++)
+    {
+      GValue value = G_VALUE_INIT;
+
+      row = g_sequence_get (siter);
+      if (row == NULL)
+        g_value_init (&value, type);
+      else
+        _gtk_tree_data_row_get_value (row, priv->layout, column, &value);
+
+      _gtk_tree_data_sort_key_init (&keys[i], &value);
+      keys[i].index = i;
+      keys[i].data = siter;
+
+      g_value_unset (&value);
+    }
+
+  _gtk_tree_data_sort_keys_sort (keys, n_rows, type, priv->order);
+
+  new_order = g_new (gint, n_rows);
+  for (i = 0; i < n_rows; i++)
+    {
+      new_order[i] = keys[i].index;
+      g_sequence_move (keys[i].data, end_siter);
+    }
+
+  _gtk_tree_data_sort_keys_free (keys, n_rows, type);
+
+  return new_order;
+}
+
 static void
 gtk_list_store_sort (GtkListStore *list_store)
 {
@@ -1966,13 +2077,17 @@ gtk_list_store_sort (GtkListStore *list_store)
       g_sequence_get_length (priv->seq) <= 1)
     return;
 
-  old_positions = save_positions (priv->seq);
+  new_order = gtk_list_store_sort_by_keys (list_store);
+  if (new_order == NULL)
+    {
+      old_positions = save_positions (priv->seq);
 
-  g_sequence_sort_iter (priv->seq, gtk_list_store_compare_func, list_store);
+      g_sequence_sort_iter (priv->seq, gtk_list_store_compare_func, list_store);
 
-  /* Let the world know about our new order */
-  new_order = generate_order (priv->seq, old_positions);
+      new_order = generate_order (priv->seq, old_positions);
+    }
 
+  /* Let the world know about our new order */
   path = gtk_tree_path_new ();
   gtk_tree_model_rows_reordered (GTK_TREE_MODEL (list_store),
 				 path, NULL, new_order);
@@ -2086,6 +2201,8 @@ gtk_list_store_set_sort_column_id (GtkTreeSortable  *sortable,
     }
 
 
+  gtk_list_store_flush_batch (list_store);
+
   priv->sort_column_id = sort_column_id;
   priv->order = order;
 
@@ -2104,6 +2221,8 @@ gtk_list_store_set_sort_func (GtkTreeSortable        *sortable,
   GtkListStore *list_store = GTK_LIST_STORE (sortable);
   GtkListStorePrivate *priv = list_store->priv;
 
+  gtk_list_store_flush_batch (list_store);
+
   priv->sort_list = _gtk_tree_data_list_set_header (priv->sort_list, 
 							  sort_column_id, 
 							  func, data, destroy);
@@ -2121,6 +2240,8 @@ gtk_list_store_set_default_sort_func (GtkTreeSortable        *sortable,
   GtkListStore *list_store = GTK_LIST_STORE (sortable);
   GtkListStorePrivate *priv = list_store->priv;
 
+  gtk_list_store_flush_batch (list_store);
+
   if (priv->default_sort_destroy)
     {
       GDestroyNotify d = priv->default_sort_destroy;
@@ -2200,6 +2321,16 @@ gtk_list_store_insert_with_values (GtkListStore *list_store,
   if (!iter)
     iter = &tmp_iter;
 
+  if (gtk_list_store_defer_insert (list_store, iter, position))
+    {
+      va_start (var_args, position);
+      gtk_list_store_set_valist_internal (list_store, iter,
+                                          &changed, &maybe_need_sort,
+                                          var_args);
+      va_end (var_args);
+      return;
+    }
+
   priv->columns_dirty = TRUE;
 
   seq = priv->seq;
@@ -2280,6 +2411,14 @@ gtk_list_store_insert_with_valuesv (GtkListStore *list_store,
   if (!iter)
     iter = &tmp_iter;
 
+  if (gtk_list_store_defer_insert (list_store, iter, position))
+    {
+      gtk_list_store_set_vector_internal (list_store, iter,
+                                          &changed, &maybe_need_sort,
+                                          columns, values, n_values);
+      return;
+    }
+
   priv->columns_dirty = TRUE;
 
   seq = priv->seq;
@@ -2314,6 +2453,305 @@ gtk_list_store_insert_with_valuesv (GtkListStore *list_store,
   gtk_tree_path_free (path);
 }
 
+/* Batches */
+
+static gboolean
+gtk_list_store_row_is_pending (GtkListStore  *list_store,
+                               GSequenceIter *ptr)
+{
+  return g_sequence_iter_get_sequence (ptr) == list_store->priv->batch_seq;
+}
+
+/* Appends the row to the pending rows if we are in a batch.
+ * Otherwise, or for any other position, announces the pending
+ * rows first and returns %FALSE.
+ */
+static gboolean
+gtk_list_store_defer_insert (GtkListStore *list_store,
+                             GtkTreeIter  *iter,
+                             gint          position)
+{
+  GtkListStorePrivate *priv = list_store->priv;
+
+  if (priv->batch_depth == 0 ||
+      (position >= 0 && position < priv->length))
+    {
+      gtk_list_store_flush_batch (list_store);
+      return FALSE;
+    }
+
+  priv->columns_dirty = TRUE;
+
+  iter->stamp = priv->stamp;
+  iter->user_data = g_sequence_append (priv->batch_seq, NULL);
+
+  return TRUE;
+}
+
+static gint
+gtk_list_store_compare_rows (gconstpointer a,
+                             gconstpointer b,
+                             gpointer      user_data)
+{
+  return gtk_list_store_compare_func (*(GSequenceIter **) a,
+                                      *(GSequenceIter **) b,
+                                      user_data);
+}
+
+static void
+gtk_list_store_flush_batch (GtkListStore *list_store)
+{
+  GtkListStorePrivate *priv = list_store->priv;
+  GSequenceIter **rows;
+  GSequenceIter *ptr;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  GSList *l;
+  gint *indices;
+  gint n_rows;
+  gint pos;
+  gint i;
+
+  /* A ::row-inserted handler changing the store while we announce
+   * the rows doesn't get the rest of them early
+   */
+  if (priv->emitting_batch)
+    return;
+
+  n_rows = g_sequence_get_length (priv->batch_seq);
+  if (n_rows == 0)
+    return;
+
+  rows = g_new (GSequenceIter *, n_rows);
+  indices = g_new (gint, n_rows);
+
+  ptr = g_sequence_get_begin_iter (priv->batch_seq);
+  for (i = 0; i < n_rows; i++)
+    {
+      rows[i] = ptr;
+      ptr = g_sequence_iter_next (ptr);
+    }
+
+  /* Sort the new rows on their own, so that they can be merged
+   * into the sorted part of the list in a single pass
+   */
+  if (GTK_LIST_STORE_IS_SORTED (list_store))
+    g_qsort_with_data (rows, n_rows, sizeof (GSequenceIter *),
+                       gtk_list_store_compare_rows, list_store);
+
+  /* Move the rows into the list one at a time and announce each of
+   * them once it is there, so that ::row-inserted handlers always see
+   * the rows they were told about and no others. Moving a row keeps
+   * the iters pointing to it valid.
+   *
+   * Views that registered a rows-inserted handler ignore these
+   * signals and get all the rows at once below.
+   */
+  priv->emitting_batch = TRUE;
+
+  pos = 0;
+  for (i = 0; i < n_rows; i++)
+    {
+      gint lo = MIN (pos, priv->length);
+
+      if (GTK_LIST_STORE_IS_SORTED (list_store))
+        {
+          gint hi = priv->length;
+
+          while (lo < hi)
+            {
+              gint mid = lo + (hi - lo) / 2;
+
+              ptr = g_sequence_get_iter_at_pos (priv->seq, mid);
+              if (gtk_list_store_compare_func (ptr, rows[i], list_store) > 0)
+                hi = mid;
+              else
+                lo = mid + 1;
+            }
+        }
+      else
+        lo = priv->length;
+
+      g_sequence_move (rows[i], g_sequence_get_iter_at_pos (priv->seq, lo));
+      priv->length++;
+
+      indices[i] = lo;
+      pos = lo + 1;
+
+      iter.stamp = priv->stamp;
+      iter.user_data = rows[i];
+
+      path = gtk_tree_path_new_from_indices (lo, -1);
+      gtk_tree_model_row_inserted (GTK_TREE_MODEL (list_store), path, &iter);
+      gtk_tree_path_free (path);
+    }
+
+  priv->emitting_batch = FALSE;
+
+  for (l = priv->rows_inserted_handlers; l; l = l->next)
+    {
+      RowsInsertedHandler *handler = l->data;
+
+      handler->func (list_store, indices, n_rows, handler->data);
+    }
+
+  g_free (rows);
+  g_free (indices);
+}
+
+/**
+ * gtk_list_store_begin_batch:
+ * @list_store: a #GtkListStore
+ *
+ * Starts a batch of appends. Rows appended to @list_store until the
+ * matching call to gtk_list_store_end_batch() are not announced to
+ * views one by one; they are sorted and announced together when the
+ * batch ends. Values can be set on them in the meantime without
+ * emitting any signal.
+ *
+ * The rows appended during a batch are not part of @list_store
+ * until they are announced: they have no path, and don’t show up
+ * when iterating over @list_store. Any other change to @list_store
+ * during the batch announces the rows appended so far first.
+ *
+ * Batches can be nested.
+ *
+ * Since: 3.20
+ */
+void
+gtk_list_store_begin_batch (GtkListStore *list_store)
+{
+  GtkListStorePrivate *priv;
+
+  g_return_if_fail (GTK_IS_LIST_STORE (list_store));
+
+  priv = list_store->priv;
+
+  priv->batch_depth++;
+}
+
+/**
+ * gtk_list_store_end_batch:
+ * @list_store: a #GtkListStore
+ *
+ * Ends a batch started with gtk_list_store_begin_batch(). When the
+ * outermost batch ends, the rows appended during it are sorted into
+ * place and announced.
+ *
+ * Since: 3.20
+ */
+void
+gtk_list_store_end_batch (GtkListStore *list_store)
+{
+  GtkListStorePrivate *priv;
+
+  g_return_if_fail (GTK_IS_LIST_STORE (list_store));
+
+  priv = list_store->priv;
+
+  g_return_if_fail (priv->batch_depth > 0);
+
+  if (--priv->batch_depth > 0)
+    return;
+
+  gtk_list_store_flush_batch (list_store);
+}
+
+/**
+ * gtk_list_store_append_rows:
+ * @list_store: A #GtkListStore
+ * @n_rows: the number of rows to append
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array): an array of @n_rows * @n_values GValues
+ * @n_values: the length of the @columns array
+ *
+ * Appends @n_rows rows to @list_store, setting the given columns of
+ * each of them. @values holds the values column by column: the value
+ * of @columns[j] in the i-th new row is @values[j * @n_rows + i].
+ *
+ * This is much faster than appending the rows one by one when the
+ * store is sorted or shown in a #GtkTreeView, since it is the same as
+ * calling gtk_list_store_insert_with_valuesv() for each row in a
+ * batch, see gtk_list_store_begin_batch().
+ *
+ * Since: 3.20
+ */
+void
+gtk_list_store_append_rows (GtkListStore *list_store,
+                            gint          n_rows,
+                            gint         *columns,
+                            GValue       *values,
+                            gint          n_values)
+{
+  GValue *row;
+  gint i, j;
+
+  g_return_if_fail (GTK_IS_LIST_STORE (list_store));
+  g_return_if_fail (n_rows >= 0);
+  g_return_if_fail (n_values == 0 || (columns != NULL && values != NULL));
+
+  row = g_new (GValue, MAX (n_values, 1));
+
+  gtk_list_store_begin_batch (list_store);
+
+  for (i = 0; i < n_rows; i++)
+    {
+      /* Shallow copies, the values are only read from */
+      for (j = 0; j < n_values; j++)
+        row[j] = values[j * n_rows + i];
+
+      gtk_list_store_insert_with_valuesv (list_store, NULL, -1,
+                                          columns, row, n_values);
+    }
+
+  gtk_list_store_end_batch (list_store);
+
+  g_free (row);
+}
+
+/* Private API */
+
+void
+_gtk_list_store_add_rows_inserted_handler (GtkListStore                 *list_store,
+                                           GtkListStoreRowsInsertedFunc  func,
+                                           gpointer                      data)
+{
+  GtkListStorePrivate *priv = list_store->priv;
+  RowsInsertedHandler *handler;
+
+  handler = g_new (RowsInsertedHandler, 1);
+  handler->func = func;
+  handler->data = data;
+
+  priv->rows_inserted_handlers = g_slist_prepend (priv->rows_inserted_handlers, handler);
+}
+
+void
+_gtk_list_store_remove_rows_inserted_handler (GtkListStore *list_store,
+                                              gpointer      data)
+{
+  GtkListStorePrivate *priv = list_store->priv;
+  GSList *l;
+
+  for (l = priv->rows_inserted_handlers; l; l = l->next)
+    {
+      RowsInsertedHandler *handler = l->data;
+
+      if (handler->data == data)
+        {
+          priv->rows_inserted_handlers = g_slist_delete_link (priv->rows_inserted_handlers, l);
+          g_free (handler);
+          return;
+        }
+    }
+}
+
+gboolean
+_gtk_list_store_is_emitting_batch (GtkListStore *list_store)
+{
+  return list_store->priv->emitting_batch;
+}
+
 /* GtkBuildable custom tag implementation
  *
  * <columns>
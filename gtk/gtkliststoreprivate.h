@@ -0,0 +1,48 @@
+/* gtkliststoreprivate.h
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_LIST_STORE_PRIVATE_H__
+#define __GTK_LIST_STORE_PRIVATE_H__
+
+#include <gtk/gtkliststore.h>
+
+G_BEGIN_DECLS
+
+/* Called once for all the rows appended in a batch, instead of
+ * ::row-inserted for each of them. @indices are sorted in ascending
+ * order and are positions in the store after the insertion.
+ */
+typedef void (* GtkListStoreRowsInsertedFunc) (GtkListStore *list_store,
+                                               const gint   *indices,
+                                               gint          n_rows,
+                                               gpointer      data);
+
+/* The store still emits ::row-inserted for each row of a batch, for
+ * everybody else. Views that register @func must ignore ::row-inserted
+ * while _gtk_list_store_is_emitting_batch() returns %TRUE, the rows are
+ * passed to @func once all of them have been announced.
+ */
+void     _gtk_list_store_add_rows_inserted_handler    (GtkListStore                 *list_store,
+                                                       GtkListStoreRowsInsertedFunc  func,
+                                                       gpointer                      data);
+void     _gtk_list_store_remove_rows_inserted_handler (GtkListStore                 *list_store,
+                                                       gpointer                      data);
+gboolean _gtk_list_store_is_emitting_batch            (GtkListStore                 *list_store);
+
+G_END_DECLS
+
+#endif /* __GTK_LIST_STORE_PRIVATE_H__ */
@@ -21,7 +21,8 @@
 
 static GtkRBNode * _gtk_rbnode_new                (GtkRBTree  *tree,
 						   gint        height);
-static void        _gtk_rbnode_free               (GtkRBNode  *node);
+static void        _gtk_rbnode_free               (GtkRBTree  *tree,
+                                                   GtkRBNode  *node);
 static void        _gtk_rbnode_rotate_left        (GtkRBTree  *tree,
 						   GtkRBNode  *node);
 static void        _gtk_rbnode_rotate_right       (GtkRBTree  *tree,
@@ -53,11 +54,87 @@ _gtk_rbtree_is_nil (GtkRBNode *node)
   return node == &nil;
 }
 
+/* Nodes are carved out of chunks that a tree shares with all of its
+ * child trees. This keeps the nodes of a tree view close together in
+ * memory, instead of scattered among everything else allocated with
+ * g_slice, which is what makes walking a big tree slow.
+ *
+ * Chunks grow with the tree, so that small trees stay small. Freed
+ * nodes are kept for reuse until all the trees using the arena are
+ * gone.
+ */
+#define ARENA_MIN_CHUNK_SIZE 16
+#define ARENA_MAX_CHUNK_SIZE 4096
+
+struct _GtkRBNodeArena
+{
+  gint ref_count;
+
+  GSList *chunks;
+  GtkRBNode *free_nodes;        /* linked through ->left */
+  guint n_unused;               /* at the end of chunks->data */
+  guint chunk_size;
+};
+
+static GtkRBNodeArena *
+gtk_rbnode_arena_get (GtkRBTree *tree)
+{
+  if (tree->arena == NULL)
+    {
+      if (tree->parent_tree)
+        tree->arena = gtk_rbnode_arena_get (tree->parent_tree);
+      else
+        tree->arena = g_new0 (GtkRBNodeArena, 1);
+
+      tree->arena->ref_count++;
+    }
+
+  return tree->arena;
+}
+
+static void
+gtk_rbnode_arena_unref (GtkRBNodeArena *arena)
+{
+  if (--arena->ref_count > 0)
+    return;
+
+  g_slist_free_full (arena->chunks, g_free);
+  g_free (arena);
+}
+
+static GtkRBNode *
+gtk_rbnode_arena_alloc (GtkRBNodeArena *arena)
+{
+  GtkRBNode *node;
+
+  if (arena->free_nodes)
+    {
+      node = arena->free_nodes;
+      arena->free_nodes = node->left;
+      return node;
+    }
+
+  if (arena->n_unused == 0)
+    {
+      if (arena->chunk_size < ARENA_MAX_CHUNK_SIZE)
+        arena->chunk_size = MAX (ARENA_MIN_CHUNK_SIZE, arena->chunk_size * 2);
+
+      arena->chunks = g_slist_prepend (arena->chunks,
+                                       g_new (GtkRBNode, arena->chunk_size));
+      arena->n_unused = arena->chunk_size;
+    }
+
+  node = (GtkRBNode *) arena->chunks->data + (arena->chunk_size - arena->n_unused);
+  arena->n_unused--;
+
+  return node;
+}
+
 static GtkRBNode *
 _gtk_rbnode_new (GtkRBTree *tree,
 		 gint       height)
 {
-  GtkRBNode *node = g_slice_new (GtkRBNode);
+  GtkRBNode *node = gtk_rbnode_arena_alloc (gtk_rbnode_arena_get (tree));
 
   node->left = (GtkRBNode *) &nil;
   node->right = (GtkRBNode *) &nil;
@@ -71,8 +148,11 @@ _gtk_rbnode_new (GtkRBTree *tree,
 }
 
 static void
-_gtk_rbnode_free (GtkRBNode *node)
+_gtk_rbnode_free (GtkRBTree *tree,
+                  GtkRBNode *node)
 {
+  GtkRBNodeArena *arena = tree->arena;
+
 #ifdef G_ENABLE_DEBUG
   if (GTK_DEBUG_CHECK (TREE))
     {
@@ -85,7 +165,8 @@ _gtk_rbnode_free (GtkRBNode *node)
       node->flags = 0;
     }
 #endif
-  g_slice_free (GtkRBNode, node);
+  node->left = arena->free_nodes;
+  arena->free_nodes = node;
 }
 
 static void
@@ -332,6 +413,7 @@ _gtk_rbtree_new (void)
   retval = g_new (GtkRBTree, 1);
   retval->parent_tree = NULL;
   retval->parent_node = NULL;
+  retval->arena = NULL;
 
   retval->root = (GtkRBNode *) &nil;
 
@@ -346,7 +428,7 @@ _gtk_rbtree_free_helper (GtkRBTree  *tree,
   if (node->children)
     _gtk_rbtree_free (node->children);
 
-  _gtk_rbnode_free (node);
+  _gtk_rbnode_free (tree, node);
 }
 
 void
@@ -361,6 +443,8 @@ _gtk_rbtree_free (GtkRBTree *tree)
   if (tree->parent_node &&
       tree->parent_node->children == tree)
     tree->parent_node->children = NULL;
+  if (tree->arena)
+    gtk_rbnode_arena_unref (tree->arena);
   g_free (tree);
 }
 
@@ -738,31 +822,60 @@ _gtk_rbtree_mark_invalid (GtkRBTree *tree)
   while ((node = _gtk_rbtree_next (tree, node)) != NULL);
 }
 
+/* Sets the height of the invalid nodes below node and returns the new
+ * offset of node. Every node is visited once and offsets are summed up
+ * on the way back, instead of walking up to the root for each row.
+ */
+static gint
+set_fixed_height_subtree (GtkRBTree *tree,
+                          GtkRBNode *node,
+                          gint       height,
+                          gboolean   mark_valid)
+{
+  gint node_height;
+
+  if (_gtk_rbtree_is_nil (node))
+    return 0;
+
+  node_height = GTK_RBNODE_GET_HEIGHT (node);
+
+  if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_INVALID))
+    {
+      node_height = height;
+      if (mark_valid)
+        {
+          GTK_RBNODE_UNSET_FLAG (node, GTK_RBNODE_INVALID);
+          GTK_RBNODE_UNSET_FLAG (node, GTK_RBNODE_COLUMN_INVALID);
+        }
+    }
+
+  node->offset = node_height;
+  node->offset += set_fixed_height_subtree (tree, node->left, height, mark_valid);
+  node->offset += set_fixed_height_subtree (tree, node->right, height, mark_valid);
+  if (node->children)
+    node->offset += set_fixed_height_subtree (node->children, node->children->root,
+                                              height, mark_valid);
+
+  _fixup_validation (tree, node);
+
+  return node->offset;
+}
+
 void
 _gtk_rbtree_set_fixed_height (GtkRBTree *tree,
 			      gint       height,
 			      gboolean   mark_valid)
 {
-  GtkRBNode *node;
+  gint old_offset;
 
   if (tree == NULL)
     return;
 
-  node = _gtk_rbtree_first (tree);
-
-  do
-    {
-      if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_INVALID))
-        {
-	  _gtk_rbtree_node_set_height (tree, node, height);
-	  if (mark_valid)
-	    _gtk_rbtree_node_mark_valid (tree, node);
-	}
+  old_offset = tree->root->offset;
+  set_fixed_height_subtree (tree, tree->root, height, mark_valid);
 
-      if (node->children)
-	_gtk_rbtree_set_fixed_height (node->children, height, mark_valid);
-    }
-  while ((node = _gtk_rbtree_next (tree, node)) != NULL);
+  gtk_rbnode_adjust (tree->parent_tree, tree->parent_node,
+                     0, 0, tree->root->offset - old_offset);
 }
 
 static void
@@ -785,49 +898,76 @@ reorder_fixup (GtkRBTree *tree,
   _fixup_total_count (tree, node);
 }
 
+static GtkRBNode *
+gtk_rbtree_build_balanced (GtkRBTree  *tree,
+                           GtkRBNode **nodes,
+                           gint        n_nodes,
+                           gint        depth,
+                           gint        red_depth,
+                           GtkRBNode  *parent)
+{
+  GtkRBNode *node;
+  gint mid;
+
+  if (n_nodes == 0)
+    return (GtkRBNode *) &nil;
+
+  mid = n_nodes / 2;
+  node = nodes[mid];
+
+  node->parent = parent;
+  node->left = gtk_rbtree_build_balanced (tree, nodes, mid,
+                                          depth + 1, red_depth, node);
+  node->right = gtk_rbtree_build_balanced (tree, nodes + mid + 1, n_nodes - mid - 1,
+                                           depth + 1, red_depth, node);
+
+  node->flags = (node->flags & GTK_RBNODE_NON_COLORS) |
+                (depth == red_depth ? GTK_RBNODE_RED : GTK_RBNODE_BLACK);
+  reorder_fixup (tree, node, NULL);
+
+  return node;
+}
+
+/* Relinks @nodes into @tree, in that order, as a balanced tree. This
+ * is O(n), compared to O(n log n) for inserting them one by one.
+ *
+ * The offsets of the nodes must not include their children's, see
+ * reorder_prepare(). Splitting at the middle keeps all leaves on the
+ * last two levels, so coloring the last level red and everything else
+ * black gives a valid tree.
+ */
 static void
-reorder_copy_node (GtkRBTree *tree,
-                   GtkRBNode *to,
-                   GtkRBNode *from)
+gtk_rbtree_relink (GtkRBTree  *tree,
+                   GtkRBNode **nodes,
+                   gint        n_nodes)
 {
-  to->flags = (to->flags & GTK_RBNODE_NON_COLORS) | GTK_RBNODE_GET_COLOR (from);
-
-  to->left = from->left;
-  if (!_gtk_rbtree_is_nil (to->left))
-    to->left->parent = to;
-
-  to->right = from->right;
-  if (!_gtk_rbtree_is_nil (to->right))
-    to->right->parent = to;
-
-  to->parent = from->parent;
-  if (_gtk_rbtree_is_nil (to->parent))
-    tree->root = to;
-  else if (to->parent->left == from)
-    to->parent->left = to;
-  else if (to->parent->right == from)
-    to->parent->right = to;
+  gint depth;
+
+  for (depth = 0; (n_nodes >> (depth + 1)) > 0; depth++)
+    ;
+
+  tree->root = gtk_rbtree_build_balanced (tree, nodes, n_nodes,
+                                          0, depth > 0 ? depth : -1,
+                                          (GtkRBNode *) &nil);
 }
 
-/* It basically pulls everything out of the tree, rearranges it, and puts it
- * back together.  Our strategy is to keep the old RBTree intact, and just
- * rearrange the contents.  When that is done, we go through and update the
- * heights.  There is probably a more elegant way to write this function.  If
- * anyone wants to spend the time writing it, patches will be accepted.
+/* Rather than moving nodes around, this takes them all out of the
+ * tree and links them back together in the new order.
  */
 void
 _gtk_rbtree_reorder (GtkRBTree *tree,
 		     gint      *new_order,
 		     gint       length)
 {
-  GtkRBNode **nodes;
+  GtkRBNode **old_nodes, **nodes;
   GtkRBNode *node;
-  gint i, j;
+  gint i;
   
   g_return_if_fail (tree != NULL);
   g_return_if_fail (length > 0);
   g_return_if_fail (tree->root->count == length);
   
+  old_nodes = g_new (GtkRBNode *, length);
   nodes = g_new (GtkRBNode *, length);
 
   _gtk_rbtree_traverse (tree, tree->root, G_PRE_ORDER, reorder_prepare, NULL);
@@ -836,46 +976,87 @@ _gtk_rbtree_reorder (GtkRBTree *tree,
        node;
        node = _gtk_rbtree_next (tree, node), i++)
     {
-      nodes[i] = node;
+      old_nodes[i] = node;
     }
 
   for (i = 0; i < length; i++)
-    {
-      GtkRBNode tmp = { 0, };
-      GSList *l, *cycle = NULL;
+    nodes[i] = old_nodes[new_order[i]];
+
+  gtk_rbtree_relink (tree, nodes, length);
 
-      tmp.offset = -1;
+  g_free (old_nodes);
+  g_free (nodes);
+}
+
+/* Inserts a new node at each of the positions in @indices, which must
+ * be sorted and refer to the positions in the resulting tree. If
+ * @indices is %NULL, @n_indices nodes are appended, which is how a
+ * tree is built from scratch.
+ *
+ * Existing nodes are reused and keep their state, and the whole tree
+ * is relinked in O(n) rather than rebalanced once per new node.
+ */
+void
+_gtk_rbtree_insert_many (GtkRBTree *tree,
+                         const gint *indices,
+                         gint       n_indices,
+                         gint       height,
+                         gboolean   valid)
+{
+  GtkRBNode **nodes;
+  GtkRBNode *node;
+  guint old_total_count;
+  gint old_offset;
+  gint old_length, length;
+  gint i, j;
+
+  g_return_if_fail (tree != NULL);
+  g_return_if_fail (n_indices >= 0);
+
+  if (n_indices == 0)
+    return;
+
+  old_length = tree->root->count;
+  length = old_length + n_indices;
+  old_total_count = tree->root->total_count;
+  old_offset = tree->root->offset;
 
-      /* already swapped */
-      if (nodes[i] == NULL)
-        continue;
-      /* no need to swap */
-      if (new_order[i] == i)
-        continue;
+  nodes = g_new (GtkRBNode *, length);
+
+  _gtk_rbtree_traverse (tree, tree->root, G_PRE_ORDER, reorder_prepare, NULL);
 
-      /* make a list out of the pending nodes */
-      for (j = i; new_order[j] != i; j = new_order[j])
+  node = _gtk_rbtree_first (tree);
+  for (i = 0, j = 0; i < length; i++)
+    {
+      if (indices ? (j < n_indices && indices[j] == i) : i >= old_length)
         {
-          cycle = g_slist_prepend (cycle, nodes[j]);
-          nodes[j] = NULL;
+          nodes[i] = _gtk_rbnode_new (tree, height);
+          if (!valid)
+            GTK_RBNODE_SET_FLAG (nodes[i], GTK_RBNODE_INVALID);
+          j++;
         }
-
-      node = nodes[j];
-      reorder_copy_node (tree, &tmp, node);
-      for (l = cycle; l; l = l->next)
+      else
         {
-          reorder_copy_node (tree, node, l->data);
-          node = l->data;
+          g_assert (node != NULL);
+          nodes[i] = node;
+          node = _gtk_rbtree_next (tree, node);
         }
-
-      reorder_copy_node (tree, node, &tmp);
-      nodes[j] = NULL;
-      g_slist_free (cycle);
     }
+  g_assert (j == n_indices && node == NULL);
 
-  _gtk_rbtree_traverse (tree, tree->root, G_POST_ORDER, reorder_fixup, NULL);
+  gtk_rbtree_relink (tree, nodes, length);
+
+  gtk_rbnode_adjust (tree->parent_tree, tree->parent_node,
+                     0,
+                     tree->root->total_count - old_total_count,
+                     tree->root->offset - old_offset);
 
   g_free (nodes);
+
+#ifdef G_ENABLE_DEBUG
+  if (GTK_DEBUG_CHECK (TREE))
+    _gtk_rbtree_test (G_STRLOC, tree);
+#endif
 }
 
 /**
@@ -1224,7 +1405,7 @@ _gtk_rbtree_remove_node (GtkRBTree *tree,
                          y_height - node_height);
     }
 
-  _gtk_rbnode_free (node);
+  _gtk_rbnode_free (tree, node);
 
 #ifdef G_ENABLE_DEBUG
   if (GTK_DEBUG_CHECK (TREE))
@@ -46,6 +46,7 @@ typedef enum
 
 typedef struct _GtkRBTree GtkRBTree;
 typedef struct _GtkRBNode GtkRBNode;
+typedef struct _GtkRBNodeArena GtkRBNodeArena;
 typedef struct _GtkRBTreeView GtkRBTreeView;
 
 typedef void (*GtkRBTreeTraverseFunc) (GtkRBTree  *tree,
@@ -57,6 +58,9 @@ struct _GtkRBTree
   GtkRBNode *root;
   GtkRBTree *parent_tree;
   GtkRBNode *parent_node;
+
+  /* Where the nodes come from, shared with the child trees */
+  GtkRBNodeArena *arena;
 };
 
 struct _GtkRBNode
@@ -112,6 +116,11 @@ GtkRBNode *_gtk_rbtree_insert_after     (GtkRBTree              *tree,
 					 gboolean                valid);
 void       _gtk_rbtree_remove_node      (GtkRBTree              *tree,
 					 GtkRBNode              *node);
+void       _gtk_rbtree_insert_many      (GtkRBTree              *tree,
+					 const gint             *indices,
+					 gint                    n_indices,
+					 gint                    height,
+					 gboolean                valid);
 gboolean   _gtk_rbtree_is_nil           (GtkRBNode              *node);
 void       _gtk_rbtree_reorder          (GtkRBTree              *tree,
 					 gint                   *new_order,
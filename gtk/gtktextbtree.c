@@ -73,23 +73,6 @@
  */
 
 
-/*
- * The structure below is used to pass information between
- * _gtk_text_btree_get_tags and inc_count:
- */
-
-typedef struct TagInfo {
-  int numTags;                  /* Number of tags for which there
-                                 * is currently information in
-                                 * tags and counts. */
-  int arraySize;                        /* Number of entries allocated for
-                                         * tags and counts. */
-  GtkTextTag **tags;           /* Array of tags seen so far.
-                                * Malloc-ed. */
-  int *counts;                  /* Toggle count (so far) for each
-                                 * entry in tags.  Malloc-ed. */
-} TagInfo;
-
 
 /*
  * This is used to store per-view width/height info at the tree nodes.
@@ -133,6 +116,12 @@ typedef struct Summary {
  * The data structure below defines a node in the B-tree.
  */
 
+/* Tags in a node summary by their bit in the node's tag_mask. With
+ * more than 64 tags in a tree several share a bit, so a set bit still
+ * means checking the summary list.
+ */
+#define TAG_INFO_BIT(info) (G_GUINT64_CONSTANT (1) << ((info)->id % 64))
+
 struct _GtkTextBTreeNode {
   GtkTextBTreeNode *parent;         /* Pointer to parent node, or NULL if
                                      * this is the root. */
@@ -142,6 +131,10 @@ struct _GtkTextBTreeNode {
   Summary *summary;             /* First in malloc-ed list of info
                                  * about tags in this subtree (NULL if
                                  * no tag info in the subtree). */
+  guint64 tag_mask;             /* TAG_INFO_BIT() of the tags in the
+                                 * summary list, so that most lookups
+                                 * of tags that are not there don't
+                                 * need to walk it. */
   int level;                            /* Level of this node in the B-tree.
                                          * 0 refers to the bottom of the tree
                                          * (children are lines, not nodes). */
@@ -185,8 +178,23 @@ struct _GtkTextBTree {
   GtkTextBuffer *buffer;
   BTreeView *views;
   GSList *tag_infos;
+  GHashTable *tag_info_table;   /* GtkTextTag -> GtkTextTagInfo */
+  guint next_tag_info_id;
   gulong tag_changed_handler;
 
+  /* While tag redisplay is frozen, the ranges touched by tags that
+   * affect size and by tags that only affect appearance are merged
+   * into one range each, and the views are told about them once on
+   * thaw. The ranges are kept as marks, so that they follow text
+   * that signal handlers insert or delete in the meantime. NULL
+   * means nothing is pending.
+   */
+  guint tag_redisplay_freeze_count;
+  GtkTextMark *pending_invalidate_start;
+  GtkTextMark *pending_invalidate_end;
+  GtkTextMark *pending_redisplay_start;
+  GtkTextMark *pending_redisplay_end;
+
   /* Incremented when a segment with a byte size > 0
    * is added to or removed from the tree (i.e. the
    * length of a line may have changed, and lines may
@@ -262,7 +270,7 @@ static void              gtk_text_btree_node_adjust_toggle_count (GtkTextBTreeNo
                                                                   GtkTextTagInfo   *info,
                                                                   gint              adjust);
 static gboolean          gtk_text_btree_node_has_tag             (GtkTextBTreeNode *node,
-                                                                  GtkTextTag       *tag);
+                                                                  GtkTextTagInfo   *info);
 
 static void             segments_changed                (GtkTextBTree     *tree);
 static void             chars_changed                   (GtkTextBTree     *tree);
@@ -322,9 +330,6 @@ static void tag_changed_cb        (GtkTextTagTable  *table,
 static void cleanup_line          (GtkTextLine      *line);
 static void recompute_node_counts (GtkTextBTree     *tree,
                                    GtkTextBTreeNode *node);
-static void inc_count             (GtkTextTag       *tag,
-                                   int               inc,
-                                   TagInfo          *tagInfoPtr);
 
 static void summary_destroy       (Summary          *summary);
 
@@ -430,7 +435,7 @@ _gtk_text_btree_new (GtkTextTagTable *table,
   tree->end_iter_line = NULL;
   tree->end_iter_segment_byte_index = 0;
   tree->end_iter_segment_char_offset = 0;
-  
+
   g_object_ref (tree->table);
 
   tree->tag_changed_handler = g_signal_connect (tree->table,
@@ -440,6 +445,7 @@ _gtk_text_btree_new (GtkTextTagTable *table,
 
   tree->mark_table = g_hash_table_new (g_str_hash, g_str_equal);
   tree->child_anchor_table = NULL;
+  tree->tag_info_table = g_hash_table_new (NULL, NULL);
   
   /* We don't ref the buffer, since the buffer owns us;
    * we'd have some circularity issues. The buffer always
@@ -522,6 +528,8 @@ _gtk_text_btree_unref (GtkTextBTree *tree)
 	  g_hash_table_destroy (tree->child_anchor_table);
 	  tree->child_anchor_table = NULL;
 	}
+      g_hash_table_destroy (tree->tag_info_table);
+      tree->tag_info_table = NULL;
 
       g_object_unref (tree->insert_mark);
       tree->insert_mark = NULL;
@@ -1092,6 +1100,97 @@ _gtk_text_btree_delete (GtkTextIter *start,
   gtk_text_btree_resolve_bidi (start, end);
 }
 
+#define ONES  ((guint64) 0x0101010101010101)
+#define HIGHS ((guint64) 0x8080808080808080)
+
+/* Nonzero if any byte in @word is @byte */
+#define HAS_BYTE(word, byte) \
+  ((((word) ^ (ONES * (byte))) - ONES) & ~((word) ^ (ONES * (byte))) & HIGHS)
+
+/* Like pango_find_paragraph_boundary(), but only looks at the bytes
+ * of @text, which must be valid UTF-8, and counts the characters up
+ * to @eol in @n_chars while at it. Stretches without a paragraph
+ * separator are skipped 8 bytes at a time, and their characters are
+ * counted as the bytes that are not continuation bytes.
+ */
+static void
+find_paragraph_boundary (const gchar *text,
+                         gint         length,
+                         gint        *delim,
+                         gint        *eol,
+                         gint        *n_chars)
+{
+  const guchar *p = (const guchar *) text;
+  gint chars = 0;
+  gint i = 0;
+
+  while (TRUE)
+    {
+      while (i + 8 <= length)
+        {
+          guint64 word;
+          guint64 cont;
+
+          memcpy (&word, p + i, 8);
+
+          if (HAS_BYTE (word, '\n') || HAS_BYTE (word, '\r') || HAS_BYTE (word, 0xe2))
+            break;
+
+          /* Continuation bytes are 10xxxxxx */
+          cont = (word >> 7) & ~(word >> 6) & ONES;
+          chars += 8 - (gint) ((cont * ONES) >> 56);
+          i += 8;
+        }
+
+      if (i >= length)
+        break;
+
+      if (p[i] == '\n')
+        {
+          *delim = i;
+          *eol = i + 1;
+          *n_chars = chars + 1;
+          return;
+        }
+      else if (p[i] == '\r')
+        {
+          *delim = i;
+          if (i + 1 < length && p[i + 1] == '\n')
+            {
+              *eol = i + 2;
+              *n_chars = chars + 2;
+            }
+          else
+            {
+              *eol = i + 1;
+              *n_chars = chars + 1;
+            }
+          return;
+        }
+      else if (p[i] == 0xe2 && i + 2 < length &&
+               p[i + 1] == 0x80 && p[i + 2] == 0xa9)
+        {
+          /* U+2029 PARAGRAPH SEPARATOR */
+          *delim = i;
+          *eol = i + 3;
+          *n_chars = chars + 1;
+          return;
+        }
+
+      if ((p[i] & 0xc0) != 0x80)
+        chars++;
+      i++;
+    }
+
+  *delim = length;
+  *eol = length;
+  *n_chars = chars;
+}
+
+#undef HAS_BYTE
+#undef HIGHS
+#undef ONES
+
 void
 _gtk_text_btree_insert (GtkTextIter *iter,
                         const gchar *text,
@@ -1114,6 +1213,7 @@ _gtk_text_btree_insert (GtkTextIter *iter,
                                        * one in current chunk.
                                        */
   gint delim;                          /* index of paragraph delimiter */
+  gint n_chars;                        /* # characters in current chunk */
   int line_count_delta;                /* Counts change to total number of
                                         * lines in file.
                                         */
@@ -1162,10 +1262,11 @@ _gtk_text_btree_insert (GtkTextIter *iter,
     {
       sol = eol;
       
-      pango_find_paragraph_boundary (text + sol,
-                                     len - sol,
-                                     &delim,
-                                     &eol);      
+      find_paragraph_boundary (text + sol,
+                               len - sol,
+                               &delim,
+                               &eol,
+                               &n_chars);
 
       /* make these relative to the start of the text */
       delim += sol;
@@ -1179,8 +1280,7 @@ _gtk_text_btree_insert (GtkTextIter *iter,
       
       chunk_len = eol - sol;
 
-      g_assert (g_utf8_validate (&text[sol], chunk_len, NULL));
-      seg = _gtk_char_segment_new (&text[sol], chunk_len);
+      seg = _gtk_char_segment_new_with_chars (&text[sol], chunk_len, n_chars);
 
       char_count_delta += seg->char_count;
 
@@ -1745,12 +1845,70 @@ iter_stack_invert (IterStack *stack)
     }
 }
 
+static void
+add_pending_range (GtkTextBTree       *tree,
+                   GtkTextMark       **pending_start,
+                   GtkTextMark       **pending_end,
+                   const GtkTextIter  *start,
+                   const GtkTextIter  *end)
+{
+  GtkTextIter iter;
+
+  /* Text inserted at either end of the range is part of it */
+  if (*pending_start == NULL)
+    {
+      *pending_start = _gtk_text_btree_set_mark (tree, NULL, NULL, TRUE, start, FALSE);
+      *pending_end = _gtk_text_btree_set_mark (tree, NULL, NULL, FALSE, end, FALSE);
+      return;
+    }
+
+  _gtk_text_btree_get_iter_at_mark (tree, &iter, *pending_start);
+  if (gtk_text_iter_compare (start, &iter) < 0)
+    _gtk_text_btree_set_mark (tree, *pending_start, NULL, TRUE, start, FALSE);
+
+  _gtk_text_btree_get_iter_at_mark (tree, &iter, *pending_end);
+  if (gtk_text_iter_compare (end, &iter) > 0)
+    _gtk_text_btree_set_mark (tree, *pending_end, NULL, FALSE, end, FALSE);
+}
+
+/* Gets the range of a pending redisplay and removes its marks */
+static void
+take_pending_range (GtkTextBTree  *tree,
+                    GtkTextMark  **pending_start,
+                    GtkTextMark  **pending_end,
+                    GtkTextIter   *start,
+                    GtkTextIter   *end)
+{
+  _gtk_text_btree_get_iter_at_mark (tree, start, *pending_start);
+  _gtk_text_btree_get_iter_at_mark (tree, end, *pending_end);
+
+  _gtk_text_btree_remove_mark (tree, *pending_start);
+  _gtk_text_btree_remove_mark (tree, *pending_end);
+  *pending_start = NULL;
+  *pending_end = NULL;
+}
+
 static void
 queue_tag_redisplay (GtkTextBTree      *tree,
                      GtkTextTag        *tag,
                      const GtkTextIter *start,
                      const GtkTextIter *end)
 {
+  if (tree->tag_redisplay_freeze_count > 0)
+    {
+      if (_gtk_text_tag_affects_size (tag))
+        add_pending_range (tree,
+                           &tree->pending_invalidate_start,
+                           &tree->pending_invalidate_end,
+                           start, end);
+      else if (_gtk_text_tag_affects_nonsize_appearance (tag))
+        add_pending_range (tree,
+                           &tree->pending_redisplay_start,
+                           &tree->pending_redisplay_end,
+                           start, end);
+      return;
+    }
+
   if (_gtk_text_tag_affects_size (tag))
     {
       DV (g_print ("invalidating due to size-affecting tag (%s)\n", G_STRLOC));
@@ -1765,6 +1923,54 @@ queue_tag_redisplay (GtkTextBTree      *tree,
   /* We don't need to do anything if the tag doesn't affect display */
 }
 
+/* Stops _gtk_text_btree_tag() from invalidating or redrawing the views
+ * for each range it tags. The ranges are collected instead, and
+ * _gtk_text_btree_thaw_tag_redisplay() sends them to the views as one
+ * invalidated region and one redrawn region.
+ */
+void
+_gtk_text_btree_freeze_tag_redisplay (GtkTextBTree *tree)
+{
+  tree->tag_redisplay_freeze_count++;
+}
+
+/* Reverses a call to _gtk_text_btree_freeze_tag_redisplay(), updating
+ * the views for everything that was tagged in the meantime once the
+ * count drops to zero.
+ */
+void
+_gtk_text_btree_thaw_tag_redisplay (GtkTextBTree *tree)
+{
+  GtkTextIter start, end;
+
+  g_return_if_fail (tree->tag_redisplay_freeze_count > 0);
+
+  tree->tag_redisplay_freeze_count--;
+  if (tree->tag_redisplay_freeze_count > 0)
+    return;
+
+  if (tree->pending_invalidate_start != NULL)
+    {
+      take_pending_range (tree,
+                          &tree->pending_invalidate_start,
+                          &tree->pending_invalidate_end,
+                          &start, &end);
+
+      DV (g_print ("invalidating due to size-affecting tags (%s)\n", G_STRLOC));
+      _gtk_text_btree_invalidate_region (tree, &start, &end, FALSE);
+    }
+
+  if (tree->pending_redisplay_start != NULL)
+    {
+      take_pending_range (tree,
+                          &tree->pending_redisplay_start,
+                          &tree->pending_redisplay_end,
+                          &start, &end);
+
+      redisplay_region (tree, &start, &end, FALSE);
+    }
+}
+
 void
 _gtk_text_btree_tag (const GtkTextIter *start_orig,
                      const GtkTextIter *end_orig,
@@ -2208,6 +2414,8 @@ _gtk_text_btree_get_line_at_char (GtkTextBTree      *tree,
   return line;
 }
 
+#define LOTSA_TAGS 1000
+
 /* It returns an array sorted by tags priority, ready to pass to
  * _gtk_text_attributes_fill_from_tags() */
 GtkTextTag**
@@ -2217,20 +2425,36 @@ _gtk_text_btree_get_tags (const GtkTextIter *iter,
   GtkTextBTreeNode *node;
   GtkTextLine *siblingline;
   GtkTextLineSegment *seg;
-  int src, dst, index;
-  TagInfo tagInfo;
+  int index;
+  int numTags;
+  int deftagCnts[LOTSA_TAGS];
+  int *tagCnts = deftagCnts;
+  GtkTextTag *deftags[LOTSA_TAGS];
+  GtkTextTag **tags = deftags;
+  GtkTextTag **result;
+  GtkTextTag *tag;
   GtkTextLine *line;
+  GtkTextBTree *tree;
   gint byte_index;
-
-#define NUM_TAG_INFOS 10
+  int i, n;
 
   line = _gtk_text_iter_get_text_line (iter);
+  tree = _gtk_text_iter_get_btree (iter);
   byte_index = gtk_text_iter_get_line_index (iter);
 
-  tagInfo.numTags = 0;
-  tagInfo.arraySize = NUM_TAG_INFOS;
-  tagInfo.tags = g_new (GtkTextTag*, NUM_TAG_INFOS);
-  tagInfo.counts = g_new (int, NUM_TAG_INFOS);
+  /* The toggle counts are kept by tag priority, like in
+   * _gtk_text_btree_char_is_invisible(), so that adding up the
+   * toggles doesn't need a search for the tag.
+   */
+  numTags = gtk_text_tag_table_get_size (tree->table);
+
+  if (LOTSA_TAGS < numTags)
+    {
+      tagCnts = g_new0 (int, numTags);
+      tags = g_new (GtkTextTag*, numTags);
+    }
+  else
+    memset (tagCnts, 0, numTags * sizeof (int));
 
   /*
    * Record tag toggles within the line of indexPtr but preceding
@@ -2245,7 +2469,9 @@ _gtk_text_btree_get_tags (const GtkTextIter *iter,
       if ((seg->type == &gtk_text_toggle_on_type)
           || (seg->type == &gtk_text_toggle_off_type))
         {
-          inc_count (seg->body.toggle.info->tag, 1, &tagInfo);
+          tag = seg->body.toggle.info->tag;
+          tags[tag->priv->priority] = tag;
+          tagCnts[tag->priv->priority]++;
         }
     }
 
@@ -2264,7 +2490,9 @@ _gtk_text_btree_get_tags (const GtkTextIter *iter,
           if ((seg->type == &gtk_text_toggle_on_type)
               || (seg->type == &gtk_text_toggle_off_type))
             {
-              inc_count (seg->body.toggle.info->tag, 1, &tagInfo);
+              tag = seg->body.toggle.info->tag;
+              tags[tag->priv->priority] = tag;
+              tagCnts[tag->priv->priority]++;
             }
         }
     }
@@ -2288,8 +2516,9 @@ _gtk_text_btree_get_tags (const GtkTextIter *iter,
             {
               if (summary->toggle_count & 1)
                 {
-                  inc_count (summary->info->tag, summary->toggle_count,
-                             &tagInfo);
+                  tag = summary->info->tag;
+                  tags[tag->priv->priority] = tag;
+                  tagCnts[tag->priv->priority] += summary->toggle_count;
                 }
             }
         }
@@ -2298,31 +2527,41 @@ _gtk_text_btree_get_tags (const GtkTextIter *iter,
   /*
    * Go through the tag information and squash out all of the tags
    * that have even toggle counts (these tags exist before the point
-   * of interest, but not at the desired character itself).
+   * of interest, but not at the desired character itself). Going
+   * by priority leaves the tags in ascending order of priority.
    */
 
-  for (src = 0, dst = 0; src < tagInfo.numTags; src++)
+  n = 0;
+  for (i = 0; i < numTags; i++)
+    {
+      if (tagCnts[i] & 1)
+        n++;
+    }
+
+  result = NULL;
+  if (n > 0)
     {
-      if (tagInfo.counts[src] & 1)
+      result = g_new (GtkTextTag*, n);
+      n = 0;
+      for (i = 0; i < numTags; i++)
         {
-          g_assert (GTK_IS_TEXT_TAG (tagInfo.tags[src]));
-          tagInfo.tags[dst] = tagInfo.tags[src];
-          dst++;
+          if (tagCnts[i] & 1)
+            {
+              g_assert (GTK_IS_TEXT_TAG (tags[i]));
+              result[n++] = tags[i];
+            }
         }
     }
 
-  *num_tags = dst;
-  g_free (tagInfo.counts);
-  if (dst == 0)
+  *num_tags = n;
+
+  if (LOTSA_TAGS < numTags)
     {
-      g_free (tagInfo.tags);
-      return NULL;
+      g_free (tagCnts);
+      g_free (tags);
     }
 
-  /* Sort tags in ascending order of priority */
-  _gtk_text_tag_array_sort (tagInfo.tags, dst);
-
-  return tagInfo.tags;
+  return result;
 }
 
 static void
@@ -2470,7 +2709,6 @@ _gtk_text_btree_char_count (GtkTextBTree *tree)
   return tree->root_node->num_chars - 2;
 }
 
-#define LOTSA_TAGS 1000
 gboolean
 _gtk_text_btree_char_is_invisible (const GtkTextIter *iter)
 {
@@ -3083,7 +3321,7 @@ _gtk_text_btree_first_could_contain_tag (GtkTextBTree *tree,
           node = node->children.node;
           while (node != NULL)
             {
-              if (gtk_text_btree_node_has_tag (node, tag))
+              if (gtk_text_btree_node_has_tag (node, info))
                 goto continue_outer_loop;
 
               node = node->next;
@@ -3137,7 +3375,7 @@ _gtk_text_btree_last_could_contain_tag (GtkTextBTree *tree,
           node = node->children.node;
           while (node != NULL)
             {
-              if (gtk_text_btree_node_has_tag (node, tag))
+              if (gtk_text_btree_node_has_tag (node, info))
                 last_node = node;
               node = node->next;
             }
@@ -3710,6 +3948,19 @@ _gtk_text_line_invalidate_wrap (GtkTextLine *line,
   gtk_text_btree_node_invalidate_upward (line->parent, ld->view_id);
 }
 
+/* Updates the sizes of the nodes above @line for @view_id after the
+ * heights of lines in the same node were changed without validating
+ * them.
+ */
+void
+_gtk_text_line_update_view_size (GtkTextLine *line,
+                                 gpointer     view_id)
+{
+  g_return_if_fail (line != NULL);
+
+  gtk_text_btree_node_check_valid_upward (line->parent, view_id);
+}
+
 gint
 _gtk_text_line_char_count (GtkTextLine *line)
 {
@@ -4411,7 +4662,7 @@ _gtk_text_line_next_could_contain_tag (GtkTextLine  *line,
             {
               node = node->next;
 
-              if (gtk_text_btree_node_has_tag (node, tag))
+              if (gtk_text_btree_node_has_tag (node, info))
                 goto found;
             }
         }
@@ -4457,7 +4708,7 @@ _gtk_text_line_next_could_contain_tag (GtkTextLine  *line,
       node = node->children.node;
       while (node != NULL)
         {
-          if (gtk_text_btree_node_has_tag (node, tag))
+          if (gtk_text_btree_node_has_tag (node, info))
             break;
           node = node->next;
         }
@@ -4594,7 +4845,7 @@ _gtk_text_line_previous_could_contain_tag (GtkTextLine  *line,
 
               g_assert (this_node != line_ancestor);
 
-              if (gtk_text_btree_node_has_tag (this_node, tag))
+              if (gtk_text_btree_node_has_tag (this_node, info))
                 {
                   found_node = this_node;
                   g_slist_free (child_nodes);
@@ -4669,7 +4920,7 @@ _gtk_text_line_previous_could_contain_tag (GtkTextLine  *line,
       iter = child_nodes;
       while (iter != NULL)
         {
-          if (gtk_text_btree_node_has_tag (iter->data, tag))
+          if (gtk_text_btree_node_has_tag (iter->data, info))
             {
               /* recurse into this node. */
               node = iter->data;
@@ -4884,6 +5135,7 @@ gtk_text_btree_node_new (void)
 
   node = g_slice_new (GtkTextBTreeNode);
 
+  node->tag_mask = 0;
   node->node_data = NULL;
 
   return node;
@@ -4896,16 +5148,20 @@ gtk_text_btree_node_adjust_toggle_count (GtkTextBTreeNode  *node,
 {
   Summary *summary;
 
-  summary = node->summary;
-  while (summary != NULL)
+  summary = NULL;
+  if (node->tag_mask & TAG_INFO_BIT (info))
     {
-      if (summary->info == info)
+      summary = node->summary;
+      while (summary != NULL)
         {
-          summary->toggle_count += adjust;
-          break;
-        }
+          if (summary->info == info)
+            {
+              summary->toggle_count += adjust;
+              break;
+            }
 
-      summary = summary->next;
+          summary = summary->next;
+        }
     }
 
   if (summary == NULL)
@@ -4917,22 +5173,38 @@ gtk_text_btree_node_adjust_toggle_count (GtkTextBTreeNode  *node,
       summary->toggle_count = adjust;
       summary->next = node->summary;
       node->summary = summary;
+      node->tag_mask |= TAG_INFO_BIT (info);
     }
 }
 
+static void
+gtk_text_btree_node_update_tag_mask (GtkTextBTreeNode *node)
+{
+  Summary *summary;
+
+  node->tag_mask = 0;
+  for (summary = node->summary; summary != NULL; summary = summary->next)
+    node->tag_mask |= TAG_INFO_BIT (summary->info);
+}
+
 /* Note that the tag root and above do not have summaries
    for the tag; only nodes below the tag root have
    the summaries. */
 static gboolean
-gtk_text_btree_node_has_tag (GtkTextBTreeNode *node, GtkTextTag *tag)
+gtk_text_btree_node_has_tag (GtkTextBTreeNode *node, GtkTextTagInfo *info)
 {
   Summary *summary;
 
+  if (info == NULL)
+    return node->summary != NULL;
+
+  if ((node->tag_mask & TAG_INFO_BIT (info)) == 0)
+    return FALSE;
+
   summary = node->summary;
   while (summary != NULL)
     {
-      if (tag == NULL ||
-          summary->info->tag == tag)
+      if (summary->info == info)
         return TRUE;
 
       summary = summary->next;
@@ -6004,21 +6276,7 @@ static GtkTextTagInfo*
 gtk_text_btree_get_existing_tag_info (GtkTextBTree *tree,
                                       GtkTextTag   *tag)
 {
-  GtkTextTagInfo *info;
-  GSList *list;
-
-
-  list = tree->tag_infos;
-  while (list != NULL)
-    {
-      info = list->data;
-      if (info->tag == tag)
-        return info;
-
-      list = list->next;
-    }
-
-  return NULL;
+  return g_hash_table_lookup (tree->tag_info_table, tag);
 }
 
 static GtkTextTagInfo*
@@ -6039,8 +6297,10 @@ gtk_text_btree_get_tag_info (GtkTextBTree *tree,
       g_object_ref (tag);
       info->tag_root = NULL;
       info->toggle_count = 0;
+      info->id = tree->next_tag_info_id++;
 
       tree->tag_infos = g_slist_prepend (tree->tag_infos, info);
+      g_hash_table_insert (tree->tag_info_table, tag, info);
 
 #if 0
       g_print ("Created tag info %p for tag %s(%p)\n",
@@ -6084,6 +6344,7 @@ gtk_text_btree_remove_tag_info (GtkTextBTree *tree,
           list->next = NULL;
           g_slist_free (list);
 
+          g_hash_table_remove (tree->tag_info_table, tag);
           g_object_unref (info->tag);
 
           g_slice_free (GtkTextTagInfo, info);
@@ -6283,6 +6544,8 @@ recompute_node_counts (GtkTextBTree *tree, GtkTextBTreeNode *node)
           summary = node->summary;
         }
     }
+
+  gtk_text_btree_node_update_tag_mask (node);
 }
 
 void
@@ -6322,13 +6585,18 @@ _gtk_change_node_toggle_count (GtkTextBTreeNode *node,
        * perhaps all we have to do is adjust its count.
        */
 
-      for (prevPtr = NULL, summary = node->summary;
-           summary != NULL;
-           prevPtr = summary, summary = summary->next)
+      prevPtr = NULL;
+      summary = NULL;
+      if (node->tag_mask & TAG_INFO_BIT (info))
         {
-          if (summary->info == info)
+          for (summary = node->summary;
+               summary != NULL;
+               prevPtr = summary, summary = summary->next)
             {
-              break;
+              if (summary->info == info)
+                {
+                  break;
+                }
             }
         }
       if (summary != NULL)
@@ -6364,6 +6632,7 @@ _gtk_change_node_toggle_count (GtkTextBTreeNode *node,
               prevPtr->next = summary->next;
             }
           summary_destroy (summary);
+          gtk_text_btree_node_update_tag_mask (node);
         }
       else
         {
@@ -6391,6 +6660,7 @@ _gtk_change_node_toggle_count (GtkTextBTreeNode *node,
               summary->toggle_count = info->toggle_count - delta;
               summary->next = rootnode->summary;
               rootnode->summary = summary;
+              rootnode->tag_mask |= TAG_INFO_BIT (info);
               rootnode = rootnode->parent;
               rootLevel = rootnode->level;
               info->tag_root = rootnode;
@@ -6400,6 +6670,7 @@ _gtk_change_node_toggle_count (GtkTextBTreeNode *node,
           summary->toggle_count = delta;
           summary->next = node->summary;
           node->summary = summary;
+          node->tag_mask |= TAG_INFO_BIT (info);
         }
     }
 
@@ -6464,6 +6735,7 @@ _gtk_change_node_toggle_count (GtkTextBTreeNode *node,
               prevPtr->next = summary->next;
             }
           summary_destroy (summary);
+          gtk_text_btree_node_update_tag_mask (node2Ptr);
           info->tag_root = node2Ptr;
           break;
         }
@@ -6471,72 +6743,6 @@ _gtk_change_node_toggle_count (GtkTextBTreeNode *node,
     }
 }
 
-/*
- *----------------------------------------------------------------------
- *
- * inc_count --
- *
- *      This is a utility procedure used by _gtk_text_btree_get_tags.  It
- *      increments the count for a particular tag, adding a new
- *      entry for that tag if there wasn’t one previously.
- *
- * Results:
- *      None.
- *
- * Side effects:
- *      The information at *tagInfoPtr may be modified, and the arrays
- *      may be reallocated to make them larger.
- *
- *----------------------------------------------------------------------
- */
-
-static void
-inc_count (GtkTextTag *tag, int inc, TagInfo *tagInfoPtr)
-{
-  GtkTextTag **tag_p;
-  int count;
-
-  for (tag_p = tagInfoPtr->tags, count = tagInfoPtr->numTags;
-       count > 0; tag_p++, count--)
-    {
-      if (*tag_p == tag)
-        {
-          tagInfoPtr->counts[tagInfoPtr->numTags-count] += inc;
-          return;
-        }
-    }
-
-  /*
-   * There isn’t currently an entry for this tag, so we have to
-   * make a new one.  If the arrays are full, then enlarge the
-   * arrays first.
-   */
-
-  if (tagInfoPtr->numTags == tagInfoPtr->arraySize)
-    {
-      GtkTextTag **newTags;
-      int *newCounts, newSize;
-
-      newSize = 2*tagInfoPtr->arraySize;
-      newTags = (GtkTextTag **) g_malloc ((unsigned)
-                                          (newSize*sizeof (GtkTextTag *)));
-      memcpy ((void *) newTags, (void *) tagInfoPtr->tags,
-              tagInfoPtr->arraySize  *sizeof (GtkTextTag *));
-      g_free ((char *) tagInfoPtr->tags);
-      tagInfoPtr->tags = newTags;
-      newCounts = (int *) g_malloc ((unsigned) (newSize*sizeof (int)));
-      memcpy ((void *) newCounts, (void *) tagInfoPtr->counts,
-              tagInfoPtr->arraySize  *sizeof (int));
-      g_free ((char *) tagInfoPtr->counts);
-      tagInfoPtr->counts = newCounts;
-      tagInfoPtr->arraySize = newSize;
-    }
-
-  tagInfoPtr->tags[tagInfoPtr->numTags] = tag;
-  tagInfoPtr->counts[tagInfoPtr->numTags] = inc;
-  tagInfoPtr->numTags++;
-}
-
 static void
 gtk_text_btree_link_segment (GtkTextLineSegment *seg,
                              const GtkTextIter *iter)
@@ -6863,6 +7069,11 @@ gtk_text_btree_node_check_consistency (GtkTextBTree     *tree,
           g_error ("gtk_text_btree_node_check_consistency: found unpruned root for \"%s\"",
                    summary->info->tag->priv->name);
         }
+      if ((node->tag_mask & TAG_INFO_BIT (summary->info)) == 0)
+        {
+          g_error ("gtk_text_btree_node_check_consistency: \"%s\" missing from the tag mask",
+                   summary->info->tag->priv->name);
+        }
       toggle_count = 0;
       if (node->level == 0)
         {
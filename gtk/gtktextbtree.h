@@ -114,6 +114,8 @@ void _gtk_text_btree_tag (const GtkTextIter *start,
                           const GtkTextIter *end,
                           GtkTextTag        *tag,
                           gboolean           apply);
+void _gtk_text_btree_freeze_tag_redisplay (GtkTextBTree *tree);
+void _gtk_text_btree_thaw_tag_redisplay   (GtkTextBTree *tree);
 
 /* "Getters" */
 
@@ -270,6 +272,8 @@ gpointer            _gtk_text_line_get_data                   (GtkTextLine
                                                                gpointer             view_id);
 void                _gtk_text_line_invalidate_wrap            (GtkTextLine         *line,
                                                                GtkTextLineData     *ld);
+void                _gtk_text_line_update_view_size           (GtkTextLine         *line,
+                                                               gpointer             view_id);
 gint                _gtk_text_line_char_count                 (GtkTextLine         *line);
 gint                _gtk_text_line_byte_count                 (GtkTextLine         *line);
 gint                _gtk_text_line_char_index                 (GtkTextLine         *line);
@@ -24,6 +24,7 @@
  */
 
 #include "config.h"
+#include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
 
@@ -2851,6 +2852,271 @@ gtk_text_buffer_remove_all_tags (GtkTextBuffer     *buffer,
   g_slist_free_full (tags, g_object_unref);
 }
 
+/**
+ * gtk_text_buffer_apply_tag_to_matches:
+ * @buffer: a #GtkTextBuffer
+ * @tag: a #GtkTextTag
+ * @str: a search string
+ * @flags: flags affecting how the search is done
+ * @iter: (inout): where to start searching
+ * @limit: (allow-none): where to stop searching, or %NULL for the
+ *     end of the buffer
+ * @max_lines: the number of lines to search, or -1 to search up
+ *     to @limit
+ *
+ * Applies @tag to all the matches of @str after @iter, as found by
+ * gtk_text_iter_forward_search(). The search covers at most
+ * @max_lines lines, and @iter is then moved to where it stopped, so
+ * that highlighting the matches in a large buffer can be spread over
+ * several calls, e.g. from an idle handler.
+ *
+ * The matches are collected first and tagged afterwards, so
+ * handlers of #GtkTextBuffer::apply-tag don’t run in the middle of
+ * the search.
+ *
+ * Returns: %TRUE if there is more to search before @limit
+ *
+ * Since: 3.20
+ **/
+gboolean
+gtk_text_buffer_apply_tag_to_matches (GtkTextBuffer      *buffer,
+                                      GtkTextTag         *tag,
+                                      const gchar        *str,
+                                      GtkTextSearchFlags  flags,
+                                      GtkTextIter        *iter,
+                                      const GtkTextIter  *limit,
+                                      gint                max_lines)
+{
+  GtkTextIter search;
+  GtkTextIter end;
+  GtkTextIter chunk_end;
+  GtkTextIter search_limit;
+  GtkTextIter match_start;
+  GtkTextIter match_end;
+  GArray *matches;
+  const gchar *p;
+  gint n_newlines;
+  gint next_offset;
+  gboolean more;
+  guint i;
+
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), FALSE);
+  g_return_val_if_fail (GTK_IS_TEXT_TAG (tag), FALSE);
+  g_return_val_if_fail (str != NULL && *str != '\0', FALSE);
+  g_return_val_if_fail (iter != NULL, FALSE);
+  g_return_val_if_fail (gtk_text_iter_get_buffer (iter) == buffer, FALSE);
+  g_return_val_if_fail (limit == NULL || gtk_text_iter_get_buffer (limit) == buffer, FALSE);
+  g_return_val_if_fail (max_lines != 0, FALSE);
+  g_return_val_if_fail (tag->priv->table == buffer->priv->tag_table, FALSE);
+
+  search = *iter;
+  if (limit)
+    end = *limit;
+  else
+    gtk_text_buffer_get_end_iter (buffer, &end);
+
+  if (gtk_text_iter_compare (&search, &end) >= 0)
+    return FALSE;
+
+  chunk_end = search;
+  if (max_lines < 0 ||
+      !gtk_text_iter_forward_lines (&chunk_end, max_lines) ||
+      gtk_text_iter_compare (&chunk_end, &end) > 0)
+    chunk_end = end;
+
+  /* Matches starting before the end of the chunk can end that many
+   * lines after it.
+   */
+  n_newlines = 0;
+  for (p = strchr (str, '\n'); p != NULL; p = strchr (p + 1, '\n'))
+    n_newlines++;
+
+  search_limit = chunk_end;
+  if (n_newlines > 0 &&
+      (!gtk_text_iter_forward_lines (&search_limit, n_newlines) ||
+       gtk_text_iter_compare (&search_limit, &end) > 0))
+    search_limit = end;
+
+  matches = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  while (gtk_text_iter_forward_search (&search, str, flags,
+                                       &match_start, &match_end,
+                                       &search_limit))
+    {
+      gint offset;
+
+      if (gtk_text_iter_compare (&match_start, &chunk_end) >= 0)
+        break;
+
+      offset = gtk_text_iter_get_offset (&match_start);
+      g_array_append_val (matches, offset);
+      offset = gtk_text_iter_get_offset (&match_end);
+      g_array_append_val (matches, offset);
+
+      search = match_end;
+    }
+
+  /* Continue after the last match if it ends after the chunk.
+   * Applying tags invalidates the iters, so remember the offset.
+   */
+  if (gtk_text_iter_compare (&search, &chunk_end) > 0)
+    chunk_end = search;
+  more = gtk_text_iter_compare (&chunk_end, &end) < 0;
+  next_offset = gtk_text_iter_get_offset (&chunk_end);
+
+  _gtk_text_btree_freeze_tag_redisplay (get_btree (buffer));
+
+  for (i = 0; i < matches->len; i += 2)
+    {
+      gtk_text_buffer_get_iter_at_offset (buffer, &match_start,
+                                          g_array_index (matches, gint, i));
+      gtk_text_buffer_get_iter_at_offset (buffer, &match_end,
+                                          g_array_index (matches, gint, i + 1));
+      gtk_text_buffer_apply_tag (buffer, tag, &match_start, &match_end);
+    }
+
+  _gtk_text_btree_thaw_tag_redisplay (get_btree (buffer));
+
+  g_array_free (matches, TRUE);
+
+  gtk_text_buffer_get_iter_at_offset (buffer, iter, next_offset);
+
+  return more;
+}
+
+typedef struct
+{
+  GtkTextTag *tag;
+  gint start;
+  gint end;
+} TagSpan;
+
+static gint
+compare_tag_spans (gconstpointer a,
+                   gconstpointer b)
+{
+  const TagSpan *span_a = a;
+  const TagSpan *span_b = b;
+
+  if (span_a->tag != span_b->tag)
+    return span_a->tag->priv->priority - span_b->tag->priv->priority;
+
+  if (span_a->start != span_b->start)
+    return span_a->start < span_b->start ? -1 : 1;
+
+  return 0;
+}
+
+/**
+ * gtk_text_buffer_apply_tags:
+ * @buffer: a #GtkTextBuffer
+ * @tags: (array length=n_spans): the tags to apply
+ * @offsets: (array): the character offsets of the spans, two for
+ *     each tag in @tags
+ * @n_spans: the number of spans
+ *
+ * Applies each tag in @tags to the range between the corresponding
+ * pair of offsets in @offsets, as gtk_text_buffer_apply_tag() would.
+ * The offsets of a span don’t have to be in order, and negative
+ * offsets or offsets past the end of the buffer mean the end of the
+ * buffer, as with gtk_text_buffer_get_iter_at_offset().
+ *
+ * This is meant for syntax highlighters and other code that applies
+ * many tags at once. The spans are sorted, overlapping and adjacent
+ * spans of the same tag are merged, and the views of the buffer
+ * are relaid out or redrawn once for the whole affected range
+ * instead of once per span. The #GtkTextBuffer::apply-tag signal is
+ * still emitted for each merged span.
+ *
+ * Since: 3.20
+ **/
+void
+gtk_text_buffer_apply_tags (GtkTextBuffer  *buffer,
+                            GtkTextTag    **tags,
+                            const gint     *offsets,
+                            gint            n_spans)
+{
+  GtkTextIter start, end;
+  TagSpan *spans;
+  TagSpan *span;
+  gint char_count;
+  gint n_merged;
+  gint i;
+
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+  g_return_if_fail (n_spans >= 0);
+  g_return_if_fail (n_spans == 0 || (tags != NULL && offsets != NULL));
+
+  if (n_spans == 0)
+    return;
+
+  for (i = 0; i < n_spans; i++)
+    {
+      g_return_if_fail (GTK_IS_TEXT_TAG (tags[i]));
+      g_return_if_fail (tags[i]->priv->table == buffer->priv->tag_table);
+    }
+
+  char_count = gtk_text_buffer_get_char_count (buffer);
+
+  spans = g_new (TagSpan, n_spans);
+  n_merged = 0;
+  for (i = 0; i < n_spans; i++)
+    {
+      gint span_start, span_end;
+
+      span_start = offsets[2 * i];
+      span_end = offsets[2 * i + 1];
+      if (span_start < 0 || span_start > char_count)
+        span_start = char_count;
+      if (span_end < 0 || span_end > char_count)
+        span_end = char_count;
+
+      if (span_start == span_end)
+        continue;
+
+      span = &spans[n_merged++];
+      span->tag = tags[i];
+      span->start = MIN (span_start, span_end);
+      span->end = MAX (span_start, span_end);
+    }
+
+  /* Sort the spans by tag and then by position, so that each tag
+   * is applied in one pass from the start of the buffer to the end,
+   * and the spans a tag already covers can be merged.
+   */
+  qsort (spans, n_merged, sizeof (TagSpan), compare_tag_spans);
+
+  n_spans = n_merged;
+  n_merged = 0;
+  for (i = 0; i < n_spans; i++)
+    {
+      if (n_merged > 0 &&
+          spans[n_merged - 1].tag == spans[i].tag &&
+          spans[n_merged - 1].end >= spans[i].start)
+        {
+          span = &spans[n_merged - 1];
+          span->end = MAX (span->end, spans[i].end);
+        }
+      else
+        spans[n_merged++] = spans[i];
+    }
+
+  _gtk_text_btree_freeze_tag_redisplay (get_btree (buffer));
+
+  for (i = 0; i < n_merged; i++)
+    {
+      span = &spans[i];
+
+      gtk_text_buffer_get_iter_at_offset (buffer, &start, span->start);
+      gtk_text_buffer_get_iter_at_offset (buffer, &end, span->end);
+      gtk_text_buffer_emit_tag (buffer, span->tag, TRUE, &start, &end);
+    }
+
+  _gtk_text_btree_thaw_tag_redisplay (get_btree (buffer));
+
+  g_free (spans);
+}
+
 
 /*
  * Obtain various iterators
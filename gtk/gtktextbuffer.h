@@ -358,6 +358,19 @@ GDK_AVAILABLE_IN_ALL
 void gtk_text_buffer_remove_all_tags       (GtkTextBuffer     *buffer,
                                             const GtkTextIter *start,
                                             const GtkTextIter *end);
+GDK_AVAILABLE_IN_3_20
+gboolean gtk_text_buffer_apply_tag_to_matches (GtkTextBuffer      *buffer,
+                                               GtkTextTag         *tag,
+                                               const gchar        *str,
+                                               GtkTextSearchFlags  flags,
+                                               GtkTextIter        *iter,
+                                               const GtkTextIter  *limit,
+                                               gint                max_lines);
+GDK_AVAILABLE_IN_3_20
+void gtk_text_buffer_apply_tags            (GtkTextBuffer     *buffer,
+                                            GtkTextTag       **tags,
+                                            const gint        *offsets,
+                                            gint               n_spans);
 
 
 /* You can either ignore the return value, or use it to
@@ -453,6 +453,168 @@ gtk_text_buffer_get_deserialize_formats (GtkTextBuffer *buffer,
   return get_formats (formats, n_formats);
 }
 
+static GtkRichTextFormat *
+find_format (GList   *formats,
+             GdkAtom  format)
+{
+  GList *l;
+
+  for (l = formats; l; l = l->next)
+    {
+      GtkRichTextFormat *fmt = l->data;
+
+      if (fmt->atom == format)
+        return fmt;
+    }
+
+  return NULL;
+}
+
+/*  We don't want the tags that are effective at the insertion
+ *  point to affect the pasted text, therefore we remove and
+ *  remember them, so they can be re-applied left and right of
+ *  the inserted text after pasting
+ */
+typedef struct
+{
+  GSList      *tags;
+  GtkTextMark *left_end;
+  GtkTextMark *right_start;
+  GSList      *left_start_list;
+  GSList      *right_end_list;
+} SplitTags;
+
+static void
+split_tags (GtkTextBuffer *content_buffer,
+            GtkTextIter   *iter,
+            SplitTags     *split)
+{
+  GSList *list;
+
+  split->tags = gtk_text_iter_get_tags (iter);
+  split->left_end = NULL;
+  split->right_start = NULL;
+  split->left_start_list = NULL;
+  split->right_end_list = NULL;
+
+  list = split->tags;
+  while (list)
+    {
+      GtkTextTag *tag = list->data;
+
+      list = list->next;
+
+      /*  If a tag begins at the insertion point, ignore it
+       *  because it doesn't affect the pasted text
+       */
+      if (gtk_text_iter_begins_tag (iter, tag))
+        split->tags = g_slist_remove (split->tags, tag);
+    }
+
+  if (split->tags == NULL)
+    return;
+
+  /*  Need to remember text marks, because text iters
+   *  don't survive pasting
+   */
+  split->left_end = gtk_text_buffer_create_mark (content_buffer,
+                                                 NULL, iter, TRUE);
+  split->right_start = gtk_text_buffer_create_mark (content_buffer,
+                                                    NULL, iter, FALSE);
+
+  for (list = split->tags; list; list = list->next)
+    {
+      GtkTextTag  *tag             = list->data;
+      GtkTextIter *backward_toggle = gtk_text_iter_copy (iter);
+      GtkTextIter *forward_toggle  = gtk_text_iter_copy (iter);
+      GtkTextMark *left_start      = NULL;
+      GtkTextMark *right_end       = NULL;
+
+      gtk_text_iter_backward_to_tag_toggle (backward_toggle, tag);
+      left_start = gtk_text_buffer_create_mark (content_buffer,
+                                                NULL,
+                                                backward_toggle,
+                                                FALSE);
+
+      gtk_text_iter_forward_to_tag_toggle (forward_toggle, tag);
+      right_end = gtk_text_buffer_create_mark (content_buffer,
+                                               NULL,
+                                               forward_toggle,
+                                               TRUE);
+
+      split->left_start_list = g_slist_prepend (split->left_start_list, left_start);
+      split->right_end_list = g_slist_prepend (split->right_end_list, right_end);
+
+      gtk_text_buffer_remove_tag (content_buffer, tag,
+                                  backward_toggle,
+                                  forward_toggle);
+
+      gtk_text_iter_free (forward_toggle);
+      gtk_text_iter_free (backward_toggle);
+    }
+
+  split->left_start_list = g_slist_reverse (split->left_start_list);
+  split->right_end_list = g_slist_reverse (split->right_end_list);
+}
+
+static void
+rejoin_split_tags (GtkTextBuffer *content_buffer,
+                   SplitTags     *split)
+{
+  GSList      *list;
+  GSList      *left_list;
+  GSList      *right_list;
+  GtkTextIter  left_e;
+  GtkTextIter  right_s;
+
+  if (split->tags == NULL)
+    return;
+
+  /*  Turn the remembered marks back into iters so they
+   *  can by used to re-apply the remembered tags
+   */
+  gtk_text_buffer_get_iter_at_mark (content_buffer,
+                                    &left_e, split->left_end);
+  gtk_text_buffer_get_iter_at_mark (content_buffer,
+                                    &right_s, split->right_start);
+
+  for (list = split->tags,
+       left_list = split->left_start_list,
+       right_list = split->right_end_list;
+       list && left_list && right_list;
+       list = list->next,
+       left_list = left_list->next,
+       right_list = right_list->next)
+    {
+      GtkTextTag  *tag        = list->data;
+      GtkTextMark *left_start = left_list->data;
+      GtkTextMark *right_end  = right_list->data;
+      GtkTextIter  left_s;
+      GtkTextIter  right_e;
+
+      gtk_text_buffer_get_iter_at_mark (content_buffer,
+                                        &left_s, left_start);
+      gtk_text_buffer_get_iter_at_mark (content_buffer,
+                                        &right_e, right_end);
+
+      gtk_text_buffer_apply_tag (content_buffer, tag,
+                                 &left_s, &left_e);
+      gtk_text_buffer_apply_tag (content_buffer, tag,
+                                 &right_s, &right_e);
+
+      gtk_text_buffer_delete_mark (content_buffer, left_start);
+      gtk_text_buffer_delete_mark (content_buffer, right_end);
+    }
+
+  gtk_text_buffer_delete_mark (content_buffer, split->left_end);
+  gtk_text_buffer_delete_mark (content_buffer, split->right_start);
+
+  g_slist_free (split->tags);
+  g_slist_free (split->left_start_list);
+  g_slist_free (split->right_end_list);
+  split->tags = NULL;
+}
+
 /**
  * gtk_text_buffer_serialize:
  * @register_buffer: the #GtkTextBuffer @format is registered with
@@ -543,8 +705,7 @@ gtk_text_buffer_deserialize (GtkTextBuffer  *register_buffer,
                              gsize           length,
                              GError        **error)
 {
-  GList *formats;
-  GList *l;
+  GtkRichTextFormat *fmt;
 
   g_return_val_if_fail (GTK_IS_TEXT_BUFFER (register_buffer), FALSE);
   g_return_val_if_fail (GTK_IS_TEXT_BUFFER (content_buffer), FALSE);
@@ -554,153 +715,31 @@ gtk_text_buffer_deserialize (GtkTextBuffer  *register_buffer,
   g_return_val_if_fail (length > 0, FALSE);
   g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-  formats = g_object_get_qdata (G_OBJECT (register_buffer), deserialize_quark ());
+  fmt = find_format (g_object_get_qdata (G_OBJECT (register_buffer), deserialize_quark ()),
+                     format);
 
-  for (l = formats; l; l = l->next)
+  if (fmt)
     {
-      GtkRichTextFormat *fmt = l->data;
+      GtkTextBufferDeserializeFunc function = fmt->function;
+      gboolean                     success;
+      SplitTags                    split;
 
-      if (fmt->atom == format)
-        {
-          GtkTextBufferDeserializeFunc function = fmt->function;
-          gboolean                     success;
-          GSList                      *split_tags;
-          GSList                      *list;
-          GtkTextMark                 *left_end        = NULL;
-          GtkTextMark                 *right_start     = NULL;
-          GSList                      *left_start_list = NULL;
-          GSList                      *right_end_list  = NULL;
-
-          /*  We don't want the tags that are effective at the insertion
-           *  point to affect the pasted text, therefore we remove and
-           *  remember them, so they can be re-applied left and right of
-           *  the inserted text after pasting
-           */
-          split_tags = gtk_text_iter_get_tags (iter);
-
-          list = split_tags;
-          while (list)
-            {
-              GtkTextTag *tag = list->data;
-
-              list = list->next;
-
-              /*  If a tag begins at the insertion point, ignore it
-               *  because it doesn't affect the pasted text
-               */
-              if (gtk_text_iter_begins_tag (iter, tag))
-                split_tags = g_slist_remove (split_tags, tag);
-            }
-
-          if (split_tags)
-            {
-              /*  Need to remember text marks, because text iters
-               *  don't survive pasting
-               */
-              left_end = gtk_text_buffer_create_mark (content_buffer,
-                                                      NULL, iter, TRUE);
-              right_start = gtk_text_buffer_create_mark (content_buffer,
-                                                         NULL, iter, FALSE);
-
-              for (list = split_tags; list; list = list->next)
-                {
-                  GtkTextTag  *tag             = list->data;
-                  GtkTextIter *backward_toggle = gtk_text_iter_copy (iter);
-                  GtkTextIter *forward_toggle  = gtk_text_iter_copy (iter);
-                  GtkTextMark *left_start      = NULL;
-                  GtkTextMark *right_end       = NULL;
-
-                  gtk_text_iter_backward_to_tag_toggle (backward_toggle, tag);
-                  left_start = gtk_text_buffer_create_mark (content_buffer,
-                                                            NULL,
-                                                            backward_toggle,
-                                                            FALSE);
-
-                  gtk_text_iter_forward_to_tag_toggle (forward_toggle, tag);
-                  right_end = gtk_text_buffer_create_mark (content_buffer,
-                                                           NULL,
-                                                           forward_toggle,
-                                                           TRUE);
-
-                  left_start_list = g_slist_prepend (left_start_list, left_start);
-                  right_end_list = g_slist_prepend (right_end_list, right_end);
-
-                  gtk_text_buffer_remove_tag (content_buffer, tag,
-                                              backward_toggle,
-                                              forward_toggle);
-
-                  gtk_text_iter_free (forward_toggle);
-                  gtk_text_iter_free (backward_toggle);
-                }
-
-              left_start_list = g_slist_reverse (left_start_list);
-              right_end_list = g_slist_reverse (right_end_list);
-            }
-
-          success = function (register_buffer, content_buffer,
-                              iter, data, length,
-                              fmt->can_create_tags,
-                              fmt->user_data,
-                              error);
-
-          if (!success && error != NULL && *error == NULL)
-            g_set_error (error, 0, 0,
-                         _("Unknown error when trying to deserialize %s"),
-                         gdk_atom_name (format));
-
-          if (split_tags)
-            {
-              GSList      *left_list;
-              GSList      *right_list;
-              GtkTextIter  left_e;
-              GtkTextIter  right_s;
-
-              /*  Turn the remembered marks back into iters so they
-               *  can by used to re-apply the remembered tags
-               */
-              gtk_text_buffer_get_iter_at_mark (content_buffer,
-                                                &left_e, left_end);
-              gtk_text_buffer_get_iter_at_mark (content_buffer,
-                                                &right_s, right_start);
-
-              for (list = split_tags,
-                   left_list = left_start_list,
-                   right_list = right_end_list;
-                   list && left_list && right_list;
-                   list = list->next,
-                   left_list = left_list->next,
-                   right_list = right_list->next)
-                {
-                  GtkTextTag  *tag        = list->data;
-                  GtkTextMark *left_start = left_list->data;
-                  GtkTextMark *right_end  = right_list->data;
-                  GtkTextIter  left_s;
-                  GtkTextIter  right_e;
-
-                  gtk_text_buffer_get_iter_at_mark (content_buffer,
-                                                    &left_s, left_start);
-                  gtk_text_buffer_get_iter_at_mark (content_buffer,
-                                                    &right_e, right_end);
-
-                  gtk_text_buffer_apply_tag (content_buffer, tag,
-                                             &left_s, &left_e);
-                  gtk_text_buffer_apply_tag (content_buffer, tag,
-                                             &right_s, &right_e);
-
-                  gtk_text_buffer_delete_mark (content_buffer, left_start);
-                  gtk_text_buffer_delete_mark (content_buffer, right_end);
-                }
-
-              gtk_text_buffer_delete_mark (content_buffer, left_end);
-              gtk_text_buffer_delete_mark (content_buffer, right_start);
-
-              g_slist_free (split_tags);
-              g_slist_free (left_start_list);
-              g_slist_free (right_end_list);
-            }
-
-          return success;
-        }
+      split_tags (content_buffer, iter, &split);
+
+      success = function (register_buffer, content_buffer,
+                          iter, data, length,
+                          fmt->can_create_tags,
+                          fmt->user_data,
+                          error);
+
+      if (!success && error != NULL && *error == NULL)
+        g_set_error (error, 0, 0,
+                     _("Unknown error when trying to deserialize %s"),
+                     gdk_atom_name (format));
+
+      rejoin_split_tags (content_buffer, &split);
+
+      return success;
     }
 
   g_set_error (error, 0, 0,
@@ -710,6 +749,431 @@ gtk_text_buffer_deserialize (GtkTextBuffer  *register_buffer,
   return FALSE;
 }
 
+/* Amount of data read or written at a time by the stream functions */
+#define STREAM_CHUNK_SIZE 65536
+
+typedef struct
+{
+  GtkTextBufferRichTextWriter *writer;
+  GOutputStream *stream;
+  GString *chunk;
+  gboolean done;
+  guint8 *data;
+} SerializeData;
+
+static void
+serialize_data_free (SerializeData *data)
+{
+  if (data->writer)
+    _gtk_text_buffer_rich_text_writer_free (data->writer);
+  g_object_unref (data->stream);
+  g_string_free (data->chunk, TRUE);
+  g_free (data->data);
+  g_slice_free (SerializeData, data);
+}
+
+static gboolean serialize_step (gpointer user_data);
+
+static void
+serialize_write_cb (GObject      *source,
+                    GAsyncResult *result,
+                    gpointer      user_data)
+{
+  GTask *task = user_data;
+  SerializeData *data = g_task_get_task_data (task);
+  GError *error = NULL;
+
+  if (!g_output_stream_write_all_finish (G_OUTPUT_STREAM (source), result, NULL, &error))
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  if (data->done)
+    {
+      g_task_return_boolean (task, TRUE);
+      g_object_unref (task);
+      return;
+    }
+
+  g_string_truncate (data->chunk, 0);
+  g_idle_add (serialize_step, task);
+}
+
+/* Serializes until there is a chunk to write. Measuring the text
+ * doesn't produce any output, so this returns to the main loop in
+ * between, to keep the application responsive.
+ */
+static gboolean
+serialize_step (gpointer user_data)
+{
+  GTask *task = user_data;
+  SerializeData *data = g_task_get_task_data (task);
+  GError *error = NULL;
+
+  if (g_task_return_error_if_cancelled (task))
+    {
+      g_object_unref (task);
+      return G_SOURCE_REMOVE;
+    }
+
+  if (!_gtk_text_buffer_rich_text_writer_next (data->writer, data->chunk,
+                                               &data->done, &error))
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return G_SOURCE_REMOVE;
+    }
+
+  if (data->chunk->len >= STREAM_CHUNK_SIZE ||
+      (data->done && data->chunk->len > 0))
+    {
+      g_output_stream_write_all_async (data->stream,
+                                       data->chunk->str, data->chunk->len,
+                                       g_task_get_priority (task),
+                                       g_task_get_cancellable (task),
+                                       serialize_write_cb, task);
+      return G_SOURCE_REMOVE;
+    }
+
+  if (data->done)
+    {
+      g_task_return_boolean (task, TRUE);
+      g_object_unref (task);
+      return G_SOURCE_REMOVE;
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+/**
+ * gtk_text_buffer_serialize_to_stream_async:
+ * @register_buffer: the #GtkTextBuffer @format is registered with
+ * @content_buffer: the #GtkTextBuffer to serialize
+ * @format: the rich text format to use for serializing
+ * @start: start of block of text to serialize
+ * @end: end of block of test to serialize
+ * @stream: the #GOutputStream to write to
+ * @io_priority: the I/O priority of the request
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore
+ * @callback: (scope async): a #GAsyncReadyCallback to call when done
+ * @user_data: (closure): the data to pass to @callback
+ *
+ * Serializes the text between @start and @end like
+ * gtk_text_buffer_serialize(), and writes it to @stream.
+ *
+ * The rich text format of GTK+, as registered with
+ * gtk_text_buffer_register_serialize_tagset(), is serialized a piece
+ * at a time from the main loop, and never held in memory as a whole.
+ * Other formats are serialized into memory first.
+ *
+ * @content_buffer must not be modified until @callback is called.
+ * If it is, the operation fails.
+ *
+ * Since: 3.20
+ **/
+void
+gtk_text_buffer_serialize_to_stream_async (GtkTextBuffer       *register_buffer,
+                                           GtkTextBuffer       *content_buffer,
+                                           GdkAtom              format,
+                                           const GtkTextIter   *start,
+                                           const GtkTextIter   *end,
+                                           GOutputStream       *stream,
+                                           int                  io_priority,
+                                           GCancellable        *cancellable,
+                                           GAsyncReadyCallback  callback,
+                                           gpointer             user_data)
+{
+  GtkRichTextFormat *fmt;
+  SerializeData *data;
+  GTask *task;
+  gsize length;
+
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (register_buffer));
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (content_buffer));
+  g_return_if_fail (format != GDK_NONE);
+  g_return_if_fail (start != NULL);
+  g_return_if_fail (end != NULL);
+  g_return_if_fail (G_IS_OUTPUT_STREAM (stream));
+
+  task = g_task_new (register_buffer, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gtk_text_buffer_serialize_to_stream_async);
+  g_task_set_priority (task, io_priority);
+
+  fmt = find_format (g_object_get_qdata (G_OBJECT (register_buffer), serialize_quark ()),
+                     format);
+  if (fmt == NULL)
+    {
+      g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                               _("No serialize function found for format %s"),
+                               gdk_atom_name (format));
+      g_object_unref (task);
+      return;
+    }
+
+  data = g_slice_new0 (SerializeData);
+  data->stream = g_object_ref (stream);
+  data->chunk = g_string_sized_new (STREAM_CHUNK_SIZE + 4096);
+  g_task_set_task_data (task, data, (GDestroyNotify) serialize_data_free);
+
+  if (fmt->function == _gtk_text_buffer_serialize_rich_text)
+    {
+      data->writer = _gtk_text_buffer_rich_text_writer_new (content_buffer, start, end);
+      g_idle_add (serialize_step, task);
+      return;
+    }
+
+  data->data = gtk_text_buffer_serialize (register_buffer, content_buffer,
+                                          format, start, end, &length);
+  data->done = TRUE;
+  g_output_stream_write_all_async (stream, data->data, length,
+                                   io_priority, cancellable,
+                                   serialize_write_cb, task);
+}
+
+/**
+ * gtk_text_buffer_serialize_to_stream_finish:
+ * @register_buffer: the #GtkTextBuffer @format is registered with
+ * @result: a #GAsyncResult
+ * @error: return location for a #GError
+ *
+ * Finishes an operation started with
+ * gtk_text_buffer_serialize_to_stream_async().
+ *
+ * Returns: %TRUE on success, %FALSE otherwise
+ *
+ * Since: 3.20
+ **/
+gboolean
+gtk_text_buffer_serialize_to_stream_finish (GtkTextBuffer  *register_buffer,
+                                            GAsyncResult   *result,
+                                            GError        **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, register_buffer), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+typedef struct
+{
+  GtkTextBufferRichTextReader *reader;
+  GtkTextBuffer *register_buffer;
+  GtkTextBuffer *content_buffer;
+  GdkAtom format;
+  GInputStream *stream;
+  GtkTextMark *mark;
+  SplitTags split;
+  GByteArray *data;
+  guint8 *chunk;
+} DeserializeData;
+
+/* Puts back the tags split at the insertion point and removes what
+ * is left of the insertion, before the callback gets to see the buffer
+ */
+static void
+deserialize_data_finish (DeserializeData *data)
+{
+  if (data->reader)
+    {
+      _gtk_text_buffer_rich_text_reader_free (data->reader);
+      data->reader = NULL;
+      rejoin_split_tags (data->content_buffer, &data->split);
+    }
+
+  if (data->mark)
+    {
+      gtk_text_buffer_delete_mark (data->content_buffer, data->mark);
+      data->mark = NULL;
+    }
+}
+
+static void
+deserialize_data_free (DeserializeData *data)
+{
+  deserialize_data_finish (data);
+  g_object_unref (data->register_buffer);
+  g_object_unref (data->content_buffer);
+  g_object_unref (data->stream);
+  if (data->data)
+    g_byte_array_unref (data->data);
+  g_free (data->chunk);
+  g_slice_free (DeserializeData, data);
+}
+
+static void
+deserialize_read_cb (GObject      *source,
+                     GAsyncResult *result,
+                     gpointer      user_data)
+{
+  GTask *task = user_data;
+  DeserializeData *data = g_task_get_task_data (task);
+  GError *error = NULL;
+  gboolean success;
+  GtkTextIter iter;
+  gssize n_read;
+
+  n_read = g_input_stream_read_finish (G_INPUT_STREAM (source), result, &error);
+
+  if (n_read > 0)
+    {
+      if (data->reader)
+        success = _gtk_text_buffer_rich_text_reader_feed (data->reader, data->chunk,
+                                                          n_read, &error);
+      else
+        {
+          g_byte_array_append (data->data, data->chunk, n_read);
+          success = TRUE;
+        }
+
+      if (success)
+        {
+          g_input_stream_read_async (data->stream,
+                                     data->chunk, STREAM_CHUNK_SIZE,
+                                     g_task_get_priority (task),
+                                     g_task_get_cancellable (task),
+                                     deserialize_read_cb, task);
+          return;
+        }
+    }
+  else if (n_read == 0)
+    {
+      if (data->reader)
+        success = _gtk_text_buffer_rich_text_reader_end (data->reader, &error);
+      else if (data->data->len == 0)
+        {
+          g_set_error_literal (&error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                               _("No data to deserialize"));
+          success = FALSE;
+        }
+      else
+        {
+          gtk_text_buffer_get_iter_at_mark (data->content_buffer, &iter, data->mark);
+          success = gtk_text_buffer_deserialize (data->register_buffer,
+                                                 data->content_buffer,
+                                                 data->format, &iter,
+                                                 data->data->data, data->data->len,
+                                                 &error);
+        }
+    }
+  else
+    success = FALSE;
+
+  deserialize_data_finish (data);
+
+  if (success)
+    g_task_return_boolean (task, TRUE);
+  else
+    g_task_return_error (task, error);
+
+  g_object_unref (task);
+}
+
+/**
+ * gtk_text_buffer_deserialize_from_stream_async:
+ * @register_buffer: the #GtkTextBuffer @format is registered with
+ * @content_buffer: the #GtkTextBuffer to deserialize into
+ * @format: the rich text format to use for deserializing
+ * @iter: insertion point for the deserialized text
+ * @stream: the #GInputStream to read from
+ * @io_priority: the I/O priority of the request
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore
+ * @callback: (scope async): a #GAsyncReadyCallback to call when done
+ * @user_data: (closure): the data to pass to @callback
+ *
+ * Reads rich text in format @format from @stream, and inserts it at
+ * @iter like gtk_text_buffer_deserialize().
+ *
+ * The rich text format of GTK+, as registered with
+ * gtk_text_buffer_register_deserialize_tagset(), is inserted while it
+ * is read, without holding all of the data in memory. If an error
+ * occurs, the text that was inserted up to that point stays in
+ * @content_buffer. Other formats are read into memory first.
+ *
+ * Since: 3.20
+ **/
+void
+gtk_text_buffer_deserialize_from_stream_async (GtkTextBuffer       *register_buffer,
+                                               GtkTextBuffer       *content_buffer,
+                                               GdkAtom              format,
+                                               GtkTextIter         *iter,
+                                               GInputStream        *stream,
+                                               int                  io_priority,
+                                               GCancellable        *cancellable,
+                                               GAsyncReadyCallback  callback,
+                                               gpointer             user_data)
+{
+  GtkRichTextFormat *fmt;
+  DeserializeData *data;
+  GTask *task;
+
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (register_buffer));
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (content_buffer));
+  g_return_if_fail (format != GDK_NONE);
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (G_IS_INPUT_STREAM (stream));
+
+  task = g_task_new (register_buffer, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gtk_text_buffer_deserialize_from_stream_async);
+  g_task_set_priority (task, io_priority);
+
+  fmt = find_format (g_object_get_qdata (G_OBJECT (register_buffer), deserialize_quark ()),
+                     format);
+  if (fmt == NULL)
+    {
+      g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                               _("No deserialize function found for format %s"),
+                               gdk_atom_name (format));
+      g_object_unref (task);
+      return;
+    }
+
+  data = g_slice_new0 (DeserializeData);
+  data->register_buffer = g_object_ref (register_buffer);
+  data->content_buffer = g_object_ref (content_buffer);
+  data->format = format;
+  data->stream = g_object_ref (stream);
+  data->mark = gtk_text_buffer_create_mark (content_buffer, NULL, iter, FALSE);
+  data->chunk = g_malloc (STREAM_CHUNK_SIZE);
+  g_task_set_task_data (task, data, (GDestroyNotify) deserialize_data_free);
+
+  if (fmt->function == _gtk_text_buffer_deserialize_rich_text)
+    {
+      split_tags (content_buffer, iter, &data->split);
+      data->reader = _gtk_text_buffer_rich_text_reader_new (content_buffer, iter,
+                                                            fmt->can_create_tags);
+    }
+  else
+    data->data = g_byte_array_new ();
+
+  g_input_stream_read_async (stream, data->chunk, STREAM_CHUNK_SIZE,
+                             io_priority, cancellable,
+                             deserialize_read_cb, task);
+}
+
+/**
+ * gtk_text_buffer_deserialize_from_stream_finish:
+ * @register_buffer: the #GtkTextBuffer @format is registered with
+ * @result: a #GAsyncResult
+ * @error: return location for a #GError
+ *
+ * Finishes an operation started with
+ * gtk_text_buffer_deserialize_from_stream_async().
+ *
+ * Returns: %TRUE on success, %FALSE otherwise
+ *
+ * Since: 3.20
+ **/
+gboolean
+gtk_text_buffer_deserialize_from_stream_finish (GtkTextBuffer  *register_buffer,
+                                                GAsyncResult   *result,
+                                                GError        **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, register_buffer), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 
 /*  private functions  */
 
@@ -133,6 +133,36 @@ gboolean  gtk_text_buffer_deserialize                 (GtkTextBuffer
                                                        gsize                         length,
                                                        GError                      **error);
 
+GDK_AVAILABLE_IN_3_20
+void      gtk_text_buffer_serialize_to_stream_async   (GtkTextBuffer                *register_buffer,
+                                                       GtkTextBuffer                *content_buffer,
+                                                       GdkAtom                       format,
+                                                       const GtkTextIter            *start,
+                                                       const GtkTextIter            *end,
+                                                       GOutputStream                *stream,
+                                                       int                           io_priority,
+                                                       GCancellable                 *cancellable,
+                                                       GAsyncReadyCallback           callback,
+                                                       gpointer                      user_data);
+GDK_AVAILABLE_IN_3_20
+gboolean  gtk_text_buffer_serialize_to_stream_finish  (GtkTextBuffer                *register_buffer,
+                                                       GAsyncResult                 *result,
+                                                       GError                      **error);
+GDK_AVAILABLE_IN_3_20
+void      gtk_text_buffer_deserialize_from_stream_async (GtkTextBuffer              *register_buffer,
+                                                         GtkTextBuffer              *content_buffer,
+                                                         GdkAtom                     format,
+                                                         GtkTextIter                *iter,
+                                                         GInputStream               *stream,
+                                                         int                         io_priority,
+                                                         GCancellable               *cancellable,
+                                                         GAsyncReadyCallback         callback,
+                                                         gpointer                    user_data);
+GDK_AVAILABLE_IN_3_20
+gboolean  gtk_text_buffer_deserialize_from_stream_finish (GtkTextBuffer             *register_buffer,
+                                                          GAsyncResult              *result,
+                                                          GError                   **error);
+
 G_END_DECLS
 
 #endif /* __GTK_TEXT_BUFFER_RICH_TEXT_H__ */
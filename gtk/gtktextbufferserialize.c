@@ -34,6 +34,12 @@
 #include "gtkintl.h"
 
 
+/* Runs of text between tag toggles are written in pieces of at most
+ * this many characters, so that the serializer never needs much more
+ * memory than that for the text, however long the runs are.
+ */
+#define MAX_TEXT_RUN 16384
+
 typedef struct
 {
   GString *tag_table_str;
@@ -45,6 +51,11 @@ typedef struct
   GList *pixbufs;
   gint tag_id;
   GHashTable *tag_id_tags;
+
+  /* State of serialize_text_step() */
+  GtkTextIter iter;
+  GSList *tag_list;
+  GSList *active_tags;
 } SerializationContext;
 
 static gchar *
@@ -435,162 +446,207 @@ serialize_section_header (GString     *str,
 }
 
 static void
-serialize_text (GtkTextBuffer        *buffer,
-                SerializationContext *context)
+serialize_text_start (SerializationContext *context,
+                      GString              *str)
 {
-  GtkTextIter iter, old_iter;
-  GSList *tag_list, *new_tag_list;
-  GSList *active_tags;
+  g_string_append (str, "<text>");
 
-  g_string_append (context->text_str, "<text>");
+  context->iter = context->start;
+  context->tag_list = NULL;
+  context->active_tags = NULL;
+}
 
-  iter = context->start;
-  tag_list = NULL;
-  active_tags = NULL;
+/* Serializes the text up to the next tag toggle, pixbuf or
+ * MAX_TEXT_RUN characters, whichever comes first. Returns %FALSE
+ * once the end of the range has been written.
+ */
+static gboolean
+serialize_text_step (SerializationContext *context,
+                     GString              *str)
+{
+  GtkTextIter old_iter;
+  GSList *new_tag_list;
+  GList *added, *removed;
+  GList *tmp;
+  gchar *tmp_text, *escaped_text;
+  gint n_chars;
 
-  do
-    {
-      GList *added, *removed;
-      GList *tmp;
-      gchar *tmp_text, *escaped_text;
+  new_tag_list = gtk_text_iter_get_tags (&context->iter);
+  find_list_delta (context->tag_list, new_tag_list, &added, &removed);
 
-      new_tag_list = gtk_text_iter_get_tags (&iter);
-      find_list_delta (tag_list, new_tag_list, &added, &removed);
+  /* Handle removed tags */
+  for (tmp = removed; tmp; tmp = tmp->next)
+    {
+      GtkTextTag *tag = tmp->data;
 
-      /* Handle removed tags */
-      for (tmp = removed; tmp; tmp = tmp->next)
-	{
-	  GtkTextTag *tag = tmp->data;
+      /* Only close the tag if we didn't close it before (by using
+       * the stack logic in the while() loop below)
+       */
+      if (g_slist_find (context->active_tags, tag))
+        {
+          g_string_append (str, "</apply_tag>");
 
-          /* Only close the tag if we didn't close it before (by using
-           * the stack logic in the while() loop below)
+          /* Drop all tags that were opened after this one (which are
+           * above this on in the stack)
            */
-          if (g_slist_find (active_tags, tag))
+          while (context->active_tags->data != tag)
             {
-              g_string_append (context->text_str, "</apply_tag>");
-
-              /* Drop all tags that were opened after this one (which are
-               * above this on in the stack)
-               */
-              while (active_tags->data != tag)
-                {
-                  added = g_list_prepend (added, active_tags->data);
-                  active_tags = g_slist_remove (active_tags, active_tags->data);
-                  g_string_append_printf (context->text_str, "</apply_tag>");
-                }
-
-              active_tags = g_slist_remove (active_tags, active_tags->data);
+              added = g_list_prepend (added, context->active_tags->data);
+              context->active_tags = g_slist_remove (context->active_tags,
+                                                     context->active_tags->data);
+              g_string_append_printf (str, "</apply_tag>");
             }
-	}
 
-      /* Handle added tags */
-      for (tmp = added; tmp; tmp = tmp->next)
-	{
-	  GtkTextTag *tag = tmp->data;
-	  gchar *tag_name;
+          context->active_tags = g_slist_remove (context->active_tags,
+                                                 context->active_tags->data);
+        }
+    }
+
+  /* Handle added tags */
+  for (tmp = added; tmp; tmp = tmp->next)
+    {
+      GtkTextTag *tag = tmp->data;
+      gchar *tag_name;
 
-	  /* Add it to the tag hash table */
-	  g_hash_table_insert (context->tags, tag, tag);
+      /* Add it to the tag hash table */
+      g_hash_table_insert (context->tags, tag, tag);
 
-	  if (tag->priv->name)
-	    {
-	      tag_name = g_markup_escape_text (tag->priv->name, -1);
+      if (tag->priv->name)
+        {
+          tag_name = g_markup_escape_text (tag->priv->name, -1);
 
-	      g_string_append_printf (context->text_str, "<apply_tag name=\"%s\">", tag_name);
-	      g_free (tag_name);
-	    }
-	  else
-	    {
-	      gpointer tag_id;
+          g_string_append_printf (str, "<apply_tag name=\"%s\">", tag_name);
+          g_free (tag_name);
+        }
+      else
+        {
+          gpointer tag_id;
 
-	      /* We've got an anonymous tag, find out if it's been
-		 used before */
-	      if (!g_hash_table_lookup_extended (context->tag_id_tags, tag, NULL, &tag_id))
-		{
-		  tag_id = GINT_TO_POINTER (context->tag_id++);
+          /* We've got an anonymous tag, find out if it's been
+             used before */
+          if (!g_hash_table_lookup_extended (context->tag_id_tags, tag, NULL, &tag_id))
+            {
+              tag_id = GINT_TO_POINTER (context->tag_id++);
 
-		  g_hash_table_insert (context->tag_id_tags, tag, tag_id);
-		}
+              g_hash_table_insert (context->tag_id_tags, tag, tag_id);
+            }
 
-	      g_string_append_printf (context->text_str, "<apply_tag id=\"%d\">", GPOINTER_TO_INT (tag_id));
-	    }
+          g_string_append_printf (str, "<apply_tag id=\"%d\">", GPOINTER_TO_INT (tag_id));
+        }
 
-	  active_tags = g_slist_prepend (active_tags, tag);
-	}
+      context->active_tags = g_slist_prepend (context->active_tags, tag);
+    }
 
-      g_slist_free (tag_list);
-      tag_list = new_tag_list;
+  g_slist_free (context->tag_list);
+  context->tag_list = new_tag_list;
 
-      g_list_free (added);
-      g_list_free (removed);
+  g_list_free (added);
+  g_list_free (removed);
 
-      old_iter = iter;
+  old_iter = context->iter;
+  n_chars = 0;
 
-      /* Now try to go to either the next tag toggle, or if a pixbuf appears */
-      while (TRUE)
-	{
-	  gunichar ch = gtk_text_iter_get_char (&iter);
+  /* Now try to go to either the next tag toggle, or if a pixbuf appears */
+  while (TRUE)
+    {
+      gunichar ch = gtk_text_iter_get_char (&context->iter);
 
-	  if (ch == 0xFFFC)
-	    {
-	      GdkPixbuf *pixbuf = gtk_text_iter_get_pixbuf (&iter);
+      if (ch == 0xFFFC)
+        {
+          GdkPixbuf *pixbuf = gtk_text_iter_get_pixbuf (&context->iter);
 
-	      if (pixbuf)
-		{
-		  /* Append the text before the pixbuf */
-		  tmp_text = gtk_text_iter_get_slice (&old_iter, &iter);
-		  escaped_text = g_markup_escape_text (tmp_text, -1);
-		  g_free (tmp_text);
+          if (pixbuf)
+            {
+              /* Append the text before the pixbuf */
+              tmp_text = gtk_text_iter_get_slice (&old_iter, &context->iter);
+              escaped_text = g_markup_escape_text (tmp_text, -1);
+              g_free (tmp_text);
 
-		  /* Forward so we don't get the 0xfffc char */
-		  gtk_text_iter_forward_char (&iter);
-		  old_iter = iter;
+              /* Forward so we don't get the 0xfffc char */
+              gtk_text_iter_forward_char (&context->iter);
+              old_iter = context->iter;
 
-		  g_string_append (context->text_str, escaped_text);
-		  g_free (escaped_text);
+              g_string_append (str, escaped_text);
+              g_free (escaped_text);
 
-		  g_string_append_printf (context->text_str, "<pixbuf index=\"%d\" />", context->n_pixbufs);
+              g_string_append_printf (str, "<pixbuf index=\"%d\" />", context->n_pixbufs);
 
-		  context->n_pixbufs++;
-		  context->pixbufs = g_list_prepend (context->pixbufs, pixbuf);
-		}
-	    }
-          else if (ch == 0)
-            {
-                break;
+              context->n_pixbufs++;
+              context->pixbufs = g_list_prepend (context->pixbufs, g_object_ref (pixbuf));
             }
-	  else
-	    gtk_text_iter_forward_char (&iter);
+          else
+            gtk_text_iter_forward_char (&context->iter);
+        }
+      else if (ch == 0)
+        {
+          break;
+        }
+      else
+        gtk_text_iter_forward_char (&context->iter);
 
-	  if (gtk_text_iter_toggles_tag (&iter, NULL))
-	    break;
-	}
+      if (gtk_text_iter_toggles_tag (&context->iter, NULL) ||
+          gtk_text_iter_compare (&context->iter, &context->end) >= 0 ||
+          ++n_chars >= MAX_TEXT_RUN)
+        break;
+    }
 
-      /* We might have moved too far */
-      if (gtk_text_iter_compare (&iter, &context->end) > 0)
-	iter = context->end;
+  /* We might have moved too far */
+  if (gtk_text_iter_compare (&context->iter, &context->end) > 0)
+    context->iter = context->end;
 
-      /* Append the text */
-      tmp_text = gtk_text_iter_get_slice (&old_iter, &iter);
-      escaped_text = g_markup_escape_text (tmp_text, -1);
-      g_free (tmp_text);
+  /* Append the text */
+  tmp_text = gtk_text_iter_get_slice (&old_iter, &context->iter);
+  escaped_text = g_markup_escape_text (tmp_text, -1);
+  g_free (tmp_text);
 
-      g_string_append (context->text_str, escaped_text);
-      g_free (escaped_text);
-    }
-  while (!gtk_text_iter_equal (&iter, &context->end));
+  g_string_append (str, escaped_text);
+  g_free (escaped_text);
+
+  if (!gtk_text_iter_equal (&context->iter, &context->end))
+    return TRUE;
 
-  g_slist_free (tag_list);
+  g_slist_free (context->tag_list);
+  context->tag_list = NULL;
 
   /* Close any open tags */
-  for (tag_list = active_tags; tag_list; tag_list = tag_list->next)
-    g_string_append (context->text_str, "</apply_tag>");
+  for (new_tag_list = context->active_tags; new_tag_list; new_tag_list = new_tag_list->next)
+    g_string_append (str, "</apply_tag>");
+
+  g_slist_free (context->active_tags);
+  context->active_tags = NULL;
+  g_string_append (str, "</text>\n</text_view_markup>\n");
+
+  return FALSE;
+}
 
-  g_slist_free (active_tags);
-  g_string_append (context->text_str, "</text>\n</text_view_markup>\n");
+static void
+serialize_text (GtkTextBuffer        *buffer,
+                SerializationContext *context)
+{
+  serialize_text_start (context, context->text_str);
+
+  while (serialize_text_step (context, context->text_str))
+    ;
 }
 
 G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+static void
+serialize_pixbuf (GdkPixbuf *pixbuf,
+                  GString   *text)
+{
+  GdkPixdata pixdata;
+  guint8 *tmp;
+  guint len;
+
+  gdk_pixdata_from_pixbuf (&pixdata, pixbuf, FALSE);
+  tmp = gdk_pixdata_serialize (&pixdata, &len);
+
+  serialize_section_header (text, "GTKTEXTBUFFERPIXBDATA-0001", len);
+  g_string_append_len (text, (gchar *) tmp, len);
+  g_free (tmp);
+}
+G_GNUC_END_IGNORE_DEPRECATIONS
+
 static void
 serialize_pixbufs (SerializationContext *context,
 		   GString              *text)
@@ -598,21 +654,8 @@ serialize_pixbufs (SerializationContext *context,
   GList *list;
 
   for (list = context->pixbufs; list != NULL; list = list->next)
-    {
-      GdkPixbuf *pixbuf = list->data;
-      GdkPixdata pixdata;
-      guint8 *tmp;
-      guint len;
-
-      gdk_pixdata_from_pixbuf (&pixdata, pixbuf, FALSE);
-      tmp = gdk_pixdata_serialize (&pixdata, &len);
-
-      serialize_section_header (text, "GTKTEXTBUFFERPIXBDATA-0001", len);
-      g_string_append_len (text, (gchar *) tmp, len);
-      g_free (tmp);
-    }
+    serialize_pixbuf (list->data, text);
 }
-G_GNUC_END_IGNORE_DEPRECATIONS
 
 guint8 *
 _gtk_text_buffer_serialize_rich_text (GtkTextBuffer     *register_buffer,
@@ -651,7 +694,7 @@ _gtk_text_buffer_serialize_rich_text (GtkTextBuffer     *register_buffer,
   serialize_pixbufs (&context, text);
 
   g_hash_table_destroy (context.tags);
-  g_list_free (context.pixbufs);
+  g_list_free_full (context.pixbufs, g_object_unref);
   g_string_free (context.text_str, TRUE);
   g_string_free (context.tag_table_str, TRUE);
   g_hash_table_destroy (context.tag_id_tags);
@@ -661,6 +704,195 @@ _gtk_text_buffer_serialize_rich_text (GtkTextBuffer     *register_buffer,
   return (guint8 *) g_string_free (text, FALSE);
 }
 
+/* The streaming writer produces the same bytes as
+ * _gtk_text_buffer_serialize_rich_text(), a piece at a time.
+ *
+ * The contents section starts with its length, and the tag table
+ * comes before the text, but it is only known which tags are used
+ * after the text is serialized. So the text is serialized twice:
+ * once to find the tags and measure the section, and then again to
+ * write it out. Neither pass keeps more than a piece of the text.
+ */
+typedef enum
+{
+  WRITER_MEASURE,
+  WRITER_TAGS,
+  WRITER_TEXT,
+  WRITER_PIXBUFS,
+  WRITER_DONE
+} WriterPhase;
+
+struct _GtkTextBufferRichTextWriter
+{
+  SerializationContext context;
+  GtkTextBuffer *buffer;
+  WriterPhase phase;
+  gsize text_length;
+  GString *scratch;
+  GList *next_pixbuf;
+
+  gulong changed_handler;
+  gulong apply_tag_handler;
+  gulong remove_tag_handler;
+  gboolean modified;
+};
+
+static void
+writer_buffer_modified (GtkTextBufferRichTextWriter *writer)
+{
+  writer->modified = TRUE;
+}
+
+GtkTextBufferRichTextWriter *
+_gtk_text_buffer_rich_text_writer_new (GtkTextBuffer     *content_buffer,
+                                       const GtkTextIter *start,
+                                       const GtkTextIter *end)
+{
+  GtkTextBufferRichTextWriter *writer;
+
+  writer = g_slice_new0 (GtkTextBufferRichTextWriter);
+
+  writer->buffer = g_object_ref (content_buffer);
+  writer->context.tags = g_hash_table_new (NULL, NULL);
+  writer->context.tag_table_str = g_string_new (NULL);
+  writer->context.start = *start;
+  writer->context.end = *end;
+  writer->context.tag_id_tags = g_hash_table_new (NULL, NULL);
+  writer->scratch = g_string_new (NULL);
+  writer->phase = WRITER_MEASURE;
+
+  /* The iters and the measured length would be wrong after any change */
+  writer->changed_handler =
+    g_signal_connect_swapped (content_buffer, "changed",
+                              G_CALLBACK (writer_buffer_modified), writer);
+  writer->apply_tag_handler =
+    g_signal_connect_swapped (content_buffer, "apply-tag",
+                              G_CALLBACK (writer_buffer_modified), writer);
+  writer->remove_tag_handler =
+    g_signal_connect_swapped (content_buffer, "remove-tag",
+                              G_CALLBACK (writer_buffer_modified), writer);
+
+  serialize_text_start (&writer->context, writer->scratch);
+  writer->text_length = writer->scratch->len;
+  g_string_truncate (writer->scratch, 0);
+
+  return writer;
+}
+
+void
+_gtk_text_buffer_rich_text_writer_free (GtkTextBufferRichTextWriter *writer)
+{
+  g_signal_handler_disconnect (writer->buffer, writer->changed_handler);
+  g_signal_handler_disconnect (writer->buffer, writer->apply_tag_handler);
+  g_signal_handler_disconnect (writer->buffer, writer->remove_tag_handler);
+  g_object_unref (writer->buffer);
+
+  g_slist_free (writer->context.tag_list);
+  g_slist_free (writer->context.active_tags);
+  g_hash_table_destroy (writer->context.tags);
+  g_list_free_full (writer->context.pixbufs, g_object_unref);
+  g_string_free (writer->context.tag_table_str, TRUE);
+  g_hash_table_destroy (writer->context.tag_id_tags);
+  g_string_free (writer->scratch, TRUE);
+
+  g_slice_free (GtkTextBufferRichTextWriter, writer);
+}
+
+/* Appends the next piece of the serialized data to @out, usually
+ * about MAX_TEXT_RUN bytes, but nothing while the text is measured.
+ * Sets @done when everything has been written.
+ */
+gboolean
+_gtk_text_buffer_rich_text_writer_next (GtkTextBufferRichTextWriter  *writer,
+                                        GString                      *out,
+                                        gboolean                     *done,
+                                        GError                      **error)
+{
+  SerializationContext *context = &writer->context;
+  gsize length;
+
+  *done = FALSE;
+
+  if (writer->modified)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                           _("The text buffer was modified during serialization"));
+      return FALSE;
+    }
+
+  switch (writer->phase)
+    {
+    case WRITER_MEASURE:
+      while (writer->scratch->len < MAX_TEXT_RUN)
+        {
+          if (!serialize_text_step (context, writer->scratch))
+            {
+              writer->phase = WRITER_TAGS;
+              break;
+            }
+        }
+      writer->text_length += writer->scratch->len;
+      g_string_truncate (writer->scratch, 0);
+      break;
+
+    case WRITER_TAGS:
+      serialize_tags (context);
+
+      length = context->tag_table_str->len + writer->text_length;
+      if (length > G_MAXINT)
+        {
+          g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                               _("The text is too large to serialize"));
+          return FALSE;
+        }
+
+      serialize_section_header (out, "GTKTEXTBUFFERCONTENTS-0001", length);
+      g_string_append_len (out, context->tag_table_str->str, context->tag_table_str->len);
+
+      /* Serialize the text again, this time for real. The tags were
+       * all seen in the first pass, so anonymous tags keep their ids.
+       */
+      g_list_free_full (context->pixbufs, g_object_unref);
+      context->pixbufs = NULL;
+      context->n_pixbufs = 0;
+      serialize_text_start (context, out);
+      writer->phase = WRITER_TEXT;
+      break;
+
+    case WRITER_TEXT:
+      length = out->len;
+      while (out->len - length < MAX_TEXT_RUN)
+        {
+          if (!serialize_text_step (context, out))
+            {
+              context->pixbufs = g_list_reverse (context->pixbufs);
+              writer->next_pixbuf = context->pixbufs;
+              writer->phase = WRITER_PIXBUFS;
+              break;
+            }
+        }
+      break;
+
+    case WRITER_PIXBUFS:
+      if (writer->next_pixbuf)
+        {
+          serialize_pixbuf (writer->next_pixbuf->data, out);
+          writer->next_pixbuf = writer->next_pixbuf->next;
+        }
+      else
+        writer->phase = WRITER_DONE;
+      break;
+
+    case WRITER_DONE:
+    default:
+      break;
+    }
+
+  *done = writer->phase == WRITER_DONE;
+
+  return TRUE;
+}
+
 typedef enum
 {
   STATE_START,
@@ -723,6 +955,14 @@ typedef struct
 
   gboolean parsed_text;
   gboolean parsed_tags;
+
+  /* When streaming, text is inserted at this mark as it is parsed,
+   * and pixbufs are inserted later, when their sections are read.
+   * Until then, each is held by a placeholder character, and the
+   * index of the pixbuf maps to a mark in front of it.
+   */
+  GtkTextMark *insert_mark;
+  GHashTable *pending_pixbufs;
 } ParseInfo;
 
 static void
@@ -1142,6 +1382,21 @@ parse_apply_tag_element (GMarkupParseContext  *context,
 	return;
 
       int_id = atoi (pixbuf_id);
+
+      if (info->insert_mark)
+        {
+          GtkTextIter iter;
+          GtkTextMark *mark;
+
+          gtk_text_buffer_get_iter_at_mark (info->buffer, &iter, info->insert_mark);
+          mark = gtk_text_buffer_create_mark (info->buffer, NULL, &iter, TRUE);
+          gtk_text_buffer_insert (info->buffer, &iter, "\357\277\274", -1);
+          g_hash_table_insert (info->pending_pixbufs, GINT_TO_POINTER (int_id), mark);
+
+          push_state (info, STATE_PIXBUF);
+          return;
+        }
+
       pixbuf = get_pixbuf_from_headers (info->headers, int_id, error);
 
       span = g_slice_new0 (TextSpan);
@@ -1575,6 +1830,25 @@ all_whitespace (const char *text,
   return TRUE;
 }
 
+static void
+insert_streamed_text (ParseInfo   *info,
+                      const gchar *text,
+                      gsize        text_len)
+{
+  GtkTextIter start, end;
+  GSList *tags;
+  gint offset;
+
+  gtk_text_buffer_get_iter_at_mark (info->buffer, &end, info->insert_mark);
+  offset = gtk_text_iter_get_offset (&end);
+
+  gtk_text_buffer_insert (info->buffer, &end, text, text_len);
+  gtk_text_buffer_get_iter_at_offset (info->buffer, &start, offset);
+
+  for (tags = info->tag_stack; tags; tags = tags->next)
+    gtk_text_buffer_apply_tag (info->buffer, tags->data, &start, &end);
+}
+
 static void
 text_handler (GMarkupParseContext  *context,
 	      const gchar          *text,
@@ -1600,6 +1874,12 @@ text_handler (GMarkupParseContext  *context,
       if (text_len == 0)
 	return;
 
+      if (info->insert_mark)
+        {
+          insert_streamed_text (info, text, text_len);
+          return;
+        }
+
       span = g_slice_new0 (TextSpan);
       span->text = g_strndup (text, text_len);
       span->tags = g_slist_copy (info->tag_stack);
@@ -1632,6 +1912,8 @@ parse_info_init (ParseInfo     *info,
   info->current_tag = NULL;
   info->current_tag_prio = -1;
   info->tag_priorities = NULL;
+  info->insert_mark = NULL;
+  info->pending_pixbufs = NULL;
 
   info->buffer = buffer;
 }
@@ -1904,3 +2186,264 @@ _gtk_text_buffer_deserialize_rich_text (GtkTextBuffer *register_buffer,
 
   return retval;
 }
+
+/* The streaming reader takes the serialized data in pieces of any
+ * size. The text is inserted as it is parsed, so only the markup
+ * between two tags and one pixbuf section at a time are kept in
+ * memory.
+ */
+typedef enum
+{
+  READER_HEADER,
+  READER_CONTENTS,
+  READER_PIXBUF,
+  READER_TRAILER
+} ReaderPhase;
+
+struct _GtkTextBufferRichTextReader
+{
+  ParseInfo info;
+  GMarkupParseContext *context;
+  ReaderPhase phase;
+  guint8 header[30];
+  gsize header_len;
+  gsize remaining;
+  GByteArray *section;
+  gint n_sections;
+};
+
+GtkTextBufferRichTextReader *
+_gtk_text_buffer_rich_text_reader_new (GtkTextBuffer     *content_buffer,
+                                       const GtkTextIter *iter,
+                                       gboolean           create_tags)
+{
+  GtkTextBufferRichTextReader *reader;
+
+  static const GMarkupParser rich_text_parser = {
+    start_element_handler,
+    end_element_handler,
+    text_handler,
+    NULL,
+    NULL
+  };
+
+  reader = g_slice_new0 (GtkTextBufferRichTextReader);
+
+  g_object_ref (content_buffer);
+  parse_info_init (&reader->info, content_buffer, create_tags, NULL);
+  reader->info.insert_mark = gtk_text_buffer_create_mark (content_buffer, NULL, iter, FALSE);
+  reader->info.pending_pixbufs = g_hash_table_new (NULL, NULL);
+
+  reader->context = g_markup_parse_context_new (&rich_text_parser,
+                                                0, &reader->info, NULL);
+  reader->section = g_byte_array_new ();
+  reader->phase = READER_HEADER;
+
+  return reader;
+}
+
+static void
+remove_pending_pixbuf (gpointer key,
+                       gpointer value,
+                       gpointer user_data)
+{
+  GtkTextBuffer *buffer = user_data;
+  GtkTextMark *mark = value;
+  GtkTextIter start, end;
+
+  /* Remove the placeholder of a pixbuf that never came */
+  gtk_text_buffer_get_iter_at_mark (buffer, &start, mark);
+  end = start;
+  gtk_text_iter_forward_char (&end);
+  gtk_text_buffer_delete (buffer, &start, &end);
+  gtk_text_buffer_delete_mark (buffer, mark);
+}
+
+void
+_gtk_text_buffer_rich_text_reader_free (GtkTextBufferRichTextReader *reader)
+{
+  GtkTextBuffer *buffer = reader->info.buffer;
+
+  g_hash_table_foreach (reader->info.pending_pixbufs, remove_pending_pixbuf, buffer);
+  g_hash_table_destroy (reader->info.pending_pixbufs);
+  gtk_text_buffer_delete_mark (buffer, reader->info.insert_mark);
+
+  parse_info_free (&reader->info);
+  g_markup_parse_context_free (reader->context);
+  g_byte_array_unref (reader->section);
+  g_object_unref (buffer);
+
+  g_slice_free (GtkTextBufferRichTextReader, reader);
+}
+
+G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+static gboolean
+reader_insert_pixbuf (GtkTextBufferRichTextReader  *reader,
+                      GError                      **error)
+{
+  GtkTextBuffer *buffer = reader->info.buffer;
+  GtkTextMark *mark;
+  GtkTextIter start, end;
+  GdkPixdata pixdata;
+  GdkPixbuf *pixbuf;
+  gpointer id;
+
+  /* The first section holds the contents, the pixbufs come after */
+  id = GINT_TO_POINTER (reader->n_sections - 2);
+  mark = g_hash_table_lookup (reader->info.pending_pixbufs, id);
+  if (mark == NULL)
+    return TRUE;
+
+  if (!gdk_pixdata_deserialize (&pixdata, reader->section->len,
+                                reader->section->data, error))
+    return FALSE;
+
+  pixbuf = gdk_pixbuf_from_pixdata (&pixdata, TRUE, error);
+  if (pixbuf == NULL)
+    return FALSE;
+
+  g_hash_table_remove (reader->info.pending_pixbufs, id);
+
+  gtk_text_buffer_get_iter_at_mark (buffer, &start, mark);
+  end = start;
+  gtk_text_iter_forward_char (&end);
+  gtk_text_buffer_delete (buffer, &start, &end);
+  gtk_text_buffer_insert_pixbuf (buffer, &start, pixbuf);
+  gtk_text_buffer_delete_mark (buffer, mark);
+
+  g_object_unref (pixbuf);
+
+  return TRUE;
+}
+G_GNUC_END_IGNORE_DEPRECATIONS
+
+static gboolean
+reader_start_section (GtkTextBufferRichTextReader  *reader,
+                      GError                      **error)
+{
+  gint length;
+
+  length = read_int (reader->header + 26);
+  reader->header_len = 0;
+  reader->n_sections++;
+
+  if (strncmp ((gchar *) reader->header, "GTKTEXTBUFFERCONTENTS-0001", 26) == 0 &&
+      reader->n_sections == 1 && length >= 0)
+    reader->phase = READER_CONTENTS;
+  else if (strncmp ((gchar *) reader->header, "GTKTEXTBUFFERPIXBDATA-0001", 26) == 0 &&
+           reader->n_sections > 1 && length >= 0)
+    reader->phase = READER_PIXBUF;
+  else if (reader->n_sections > 1)
+    {
+      /* Like read_headers(), ignore anything after the known sections */
+      reader->phase = READER_TRAILER;
+      return TRUE;
+    }
+  else
+    {
+      g_set_error_literal (error,
+                           G_MARKUP_ERROR,
+                           G_MARKUP_ERROR_PARSE,
+                           _("Serialized data is malformed. First section isn't GTKTEXTBUFFERCONTENTS-0001"));
+      return FALSE;
+    }
+
+  reader->remaining = length;
+  g_byte_array_set_size (reader->section, 0);
+
+  return TRUE;
+}
+
+static gboolean
+reader_end_section (GtkTextBufferRichTextReader  *reader,
+                    GError                      **error)
+{
+  ReaderPhase phase = reader->phase;
+
+  reader->phase = READER_HEADER;
+
+  if (phase == READER_CONTENTS)
+    return g_markup_parse_context_end_parse (reader->context, error);
+  else
+    return reader_insert_pixbuf (reader, error);
+}
+
+gboolean
+_gtk_text_buffer_rich_text_reader_feed (GtkTextBufferRichTextReader  *reader,
+                                        const guint8                 *data,
+                                        gsize                         length,
+                                        GError                      **error)
+{
+  gsize n;
+
+  while (length > 0)
+    {
+      switch (reader->phase)
+        {
+        case READER_HEADER:
+          n = MIN (length, sizeof (reader->header) - reader->header_len);
+          memcpy (reader->header + reader->header_len, data, n);
+          reader->header_len += n;
+          data += n;
+          length -= n;
+
+          if (reader->header_len == sizeof (reader->header))
+            {
+              if (!reader_start_section (reader, error))
+                return FALSE;
+              if (reader->phase != READER_TRAILER && reader->remaining == 0 &&
+                  !reader_end_section (reader, error))
+                return FALSE;
+            }
+          break;
+
+        case READER_CONTENTS:
+          n = MIN (length, reader->remaining);
+          if (!g_markup_parse_context_parse (reader->context, (const gchar *) data, n, error))
+            return FALSE;
+          data += n;
+          length -= n;
+          reader->remaining -= n;
+
+          if (reader->remaining == 0 && !reader_end_section (reader, error))
+            return FALSE;
+          break;
+
+        case READER_PIXBUF:
+          n = MIN (length, reader->remaining);
+          g_byte_array_append (reader->section, data, n);
+          data += n;
+          length -= n;
+          reader->remaining -= n;
+
+          if (reader->remaining == 0 && !reader_end_section (reader, error))
+            return FALSE;
+          break;
+
+        case READER_TRAILER:
+        default:
+          return TRUE;
+        }
+    }
+
+  return TRUE;
+}
+
+/* Checks that the data ended after a complete section */
+gboolean
+_gtk_text_buffer_rich_text_reader_end (GtkTextBufferRichTextReader  *reader,
+                                       GError                      **error)
+{
+  if (reader->n_sections == 0 ||
+      (reader->phase != READER_HEADER && reader->phase != READER_TRAILER) ||
+      reader->header_len != 0)
+    {
+      g_set_error_literal (error,
+                           G_MARKUP_ERROR,
+                           G_MARKUP_ERROR_PARSE,
+                           _("Serialized data is malformed"));
+      return FALSE;
+    }
+
+  return TRUE;
+}
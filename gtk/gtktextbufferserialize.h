@@ -37,5 +37,29 @@ gboolean _gtk_text_buffer_deserialize_rich_text (GtkTextBuffer     *register_buf
                                                  gpointer           user_data,
                                                  GError           **error);
 
+typedef struct _GtkTextBufferRichTextWriter GtkTextBufferRichTextWriter;
+typedef struct _GtkTextBufferRichTextReader GtkTextBufferRichTextReader;
+
+GtkTextBufferRichTextWriter *
+         _gtk_text_buffer_rich_text_writer_new  (GtkTextBuffer                *content_buffer,
+                                                 const GtkTextIter            *start,
+                                                 const GtkTextIter            *end);
+gboolean _gtk_text_buffer_rich_text_writer_next (GtkTextBufferRichTextWriter  *writer,
+                                                 GString                      *out,
+                                                 gboolean                     *done,
+                                                 GError                      **error);
+void     _gtk_text_buffer_rich_text_writer_free (GtkTextBufferRichTextWriter  *writer);
+
+GtkTextBufferRichTextReader *
+         _gtk_text_buffer_rich_text_reader_new  (GtkTextBuffer                *content_buffer,
+                                                 const GtkTextIter            *iter,
+                                                 gboolean                      create_tags);
+gboolean _gtk_text_buffer_rich_text_reader_feed (GtkTextBufferRichTextReader  *reader,
+                                                 const guint8                 *data,
+                                                 gsize                         length,
+                                                 GError                      **error);
+gboolean _gtk_text_buffer_rich_text_reader_end  (GtkTextBufferRichTextReader  *reader,
+                                                 GError                      **error);
+void     _gtk_text_buffer_rich_text_reader_free (GtkTextBufferRichTextReader  *reader);
 
 #endif /* __GTK_TEXT_BUFFER_SERIALIZE_H__ */
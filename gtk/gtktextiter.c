@@ -4877,6 +4877,190 @@ strbreakup (const char *string,
   return str_array;
 }
 
+/* Returns the text of @line as gtk_text_iter_get_slice() would, or
+ * as gtk_text_iter_get_text() would if @slice is %FALSE. If the line
+ * has a single character segment, that is returned without copying,
+ * otherwise the text is put together in @buffer. Byte indexes in the
+ * text are line indexes, so %NULL is returned if @slice is %FALSE
+ * and the line has pixbufs or child anchors.
+ */
+static const gchar *
+line_get_text (GtkTextLine *line,
+               gboolean     slice,
+               GString     *buffer,
+               gint        *length)
+{
+  GtkTextLineSegment *seg;
+  GtkTextLineSegment *char_seg;
+  gint n_segs;
+
+  char_seg = NULL;
+  n_segs = 0;
+  for (seg = line->segments; seg != NULL; seg = seg->next)
+    {
+      if (seg->byte_count == 0)
+        continue;
+
+      if (seg->type == &gtk_text_char_type)
+        char_seg = seg;
+      else if (!slice)
+        return NULL;
+
+      n_segs++;
+    }
+
+  if (n_segs == 0)
+    {
+      *length = 0;
+      return "";
+    }
+
+  if (n_segs == 1 && char_seg != NULL)
+    {
+      *length = char_seg->byte_count;
+      return char_seg->body.chars;
+    }
+
+  g_string_truncate (buffer, 0);
+  for (seg = line->segments; seg != NULL; seg = seg->next)
+    {
+      if (seg->type == &gtk_text_char_type)
+        g_string_append_len (buffer, seg->body.chars, seg->byte_count);
+      else if (seg->byte_count > 0)
+        g_string_append_len (buffer, _gtk_text_unknown_char_utf8,
+                             GTK_TEXT_UNKNOWN_CHAR_UTF8_LEN);
+    }
+
+  *length = buffer->len;
+  return buffer->str;
+}
+
+/* Boyer-Moore-Horspool: @skip says how far the needle can be moved
+ * when a byte is at the position of its last byte.
+ */
+static void
+horspool_init (const gchar *needle,
+               gsize        needle_len,
+               gsize        skip[256])
+{
+  gsize i;
+
+  for (i = 0; i < 256; i++)
+    skip[i] = needle_len;
+
+  for (i = 0; i + 1 < needle_len; i++)
+    skip[(guchar) needle[i]] = needle_len - 1 - i;
+}
+
+static const gchar *
+horspool_search (const gchar *haystack,
+                 gsize        haystack_len,
+                 const gchar *needle,
+                 gsize        needle_len,
+                 const gsize  skip[256])
+{
+  gsize last = needle_len - 1;
+  gsize i = 0;
+
+  while (i + needle_len <= haystack_len)
+    {
+      guchar c = haystack[i + last];
+
+      if (c == (guchar) needle[last] &&
+          memcmp (haystack + i, needle, last) == 0)
+        return haystack + i;
+
+      i += skip[c];
+    }
+
+  return NULL;
+}
+
+/* The case sensitive search for needles without newlines, which looks
+ * at the segments of each line instead of copying its text, and at
+ * each line only once.
+ */
+static gboolean
+forward_search_in_lines (const GtkTextIter *iter,
+                         const gchar       *str,
+                         gboolean           slice,
+                         GtkTextIter       *match_start,
+                         GtkTextIter       *match_end,
+                         const GtkTextIter *limit)
+{
+  GtkTextIter search;
+  GString *buffer;
+  gsize skip[256];
+  gsize str_len;
+  gint index;
+  gboolean found;
+
+  str_len = strlen (str);
+  horspool_init (str, str_len, skip);
+  buffer = g_string_new (NULL);
+
+  search = *iter;
+  index = gtk_text_iter_get_line_index (&search);
+  found = FALSE;
+
+  do
+    {
+      const gchar *text;
+      const gchar *match;
+      gint length;
+
+      if (limit &&
+          gtk_text_iter_compare (&search, limit) >= 0)
+        break;
+
+      text = line_get_text (_gtk_text_iter_get_text_line (&search),
+                            slice, buffer, &length);
+
+      if (text == NULL)
+        {
+          GtkTextIter start;
+          const gchar *lines[2];
+
+          /* Fall back to the slow path for lines with pixbufs or
+           * child anchors in text only searches.
+           */
+          lines[0] = str;
+          lines[1] = NULL;
+          start = search;
+          if (index > 0)
+            gtk_text_iter_set_line_index (&start, index);
+
+          if (lines_match (&start, lines, FALSE, slice, FALSE,
+                           match_start, match_end))
+            {
+              found = TRUE;
+              break;
+            }
+        }
+      else if (length - index >= (gint) str_len)
+        {
+          match = horspool_search (text + index, length - index,
+                                   str, str_len, skip);
+          if (match)
+            {
+              *match_start = search;
+              gtk_text_iter_set_line_index (match_start, match - text);
+              *match_end = *match_start;
+              gtk_text_iter_set_line_index (match_end, match - text + str_len);
+              found = TRUE;
+              break;
+            }
+        }
+
+      index = 0;
+    }
+  while (gtk_text_iter_forward_line (&search));
+
+  g_string_free (buffer, TRUE);
+
+  return found;
+}
+
 /**
  * gtk_text_iter_forward_search:
  * @iter: start of search
@@ -4946,6 +5130,25 @@ gtk_text_iter_forward_search (const GtkTextIter *iter,
   slice = (flags & GTK_TEXT_SEARCH_TEXT_ONLY) == 0;
   case_insensitive = (flags & GTK_TEXT_SEARCH_CASE_INSENSITIVE) != 0;
 
+  if (!visible_only && !case_insensitive && strchr (str, '\n') == NULL)
+    {
+      GtkTextIter end;
+
+      if (forward_search_in_lines (iter, str, slice, &match, &end, limit) &&
+          (limit == NULL ||
+           gtk_text_iter_compare (&end, limit) <= 0))
+        {
+          if (match_start)
+            *match_start = match;
+          if (match_end)
+            *match_end = end;
+
+          return TRUE;
+        }
+
+      return FALSE;
+    }
+
   /* locate all lines */
 
   lines = strbreakup (str, "\n", -1, NULL, case_insensitive);
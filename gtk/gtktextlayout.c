@@ -99,8 +99,34 @@ struct _GtkTextLayoutPrivate
      direction only influences the direction of the cursor line.
   */
   GtkTextLine *cursor_line;
+
+  /* The displays of the lines that were used last, most recent
+   * first, and the links in that queue by line. Only lines with
+   * line data are cached, so that freeing the line data always
+   * removes the display.
+   */
+  GQueue display_cache;
+  GHashTable *display_cache_lines;
+  gsize display_cache_size;
+
+  /* Metrics of the default style, used to guess the height of lines
+   * that have not been wrapped yet. 0 if not computed yet.
+   */
+  gint estimated_line_height;
+  gint estimated_char_width;
+
+  /* Set while the lines are invalidated for a new screen width */
+  guint keep_displays : 1;
 };
 
+/* Line displays are cached until their estimated size adds up to
+ * this. With the estimate below that is about a thousand lines of
+ * 80 characters, which is more than a screen full.
+ */
+#define DISPLAY_CACHE_MAX_SIZE   (4 * 1024 * 1024)
+#define DISPLAY_CACHE_LINE_SIZE  1024
+#define DISPLAY_CACHE_CHAR_SIZE  40
+
 static GtkTextLineData *gtk_text_layout_real_wrap (GtkTextLayout *layout,
                                                    GtkTextLine *line,
                                                    /* may be NULL */
@@ -114,6 +140,7 @@ static void gtk_text_layout_real_invalidate        (GtkTextLayout     *layout,
 static void gtk_text_layout_real_invalidate_cursors(GtkTextLayout     *layout,
 						    const GtkTextIter *start,
 						    const GtkTextIter *end);
+static void gtk_text_layout_display_cache_clear   (GtkTextLayout     *layout);
 static void gtk_text_layout_invalidate_cache       (GtkTextLayout     *layout,
 						    GtkTextLine       *line,
 						    gboolean           cursors_only);
@@ -195,12 +222,7 @@ gtk_text_layout_dispose (GObject *object)
   g_clear_object (&layout->ltr_context);
   g_clear_object (&layout->rtl_context);
 
-  if (layout->one_display_cache)
-    {
-      GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-      layout->one_display_cache = NULL;
-      gtk_text_layout_free_line_display (layout, tmp_display);
-    }
+  gtk_text_layout_display_cache_clear (layout);
 
   if (layout->preedit_attrs != NULL)
     {
@@ -218,6 +240,9 @@ gtk_text_layout_finalize (GObject *object)
 
   layout = GTK_TEXT_LAYOUT (object);
 
+  gtk_text_layout_display_cache_clear (layout);
+  g_hash_table_unref (GTK_TEXT_LAYOUT_GET_PRIVATE (layout)->display_cache_lines);
+
   g_free (layout->preedit_string);
 
   G_OBJECT_CLASS (gtk_text_layout_parent_class)->finalize (object);
@@ -278,7 +303,12 @@ gtk_text_layout_class_init (GtkTextLayoutClass *klass)
 static void
 gtk_text_layout_init (GtkTextLayout *text_layout)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (text_layout);
+
   text_layout->cursor_visible = TRUE;
+
+  g_queue_init (&priv->display_cache);
+  priv->display_cache_lines = g_hash_table_new (NULL, NULL);
 }
 
 GtkTextLayout*
@@ -315,6 +345,8 @@ gtk_text_layout_set_buffer (GtkTextLayout *layout,
 
   if (layout->buffer)
     {
+      gtk_text_layout_display_cache_clear (layout);
+
       _gtk_text_btree_remove_view (_gtk_text_buffer_get_btree (layout->buffer),
                                   layout);
 
@@ -355,8 +387,13 @@ gtk_text_layout_set_buffer (GtkTextLayout *layout,
 void
 gtk_text_layout_default_style_changed (GtkTextLayout *layout)
 {
+  GtkTextLayoutPrivate *priv;
+
   g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
 
+  priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  priv->estimated_line_height = 0;
+
   DV (g_print ("invalidating all due to default style change (%s)\n", G_STRLOC));
   gtk_text_layout_invalidate_all (layout);
 }
@@ -386,8 +423,13 @@ gtk_text_layout_set_contexts (GtkTextLayout *layout,
                               PangoContext  *ltr_context,
                               PangoContext  *rtl_context)
 {
+  GtkTextLayoutPrivate *priv;
+
   g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
 
+  priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  priv->estimated_line_height = 0;
+
   if (layout->ltr_context != ltr_context)
     {
       if (layout->ltr_context)
@@ -492,6 +534,9 @@ gtk_text_layout_get_buffer (GtkTextLayout *layout)
 void
 gtk_text_layout_set_screen_width (GtkTextLayout *layout, gint width)
 {
+  GtkTextLayoutPrivate *priv;
+  GList *l;
+
   g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
   g_return_if_fail (width >= 0);
   g_return_if_fail (layout->wrap_loop_count == 0);
@@ -499,10 +544,24 @@ gtk_text_layout_set_screen_width (GtkTextLayout *layout, gint width)
   if (layout->screen_width == width)
     return;
 
+  priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   layout->screen_width = width;
 
+  /* Only line breaking depends on the width, so the cached displays
+   * keep their text and attributes, and are wrapped again when they
+   * are used. Lines still need to be invalidated to be measured again.
+   */
+  for (l = priv->display_cache.head; l != NULL; l = l->next)
+    {
+      GtkTextLineDisplay *display = l->data;
+
+      display->width_invalid = TRUE;
+    }
+
   DV (g_print ("invalidating all due to new screen width (%s)\n", G_STRLOC));
+  priv->keep_displays = TRUE;
   gtk_text_layout_invalidate_all (layout);
+  priv->keep_displays = FALSE;
 }
 
 /**
@@ -637,18 +696,23 @@ text_layout_changed (GtkTextLayout *layout,
                      gint           new_height,
                      gboolean       cursors_only)
 {
-  /* Check if the range intersects our cached line display,
-   * and invalidate the cached line if so.
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *l, *next;
+
+  /* Check if the range intersects our cached line displays,
+   * and invalidate the cached lines if so.
    */
-  if (layout->one_display_cache)
+  for (l = priv->display_cache.head; l != NULL; l = next)
     {
-      GtkTextLine *line = layout->one_display_cache->line;
+      GtkTextLineDisplay *display = l->data;
       gint cache_y = _gtk_text_btree_find_line_top (_gtk_text_buffer_get_btree (layout->buffer),
-						    line, layout);
-      gint cache_height = layout->one_display_cache->height;
+						    display->line, layout);
+      gint cache_height = display->height;
+
+      next = l->next;
 
       if (cache_y + cache_height > y && cache_y < y + old_height)
-	gtk_text_layout_invalidate_cache (layout, line, cursors_only);
+	gtk_text_layout_invalidate_cache (layout, display->line, cursors_only);
     }
 
   gtk_text_layout_emit_changed (layout, y, old_height, new_height);
@@ -815,14 +879,79 @@ gtk_text_layout_invalidate_all (GtkTextLayout *layout)
   gtk_text_layout_invalidate (layout, &start, &end);
 }
 
+static gsize
+line_display_cache_size (GtkTextLineDisplay *display)
+{
+  /* A rough estimate of the memory used by the display */
+  return DISPLAY_CACHE_LINE_SIZE +
+         DISPLAY_CACHE_CHAR_SIZE * pango_layout_get_character_count (display->layout);
+}
+
+static gboolean
+gtk_text_layout_display_is_cached (GtkTextLayout      *layout,
+                                   GtkTextLineDisplay *display)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  link = g_hash_table_lookup (priv->display_cache_lines, display->line);
+
+  return link != NULL && link->data == display;
+}
+
+static void
+gtk_text_layout_display_cache_remove (GtkTextLayout *layout,
+                                      GList         *link)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextLineDisplay *display = link->data;
+
+  g_hash_table_remove (priv->display_cache_lines, display->line);
+  g_queue_delete_link (&priv->display_cache, link);
+  priv->display_cache_size -= line_display_cache_size (display);
+
+  gtk_text_layout_free_line_display (layout, display);
+}
+
+static void
+gtk_text_layout_display_cache_add (GtkTextLayout      *layout,
+                                   GtkTextLineDisplay *display)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  g_queue_push_head (&priv->display_cache, display);
+  g_hash_table_insert (priv->display_cache_lines, display->line, priv->display_cache.head);
+  priv->display_cache_size += line_display_cache_size (display);
+
+  /* Drop the least recently used displays, but always keep
+   * the one we just made
+   */
+  while (priv->display_cache_size > DISPLAY_CACHE_MAX_SIZE &&
+         priv->display_cache.length > 1)
+    gtk_text_layout_display_cache_remove (layout, priv->display_cache.tail);
+}
+
+static void
+gtk_text_layout_display_cache_clear (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  while (priv->display_cache.head != NULL)
+    gtk_text_layout_display_cache_remove (layout, priv->display_cache.head);
+}
+
 static void
 gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
                                   GtkTextLine   *line,
 				  gboolean       cursors_only)
 {
-  if (layout->one_display_cache && line == layout->one_display_cache->line)
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  link = g_hash_table_lookup (priv->display_cache_lines, line);
+  if (link != NULL)
     {
-      GtkTextLineDisplay *display = layout->one_display_cache;
+      GtkTextLineDisplay *display = link->data;
 
       if (cursors_only)
 	{
@@ -832,11 +961,8 @@ gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
 	  display->cursors_invalid = TRUE;
 	  display->has_block_cursor = FALSE;
 	}
-      else
-	{
-	  layout->one_display_cache = NULL;
-	  gtk_text_layout_free_line_display (layout, display);
-	}
+      else if (!(priv->keep_displays && display->width_invalid))
+        gtk_text_layout_display_cache_remove (layout, link);
     }
 }
 
@@ -867,16 +993,93 @@ gtk_text_layout_invalidate_cursor_line (GtkTextLayout *layout,
     }
 }
 
+static void
+gtk_text_layout_invalidate_neutral_line (GtkTextLayout *layout,
+                                         GtkTextLine   *line)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  link = g_hash_table_lookup (priv->display_cache_lines, line);
+  if (link != NULL && line->dir_strong == PANGO_DIRECTION_NEUTRAL)
+    gtk_text_layout_display_cache_remove (layout, link);
+}
+
 static void
 gtk_text_layout_update_cursor_line(GtkTextLayout *layout)
 {
   GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextLine *old_cursor_line;
   GtkTextIter iter;
 
   gtk_text_buffer_get_iter_at_mark (layout->buffer, &iter,
                                     gtk_text_buffer_get_insert (layout->buffer));
 
+  old_cursor_line = priv->cursor_line;
   priv->cursor_line = _gtk_text_iter_get_text_line (&iter);
+
+  /* Lines without strong direction take theirs from the keyboard
+   * when they have the cursor, so their displays change. The old
+   * line may be gone, but then it is not in the cache either.
+   */
+  if (old_cursor_line != priv->cursor_line)
+    {
+      gtk_text_layout_invalidate_neutral_line (layout, old_cursor_line);
+      gtk_text_layout_invalidate_neutral_line (layout, priv->cursor_line);
+    }
+}
+
+/* Guesses the height of @line from the metrics of the default style
+ * and the number of characters in it, without laying it out. Returns
+ * 0 if there is no font to measure yet.
+ */
+static gint
+gtk_text_layout_estimate_line_height (GtkTextLayout *layout,
+                                      GtkTextLine   *line)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextAttributes *style = layout->default_style;
+  gint n_rows;
+
+  if (style == NULL || layout->ltr_context == NULL)
+    return 0;
+
+  if (priv->estimated_line_height == 0)
+    {
+      PangoFontMetrics *metrics;
+
+      metrics = pango_context_get_metrics (layout->ltr_context,
+                                           style->font,
+                                           style->language);
+      priv->estimated_line_height =
+        PIXEL_BOUND (pango_font_metrics_get_ascent (metrics) +
+                     pango_font_metrics_get_descent (metrics));
+      priv->estimated_char_width =
+        PIXEL_BOUND (pango_font_metrics_get_approximate_char_width (metrics));
+      pango_font_metrics_unref (metrics);
+
+      if (priv->estimated_line_height == 0)
+        return 0;
+    }
+
+  n_rows = 1;
+  if (style->wrap_mode != GTK_WRAP_NONE)
+    {
+      gint width;
+
+      width = layout->screen_width - style->left_margin - style->right_margin;
+      if (width > 0)
+        {
+          gint line_width;
+
+          line_width = _gtk_text_line_char_count (line) * priv->estimated_char_width;
+          n_rows = MAX (1, (line_width + width - 1) / width);
+        }
+    }
+
+  return style->pixels_above_lines + style->pixels_below_lines +
+         n_rows * priv->estimated_line_height +
+         (n_rows - 1) * style->pixels_inside_wrap;
 }
 
 static void
@@ -886,6 +1089,7 @@ gtk_text_layout_real_invalidate (GtkTextLayout *layout,
 {
   GtkTextLine *line;
   GtkTextLine *last_line;
+  GtkTextLine *estimated_line;
 
   g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
   g_return_if_fail (layout->wrap_loop_count == 0);
@@ -904,6 +1108,7 @@ gtk_text_layout_real_invalidate (GtkTextLayout *layout,
 
   last_line = _gtk_text_iter_get_text_line (end);
   line = _gtk_text_iter_get_text_line (start);
+  estimated_line = NULL;
 
   while (TRUE)
     {
@@ -913,6 +1118,29 @@ gtk_text_layout_real_invalidate (GtkTextLayout *layout,
       
       if (line_data)
         _gtk_text_line_invalidate_wrap (line, line_data);
+      else
+        {
+          gint height;
+
+          /* Give lines that were never wrapped an estimated height
+           * right away, instead of 0 until validation reaches them,
+           * so that the size of a large buffer is roughly right
+           * before it has been validated.
+           */
+          height = gtk_text_layout_estimate_line_height (layout, line);
+          if (height > 0)
+            {
+              line_data = _gtk_text_line_data_new (layout, line);
+              line_data->height = height;
+              _gtk_text_line_add_data (line, line_data);
+              _gtk_text_line_invalidate_wrap (line, line_data);
+
+              /* The sizes of the nodes are updated once per node */
+              if (estimated_line && estimated_line->parent != line->parent)
+                _gtk_text_line_update_view_size (estimated_line, layout);
+              estimated_line = line;
+            }
+        }
 
       if (line == last_line)
         break;
@@ -920,6 +1148,9 @@ gtk_text_layout_real_invalidate (GtkTextLayout *layout,
       line = _gtk_text_line_next_excluding_last (line);
     }
 
+  if (estimated_line)
+    _gtk_text_line_update_view_size (estimated_line, layout);
+
   gtk_text_layout_invalidated (layout);
 }
 
@@ -928,32 +1159,51 @@ gtk_text_layout_real_invalidate_cursors (GtkTextLayout     *layout,
 					 const GtkTextIter *start,
 					 const GtkTextIter *end)
 {
-  /* Check if the range intersects our cached line display,
-   * and invalidate the cached line if so.
-   */
-  if (layout->one_display_cache)
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextLine *line;
+  GtkTextLine *last_line;
+  gint first_number;
+  gint last_number;
+  GList *l;
+
+  if (gtk_text_iter_compare (start, end) > 0)
     {
-      GtkTextIter line_start, line_end;
-      GtkTextLine *line = layout->one_display_cache->line;
+      const GtkTextIter *tmp = start;
+      start = end;
+      end = tmp;
+    }
 
-      gtk_text_layout_get_iter_at_line (layout, &line_start, line, 0);
+  /* Invalidate the cached line displays in the range. Cursor
+   * changes usually touch a line or two, so look those up, but
+   * check the cache instead when the range has more lines.
+   */
+  line = _gtk_text_iter_get_text_line (start);
+  last_line = _gtk_text_iter_get_text_line (end);
+  first_number = gtk_text_iter_get_line (start);
+  last_number = gtk_text_iter_get_line (end);
 
-      line_end = line_start;
-      if (!gtk_text_iter_ends_line (&line_end))
-	gtk_text_iter_forward_to_line_end (&line_end);
+  if (last_number - first_number < (gint) priv->display_cache.length)
+    {
+      while (TRUE)
+        {
+          gtk_text_layout_invalidate_cache (layout, line, TRUE);
 
-      if (gtk_text_iter_compare (start, end) > 0)
-	{
-	  const GtkTextIter *tmp = start;
-	  start = end;
-	  end = tmp;
-	}
+          if (line == last_line)
+            break;
 
-      if (gtk_text_iter_compare (&line_start, end) <= 0 &&
-	  gtk_text_iter_compare (start, &line_end) <= 0)
-	{
-	  gtk_text_layout_invalidate_cache (layout, line, TRUE);
-	}
+          line = _gtk_text_line_next_excluding_last (line);
+        }
+    }
+  else
+    {
+      for (l = priv->display_cache.head; l != NULL; l = l->next)
+        {
+          GtkTextLineDisplay *display = l->data;
+          gint number = _gtk_text_line_get_number (display->line);
+
+          if (number >= first_number && number <= last_number)
+            gtk_text_layout_invalidate_cache (layout, display->line, TRUE);
+        }
     }
 
   gtk_text_layout_invalidated (layout);
@@ -1398,7 +1648,8 @@ set_para_values (GtkTextLayout      *layout,
   h_margin = display->left_margin + display->right_margin;
   h_padding = layout->left_padding + layout->right_padding;
 
-  if (style->wrap_mode != GTK_WRAP_NONE)
+  display->wraps = style->wrap_mode != GTK_WRAP_NONE;
+  if (display->wraps)
     {
       int layout_width = (layout->screen_width - h_margin - h_padding);
       pango_layout_set_width (display->layout, layout_width * PANGO_SCALE);
@@ -2223,6 +2474,113 @@ tags_array_toggle_tag (GPtrArray  *array,
   return array;
 }
 
+static void
+update_line_display_size (GtkTextLayout      *layout,
+                          GtkTextLineDisplay *display)
+{
+  PangoRectangle extents;
+  gint text_pixel_width;
+  gint h_margin;
+  gint h_padding;
+
+  pango_layout_get_extents (display->layout, NULL, &extents);
+
+  text_pixel_width = PIXEL_BOUND (extents.width);
+
+  h_margin = display->left_margin + display->right_margin;
+  h_padding = layout->left_padding + layout->right_padding;
+
+  display->width = text_pixel_width + h_margin + h_padding;
+  display->height = display->top_margin + display->bottom_margin +
+                    PANGO_PIXELS (extents.height);
+  display->x_offset = display->left_margin;
+
+  /* If we aren't wrapping, we need to do the alignment of each
+   * paragraph ourselves.
+   */
+  if (pango_layout_get_width (display->layout) < 0)
+    {
+      gint excess = display->total_width - text_pixel_width;
+
+      switch (pango_layout_get_alignment (display->layout))
+	{
+	case PANGO_ALIGN_LEFT:
+	  break;
+	case PANGO_ALIGN_CENTER:
+	  display->x_offset += excess / 2;
+	  break;
+	case PANGO_ALIGN_RIGHT:
+	  display->x_offset += excess;
+	  break;
+	}
+    }
+}
+
+/* Whether a paragraph that is laid out as a single left aligned
+ * line stays the same when wrapped to @width. Setting the width of
+ * the PangoLayout makes it itemize and shape the text again, so this
+ * is worth avoiding for the many lines that are shorter than the
+ * screen.
+ */
+static gboolean
+line_display_fits_width (GtkTextLineDisplay *display,
+                         gint                width)
+{
+  PangoLayout *layout = display->layout;
+  PangoLayoutLine *line;
+  PangoRectangle extents;
+
+  if (pango_layout_get_width (layout) < 0 ||
+      pango_layout_get_alignment (layout) != PANGO_ALIGN_LEFT ||
+      pango_layout_get_justify (layout) ||
+      pango_layout_get_line_count (layout) != 1)
+    return FALSE;
+
+  line = pango_layout_get_line_readonly (layout, 0);
+  if (line->resolved_dir != PANGO_DIRECTION_LTR)
+    return FALSE;
+
+  pango_layout_line_get_extents (line, NULL, &extents);
+
+  return extents.width + MAX (pango_layout_get_indent (layout), 0) <= width;
+}
+
+/* Wraps a cached display to the current screen width, reusing its
+ * text and attributes
+ */
+static void
+rewrap_line_display (GtkTextLayout      *layout,
+                     GtkTextLineDisplay *display)
+{
+  gint h_margin;
+  gint h_padding;
+
+  display->width_invalid = FALSE;
+
+  h_margin = display->left_margin + display->right_margin;
+  h_padding = layout->left_padding + layout->right_padding;
+
+  if (display->wraps)
+    {
+      int layout_width = (layout->screen_width - h_margin - h_padding);
+
+      if (!line_display_fits_width (display, layout_width * PANGO_SCALE))
+        pango_layout_set_width (display->layout, layout_width * PANGO_SCALE);
+    }
+  display->total_width = MAX (layout->screen_width, layout->width) - h_margin - h_padding;
+
+  if (display->cursors)
+    g_array_free (display->cursors, TRUE);
+  display->cursors = NULL;
+  display->cursors_invalid = TRUE;
+  display->has_block_cursor = FALSE;
+
+  update_line_display_size (layout, display);
+
+  if (display->has_children)
+    allocate_child_widgets (layout, display);
+}
+
 GtkTextLineDisplay *
 gtk_text_layout_get_line_display (GtkTextLayout *layout,
                                   GtkTextLine   *line,
@@ -2230,14 +2588,13 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
 {
   GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextLineDisplay *display;
+  GList *cache_link;
   GtkTextLineSegment *seg;
   GtkTextIter iter;
   GtkTextAttributes *style;
   gchar *text;
-  gint text_pixel_width;
   PangoAttrList *attrs;
   gint text_allocated, layout_byte_offset, buffer_byte_offset;
-  PangoRectangle extents;
   gboolean para_values_set = FALSE;
   GSList *cursor_byte_offsets = NULL;
   GSList *cursor_segs = NULL;
@@ -2246,29 +2603,31 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   PangoDirection base_dir;
   GPtrArray *tags;
   gboolean initial_toggle_segments;
-  gint h_margin;
-  gint h_padding;
   
   g_return_val_if_fail (line != NULL, NULL);
 
-  if (layout->one_display_cache)
+  cache_link = g_hash_table_lookup (priv->display_cache_lines, line);
+  if (cache_link != NULL)
     {
-      if (line == layout->one_display_cache->line &&
-          (size_only || !layout->one_display_cache->size_only))
+      display = cache_link->data;
+
+      if (size_only || !display->size_only)
 	{
+          g_queue_unlink (&priv->display_cache, cache_link);
+          g_queue_push_head_link (&priv->display_cache, cache_link);
+
+          if (display->width_invalid)
+            rewrap_line_display (layout, display);
+
 	  if (!size_only)
-            update_text_display_cursors (layout, line, layout->one_display_cache);
-	  return layout->one_display_cache;
+            update_text_display_cursors (layout, line, display);
+	  return display;
 	}
       else
-        {
-          GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-          layout->one_display_cache = NULL;
-          gtk_text_layout_free_line_display (layout, tmp_display);
-        }
+        gtk_text_layout_display_cache_remove (layout, cache_link);
     }
 
-  DV (g_print ("creating one line display cache (%s)\n", G_STRLOC));
+  DV (g_print ("creating line display (%s)\n", G_STRLOC));
 
   display = g_slice_new0 (GtkTextLineDisplay);
 
@@ -2553,37 +2912,8 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   g_slist_free (cursor_byte_offsets);
   g_slist_free (cursor_segs);
 
-  pango_layout_get_extents (display->layout, NULL, &extents);
-
-  text_pixel_width = PIXEL_BOUND (extents.width);
-  display->width = text_pixel_width + display->left_margin + display->right_margin;
-
-  h_margin = display->left_margin + display->right_margin;
-  h_padding = layout->left_padding + layout->right_padding;
+  update_line_display_size (layout, display);
 
-  display->width = text_pixel_width + h_margin + h_padding;
-  display->height += PANGO_PIXELS (extents.height);
-
-  /* If we aren't wrapping, we need to do the alignment of each
-   * paragraph ourselves.
-   */
-  if (pango_layout_get_width (display->layout) < 0)
-    {
-      gint excess = display->total_width - text_pixel_width;
-
-      switch (pango_layout_get_alignment (display->layout))
-	{
-	case PANGO_ALIGN_LEFT:
-	  break;
-	case PANGO_ALIGN_CENTER:
-	  display->x_offset += excess / 2;
-	  break;
-	case PANGO_ALIGN_RIGHT:
-	  display->x_offset += excess;
-	  break;
-	}
-    }
-  
   /* Free this if we aren't in a loop */
   if (layout->wrap_loop_count == 0)
     invalidate_cached_style (layout);
@@ -2593,8 +2923,10 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   if (tags != NULL)
     g_ptr_array_free (tags, TRUE);
 
-  layout->one_display_cache = display;
+  if (_gtk_text_line_get_data (line, layout) != NULL)
+    gtk_text_layout_display_cache_add (layout, display);
 
+  display->has_children = saw_widget;
   if (saw_widget)
     allocate_child_widgets (layout, display);
   
@@ -2605,7 +2937,7 @@ void
 gtk_text_layout_free_line_display (GtkTextLayout      *layout,
                                    GtkTextLineDisplay *display)
 {
-  if (display != layout->one_display_cache)
+  if (!gtk_text_layout_display_is_cached (layout, display))
     {
       if (display->layout)
         g_object_unref (display->layout);
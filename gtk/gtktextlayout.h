@@ -147,9 +147,7 @@ struct _GtkTextLayout
    * over long runs with the same style. */
   GtkTextAttributes *one_style_cache;
 
-  /* A cache of one line display. Getting the same line
-   * many times in a row is the most common case.
-   */
+  /* Unused, line displays are cached in the private struct */
   GtkTextLineDisplay *one_display_cache;
 
   /* Whether we are allowed to wrap right now */
@@ -256,6 +254,9 @@ struct _GtkTextLineDisplay
   guint has_block_cursor : 1;
   guint cursor_at_line_end : 1;
   guint size_only : 1;
+  guint wraps : 1;              /* Width of layout follows the screen width */
+  guint has_children : 1;
+  guint width_invalid : 1;      /* Needs wrapping to a new screen width */
 
   GdkRGBA *pg_bg_rgba;
 };
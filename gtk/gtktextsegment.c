@@ -189,6 +189,18 @@ char_segment_self_check (GtkTextLineSegment *seg)
 
 GtkTextLineSegment*
 _gtk_char_segment_new (const gchar *text, guint len)
+{
+  return _gtk_char_segment_new_with_chars (text, len,
+                                           g_utf8_strlen (text, len));
+}
+
+/* Like _gtk_char_segment_new(), for callers that counted the
+ * characters in @text already.
+ */
+GtkTextLineSegment*
+_gtk_char_segment_new_with_chars (const gchar *text,
+                                  guint        len,
+                                  guint        chars)
 {
   GtkTextLineSegment *seg;
 
@@ -201,7 +213,7 @@ _gtk_char_segment_new (const gchar *text, guint len)
   memcpy (seg->body.chars, text, len);
   seg->body.chars[len] = '\0';
 
-  seg->char_count = g_utf8_strlen (seg->body.chars, seg->byte_count);
+  seg->char_count = chars;
 
   if (gtk_get_debug_flags () & GTK_DEBUG_TEXT)
     char_segment_self_check (seg);
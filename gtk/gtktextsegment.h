@@ -49,6 +49,7 @@ struct _GtkTextTagInfo {
   GtkTextTag *tag;
   GtkTextBTreeNode *tag_root; /* highest-level node containing the tag */
   gint toggle_count;      /* total toggles of this tag below tag_root */
+  guint id;               /* unique in the tree, for node tag masks */
 };
 
 /* Body of a segment that toggles a tag on or off */
@@ -155,6 +156,9 @@ GtkTextLineSegment  *gtk_text_line_segment_split (const GtkTextIter *iter);
 
 GtkTextLineSegment *_gtk_char_segment_new                  (const gchar    *text,
                                                             guint           len);
+GtkTextLineSegment *_gtk_char_segment_new_with_chars       (const gchar    *text,
+                                                            guint           len,
+                                                            guint           chars);
 GtkTextLineSegment *_gtk_char_segment_new_from_two_strings (const gchar    *text1,
                                                             guint           len1,
 							    guint           chars1,
@@ -123,6 +123,9 @@
 
 #define SPACE_FOR_CURSOR 1
 
+/* How long incremental validation may run per idle, in microseconds */
+#define INCREMENTAL_VALIDATE_TIME 8000
+
 #define GTK_TEXT_VIEW_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GTK_TYPE_TEXT_VIEW, GtkTextViewPrivate))
 
 typedef struct _GtkTextWindow GtkTextWindow;
@@ -4395,10 +4398,18 @@ incremental_validate_callback (gpointer data)
 {
   GtkTextView *text_view = data;
   gboolean result = TRUE;
+  gint64 end_time;
 
   DV(g_print(G_STRLOC"\n"));
-  
-  gtk_text_layout_validate (text_view->priv->layout, 2000);
+
+  /* Validate in chunks until the time slice is used up, so that
+   * large buffers don't take one main loop iteration per chunk.
+   */
+  end_time = g_get_monotonic_time () + INCREMENTAL_VALIDATE_TIME;
+  do
+    gtk_text_layout_validate (text_view->priv->layout, 2000);
+  while (!gtk_text_layout_is_valid (text_view->priv->layout) &&
+         g_get_monotonic_time () < end_time);
 
   gtk_text_view_update_adjustments (text_view);
   
@@ -22,42 +22,71 @@
 #include "gtktreedatalist.h"
 #include <string.h>
 
-/* node allocation
- */
-GtkTreeDataList *
-_gtk_tree_data_list_alloc (void)
+struct _GtkTreeDataLayout
+{
+  gint n_columns;
+  gsize row_size;
+  GType *types;
+  GType *fundamentals;
+  gsize *offsets;
+
+  /* Strings set on the rows are interned here and refcounted, so a
+   * column with many repeated values only stores each value once.
+   */
+  GHashTable *strings;
+};
+
+typedef struct
+{
+  guint ref_count;
+  gchar str[1];
+} PooledString;
+
+#define POOLED_STRING(s) ((PooledString *) ((s) - G_STRUCT_OFFSET (PooledString, str)))
+
+#define CELL(row, layout, column, type) \
+  (*(type *) ((guint8 *) (row) + (layout)->offsets[column]))
+
+static const gchar *
+string_pool_ref (GtkTreeDataLayout *layout,
+                 const gchar       *str)
 {
-  GtkTreeDataList *list;
+  gpointer key;
+  PooledString *pooled;
+  gsize len;
 
-  list = g_slice_new0 (GtkTreeDataList);
+  if (str == NULL)
+    return NULL;
 
-  return list;
+  if (g_hash_table_lookup_extended (layout->strings, str, &key, NULL))
+    {
+      POOLED_STRING ((gchar *) key)->ref_count++;
+      return key;
+    }
+
+  len = strlen (str);
+  pooled = g_malloc (G_STRUCT_OFFSET (PooledString, str) + len + 1);
+  pooled->ref_count = 1;
+  memcpy (pooled->str, str, len + 1);
+  g_hash_table_add (layout->strings, pooled->str);
+
+  return pooled->str;
 }
 
-void
-_gtk_tree_data_list_free (GtkTreeDataList *list,
-			  GType           *column_headers)
+static void
+string_pool_unref (GtkTreeDataLayout *layout,
+                   const gchar       *str)
 {
-  GtkTreeDataList *tmp, *next;
-  gint i = 0;
+  PooledString *pooled;
 
-  tmp = list;
+  if (str == NULL)
+    return;
 
-  while (tmp)
+  pooled = POOLED_STRING (str);
+  if (--pooled->ref_count == 0)
     {
-      next = tmp->next;
-      if (g_type_is_a (column_headers [i], G_TYPE_STRING))
-	g_free ((gchar *) tmp->data.v_pointer);
-      else if (g_type_is_a (column_headers [i], G_TYPE_OBJECT) && tmp->data.v_pointer != NULL)
-	g_object_unref (tmp->data.v_pointer);
-      else if (g_type_is_a (column_headers [i], G_TYPE_BOXED) && tmp->data.v_pointer != NULL)
-	g_boxed_free (column_headers [i], (gpointer) tmp->data.v_pointer);
-      else if (g_type_is_a (column_headers [i], G_TYPE_VARIANT) && tmp->data.v_pointer != NULL)
-	g_variant_unref ((gpointer) tmp->data.v_pointer);
-
-      g_slice_free (GtkTreeDataList, tmp);
-      i++;
-      tmp = next;
+      g_hash_table_remove (layout->strings, str);
+      g_free (pooled);
     }
 }
 
@@ -116,204 +145,347 @@ get_fundamental_type (GType type)
 
   return result;
 }
-void
-_gtk_tree_data_list_node_to_value (GtkTreeDataList *list,
-				   GType            type,
-				   GValue          *value)
+static gsize
+get_cell_size (GType fundamental)
 {
-  g_value_init (value, type);
-
-  switch (get_fundamental_type (type))
+  switch (fundamental)
     {
-    case G_TYPE_BOOLEAN:
-      g_value_set_boolean (value, (gboolean) list->data.v_int);
-      break;
     case G_TYPE_CHAR:
-      g_value_set_schar (value, (gchar) list->data.v_char);
-      break;
     case G_TYPE_UCHAR:
-      g_value_set_uchar (value, (guchar) list->data.v_uchar);
-      break;
+      return 1;
+    case G_TYPE_BOOLEAN:
     case G_TYPE_INT:
-      g_value_set_int (value, (gint) list->data.v_int);
-      break;
     case G_TYPE_UINT:
-      g_value_set_uint (value, (guint) list->data.v_uint);
-      break;
+    case G_TYPE_ENUM:
+    case G_TYPE_FLAGS:
+      return sizeof (gint);
+    case G_TYPE_FLOAT:
+      return sizeof (gfloat);
     case G_TYPE_LONG:
-      g_value_set_long (value, list->data.v_long);
-      break;
     case G_TYPE_ULONG:
-      g_value_set_ulong (value, list->data.v_ulong);
-      break;
+      return sizeof (glong);
     case G_TYPE_INT64:
-      g_value_set_int64 (value, list->data.v_int64);
-      break;
     case G_TYPE_UINT64:
-      g_value_set_uint64 (value, list->data.v_uint64);
-      break;
-    case G_TYPE_ENUM:
-      g_value_set_enum (value, list->data.v_int);
-      break;
-    case G_TYPE_FLAGS:
-      g_value_set_flags (value, list->data.v_uint);
-      break;
-    case G_TYPE_FLOAT:
-      g_value_set_float (value, (gfloat) list->data.v_float);
-      break;
+      return sizeof (gint64);
     case G_TYPE_DOUBLE:
-      g_value_set_double (value, (gdouble) list->data.v_double);
-      break;
+      return sizeof (gdouble);
     case G_TYPE_STRING:
-      g_value_set_string (value, (gchar *) list->data.v_pointer);
-      break;
     case G_TYPE_POINTER:
-      g_value_set_pointer (value, (gpointer) list->data.v_pointer);
-      break;
     case G_TYPE_BOXED:
-      g_value_set_boxed (value, (gpointer) list->data.v_pointer);
-      break;
+    case G_TYPE_OBJECT:
     case G_TYPE_VARIANT:
-      g_value_set_variant (value, (gpointer) list->data.v_pointer);
+      return sizeof (gpointer);
+    default:
+      return 0;
+    }
+}
+
+/* Columns are placed by decreasing size, so that every cell is
+ * naturally aligned without any padding between them.
+ */
+GtkTreeDataLayout *
+_gtk_tree_data_layout_new (gint   n_columns,
+                           GType *types)
+{
+  static const gsize sizes[] = { 8, 4, 2, 1 };
+  GtkTreeDataLayout *layout;
+  gsize offset;
+  guint s;
+  gint i;
+
+  layout = g_slice_new0 (GtkTreeDataLayout);
+  layout->n_columns = n_columns;
+  layout->types = g_memdup (types, n_columns * sizeof (GType));
+  layout->fundamentals = g_new (GType, n_columns);
+  layout->offsets = g_new0 (gsize, n_columns);
+  layout->strings = g_hash_table_new (g_str_hash, g_str_equal);
+
+  for (i = 0; i < n_columns; i++)
+    layout->fundamentals[i] = get_fundamental_type (types[i]);
+
+  offset = 0;
+  for (s = 0; s < G_N_ELEMENTS (sizes); s++)
+    {
+      for (i = 0; i < n_columns; i++)
+        {
+          if (get_cell_size (layout->fundamentals[i]) == sizes[s])
+            {
+              layout->offsets[i] = offset;
+              offset += sizes[s];
+            }
+        }
+    }
+
+  layout->row_size = MAX (offset, sizeof (gpointer));
+  layout->row_size = (layout->row_size + 7) & ~(gsize) 7;
+
+  return layout;
+}
+
+void
+_gtk_tree_data_layout_free (GtkTreeDataLayout *layout)
+{
+  if (layout == NULL)
+    return;
+
+  g_warn_if_fail (g_hash_table_size (layout->strings) == 0);
+
+  g_hash_table_unref (layout->strings);
+  g_free (layout->types);
+  g_free (layout->fundamentals);
+  g_free (layout->offsets);
+  g_slice_free (GtkTreeDataLayout, layout);
+}
+
+gsize
+_gtk_tree_data_layout_get_row_size (GtkTreeDataLayout *layout)
+{
+  return layout->row_size;
+}
+
+GtkTreeDataRow *
+_gtk_tree_data_row_new (GtkTreeDataLayout *layout)
+{
+  return g_slice_alloc0 (layout->row_size);
+}
+
+static void
+clear_cell (GtkTreeDataRow    *row,
+            GtkTreeDataLayout *layout,
+            gint               column)
+{
+  gpointer p;
+
+  switch (layout->fundamentals[column])
+    {
+    case G_TYPE_STRING:
+      string_pool_unref (layout, CELL (row, layout, column, gchar *));
       break;
     case G_TYPE_OBJECT:
-      g_value_set_object (value, (GObject *) list->data.v_pointer);
+      p = CELL (row, layout, column, gpointer);
+      if (p)
+        g_object_unref (p);
       break;
-    default:
-      g_warning ("%s: Unsupported type (%s) retrieved.", G_STRLOC, g_type_name (value->g_type));
+    case G_TYPE_BOXED:
+      p = CELL (row, layout, column, gpointer);
+      if (p)
+        g_boxed_free (layout->types[column], p);
       break;
+    case G_TYPE_VARIANT:
+      p = CELL (row, layout, column, gpointer);
+      if (p)
+        g_variant_unref (p);
+      break;
+    default:
+      return;
     }
+
+  CELL (row, layout, column, gpointer) = NULL;
 }
 
 void
-_gtk_tree_data_list_value_to_node (GtkTreeDataList *list,
-				   GValue          *value)
+_gtk_tree_data_row_free (GtkTreeDataRow    *row,
+                         GtkTreeDataLayout *layout)
 {
-  switch (get_fundamental_type (G_VALUE_TYPE (value)))
+  gint i;
+
+  if (row == NULL)
+    return;
+
+  for (i = 0; i < layout->n_columns; i++)
+    clear_cell (row, layout, i);
+
+  g_slice_free1 (layout->row_size, row);
+}
+
+GtkTreeDataRow *
+_gtk_tree_data_row_copy (GtkTreeDataRow    *row,
+                         GtkTreeDataLayout *layout)
+{
+  GtkTreeDataRow *new_row;
+  gpointer p;
+  gint i;
+
+  if (row == NULL)
+    return NULL;
+
+  new_row = g_slice_copy (layout->row_size, row);
+
+  for (i = 0; i < layout->n_columns; i++)
+    {
+      p = CELL (row, layout, i, gpointer);
+
+      switch (layout->fundamentals[i])
+        {
+        case G_TYPE_STRING:
+          if (p)
+            POOLED_STRING ((gchar *) p)->ref_count++;
+          break;
+        case G_TYPE_OBJECT:
+          if (p)
+            g_object_ref (p);
+          break;
+        case G_TYPE_BOXED:
+          if (p)
+            CELL (new_row, layout, i, gpointer) = g_boxed_copy (layout->types[i], p);
+          break;
+        case G_TYPE_VARIANT:
+          if (p)
+            g_variant_ref (p);
+          break;
+        default:
+          break;
+        }
+    }
+
+  return new_row;
+}
+
+void
+_gtk_tree_data_row_get_value (GtkTreeDataRow    *row,
+                              GtkTreeDataLayout *layout,
+                              gint               column,
+                              GValue            *value)
+{
+  g_value_init (value, layout->types[column]);
+
+  switch (layout->fundamentals[column])
     {
     case G_TYPE_BOOLEAN:
-      list->data.v_int = g_value_get_boolean (value);
+      g_value_set_boolean (value, CELL (row, layout, column, gint));
       break;
     case G_TYPE_CHAR:
-      list->data.v_char = g_value_get_schar (value);
+      g_value_set_schar (value, CELL (row, layout, column, gint8));
       break;
     case G_TYPE_UCHAR:
-      list->data.v_uchar = g_value_get_uchar (value);
+      g_value_set_uchar (value, CELL (row, layout, column, guint8));
       break;
     case G_TYPE_INT:
-      list->data.v_int = g_value_get_int (value);
+      g_value_set_int (value, CELL (row, layout, column, gint));
       break;
     case G_TYPE_UINT:
-      list->data.v_uint = g_value_get_uint (value);
+      g_value_set_uint (value, CELL (row, layout, column, guint));
       break;
     case G_TYPE_LONG:
-      list->data.v_long = g_value_get_long (value);
+      g_value_set_long (value, CELL (row, layout, column, glong));
       break;
     case G_TYPE_ULONG:
-      list->data.v_ulong = g_value_get_ulong (value);
+      g_value_set_ulong (value, CELL (row, layout, column, gulong));
       break;
     case G_TYPE_INT64:
-      list->data.v_int64 = g_value_get_int64 (value);
+      g_value_set_int64 (value, CELL (row, layout, column, gint64));
       break;
     case G_TYPE_UINT64:
-      list->data.v_uint64 = g_value_get_uint64 (value);
+      g_value_set_uint64 (value, CELL (row, layout, column, guint64));
       break;
     case G_TYPE_ENUM:
-      list->data.v_int = g_value_get_enum (value);
+      g_value_set_enum (value, CELL (row, layout, column, gint));
       break;
     case G_TYPE_FLAGS:
-      list->data.v_uint = g_value_get_flags (value);
-      break;
-    case G_TYPE_POINTER:
-      list->data.v_pointer = g_value_get_pointer (value);
+      g_value_set_flags (value, CELL (row, layout, column, guint));
       break;
     case G_TYPE_FLOAT:
-      list->data.v_float = g_value_get_float (value);
+      g_value_set_float (value, CELL (row, layout, column, gfloat));
       break;
     case G_TYPE_DOUBLE:
-      list->data.v_double = g_value_get_double (value);
+      g_value_set_double (value, CELL (row, layout, column, gdouble));
       break;
     case G_TYPE_STRING:
-      g_free (list->data.v_pointer);
-      list->data.v_pointer = g_value_dup_string (value);
+      g_value_set_string (value, CELL (row, layout, column, gchar *));
       break;
-    case G_TYPE_OBJECT:
-      if (list->data.v_pointer)
-	g_object_unref (list->data.v_pointer);
-      list->data.v_pointer = g_value_dup_object (value);
+    case G_TYPE_POINTER:
+      g_value_set_pointer (value, CELL (row, layout, column, gpointer));
       break;
     case G_TYPE_BOXED:
-      if (list->data.v_pointer)
-	g_boxed_free (G_VALUE_TYPE (value), list->data.v_pointer);
-      list->data.v_pointer = g_value_dup_boxed (value);
+      g_value_set_boxed (value, CELL (row, layout, column, gpointer));
       break;
     case G_TYPE_VARIANT:
-      if (list->data.v_pointer)
-	g_variant_unref (list->data.v_pointer);
-      list->data.v_pointer = g_value_dup_variant (value);
+      g_value_set_variant (value, CELL (row, layout, column, gpointer));
+      break;
+    case G_TYPE_OBJECT:
+      g_value_set_object (value, CELL (row, layout, column, gpointer));
       break;
     default:
-      g_warning ("%s: Unsupported type (%s) stored.", G_STRLOC, g_type_name (G_VALUE_TYPE (value)));
+      g_warning ("%s: Unsupported type (%s) retrieved.", G_STRLOC, g_type_name (value->g_type));
       break;
     }
 }
 
-GtkTreeDataList *
-_gtk_tree_data_list_node_copy (GtkTreeDataList *list,
-                               GType            type)
+/* @value must hold the type of @column, or a subtype of it */
+void
+_gtk_tree_data_row_set_value (GtkTreeDataRow    *row,
+                              GtkTreeDataLayout *layout,
+                              gint               column,
+                              GValue            *value)
 {
-  GtkTreeDataList *new_list;
-
-  g_return_val_if_fail (list != NULL, NULL);
-  
-  new_list = _gtk_tree_data_list_alloc ();
-  new_list->next = NULL;
+  const gchar *str;
 
-  switch (get_fundamental_type (type))
+  switch (layout->fundamentals[column])
     {
     case G_TYPE_BOOLEAN:
+      CELL (row, layout, column, gint) = g_value_get_boolean (value);
+      break;
     case G_TYPE_CHAR:
+      CELL (row, layout, column, gint8) = g_value_get_schar (value);
+      break;
     case G_TYPE_UCHAR:
+      CELL (row, layout, column, guint8) = g_value_get_uchar (value);
+      break;
     case G_TYPE_INT:
+      CELL (row, layout, column, gint) = g_value_get_int (value);
+      break;
     case G_TYPE_UINT:
+      CELL (row, layout, column, guint) = g_value_get_uint (value);
+      break;
     case G_TYPE_LONG:
+      CELL (row, layout, column, glong) = g_value_get_long (value);
+      break;
     case G_TYPE_ULONG:
+      CELL (row, layout, column, gulong) = g_value_get_ulong (value);
+      break;
     case G_TYPE_INT64:
+      CELL (row, layout, column, gint64) = g_value_get_int64 (value);
+      break;
     case G_TYPE_UINT64:
+      CELL (row, layout, column, guint64) = g_value_get_uint64 (value);
+      break;
     case G_TYPE_ENUM:
+      CELL (row, layout, column, gint) = g_value_get_enum (value);
+      break;
     case G_TYPE_FLAGS:
+      CELL (row, layout, column, guint) = g_value_get_flags (value);
+      break;
     case G_TYPE_POINTER:
+      CELL (row, layout, column, gpointer) = g_value_get_pointer (value);
+      break;
     case G_TYPE_FLOAT:
+      CELL (row, layout, column, gfloat) = g_value_get_float (value);
+      break;
     case G_TYPE_DOUBLE:
-      new_list->data = list->data;
+      CELL (row, layout, column, gdouble) = g_value_get_double (value);
       break;
     case G_TYPE_STRING:
-      new_list->data.v_pointer = g_strdup (list->data.v_pointer);
+      /* Take the reference first, the old and new value may be the same */
+      str = string_pool_ref (layout, g_value_get_string (value));
+      clear_cell (row, layout, column);
+      CELL (row, layout, column, const gchar *) = str;
       break;
     case G_TYPE_OBJECT:
-    case G_TYPE_INTERFACE:
-      new_list->data.v_pointer = list->data.v_pointer;
-      if (new_list->data.v_pointer)
-	g_object_ref (new_list->data.v_pointer);
+      clear_cell (row, layout, column);
+      CELL (row, layout, column, gpointer) = g_value_dup_object (value);
       break;
     case G_TYPE_BOXED:
-      if (list->data.v_pointer)
-	new_list->data.v_pointer = g_boxed_copy (type, list->data.v_pointer);
-      else
-	new_list->data.v_pointer = NULL;
+      clear_cell (row, layout, column);
+      CELL (row, layout, column, gpointer) = g_value_dup_boxed (value);
       break;
     case G_TYPE_VARIANT:
-      if (list->data.v_pointer)
-	new_list->data.v_pointer = g_variant_ref (list->data.v_pointer);
-      else
-	new_list->data.v_pointer = NULL;
+      clear_cell (row, layout, column);
+      CELL (row, layout, column, gpointer) = g_value_dup_variant (value);
       break;
     default:
-      g_warning ("Unsupported node type (%s) copied.", g_type_name (type));
+      g_warning ("%s: Unsupported type (%s) stored.", G_STRLOC, g_type_name (G_VALUE_TYPE (value)));
       break;
     }
-
-  return new_list;
 }
 
 gint
@@ -464,6 +636,197 @@ _gtk_tree_data_list_compare_func (GtkTreeModel *model,
 }
 
 
+/* Sort keys
+ *
+ * Sorting by a column with _gtk_tree_data_list_compare_func() fetches
+ * two values and, for strings, collates them on every comparison. The
+ * stores and GtkTreeModelSort instead take the value of each row once,
+ * turn it into a key that compares the same way, and sort the keys.
+ */
+
+typedef enum
+{
+  SORT_KEY_INT,
+  SORT_KEY_UINT,
+  SORT_KEY_DOUBLE,
+  SORT_KEY_STRING,
+  SORT_KEY_NONE
+} SortKeyKind;
+
+typedef struct
+{
+  SortKeyKind kind;
+  gboolean descending;
+} SortKeyOrder;
+
+static SortKeyKind
+get_sort_key_kind (GType type)
+{
+  switch (get_fundamental_type (type))
+    {
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_CHAR:
+    case G_TYPE_INT:
+    case G_TYPE_LONG:
+    case G_TYPE_INT64:
+    case G_TYPE_ENUM:
+      return SORT_KEY_INT;
+    case G_TYPE_UCHAR:
+    case G_TYPE_UINT:
+    case G_TYPE_ULONG:
+    case G_TYPE_UINT64:
+    case G_TYPE_FLAGS:
+      return SORT_KEY_UINT;
+    case G_TYPE_FLOAT:
+    case G_TYPE_DOUBLE:
+      return SORT_KEY_DOUBLE;
+    case G_TYPE_STRING:
+      return SORT_KEY_STRING;
+    default:
+      return SORT_KEY_NONE;
+    }
+}
+
+gboolean
+_gtk_tree_data_sort_keys_supported (GType type)
+{
+  return get_sort_key_kind (type) != SORT_KEY_NONE;
+}
+
+void
+_gtk_tree_data_sort_key_init (GtkTreeDataSortKey *key,
+                              const GValue       *value)
+{
+  const gchar *str;
+
+  switch (get_fundamental_type (G_VALUE_TYPE (value)))
+    {
+    case G_TYPE_BOOLEAN:
+      key->value.v_int = g_value_get_boolean (value);
+      break;
+    case G_TYPE_CHAR:
+      key->value.v_int = g_value_get_schar (value);
+      break;
+    case G_TYPE_UCHAR:
+      key->value.v_uint = g_value_get_uchar (value);
+      break;
+    case G_TYPE_INT:
+      key->value.v_int = g_value_get_int (value);
+      break;
+    case G_TYPE_UINT:
+      key->value.v_uint = g_value_get_uint (value);
+      break;
+    case G_TYPE_LONG:
+      key->value.v_int = g_value_get_long (value);
+      break;
+    case G_TYPE_ULONG:
+      key->value.v_uint = g_value_get_ulong (value);
+      break;
+    case G_TYPE_INT64:
+      key->value.v_int = g_value_get_int64 (value);
+      break;
+    case G_TYPE_UINT64:
+      key->value.v_uint = g_value_get_uint64 (value);
+      break;
+    case G_TYPE_ENUM:
+      key->value.v_int = g_value_get_enum (value);
+      break;
+    case G_TYPE_FLAGS:
+      key->value.v_uint = g_value_get_flags (value);
+      break;
+    case G_TYPE_FLOAT:
+      key->value.v_double = g_value_get_float (value);
+      break;
+    case G_TYPE_DOUBLE:
+      key->value.v_double = g_value_get_double (value);
+      break;
+    case G_TYPE_STRING:
+      /* comparing these with strcmp() is the same as g_utf8_collate() */
+      str = g_value_get_string (value);
+      key->value.v_string = g_utf8_collate_key (str ? str : "", -1);
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static gint
+compare_sort_keys (gconstpointer a,
+                   gconstpointer b,
+                   gpointer      user_data)
+{
+  const GtkTreeDataSortKey *key_a = a;
+  const GtkTreeDataSortKey *key_b = b;
+  const SortKeyOrder *order = user_data;
+  gint retval;
+
+  switch (order->kind)
+    {
+    case SORT_KEY_INT:
+      retval = (key_a->value.v_int > key_b->value.v_int) - (key_a->value.v_int < key_b->value.v_int);
+      break;
+    case SORT_KEY_UINT:
+      retval = (key_a->value.v_uint > key_b->value.v_uint) - (key_a->value.v_uint < key_b->value.v_uint);
+      break;
+    case SORT_KEY_DOUBLE:
+      if (key_a->value.v_double < key_b->value.v_double)
+        retval = -1;
+      else if (key_a->value.v_double == key_b->value.v_double)
+        retval = 0;
+      else
+        retval = 1;
+      break;
+    case SORT_KEY_STRING:
+      retval = strcmp (key_a->value.v_string, key_b->value.v_string);
+      break;
+    case SORT_KEY_NONE:
+    default:
+      g_assert_not_reached ();
+      retval = 0;
+    }
+
+  if (order->descending)
+    retval = -retval;
+
+  /* equal rows keep their order */
+  if (retval == 0)
+    retval = (key_a->index > key_b->index) - (key_a->index < key_b->index);
+
+  return retval;
+}
+
+void
+_gtk_tree_data_sort_keys_sort (GtkTreeDataSortKey *keys,
+                               gint                n_keys,
+                               GType               type,
+                               GtkSortType         order)
+{
+  SortKeyOrder sort_order;
+
+  sort_order.kind = get_sort_key_kind (type);
+  sort_order.descending = order == GTK_SORT_DESCENDING;
+
+  g_qsort_with_data (keys, n_keys, sizeof (GtkTreeDataSortKey),
+                     compare_sort_keys, &sort_order);
+}
+
+void
+_gtk_tree_data_sort_keys_free (GtkTreeDataSortKey *keys,
+                               gint                n_keys,
+                               GType               type)
+{
+  gint i;
+
+  if (get_sort_key_kind (type) == SORT_KEY_STRING)
+    {
+      for (i = 0; i < n_keys; i++)
+        g_free (keys[i].value.v_string);
+    }
+
+  g_free (keys);
+}
+
+
 GList *
 _gtk_tree_data_list_header_new (gint   n_columns,
 				GType *types)
@@ -21,25 +21,14 @@
 #include <gtk/gtktreemodel.h>
 #include <gtk/gtktreesortable.h>
 
-typedef struct _GtkTreeDataList GtkTreeDataList;
-struct _GtkTreeDataList
-{
-  GtkTreeDataList *next;
-
-  union {
-    gint	   v_int;
-    gint8          v_char;
-    guint8         v_uchar;
-    guint	   v_uint;
-    glong	   v_long;
-    gulong	   v_ulong;
-    gint64	   v_int64;
-    guint64        v_uint64;
-    gfloat	   v_float;
-    gdouble        v_double;
-    gpointer	   v_pointer;
-  } data;
-};
+/* A row is a single block holding all of its columns, laid out as
+ * described by a GtkTreeDataLayout. Scalars are stored inline, strings
+ * are shared through the string pool of the layout. The stores keep
+ * NULL for rows that were never set, which have the default value in
+ * every column.
+ */
+typedef struct _GtkTreeDataLayout GtkTreeDataLayout;
+typedef struct _GtkTreeDataRow    GtkTreeDataRow;
 
 typedef struct _GtkTreeDataSortHeader
 {
@@ -49,18 +38,50 @@ typedef struct _GtkTreeDataSortHeader
   GDestroyNotify destroy;
 } GtkTreeDataSortHeader;
 
-GtkTreeDataList *_gtk_tree_data_list_alloc          (void);
-void             _gtk_tree_data_list_free           (GtkTreeDataList *list,
-						     GType           *column_headers);
-gboolean         _gtk_tree_data_list_check_type     (GType            type);
-void             _gtk_tree_data_list_node_to_value  (GtkTreeDataList *list,
-						     GType            type,
-						     GValue          *value);
-void             _gtk_tree_data_list_value_to_node  (GtkTreeDataList *list,
-						     GValue          *value);
+gboolean           _gtk_tree_data_list_check_type (GType              type);
+
+GtkTreeDataLayout *_gtk_tree_data_layout_new      (gint               n_columns,
+                                                   GType             *types);
+void               _gtk_tree_data_layout_free     (GtkTreeDataLayout *layout);
+gsize              _gtk_tree_data_layout_get_row_size (GtkTreeDataLayout *layout);
+
+GtkTreeDataRow    *_gtk_tree_data_row_new         (GtkTreeDataLayout *layout);
+void               _gtk_tree_data_row_free        (GtkTreeDataRow    *row,
+                                                   GtkTreeDataLayout *layout);
+GtkTreeDataRow    *_gtk_tree_data_row_copy        (GtkTreeDataRow    *row,
+                                                   GtkTreeDataLayout *layout);
+void               _gtk_tree_data_row_get_value   (GtkTreeDataRow    *row,
+                                                   GtkTreeDataLayout *layout,
+                                                   gint               column,
+                                                   GValue            *value);
+void               _gtk_tree_data_row_set_value   (GtkTreeDataRow    *row,
+                                                   GtkTreeDataLayout *layout,
+                                                   gint               column,
+                                                   GValue            *value);
+
+/* Sort keys, see _gtk_tree_data_list_compare_func() */
+typedef struct _GtkTreeDataSortKey
+{
+  union {
+    gint64 v_int;
+    guint64 v_uint;
+    gdouble v_double;
+    gchar *v_string;
+  } value;
+  gint index;     /* position before sorting */
+  gpointer data;  /* the row, for the caller */
+} GtkTreeDataSortKey;
 
-GtkTreeDataList *_gtk_tree_data_list_node_copy      (GtkTreeDataList *list,
-                                                     GType            type);
+gboolean           _gtk_tree_data_sort_keys_supported (GType               type);
+void               _gtk_tree_data_sort_key_init   (GtkTreeDataSortKey *key,
+                                                   const GValue       *value);
+void               _gtk_tree_data_sort_keys_sort  (GtkTreeDataSortKey *keys,
+                                                   gint                n_keys,
+                                                   GType               type,
+                                                   GtkSortType         order);
+void               _gtk_tree_data_sort_keys_free  (GtkTreeDataSortKey *keys,
+                                                   gint                n_keys,
+                                                   GType               type);
 
 /* Header code */
 gint                   _gtk_tree_data_list_compare_func (GtkTreeModel *model,
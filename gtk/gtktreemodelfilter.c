@@ -288,6 +288,11 @@ struct _GtkTreeModelFilterPrivate
   guint in_row_deleted       : 1;
   guint virtual_root_deleted : 1;
 
+  /* gtk_tree_model_filter_refilter_async() */
+  GTask *refilter_task;
+  GtkTreeRowReference *refilter_position;
+  guint refilter_idle_id;
+
   /* signal ids */
   gulong changed_id;
   gulong inserted_id;
@@ -321,6 +326,12 @@ enum
  */
 #undef MODEL_FILTER_DEBUG
 
+/* Refilter in chunks of this many milliseconds, at the same priority
+ * as the tree view validates rows, so that the two take turns.
+ */
+#define GTK_TREE_MODEL_FILTER_TIME_MS_PER_IDLE 10
+#define GTK_TREE_MODEL_FILTER_PRIORITY_REFILTER (GDK_PRIORITY_REDRAW + 5)
+
 #define FILTER_ELT(filter_elt) ((FilterElt *)filter_elt)
 #define FILTER_LEVEL(filter_level) ((FilterLevel *)filter_level)
 #define GET_ELT(siter) ((FilterElt*) (siter ? g_sequence_get (siter) : NULL))
@@ -1980,13 +1991,16 @@ gtk_tree_model_filter_emit_row_inserted_for_path (GtkTreeModelFilter *filter,
   gtk_tree_path_free (path);
 }
 
+/* Re-evaluates the visibility of a child row. Rows that stay visible
+ * only get ::row-changed if emit_row_changed is set.
+ */
 static void
-gtk_tree_model_filter_row_changed (GtkTreeModel *c_model,
-                                   GtkTreePath  *c_path,
-                                   GtkTreeIter  *c_iter,
-                                   gpointer      data)
+gtk_tree_model_filter_update_row (GtkTreeModelFilter *filter,
+                                  GtkTreeModel       *c_model,
+                                  GtkTreePath        *c_path,
+                                  GtkTreeIter        *c_iter,
+                                  gboolean            emit_row_changed)
 {
-  GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
   GtkTreeIter iter;
   GtkTreeIter children;
   GtkTreeIter real_c_iter;
@@ -2072,7 +2086,7 @@ gtk_tree_model_filter_row_changed (GtkTreeModel *c_model,
           gtk_tree_path_free (path);
           path = gtk_tree_model_get_path (GTK_TREE_MODEL (filter), &iter);
 
-          if (level->ext_ref_count > 0)
+          if (level->ext_ref_count > 0 && emit_row_changed)
             gtk_tree_model_row_changed (GTK_TREE_MODEL (filter), path, &iter);
 
           /* and update the children */
@@ -2108,6 +2122,16 @@ done:
     gtk_tree_path_free (c_path);
 }
 
+static void
+gtk_tree_model_filter_row_changed (GtkTreeModel *c_model,
+                                   GtkTreePath  *c_path,
+                                   GtkTreeIter  *c_iter,
+                                   gpointer      data)
+{
+  gtk_tree_model_filter_update_row (GTK_TREE_MODEL_FILTER (data),
+                                    c_model, c_path, c_iter, TRUE);
+}
+
 static void
 gtk_tree_model_filter_row_inserted (GtkTreeModel *c_model,
                                     GtkTreePath  *c_path,
@@ -2727,6 +2751,19 @@ gtk_tree_model_filter_rows_reordered (GtkTreeModel *c_model,
 
   g_return_if_fail (new_order != NULL);
 
+  /* rows that moved in front of a refilter in progress would be
+   * skipped by it, so start it over
+   */
+  if (filter->priv->refilter_position)
+    {
+      path = gtk_tree_row_reference_get_path (filter->priv->refilter_position);
+      if (path != NULL &&
+          (c_path == NULL || gtk_tree_path_is_ancestor (c_path, path)))
+        g_clear_pointer (&filter->priv->refilter_position,
+                         gtk_tree_row_reference_free);
+      gtk_tree_path_free (path);
+    }
+
   if (c_path == NULL || gtk_tree_path_get_depth (c_path) == 0)
     {
       length = gtk_tree_model_iter_n_children (c_model, NULL);
@@ -4249,6 +4286,153 @@ gtk_tree_model_filter_refilter_helper (GtkTreeModel *model,
   return FALSE;
 }
 
+static void
+gtk_tree_model_filter_refilter_done (GtkTreeModelFilter *filter,
+                                     gboolean            restarted)
+{
+  GTask *task = filter->priv->refilter_task;
+
+  filter->priv->refilter_task = NULL;
+  if (filter->priv->refilter_idle_id != 0)
+    {
+      g_source_remove (filter->priv->refilter_idle_id);
+      filter->priv->refilter_idle_id = 0;
+    }
+  g_clear_pointer (&filter->priv->refilter_position,
+                   gtk_tree_row_reference_free);
+
+  if (restarted)
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_CANCELLED,
+                             "Refiltering was restarted");
+  else if (!g_task_return_error_if_cancelled (task))
+    g_task_return_boolean (task, TRUE);
+
+  g_object_unref (task);
+}
+
+/* Moves to the next row of the child model in depth-first order, without
+ * leaving the part of the model below the virtual root.
+ */
+static gboolean
+gtk_tree_model_filter_refilter_next (GtkTreeModel *c_model,
+                                     GtkTreeIter  *c_iter,
+                                     GtkTreePath  *c_path,
+                                     gint          min_depth)
+{
+  GtkTreeIter tmp;
+
+  if (gtk_tree_model_iter_children (c_model, &tmp, c_iter))
+    {
+      *c_iter = tmp;
+      gtk_tree_path_down (c_path);
+      return TRUE;
+    }
+
+  while (TRUE)
+    {
+      tmp = *c_iter;
+      if (gtk_tree_model_iter_next (c_model, &tmp))
+        {
+          *c_iter = tmp;
+          gtk_tree_path_next (c_path);
+          return TRUE;
+        }
+
+      if (gtk_tree_path_get_depth (c_path) <= min_depth ||
+          !gtk_tree_model_iter_parent (c_model, &tmp, c_iter))
+        return FALSE;
+
+      *c_iter = tmp;
+      gtk_tree_path_up (c_path);
+    }
+}
+
+static gboolean
+gtk_tree_model_filter_refilter_idle (gpointer data)
+{
+  GtkTreeModelFilter *filter = data;
+  GtkTreeModel *c_model = filter->priv->child_model;
+  GTask *task = filter->priv->refilter_task;
+  GtkTreePath *c_path;
+  GtkTreeIter c_iter;
+  gint64 end_time;
+  gint min_depth;
+  gboolean more;
+
+  if (g_cancellable_is_cancelled (g_task_get_cancellable (task)))
+    {
+      filter->priv->refilter_idle_id = 0;
+      gtk_tree_model_filter_refilter_done (filter, FALSE);
+      return G_SOURCE_REMOVE;
+    }
+
+  if (filter->priv->virtual_root)
+    min_depth = gtk_tree_path_get_depth (filter->priv->virtual_root) + 1;
+  else
+    min_depth = 1;
+
+  c_path = NULL;
+  if (filter->priv->refilter_position)
+    c_path = gtk_tree_row_reference_get_path (filter->priv->refilter_position);
+  if (c_path == NULL)
+    {
+      /* just started, or the row we were at went away */
+      if (filter->priv->virtual_root)
+        {
+          c_path = gtk_tree_path_copy (filter->priv->virtual_root);
+          gtk_tree_path_down (c_path);
+        }
+      else
+        c_path = gtk_tree_path_new_first ();
+    }
+
+  /* The signals emitted below may end up restarting or finishing this
+   * pass, and dropping the last reference to the filter with it.
+   */
+  g_object_ref (task);
+
+  end_time = g_get_monotonic_time () + GTK_TREE_MODEL_FILTER_TIME_MS_PER_IDLE * 1000;
+  more = gtk_tree_model_get_iter (c_model, &c_iter, c_path);
+
+  /* Changes are announced row by row as they are found. Holding them
+   * back until the end of the slice would leave rows in the filter
+   * that ::row-inserted handlers have not been told about, and
+   * GtkTreeModel has no signal for a range of rows.
+   */
+  while (more && filter->priv->refilter_task == task)
+    {
+      gtk_tree_model_filter_update_row (filter, c_model, c_path, &c_iter, FALSE);
+
+      more = gtk_tree_model_filter_refilter_next (c_model, &c_iter, c_path, min_depth);
+      if (g_get_monotonic_time () >= end_time)
+        break;
+    }
+
+  if (filter->priv->refilter_task != task)
+    {
+      gtk_tree_path_free (c_path);
+      g_object_unref (task);
+      return G_SOURCE_REMOVE;
+    }
+
+  if (more)
+    {
+      g_clear_pointer (&filter->priv->refilter_position,
+                       gtk_tree_row_reference_free);
+      filter->priv->refilter_position = gtk_tree_row_reference_new (c_model, c_path);
+    }
+  else
+    {
+      filter->priv->refilter_idle_id = 0;
+      gtk_tree_model_filter_refilter_done (filter, FALSE);
+    }
+
+  gtk_tree_path_free (c_path);
+  g_object_unref (task);
+
+  return more ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
 /**
  * gtk_tree_model_filter_refilter:
  * @filter: A #GtkTreeModelFilter.
@@ -4263,12 +4447,99 @@ gtk_tree_model_filter_refilter (GtkTreeModelFilter *filter)
 {
   g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
 
+  while (filter->priv->refilter_task)
+    gtk_tree_model_filter_refilter_done (filter, TRUE);
+
   /* S L O W */
   gtk_tree_model_foreach (filter->priv->child_model,
                           gtk_tree_model_filter_refilter_helper,
                           filter);
 }
 
+/**
+ * gtk_tree_model_filter_refilter_async:
+ * @filter: A #GtkTreeModelFilter.
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore
+ * @callback: (scope async): a #GAsyncReadyCallback to call when all
+ *     rows have been re-evaluated
+ * @user_data: (closure): the data to pass to the callback function
+ *
+ * Re-evaluates whether the rows of the child model are visible, like
+ * gtk_tree_model_filter_refilter(), but a few rows at a time from the
+ * main loop, so that the application stays responsive while a large
+ * model is being filtered.
+ *
+ * Unlike gtk_tree_model_filter_refilter(), this only emits signals for
+ * rows whose visibility changes; rows that stay visible do not get
+ * ::row-changed. Each row that appears or disappears still gets its
+ * own ::row-inserted or ::row-deleted, as soon as it is re-evaluated.
+ *
+ * Starting another refilter, with this function or with
+ * gtk_tree_model_filter_refilter(), cancels the one in progress and its
+ * callback gets a %G_IO_ERROR_CANCELLED error. So when the criteria of
+ * the visible function change, for example as the user types into a
+ * search entry, simply call this function again.
+ *
+ * Since: 3.20
+ */
+void
+gtk_tree_model_filter_refilter_async (GtkTreeModelFilter  *filter,
+                                      GCancellable        *cancellable,
+                                      GAsyncReadyCallback  callback,
+                                      gpointer             user_data)
+{
+  GTask *task;
+
+  g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  /* the callback of the old pass may start yet another one */
+  while (filter->priv->refilter_task)
+    gtk_tree_model_filter_refilter_done (filter, TRUE);
+
+  task = g_task_new (filter, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gtk_tree_model_filter_refilter_async);
+
+  if (filter->priv->child_model == NULL)
+    {
+      g_task_return_boolean (task, TRUE);
+      g_object_unref (task);
+      return;
+    }
+
+  filter->priv->refilter_task = task;
+  filter->priv->refilter_idle_id =
+    gdk_threads_add_idle_full (GTK_TREE_MODEL_FILTER_PRIORITY_REFILTER,
+                               gtk_tree_model_filter_refilter_idle,
+                               filter, NULL);
+  g_source_set_name_by_id (filter->priv->refilter_idle_id,
+                           "[gtk+] gtk_tree_model_filter_refilter");
+}
+
+/**
+ * gtk_tree_model_filter_refilter_finish:
+ * @filter: A #GtkTreeModelFilter.
+ * @result: a #GAsyncResult
+ * @error: (allow-none): return location for a #GError, or %NULL
+ *
+ * Finishes a refilter started with gtk_tree_model_filter_refilter_async().
+ *
+ * Returns: %TRUE if all rows were re-evaluated, %FALSE if the refilter
+ *     was cancelled or replaced by a newer one
+ *
+ * Since: 3.20
+ */
+gboolean
+gtk_tree_model_filter_refilter_finish (GtkTreeModelFilter  *filter,
+                                       GAsyncResult        *result,
+                                       GError             **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, filter), FALSE);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) == gtk_tree_model_filter_refilter_async, FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 /**
  * gtk_tree_model_filter_clear_cache:
  * @filter: A #GtkTreeModelFilter.
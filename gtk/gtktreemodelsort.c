@@ -1892,6 +1892,68 @@ gtk_tree_model_sort_offset_compare_func (gconstpointer a,
   return retval;
 }
 
+/* Sorts the level by the keys of the sort column, if the model sorts
+ * by a plain column of the child model. Returns FALSE if it does not.
+ */
+static gboolean
+gtk_tree_model_sort_sort_level_by_keys (GtkTreeModelSort *tree_model_sort,
+                                        SortLevel        *level,
+                                        SortData         *data)
+{
+  GtkTreeModelSortPrivate *priv = tree_model_sort->priv;
+  GtkTreeDataSortKey *keys;
+  GSequenceIter *siter, *end_siter;
+  GtkTreeIter child_iter;
+  gint column, n_elts, i;
+  GType type;
+
+  if (data->sort_func != _gtk_tree_data_list_compare_func)
+    return FALSE;
+
+  column = GPOINTER_TO_INT (data->sort_data);
+  if (column < 0 || column >= gtk_tree_model_get_n_columns (priv->child_model))
+    return FALSE;
+
+  type = gtk_tree_model_get_column_type (priv->child_model, column);
+  if (!_gtk_tree_data_sort_keys_supported (type))
+    return FALSE;
+
+  n_elts = g_sequence_get_length (level->seq);
+  keys = g_new (GtkTreeDataSortKey, n_elts);
+
+  end_siter = g_sequence_get_end_iter (level->seq);
+  for (siter = g_sequence_get_begin_iter (level->seq), i = 0;
+       siter != end_siter;
+       siter = g_sequence_iter_next (siter), i++)
+    {
+      SortElt *elt = g_sequence_get (siter);
+      GValue value = G_VALUE_INIT;
+
+      if (GTK_TREE_MODEL_SORT_CACHE_CHILD_ITERS (tree_model_sort))
+        child_iter = elt->iter;
+      else
+        {
+          data->parent_path_indices[data->parent_path_depth - 1] = elt->offset;
+          gtk_tree_model_get_iter (priv->child_model, &child_iter, data->parent_path);
+        }
+
+      gtk_tree_model_get_value (priv->child_model, &child_iter, column, &value);
+      _gtk_tree_data_sort_key_init (&keys[i], &value);
+      keys[i].index = elt->old_index;
+      keys[i].data = siter;
+      g_value_unset (&value);
+    }
+
+  _gtk_tree_data_sort_keys_sort (keys, n_elts, type, priv->order);
+
+  for (i = 0; i < n_elts; i++)
+    g_sequence_move (keys[i].data, end_siter);
+
+  _gtk_tree_data_sort_keys_free (keys, n_elts, type);
+
+  return TRUE;
+}
+
 static void
 gtk_tree_model_sort_sort_level (GtkTreeModelSort *tree_model_sort,
 				SortLevel        *level,
@@ -1940,7 +2002,7 @@ gtk_tree_model_sort_sort_level (GtkTreeModelSort *tree_model_sort,
   if (data.sort_func == NO_SORT_FUNC)
     g_sequence_sort (level->seq, gtk_tree_model_sort_offset_compare_func,
                      &data);
-  else
+  else if (!gtk_tree_model_sort_sort_level_by_keys (tree_model_sort, level, &data))
     g_sequence_sort (level->seq, gtk_tree_model_sort_compare_func, &data);
 
   free_sort_data (&data);
@@ -71,6 +71,7 @@ struct _GtkTreeStorePrivate
   gint sort_column_id;
   GList *sort_list;
   GType *column_headers;
+  GtkTreeDataLayout *layout;
   GtkTreeIterCompareFunc default_sort_func;
   gpointer default_sort_data;
   GDestroyNotify default_sort_destroy;
@@ -462,11 +463,29 @@ gtk_tree_store_set_column_type (GtkTreeStore *tree_store,
   priv->column_headers[column] = type;
 }
 
+/* The layout is created when the first row gets data, at which point
+ * the column types can no longer change.
+ */
+static GtkTreeDataLayout *
+gtk_tree_store_get_layout (GtkTreeStore *tree_store)
+{
+  GtkTreeStorePrivate *priv = tree_store->priv;
+
+  if (priv->layout == NULL)
+    {
+      priv->layout = _gtk_tree_data_layout_new (priv->n_columns,
+                                                priv->column_headers);
+      priv->columns_dirty = TRUE;
+    }
+
+  return priv->layout;
+}
+
 static gboolean
 node_free (GNode *node, gpointer data)
 {
   if (node->data)
-    _gtk_tree_data_list_free (node->data, (GType*)data);
+    _gtk_tree_data_row_free (node->data, data);
   node->data = NULL;
 
   return FALSE;
@@ -479,8 +498,9 @@ gtk_tree_store_finalize (GObject *object)
   GtkTreeStorePrivate *priv = tree_store->priv;
 
   g_node_traverse (priv->root, G_POST_ORDER, G_TRAVERSE_ALL, -1,
-		   node_free, priv->column_headers);
+		   node_free, priv->layout);
   g_node_destroy (priv->root);
+  _gtk_tree_data_layout_free (priv->layout);
   _gtk_tree_data_list_header_free (priv->sort_list);
   g_free (priv->column_headers);
 
@@ -648,22 +668,16 @@ gtk_tree_store_get_value (GtkTreeModel *tree_model,
 {
   GtkTreeStore *tree_store = (GtkTreeStore *) tree_model;
   GtkTreeStorePrivate *priv = tree_store->priv;
-  GtkTreeDataList *list;
-  gint tmp_column = column;
+  GtkTreeDataRow *row;
 
   g_return_if_fail (column < priv->n_columns);
   g_return_if_fail (VALID_ITER (iter, tree_store));
 
-  list = G_NODE (iter->user_data)->data;
+  row = G_NODE (iter->user_data)->data;
 
-  while (tmp_column-- > 0 && list)
-    list = list->next;
-
-  if (list)
+  if (row)
     {
-      _gtk_tree_data_list_node_to_value (list,
-					 priv->column_headers[column],
-					 value);
+      _gtk_tree_data_row_get_value (row, priv->layout, column, value);
     }
   else
     {
@@ -843,8 +857,7 @@ gtk_tree_store_real_set_value (GtkTreeStore *tree_store,
 			       gboolean      sort)
 {
   GtkTreeStorePrivate *priv = tree_store->priv;
-  GtkTreeDataList *list;
-  GtkTreeDataList *prev;
+  GtkTreeDataRow *row;
   gint old_column = column;
   GValue real_value = G_VALUE_INIT;
   gboolean converted = FALSE;
@@ -874,53 +887,18 @@ gtk_tree_store_real_set_value (GtkTreeStore *tree_store,
       converted = TRUE;
     }
 
-  prev = list = G_NODE (iter->user_data)->data;
-
-  while (list != NULL)
-    {
-      if (column == 0)
-	{
-	  if (converted)
-	    _gtk_tree_data_list_value_to_node (list, &real_value);
-	  else
-	    _gtk_tree_data_list_value_to_node (list, value);
-	  retval = TRUE;
-	  if (converted)
-	    g_value_unset (&real_value);
-          if (sort && GTK_TREE_STORE_IS_SORTED (tree_store))
-            gtk_tree_store_sort_iter_changed (tree_store, iter, old_column, TRUE);
-	  return retval;
-	}
-
-      column--;
-      prev = list;
-      list = list->next;
-    }
-
-  if (G_NODE (iter->user_data)->data == NULL)
-    {
-      G_NODE (iter->user_data)->data = list = _gtk_tree_data_list_alloc ();
-      list->next = NULL;
-    }
-  else
-    {
-      list = prev->next = _gtk_tree_data_list_alloc ();
-      list->next = NULL;
-    }
-
-  while (column != 0)
+  row = G_NODE (iter->user_data)->data;
+  if (row == NULL)
     {
-      list->next = _gtk_tree_data_list_alloc ();
-      list = list->next;
-      list->next = NULL;
-      column --;
+      row = _gtk_tree_data_row_new (gtk_tree_store_get_layout (tree_store));
+      G_NODE (iter->user_data)->data = row;
     }
 
   if (converted)
-    _gtk_tree_data_list_value_to_node (list, &real_value);
+    _gtk_tree_data_row_set_value (row, priv->layout, column, &real_value);
   else
-    _gtk_tree_data_list_value_to_node (list, value);
-  
+    _gtk_tree_data_row_set_value (row, priv->layout, column, value);
+
   retval = TRUE;
   if (converted)
     g_value_unset (&real_value);
@@ -1222,7 +1200,7 @@ gtk_tree_store_remove (GtkTreeStore *tree_store,
 
   if (G_NODE (iter->user_data)->data)
     g_node_traverse (G_NODE (iter->user_data), G_POST_ORDER, G_TRAVERSE_ALL,
-		     -1, node_free, priv->column_headers);
+		     -1, node_free, priv->layout);
 
   path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), iter);
   g_node_destroy (G_NODE (iter->user_data));
@@ -1994,31 +1972,11 @@ copy_node_data (GtkTreeStore *tree_store,
                 GtkTreeIter  *src_iter,
                 GtkTreeIter  *dest_iter)
 {
-  GtkTreeDataList *dl = G_NODE (src_iter->user_data)->data;
-  GtkTreeDataList *copy_head = NULL;
-  GtkTreeDataList *copy_prev = NULL;
-  GtkTreeDataList *copy_iter = NULL;
+  GtkTreeDataRow *row = G_NODE (src_iter->user_data)->data;
   GtkTreePath *path;
-  gint col;
 
-  col = 0;
-  while (dl)
-    {
-      copy_iter = _gtk_tree_data_list_node_copy (dl, tree_store->priv->column_headers[col]);
-
-      if (copy_head == NULL)
-        copy_head = copy_iter;
-
-      if (copy_prev)
-        copy_prev->next = copy_iter;
-
-      copy_prev = copy_iter;
-
-      dl = dl->next;
-      ++col;
-    }
-
-  G_NODE (dest_iter->user_data)->data = copy_head;
+  G_NODE (dest_iter->user_data)->data =
+    _gtk_tree_data_row_copy (row, tree_store->priv->layout);
 
   path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), dest_iter);
   gtk_tree_model_row_changed (GTK_TREE_MODEL (tree_store), path, dest_iter);
@@ -2903,6 +2861,76 @@ gtk_tree_store_compare_func (gconstpointer a,
   return retval;
 }
 
+/* Returns the column to sort by with sort keys, if the store sorts by
+ * a plain column, or -1.
+ */
+static gint
+gtk_tree_store_get_sort_key_column (GtkTreeStore *tree_store)
+{
+  GtkTreeStorePrivate *priv = tree_store->priv;
+  GtkTreeDataSortHeader *header;
+  gint column;
+
+  if (priv->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+    return -1;
+
+  header = _gtk_tree_data_list_get_header (priv->sort_list,
+                                           priv->sort_column_id);
+  if (header == NULL || header->func != _gtk_tree_data_list_compare_func)
+    return -1;
+
+  column = GPOINTER_TO_INT (header->data);
+  if (column < 0 || column >= priv->n_columns ||
+      !_gtk_tree_data_sort_keys_supported (priv->column_headers[column]))
+    return -1;
+
+  return column;
+}
+
+static void
+gtk_tree_store_sort_by_keys (GtkTreeStore *tree_store,
+                             GNode        *node,
+                             gint          column,
+                             gint          list_length,
+                             GArray       *sort_array)
+{
+  GtkTreeStorePrivate *priv = tree_store->priv;
+  GtkTreeDataSortKey *keys;
+  GType type = priv->column_headers[column];
+  gint i;
+
+  keys = g_new (GtkTreeDataSortKey, list_length);
+
+  for (i = 0; node; node = node->next, i++)
+    {
+      GValue value = G_VALUE_INIT;
+
+      if (node->data == NULL)
+        g_value_init (&value, type);
+      else
+        _gtk_tree_data_row_get_value (node->data, priv->layout, column, &value);
+
+      _gtk_tree_data_sort_key_init (&keys[i], &value);
+      keys[i].index = i;
+      keys[i].data = node;
+
+      g_value_unset (&value);
+    }
+
+  _gtk_tree_data_sort_keys_sort (keys, list_length, type, priv->order);
+
+  for (i = 0; i < list_length; i++)
+    {
+      SortTuple tuple;
+
+      tuple.offset = keys[i].index;
+      tuple.node = keys[i].data;
+      g_array_append_val (sort_array, tuple);
+    }
+
+  _gtk_tree_data_sort_keys_free (keys, list_length, type);
+}
+
 static void
 gtk_tree_store_sort_helper (GtkTreeStore *tree_store,
 			    GNode        *parent,
@@ -2916,6 +2944,7 @@ gtk_tree_store_sort_helper (GtkTreeStore *tree_store,
   gint i;
   gint *new_order;
   GtkTreePath *path;
+  gint column;
 
   node = parent->children;
   if (node == NULL || node->next == NULL)
@@ -2932,19 +2961,25 @@ gtk_tree_store_sort_helper (GtkTreeStore *tree_store,
 
   sort_array = g_array_sized_new (FALSE, FALSE, sizeof (SortTuple), list_length);
 
-  i = 0;
-  for (tmp_node = node; tmp_node; tmp_node = tmp_node->next)
+  column = gtk_tree_store_get_sort_key_column (tree_store);
+  if (column != -1)
+    gtk_tree_store_sort_by_keys (tree_store, node, column, list_length, sort_array);
+  else
     {
-      SortTuple tuple;
+      i = 0;
+      for (tmp_node = node; tmp_node; tmp_node = tmp_node->next)
+        {
+          SortTuple tuple;
 
-      tuple.offset = i;
-      tuple.node = tmp_node;
-      g_array_append_val (sort_array, tuple);
-      i++;
-    }
+          tuple.offset = i;
+          tuple.node = tmp_node;
+          g_array_append_val (sort_array, tuple);
+          i++;
+        }
 
-  /* Sort the array */
-  g_array_sort_with_data (sort_array, gtk_tree_store_compare_func, tree_store);
+      /* Sort the array */
+      g_array_sort_with_data (sort_array, gtk_tree_store_compare_func, tree_store);
+    }
 
   for (i = 0; i < list_length - 1; i++)
     {
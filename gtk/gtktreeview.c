@@ -40,6 +40,7 @@
 #include "gtkframe.h"
 #include "gtkmain.h"
 #include "gtktreemodelsort.h"
+#include "gtkliststoreprivate.h"
 #include "gtktooltip.h"
 #include "gtkscrollable.h"
 #include "gtkcelllayout.h"
@@ -440,12 +441,29 @@ struct _GtkTreeViewPrivate
   /* Tooltip support */
   gint tooltip_column;
 
+  /* Height given to rows before they are validated, sampled from
+   * the first rows that were
+   */
+  gint row_height_estimate;
+
+  /* Style properties used by validate_row(), looked up once rather
+   * than for every row. Reset when the style changes.
+   */
+  gint row_horizontal_separator;
+  gint row_vertical_separator;
+  gint row_grid_line_width;
+  gint row_separator_height;
+  gint row_expander_size;
+
   /* Here comes the bitfield */
   guint scroll_to_use_align : 1;
 
   guint fixed_height_mode : 1;
   guint fixed_height_check : 1;
 
+  guint row_wide_separators : 1;
+  guint row_style_valid : 1;
+
   guint activate_on_single_click : 1;
   guint reorderable : 1;
   guint header_has_focus : 1;
@@ -665,6 +683,10 @@ static void gtk_tree_view_row_inserted                    (GtkTreeModel    *mode
 							   GtkTreePath     *path,
 							   GtkTreeIter     *iter,
 							   gpointer         data);
+static void gtk_tree_view_rows_inserted                   (GtkListStore    *list_store,
+							   const gint      *indices,
+							   gint             n_rows,
+							   gpointer         data);
 static void gtk_tree_view_row_has_child_toggled           (GtkTreeModel    *model,
 							   GtkTreePath     *path,
 							   GtkTreeIter     *iter,
@@ -6242,21 +6264,39 @@ validate_row (GtkTreeView *tree_view,
 
   is_separator = row_is_separator (tree_view, iter, NULL);
 
-  gtk_widget_style_get (GTK_WIDGET (tree_view),
-			"horizontal-separator", &horizontal_separator,
-			"vertical-separator", &vertical_separator,
-			"grid-line-width", &grid_line_width,
-                        "wide-separators",  &wide_separators,
-                        "separator-height", &separator_height,
-			NULL);
-  
+  /* Looking these up dominates the cost of validating simple rows */
+  if (!tree_view->priv->row_style_valid)
+    {
+      gtk_widget_style_get (GTK_WIDGET (tree_view),
+                            "horizontal-separator", &horizontal_separator,
+                            "vertical-separator", &vertical_separator,
+                            "grid-line-width", &grid_line_width,
+                            "wide-separators",  &wide_separators,
+                            "separator-height", &separator_height,
+                            NULL);
+
+      tree_view->priv->row_horizontal_separator = horizontal_separator;
+      tree_view->priv->row_vertical_separator = vertical_separator;
+      tree_view->priv->row_grid_line_width = grid_line_width;
+      tree_view->priv->row_wide_separators = wide_separators;
+      tree_view->priv->row_separator_height = separator_height;
+      tree_view->priv->row_expander_size = gtk_tree_view_get_expander_size (tree_view);
+      tree_view->priv->row_style_valid = TRUE;
+    }
+
+  horizontal_separator = tree_view->priv->row_horizontal_separator;
+  vertical_separator = tree_view->priv->row_vertical_separator;
+  grid_line_width = tree_view->priv->row_grid_line_width;
+  wide_separators = tree_view->priv->row_wide_separators;
+  separator_height = tree_view->priv->row_separator_height;
+  expander_size = tree_view->priv->row_expander_size;
+
   draw_vgrid_lines =
     tree_view->priv->grid_lines == GTK_TREE_VIEW_GRID_LINES_VERTICAL
     || tree_view->priv->grid_lines == GTK_TREE_VIEW_GRID_LINES_BOTH;
   draw_hgrid_lines =
     tree_view->priv->grid_lines == GTK_TREE_VIEW_GRID_LINES_HORIZONTAL
     || tree_view->priv->grid_lines == GTK_TREE_VIEW_GRID_LINES_BOTH;
-  expander_size = gtk_tree_view_get_expander_size (tree_view);
 
   for (last_column = g_list_last (tree_view->priv->columns);
        last_column &&
@@ -6779,6 +6819,7 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
   gint y = -1;
   gint prev_height = -1;
   gboolean fixed_height = TRUE;
+  gint64 total_height = 0;
 
   g_assert (tree_view);
 
@@ -6879,6 +6920,7 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
 	  gint height;
 
 	  height = gtk_tree_view_get_row_height (tree_view, node);
+	  total_height += height;
 	  if (prev_height < 0)
 	    prev_height = height;
 	  else if (prev_height != height)
@@ -6891,8 +6933,18 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
 
   if (!tree_view->priv->fixed_height_check)
    {
+     /* Give the rows we haven't got to yet the average height of the
+      * ones we have, so that the scrollbar is about right from the
+      * start instead of growing as validation goes on. They stay
+      * invalid and get measured later.
+      */
      if (fixed_height)
-       _gtk_rbtree_set_fixed_height (tree_view->priv->tree, prev_height, FALSE);
+       tree_view->priv->row_height_estimate = prev_height;
+     else
+       tree_view->priv->row_height_estimate = (total_height + i / 2) / i;
+
+     _gtk_rbtree_set_fixed_height (tree_view->priv->tree,
+                                   tree_view->priv->row_height_estimate, FALSE);
 
      tree_view->priv->fixed_height_check = 1;
    }
@@ -8711,6 +8763,8 @@ gtk_tree_view_style_updated (GtkWidget *widget)
 
   GTK_WIDGET_CLASS (gtk_tree_view_parent_class)->style_updated (widget);
 
+  tree_view->priv->row_style_valid = FALSE;
+
   if (gtk_widget_get_realized (widget))
     {
       gtk_tree_view_set_grid_lines (tree_view, tree_view->priv->grid_lines);
@@ -8729,6 +8783,7 @@ gtk_tree_view_style_updated (GtkWidget *widget)
 	}
 
       tree_view->priv->fixed_height = -1;
+      tree_view->priv->row_height_estimate = 0;
       _gtk_rbtree_mark_invalid (tree_view->priv->tree);
     }
 }
@@ -9018,6 +9073,13 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
 
   g_return_if_fail (path != NULL || iter != NULL);
 
+  /* The rows of a list store batch are added all at once by
+   * gtk_tree_view_rows_inserted()
+   */
+  if (GTK_IS_LIST_STORE (model) &&
+      _gtk_list_store_is_emitting_batch (GTK_LIST_STORE (model)))
+    return;
+
   if (tree_view->priv->fixed_height_mode
       && tree_view->priv->fixed_height >= 0)
     height = tree_view->priv->fixed_height;
@@ -9087,12 +9149,16 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
   if (indices[depth - 1] == 0)
     {
       tmpnode = _gtk_rbtree_find_count (tree, 1);
-      tmpnode = _gtk_rbtree_insert_before (tree, tmpnode, height, FALSE);
+      tmpnode = _gtk_rbtree_insert_before (tree, tmpnode,
+                                           height > 0 ? height : tree_view->priv->row_height_estimate,
+                                           FALSE);
     }
   else
     {
       tmpnode = _gtk_rbtree_find_count (tree, indices[depth - 1]);
-      tmpnode = _gtk_rbtree_insert_after (tree, tmpnode, height, FALSE);
+      tmpnode = _gtk_rbtree_insert_after (tree, tmpnode,
+                                          height > 0 ? height : tree_view->priv->row_height_estimate,
+                                          FALSE);
     }
 
   _gtk_tree_view_accessible_add (tree_view, tree, tmpnode);
@@ -9114,6 +9180,65 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
     gtk_tree_path_free (path);
 }
 
+/* Rows appended to a GtkListStore in a batch, for which we ignored
+ * ::row-inserted. All of them are inserted into the RBTree at once,
+ * relinking it in O(n).
+ */
+static void
+gtk_tree_view_rows_inserted (GtkListStore *list_store,
+                             const gint   *indices,
+                             gint          n_rows,
+                             gpointer      data)
+{
+  GtkTreeView *tree_view = data;
+  GtkRBTree *tree;
+  GtkTreePath *path;
+  gint height;
+  gint i;
+
+  if (tree_view->priv->fixed_height_mode
+      && tree_view->priv->fixed_height >= 0)
+    height = tree_view->priv->fixed_height;
+  else
+    height = 0;
+
+  if (tree_view->priv->tree == NULL)
+    tree_view->priv->tree = _gtk_rbtree_new ();
+
+  tree = tree_view->priv->tree;
+
+  /* Update all row-references, nothing moves when appending */
+  if (indices[0] < tree->root->count)
+    {
+      for (i = 0; i < n_rows; i++)
+        {
+          path = gtk_tree_path_new_from_indices (indices[i], -1);
+          gtk_tree_row_reference_inserted (G_OBJECT (tree_view), path);
+          gtk_tree_path_free (path);
+        }
+    }
+
+  /* GtkListStore doesn't implement ref_node(), so we don't
+   * ref the new rows like gtk_tree_view_row_inserted() does.
+   */
+  if (height > 0)
+    _gtk_rbtree_insert_many (tree, indices, n_rows, height, TRUE);
+  else
+    _gtk_rbtree_insert_many (tree, indices, n_rows, tree_view->priv->row_height_estimate, FALSE);
+
+  if (_gtk_widget_peek_accessible (GTK_WIDGET (tree_view)))
+    {
+      for (i = 0; i < n_rows; i++)
+        _gtk_tree_view_accessible_add (tree_view, tree,
+                                       _gtk_rbtree_find_count (tree, indices[i] + 1));
+    }
+
+  if (height > 0)
+    gtk_widget_queue_resize (GTK_WIDGET (tree_view));
+  else
+    install_presize_handler (tree_view);
+}
+
 static void
 gtk_tree_view_row_has_child_toggled (GtkTreeModel *model,
 				     GtkTreePath  *path,
@@ -9533,20 +9658,28 @@ gtk_tree_view_build_tree (GtkTreeView *tree_view,
 {
   GtkRBNode *temp = NULL;
   GtkTreePath *path = NULL;
+  GtkTreeIter parent;
+  gint n_rows;
+
+  if (depth > 1 && gtk_tree_model_iter_parent (tree_view->priv->model, &parent, iter))
+    n_rows = gtk_tree_model_iter_n_children (tree_view->priv->model, &parent);
+  else
+    n_rows = gtk_tree_model_iter_n_children (tree_view->priv->model, NULL);
+
+  /* Create all the nodes at once, which builds a balanced tree in
+   * O(n) instead of rebalancing after every row.
+   */
+  if (tree_view->priv->fixed_height > 0)
+    _gtk_rbtree_insert_many (tree, NULL, n_rows, tree_view->priv->fixed_height, TRUE);
+  else
+    _gtk_rbtree_insert_many (tree, NULL, n_rows, tree_view->priv->row_height_estimate, FALSE);
+  temp = _gtk_rbtree_first (tree);
 
   do
     {
-      gtk_tree_model_ref_node (tree_view->priv->model, iter);
-      temp = _gtk_rbtree_insert_after (tree, temp, 0, FALSE);
+      TREE_VIEW_INTERNAL_ASSERT_VOID (temp != NULL);
 
-      if (tree_view->priv->fixed_height > 0)
-        {
-          if (GTK_RBNODE_FLAG_SET (temp, GTK_RBNODE_INVALID))
-	    {
-              _gtk_rbtree_node_set_height (tree, temp, tree_view->priv->fixed_height);
-	      _gtk_rbtree_node_mark_valid (tree, temp);
-	    }
-        }
+      gtk_tree_model_ref_node (tree_view->priv->model, iter);
 
       if (tree_view->priv->is_list)
         continue;
@@ -9583,7 +9716,8 @@ gtk_tree_view_build_tree (GtkTreeView *tree_view,
 	    temp->flags ^= GTK_RBNODE_IS_PARENT;
 	}
     }
-  while (gtk_tree_model_iter_next (tree_view->priv->model, iter));
+  while ((temp = _gtk_rbtree_next (tree, temp)) != NULL &&
+         gtk_tree_model_iter_next (tree_view->priv->model, iter));
 
   if (path)
     gtk_tree_path_free (path);
@@ -11424,6 +11558,9 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
       g_signal_handlers_disconnect_by_func (tree_view->priv->model,
 					    gtk_tree_view_row_inserted,
 					    tree_view);
+      if (GTK_IS_LIST_STORE (tree_view->priv->model))
+        _gtk_list_store_remove_rows_inserted_handler (GTK_LIST_STORE (tree_view->priv->model),
+                                                      tree_view);
       g_signal_handlers_disconnect_by_func (tree_view->priv->model,
 					    gtk_tree_view_row_has_child_toggled,
 					    tree_view);
@@ -11457,6 +11594,7 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
       tree_view->priv->search_column = -1;
       tree_view->priv->fixed_height_check = 0;
       tree_view->priv->fixed_height = -1;
+      tree_view->priv->row_height_estimate = 0;
       tree_view->priv->dy = tree_view->priv->top_row_dy = 0;
     }
 
@@ -11484,6 +11622,10 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
 	}
 
       g_object_ref (tree_view->priv->model);
+      if (GTK_IS_LIST_STORE (tree_view->priv->model))
+        _gtk_list_store_add_rows_inserted_handler (GTK_LIST_STORE (tree_view->priv->model),
+                                                   gtk_tree_view_rows_inserted,
+                                                   tree_view);
       g_signal_connect (tree_view->priv->model,
 			"row-changed",
 			G_CALLBACK (gtk_tree_view_row_changed),
@@ -0,0 +1,388 @@
+/* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+
+/* Connects a number of headless viewers to a running broadwayd and
+ * reports how much each of them received. Run an application against
+ * the same display while this runs to put some load on the server.
+ *
+ * The first viewer is the one in control, and it acknowledges frames
+ * like the browser does. The others only watch.
+ */
+
+#include <string.h>
+#include <gio/gio.h>
+
+static int n_viewers = 4;
+static int duration = 10;
+static gboolean slow = FALSE;
+static char *address = NULL;
+
+static GOptionEntry options[] = {
+  { "viewers", 'n', 0, G_OPTION_ARG_INT, &n_viewers, "Number of viewers", "N" },
+  { "duration", 'd', 0, G_OPTION_ARG_INT, &duration, "Run for this many seconds", "SECONDS" },
+  { "slow", 's', 0, G_OPTION_ARG_NONE, &slow, "Make the last viewer read slowly", NULL },
+  { NULL }
+};
+
+typedef struct {
+  int index;
+  GSocketConnection *connection;
+  GInputStream *in;
+  GOutputStream *out;
+  GConverter *decompressor;
+  GString *inflated;
+  guint32 last_serial;
+
+  guint64 frames;
+  guint64 buffers;
+  guint64 bytes;
+  guint64 buffer_bytes;
+  guint64 inflated_bytes;
+  gboolean failed;
+} Viewer;
+
+static volatile gint stop;
+
+static gboolean
+read_exact (Viewer *viewer, void *buf, gsize len)
+{
+  gsize read;
+
+  return g_input_stream_read_all (viewer->in, buf, len, &read, NULL, NULL) &&
+    read == len;
+}
+
+static gboolean
+handshake (Viewer *viewer)
+{
+  GString *request, *reply;
+  char c;
+  gboolean res;
+
+  request = g_string_new ("");
+  g_string_append_printf (request,
+                          "GET /socket HTTP/1.1\r\n"
+                          "Host: %s\r\n"
+                          "Upgrade: websocket\r\n"
+                          "Connection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                          "Sec-WebSocket-Protocol: broadway\r\n"
+                          "Sec-WebSocket-Version: 13\r\n"
+                          "\r\n",
+                          address);
+  res = g_output_stream_write_all (viewer->out, request->str, request->len,
+                                   NULL, NULL, NULL);
+  g_string_free (request, TRUE);
+  if (!res)
+    return FALSE;
+
+  reply = g_string_new ("");
+  while (!g_str_has_suffix (reply->str, "\r\n\r\n"))
+    {
+      if (!read_exact (viewer, &c, 1))
+        {
+          g_string_free (reply, TRUE);
+          return FALSE;
+        }
+      g_string_append_c (reply, c);
+    }
+
+  res = g_str_has_prefix (reply->str, "HTTP/1.1 101");
+  g_string_free (reply, TRUE);
+
+  return res;
+}
+
+/* Acknowledge everything seen so far, like broadway.js does */
+static void
+send_ack (Viewer *viewer)
+{
+  guint8 frame[2 + 4 + 12];
+  guint32 payload[3];
+  gsize i;
+
+  payload[0] = GUINT32_TO_BE ('A');
+  payload[1] = GUINT32_TO_BE (viewer->last_serial);
+  payload[2] = 0;
+
+  frame[0] = 0x80 | 2;
+  frame[1] = 0x80 | sizeof (payload);
+  /* An all-zero mask leaves the payload as is */
+  memset (frame + 2, 0, 4);
+  for (i = 0; i < sizeof (payload); i++)
+    frame[6 + i] = ((guint8 *)payload)[i];
+
+  g_output_stream_write_all (viewer->out, frame, sizeof (frame), NULL, NULL, NULL);
+}
+
+static gboolean
+inflate_data (Viewer *viewer, const guint8 *data, gsize len)
+{
+  GConverterResult res;
+  gsize read, written, old_len;
+  GError *error = NULL;
+
+  while (len > 0)
+    {
+      old_len = viewer->inflated->len;
+      g_string_set_size (viewer->inflated, old_len + 4 * len + 4096);
+
+      res = g_converter_convert (viewer->decompressor,
+                                 data, len,
+                                 viewer->inflated->str + old_len,
+                                 viewer->inflated->len - old_len,
+                                 G_CONVERTER_NO_FLAGS,
+                                 &read, &written, &error);
+      g_string_set_size (viewer->inflated, old_len + written);
+
+      if (res == G_CONVERTER_ERROR)
+        {
+          g_printerr ("viewer %d: inflate failed: %s\n", viewer->index, error->message);
+          g_error_free (error);
+          return FALSE;
+        }
+
+      data += read;
+      len -= read;
+    }
+
+  viewer->inflated_bytes += viewer->inflated->len;
+  g_string_set_size (viewer->inflated, 0);
+
+  return TRUE;
+}
+
+#define GET32(p) ((guint32)(p)[0] | ((guint32)(p)[1] << 8) | ((guint32)(p)[2] << 16) | ((guint32)(p)[3] << 24))
+
+static gboolean
+handle_commands (Viewer *viewer, const guint8 *p, gsize len)
+{
+  const guint8 *end = p + len;
+  gboolean got_buffer = FALSE;
+  guint32 size;
+  guint8 flags;
+  char op;
+
+  while (p + 5 <= end)
+    {
+      op = p[0];
+      viewer->last_serial = GET32 (p + 1);
+      p += 5;
+
+      switch (op)
+        {
+        case 's':
+          p += 11;
+          break;
+        case 'S':
+        case 'H':
+        case 'r':
+        case 'R':
+        case 'd':
+        case 'k':
+          p += 2;
+          break;
+        case 'p':
+          p += 4;
+          break;
+        case 'm':
+          flags = p[2];
+          p += 3;
+          if (flags & 1)
+            p += 4;
+          if (flags & 2)
+            p += 4;
+          break;
+        case 'g':
+          p += 3;
+          break;
+        case 'u':
+        case 'D':
+          break;
+        case 'b':
+          p += 6;
+          if (p + 4 > end)
+            return FALSE;
+          size = GET32 (p);
+          p += 4;
+          if (p + size > end)
+            return FALSE;
+          if (!inflate_data (viewer, p, size))
+            return FALSE;
+          p += size;
+          viewer->buffers++;
+          viewer->buffer_bytes += size;
+          got_buffer = TRUE;
+          break;
+        default:
+          g_printerr ("viewer %d: unknown op %c\n", viewer->index, op);
+          return FALSE;
+        }
+    }
+
+  if (p != end)
+    return FALSE;
+
+  if (got_buffer && viewer->index == 0)
+    send_ack (viewer);
+
+  return TRUE;
+}
+
+static gboolean
+read_frame (Viewer *viewer)
+{
+  guint8 header[10];
+  guint8 *data;
+  guint64 len;
+  gboolean res;
+
+  if (!read_exact (viewer, header, 2))
+    return FALSE;
+
+  len = header[1] & 0x7f;
+  if (len == 126)
+    {
+      if (!read_exact (viewer, header + 2, 2))
+        return FALSE;
+      len = (header[2] << 8) | header[3];
+    }
+  else if (len == 127)
+    {
+      if (!read_exact (viewer, header + 2, 8))
+        return FALSE;
+      len = GUINT64_FROM_BE (*(guint64 *)(header + 2));
+    }
+
+  data = g_malloc (len);
+  if (!read_exact (viewer, data, len))
+    {
+      g_free (data);
+      return FALSE;
+    }
+
+  viewer->frames++;
+  viewer->bytes += len;
+
+  res = TRUE;
+  if ((header[0] & 0x0f) == 2)
+    res = handle_commands (viewer, data, len);
+
+  g_free (data);
+
+  return res;
+}
+
+static gpointer
+viewer_thread (gpointer data)
+{
+  Viewer *viewer = data;
+  GSocketClient *client;
+  GError *error = NULL;
+
+  client = g_socket_client_new ();
+  viewer->connection = g_socket_client_connect_to_host (client, address, 8080, NULL, &error);
+  g_object_unref (client);
+
+  if (viewer->connection == NULL)
+    {
+      g_printerr ("viewer %d: %s\n", viewer->index, error->message);
+      g_error_free (error);
+      viewer->failed = TRUE;
+      return NULL;
+    }
+
+  viewer->in = g_io_stream_get_input_stream (G_IO_STREAM (viewer->connection));
+  viewer->out = g_io_stream_get_output_stream (G_IO_STREAM (viewer->connection));
+  viewer->decompressor = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW));
+  viewer->inflated = g_string_new ("");
+
+  if (!handshake (viewer))
+    {
+      g_printerr ("viewer %d: handshake failed\n", viewer->index);
+      viewer->failed = TRUE;
+    }
+
+  while (!viewer->failed && !g_atomic_int_get (&stop))
+    {
+      if (!read_frame (viewer))
+        {
+          if (!g_atomic_int_get (&stop))
+            viewer->failed = TRUE;
+          break;
+        }
+
+      if (slow && viewer->index > 0 && viewer->index == n_viewers - 1)
+        g_usleep (50000);
+    }
+
+  return NULL;
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  Viewer *viewers;
+  GThread **threads;
+  int i;
+
+  context = g_option_context_new ("[HOST[:PORT]] - load a broadway server with viewers");
+  g_option_context_add_main_entries (context, options, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+  g_option_context_free (context);
+
+  address = g_strdup (argc > 1 ? argv[1] : "localhost:8080");
+
+  viewers = g_new0 (Viewer, n_viewers);
+  threads = g_new0 (GThread *, n_viewers);
+
+  for (i = 0; i < n_viewers; i++)
+    {
+      viewers[i].index = i;
+      threads[i] = g_thread_new ("viewer", viewer_thread, &viewers[i]);
+      /* Make sure the first one ends up in control */
+      if (i == 0)
+        g_usleep (G_USEC_PER_SEC / 10);
+    }
+
+  g_usleep (duration * G_USEC_PER_SEC);
+  g_atomic_int_set (&stop, 1);
+
+  g_print ("viewer      frames     buffers  bytes/s     buffer bytes  inflated bytes\n");
+  for (i = 0; i < n_viewers; i++)
+    {
+      Viewer *viewer = &viewers[i];
+
+      /* Wake up the blocked read */
+      if (viewer->connection)
+        g_socket_shutdown (g_socket_connection_get_socket (viewer->connection),
+                           TRUE, TRUE, NULL);
+      g_thread_join (threads[i]);
+
+      if (viewer->connection)
+        {
+          g_io_stream_close (G_IO_STREAM (viewer->connection), NULL, NULL);
+          g_object_unref (viewer->connection);
+          g_object_unref (viewer->decompressor);
+          g_string_free (viewer->inflated, TRUE);
+        }
+
+      g_print ("%-6d%s  %10" G_GUINT64_FORMAT "  %10" G_GUINT64_FORMAT "  %10" G_GUINT64_FORMAT
+               "  %14" G_GUINT64_FORMAT "  %14" G_GUINT64_FORMAT "\n",
+               viewer->index, viewer->failed ? "!" : " ",
+               viewer->frames, viewer->buffers,
+               viewer->bytes / MAX (duration, 1),
+               viewer->buffer_bytes, viewer->inflated_bytes);
+    }
+
+  g_free (viewers);
+  g_free (threads);
+  g_free (address);
+
+  return 0;
+}
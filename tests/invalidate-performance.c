@@ -0,0 +1,146 @@
+/* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+
+/* Invalidates many small areas per frame, like list rows, text
+ * cursors and spinners do, and measures how long it takes to process
+ * the updates with different coalescing settings.
+ */
+
+#include <gtk/gtk.h>
+#include "gdk/gdk-private.h"
+
+#define WIDTH 800
+#define HEIGHT 600
+#define FRAMES 200
+
+static guint n_rects;
+static guint64 painted_pixels;
+
+static gboolean
+draw_cb (GtkWidget *widget,
+         cairo_t   *cr)
+{
+  cairo_rectangle_list_t *list;
+  int i;
+
+  /* Paint every clip rectangle separately, like a widget that
+     only redraws what it has to */
+  list = cairo_copy_clip_rectangle_list (cr);
+  for (i = 0; i < list->num_rectangles; i++)
+    {
+      cairo_rectangle_t *r = &list->rectangles[i];
+
+      cairo_rectangle (cr, r->x, r->y, r->width, r->height);
+      cairo_set_source_rgb (cr, (i % 3) / 2.0, 0.5, 0.5);
+      cairo_fill (cr);
+      painted_pixels += r->width * r->height;
+    }
+  n_rects += list->num_rectangles;
+  cairo_rectangle_list_destroy (list);
+
+  return TRUE;
+}
+
+static void
+invalidate_frame (GdkWindow *window,
+                  int        frame)
+{
+  GdkRectangle r;
+  int i;
+
+  /* List rows */
+  for (i = 0; i < 30; i++)
+    {
+      r.x = 10;
+      r.y = 10 + i * 19;
+      r.width = 300;
+      r.height = 18;
+      gdk_window_invalidate_rect (window, &r, FALSE);
+    }
+
+  /* Cursors */
+  for (i = 0; i < 20; i++)
+    {
+      r.x = 400 + (i * 37 + frame) % 380;
+      r.y = 20 + i * 28;
+      r.width = 1;
+      r.height = 16;
+      gdk_window_invalidate_rect (window, &r, FALSE);
+    }
+
+  /* Spinners, scattered around */
+  for (i = 0; i < 100; i++)
+    {
+      r.x = (i * 97 + frame * 3) % (WIDTH - 16);
+      r.y = (i * 61) % (HEIGHT - 16);
+      r.width = 16;
+      r.height = 16;
+      gdk_window_invalidate_rect (window, &r, FALSE);
+    }
+}
+
+static void
+run (GtkWidget  *window,
+     const char *name,
+     guint       overdraw,
+     guint       max_rects)
+{
+  GdkWindow *gdk_window;
+  GTimer *timer;
+  double msec;
+  int i;
+
+  gdk_window = gtk_widget_get_window (window);
+
+  GDK_PRIVATE_CALL (gdk_display_set_update_coalescing) (gtk_widget_get_display (window),
+                                                        overdraw, max_rects);
+
+  n_rects = 0;
+  painted_pixels = 0;
+  timer = g_timer_new ();
+
+  for (i = 0; i < FRAMES; i++)
+    {
+      invalidate_frame (gdk_window, i);
+      gdk_window_process_updates (gdk_window, TRUE);
+    }
+
+  gdk_display_sync (gtk_widget_get_display (window));
+  msec = g_timer_elapsed (timer, NULL) * 1000;
+  g_timer_destroy (timer);
+
+  g_print ("%-22s %7.3f msec/frame, %6.1f rects/frame, %8" G_GUINT64_FORMAT " pixels/frame\n",
+           name, msec / FRAMES, (double) n_rects / FRAMES, painted_pixels / FRAMES);
+}
+
+int
+main (int argc, char **argv)
+{
+  GtkWidget *window, *area;
+  int j;
+
+  gtk_init (&argc, &argv);
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (window), WIDTH, HEIGHT);
+  area = gtk_drawing_area_new ();
+  g_signal_connect (area, "draw", G_CALLBACK (draw_cb), NULL);
+  gtk_container_add (GTK_CONTAINER (window), area);
+  gtk_widget_show_all (window);
+
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  /* We do everything twice, the first time as warmup */
+  for (j = 0; j < 2; j++)
+    {
+      if (j == 1)
+        g_print ("\n");
+      run (window, "no coalescing", 0, 0);
+      run (window, "overdraw 25%", 25, 0);
+      run (window, "max 32 rects", 0, 32);
+      run (window, "overdraw 25%, 32 rects", 25, 32);
+      run (window, "overdraw 50%, 8 rects", 50, 8);
+    }
+
+  return 0;
+}
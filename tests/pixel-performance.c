@@ -0,0 +1,73 @@
+/* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+
+#include <gdk/gdkpixelconvertprivate.h>
+
+#define SIZE 2000
+
+static void
+run (const char *kernels, guint32 *argb, guint8 *rgba)
+{
+  const guint8 colors[4][4] = {
+    { 46, 52, 54, 255 },
+    { 78, 154, 6, 255 },
+    { 196, 160, 0, 255 },
+    { 204, 0, 0, 255 }
+  };
+  GTimer *timer;
+  double msec;
+  int i, j;
+
+  if (!gdk_pixel_set_kernels (kernels))
+    return;
+
+  timer = g_timer_new ();
+
+#define BENCH(name, code) G_STMT_START {                                        \
+  /* We do everything three times, first two as warmup */                       \
+  for (j = 0; j < 3; j++)                                                       \
+    {                                                                           \
+      g_timer_start (timer);                                                    \
+      for (i = 0; i < SIZE; i++)                                                \
+        code;                                                                   \
+      msec = g_timer_elapsed (timer, NULL) * 1000;                              \
+    }                                                                           \
+  g_print ("%-8s %-22s %7.2f msec, %7.2f kpixels/msec\n",                       \
+           kernels, name, msec, SIZE * SIZE / (msec * 1000));                   \
+  } G_STMT_END
+
+  BENCH ("unpremultiply", gdk_pixel_unpremultiply (argb + i * SIZE, argb + i * SIZE, SIZE));
+  BENCH ("unpremultiply_to_rgba", gdk_pixel_unpremultiply_to_rgba (rgba + 4 * i * SIZE, argb + i * SIZE, SIZE));
+  BENCH ("premultiply", gdk_pixel_premultiply (argb + i * SIZE, rgba + 4 * i * SIZE, SIZE));
+  BENCH ("recolor_symbolic", gdk_pixel_recolor_symbolic (rgba + 4 * i * SIZE, rgba + 4 * i * SIZE, SIZE, colors, 255));
+
+#undef BENCH
+
+  g_timer_destroy (timer);
+}
+
+int
+main (int argc, char **argv)
+{
+  guint32 *argb;
+  guint8 *rgba;
+  int i;
+
+  argb = g_new (guint32, SIZE * SIZE);
+  rgba = g_new (guint8, 4 * SIZE * SIZE);
+
+  for (i = 0; i < SIZE * SIZE; i++)
+    {
+      guint a = (i * 13) & 0xff;
+      argb[i] = a << 24 | ((a * 3 / 4) << 16) | ((a / 2) << 8) | (a / 4);
+    }
+
+  g_print ("Default kernels: %s\n", gdk_pixel_get_kernels ());
+
+  run ("generic", argb, rgba);
+  run ("sse2", argb, rgba);
+
+  g_free (argb);
+  g_free (rgba);
+
+  return 0;
+}
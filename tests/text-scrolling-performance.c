@@ -0,0 +1,157 @@
+/* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+
+/* Scrolls a text view with a large buffer back and forth, so that
+ * most lines stay on screen from one frame to the next. With --resize,
+ * the window is made wider and narrower instead, so that the lines
+ * on screen are wrapped again in every frame. Run with --statistics
+ * to see the frame rate.
+ */
+
+#include <gtk/gtk.h>
+#include <math.h>
+
+#include "frame-stats.h"
+
+static int n_lines = 100000;
+static double speed = 0.05;
+static gboolean resize = FALSE;
+
+static GOptionEntry options[] = {
+  { "lines", 'l', 0, G_OPTION_ARG_INT, &n_lines, "Number of lines in the buffer", "COUNT" },
+  { "speed", 's', 0, G_OPTION_ARG_DOUBLE, &speed, "Scrolling speed, in buffers per second", "SPEED" },
+  { "resize", 'r', 0, G_OPTION_ARG_NONE, &resize, "Resize the window instead of scrolling", NULL },
+  { NULL }
+};
+
+static void
+fill_buffer (GtkTextBuffer *buffer)
+{
+  static const char *words[] = {
+    "lorem", "ipsum", "dolor", "sit", "amet", "consectetur",
+    "adipiscing", "elit", "sed", "do", "eiusmod", "tempor"
+  };
+  GtkTextTag *bold;
+  GtkTextIter iter;
+  GString *line;
+  int i, j;
+
+  bold = gtk_text_buffer_create_tag (buffer, "bold",
+                                     "weight", PANGO_WEIGHT_BOLD,
+                                     NULL);
+
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  line = g_string_new (NULL);
+
+  for (i = 0; i < n_lines; i++)
+    {
+      g_string_printf (line, "%d:", i);
+      for (j = 0; j < 4 + i % 9; j++)
+        {
+          g_string_append_c (line, ' ');
+          g_string_append (line, words[(i + j * 7) % G_N_ELEMENTS (words)]);
+        }
+
+      gtk_text_buffer_insert_with_tags (buffer, &iter, line->str, -1, bold, NULL);
+      gtk_text_buffer_insert (buffer, &iter, " and some more plain text\n", -1);
+    }
+
+  g_string_free (line, TRUE);
+}
+
+static gboolean
+scroll_text_view (GtkWidget     *text_view,
+                  GdkFrameClock *frame_clock,
+                  gpointer       user_data)
+{
+  static gint64 start_time;
+  gint64 now = gdk_frame_clock_get_frame_time (frame_clock);
+  GtkAdjustment *adjustment;
+  gdouble elapsed;
+  gdouble upper, page_size;
+
+  if (start_time == 0)
+    start_time = now;
+
+  elapsed = (now - start_time) / 1000000.;
+
+  adjustment = gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (text_view));
+  upper = gtk_adjustment_get_upper (adjustment);
+  page_size = gtk_adjustment_get_page_size (adjustment);
+
+  gtk_adjustment_set_value (adjustment,
+                            (0.5 - 0.5 * cos (G_PI * speed * elapsed)) * (upper - page_size));
+
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+resize_window (GtkWidget     *window,
+               GdkFrameClock *frame_clock,
+               gpointer       user_data)
+{
+  static gint64 start_time;
+  gint64 now = gdk_frame_clock_get_frame_time (frame_clock);
+  gdouble elapsed;
+
+  if (start_time == 0)
+    start_time = now;
+
+  elapsed = (now - start_time) / 1000000.;
+
+  gtk_window_resize (GTK_WINDOW (window),
+                     400 + 400 * (0.5 - 0.5 * cos (2 * G_PI * elapsed)),
+                     600);
+
+  return G_SOURCE_CONTINUE;
+}
+
+int
+main (int argc, char **argv)
+{
+  GtkWidget *window;
+  GtkWidget *scrolled_window;
+  GtkWidget *text_view;
+  GError *error = NULL;
+
+  GOptionContext *context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, options, NULL);
+  frame_stats_add_options (g_option_context_get_main_group (context));
+  g_option_context_add_group (context,
+                              gtk_get_option_group (TRUE));
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("Option parsing failed: %s\n", error->message);
+      return 1;
+    }
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  frame_stats_ensure (GTK_WINDOW (window));
+  gtk_window_set_default_size (GTK_WINDOW (window), 800, 600);
+
+  scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (window), scrolled_window);
+
+  text_view = gtk_text_view_new ();
+  gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (text_view), GTK_WRAP_WORD);
+  fill_buffer (gtk_text_view_get_buffer (GTK_TEXT_VIEW (text_view)));
+  gtk_container_add (GTK_CONTAINER (scrolled_window), text_view);
+
+  if (resize)
+    gtk_widget_add_tick_callback (window,
+                                  resize_window,
+                                  NULL,
+                                  NULL);
+  else
+    gtk_widget_add_tick_callback (text_view,
+                                  scroll_text_view,
+                                  NULL,
+                                  NULL);
+
+  gtk_widget_show_all (window);
+  g_signal_connect (window, "destroy",
+                    G_CALLBACK (gtk_main_quit), NULL);
+  gtk_main ();
+
+  return 0;
+}
@@ -0,0 +1,212 @@
+#include <string.h>
+#include "gdk/gdkpixelconvertprivate.h"
+
+/* The reference versions of the conversions, as they were written
+ * before there was a shared module */
+
+static void
+reference_unpremultiply_to_rgba (guint8 *dest, const guint32 *src, int n)
+{
+  int x;
+
+  for (x = 0; x < n; x++)
+    {
+      guint alpha = src[x] >> 24;
+
+      if (alpha == 0)
+        {
+          dest[x * 4 + 0] = 0;
+          dest[x * 4 + 1] = 0;
+          dest[x * 4 + 2] = 0;
+        }
+      else
+        {
+          dest[x * 4 + 0] = (((src[x] & 0xff0000) >> 16) * 255 + alpha / 2) / alpha;
+          dest[x * 4 + 1] = (((src[x] & 0x00ff00) >>  8) * 255 + alpha / 2) / alpha;
+          dest[x * 4 + 2] = (((src[x] & 0x0000ff) >>  0) * 255 + alpha / 2) / alpha;
+        }
+      dest[x * 4 + 3] = alpha;
+    }
+}
+
+static void
+reference_premultiply (guint32 *dest, const guint8 *p, int n)
+{
+  guint t, r, g, b;
+  int x;
+
+#define MULT(d,c,a,t) G_STMT_START { t = c * a + 0x80; d = ((t >> 8) + t) >> 8; } G_STMT_END
+
+  for (x = 0; x < n; x++, p += 4)
+    {
+      MULT (r, p[0], p[3], t);
+      MULT (g, p[1], p[3], t);
+      MULT (b, p[2], p[3], t);
+      dest[x] = (guint32)p[3] << 24 | r << 16 | g << 8 | b;
+    }
+
+#undef MULT
+}
+
+static const char *kernels[] = { "generic", "sse2" };
+
+/* Every combination of alpha and one color channel, plus some junk in
+ * the others, with an odd length to exercise the tails */
+#define N_PIXELS (256 * 256 + 3)
+
+static guint32 *
+make_argb (void)
+{
+  guint32 *pixels;
+  int i;
+
+  pixels = g_new (guint32, N_PIXELS);
+  for (i = 0; i < N_PIXELS; i++)
+    pixels[i] = (guint32)(i & 0xff) << 24 | (guint32)((i >> 8) & 0xff) << 16 |
+                (guint32)((i * 7) & 0xff) << 8 | (guint32)((i >> 8) & 0xff);
+
+  return pixels;
+}
+
+static guint8 *
+make_rgba (void)
+{
+  guint8 *pixels;
+  GRand *rand;
+  int i;
+
+  rand = g_rand_new_with_seed (42);
+  pixels = g_new (guint8, 4 * N_PIXELS);
+  for (i = 0; i < N_PIXELS; i++)
+    {
+      /* Symbolic icons mostly have c2 + c3 + c4 <= 255 */
+      int max = i % 3 ? 256 : 86;
+
+      pixels[4 * i + 0] = g_rand_int_range (rand, 0, max);
+      pixels[4 * i + 1] = g_rand_int_range (rand, 0, max);
+      pixels[4 * i + 2] = g_rand_int_range (rand, 0, max);
+      pixels[4 * i + 3] = i % 5 ? (i >> 8) & 0xff : 0;
+    }
+  g_rand_free (rand);
+
+  return pixels;
+}
+
+static void
+test_unpremultiply (void)
+{
+  guint32 *src, *dest;
+  guint8 *rgba, *expected;
+  guint i, k;
+
+  src = make_argb ();
+  dest = g_new (guint32, N_PIXELS);
+  rgba = g_new (guint8, 4 * N_PIXELS);
+  expected = g_new (guint8, 4 * N_PIXELS);
+
+  reference_unpremultiply_to_rgba (expected, src, N_PIXELS);
+
+  for (k = 0; k < G_N_ELEMENTS (kernels); k++)
+    {
+      if (!gdk_pixel_set_kernels (kernels[k]))
+        continue;
+
+      gdk_pixel_unpremultiply_to_rgba (rgba, src, N_PIXELS);
+      g_assert (memcmp (rgba, expected, 4 * N_PIXELS) == 0);
+
+      gdk_pixel_unpremultiply (dest, src, N_PIXELS);
+      for (i = 0; i < N_PIXELS; i++)
+        {
+          g_assert_cmpuint (dest[i] >> 24, ==, expected[4 * i + 3]);
+          g_assert_cmpuint ((dest[i] >> 16) & 0xff, ==, expected[4 * i + 0]);
+          g_assert_cmpuint ((dest[i] >> 8) & 0xff, ==, expected[4 * i + 1]);
+          g_assert_cmpuint (dest[i] & 0xff, ==, expected[4 * i + 2]);
+        }
+
+      /* In place, as broadway does it */
+      memcpy (dest, src, 4 * N_PIXELS);
+      gdk_pixel_unpremultiply (dest, dest, N_PIXELS);
+      g_assert_cmpuint (dest[N_PIXELS - 1] >> 24, ==, expected[4 * (N_PIXELS - 1) + 3]);
+    }
+
+  g_free (src);
+  g_free (dest);
+  g_free (rgba);
+  g_free (expected);
+}
+
+static void
+test_premultiply (void)
+{
+  guint8 *src;
+  guint32 *dest, *expected;
+  guint k;
+
+  src = make_rgba ();
+  dest = g_new (guint32, N_PIXELS);
+  expected = g_new (guint32, N_PIXELS);
+
+  reference_premultiply (expected, src, N_PIXELS);
+
+  for (k = 0; k < G_N_ELEMENTS (kernels); k++)
+    {
+      if (!gdk_pixel_set_kernels (kernels[k]))
+        continue;
+
+      gdk_pixel_premultiply (dest, src, N_PIXELS);
+      g_assert (memcmp (dest, expected, 4 * N_PIXELS) == 0);
+    }
+
+  g_free (src);
+  g_free (dest);
+  g_free (expected);
+}
+
+static void
+test_recolor (void)
+{
+  const guint8 colors[4][4] = {
+    { 46, 52, 54, 255 },
+    { 78, 154, 6, 255 },
+    { 196, 160, 0, 255 },
+    { 204, 0, 0, 255 }
+  };
+  const int alphas[] = { 255, 128, 0 };
+  guint8 *src, *dest, *expected;
+  guint a, k;
+
+  src = make_rgba ();
+  dest = g_new (guint8, 4 * N_PIXELS);
+  expected = g_new (guint8, 4 * N_PIXELS);
+
+  for (a = 0; a < G_N_ELEMENTS (alphas); a++)
+    {
+      gdk_pixel_set_kernels ("generic");
+      gdk_pixel_recolor_symbolic (expected, src, N_PIXELS, colors, alphas[a]);
+
+      for (k = 0; k < G_N_ELEMENTS (kernels); k++)
+        {
+          if (!gdk_pixel_set_kernels (kernels[k]))
+            continue;
+
+          gdk_pixel_recolor_symbolic (dest, src, N_PIXELS, colors, alphas[a]);
+          g_assert (memcmp (dest, expected, 4 * N_PIXELS) == 0);
+        }
+    }
+
+  g_free (src);
+  g_free (dest);
+  g_free (expected);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/pixelconvert/unpremultiply", test_unpremultiply);
+  g_test_add_func ("/pixelconvert/premultiply", test_premultiply);
+  g_test_add_func ("/pixelconvert/recolor", test_recolor);
+
+  return g_test_run ();
+}
@@ -6782,6 +6782,114 @@ specific_bug_679910 (void)
   g_object_unref (store);
 }
 
+static gint refilter_async_modulo = 1;
+
+static gboolean
+refilter_async_visible_func (GtkTreeModel *model,
+                             GtkTreeIter  *iter,
+                             gpointer      data)
+{
+  gint value;
+
+  gtk_tree_model_get (model, iter, 0, &value, -1);
+
+  return value % refilter_async_modulo == 0;
+}
+
+typedef struct {
+  gboolean done;
+  gboolean result;
+  GError *error;
+} RefilterAsyncResult;
+
+static void
+refilter_async_callback (GObject      *source,
+                         GAsyncResult *result,
+                         gpointer      data)
+{
+  RefilterAsyncResult *res = data;
+
+  res->result = gtk_tree_model_filter_refilter_finish (GTK_TREE_MODEL_FILTER (source),
+                                                       result, &res->error);
+  res->done = TRUE;
+}
+
+static void
+specific_refilter_async (void)
+{
+  GtkListStore *store;
+  GtkTreeModel *filter;
+  GtkTreeIter iter;
+  GCancellable *cancellable;
+  RefilterAsyncResult first = { FALSE, FALSE, NULL };
+  RefilterAsyncResult second = { FALSE, FALSE, NULL };
+  RefilterAsyncResult third = { FALSE, FALSE, NULL };
+  gint i, value;
+
+  store = gtk_list_store_new (1, G_TYPE_INT);
+  for (i = 0; i < 3000; i++)
+    gtk_list_store_insert_with_values (store, NULL, i, 0, i, -1);
+
+  filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (store), NULL);
+  gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter),
+                                          refilter_async_visible_func,
+                                          NULL, NULL);
+
+  refilter_async_modulo = 1;
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 3000);
+
+  /* a newer refilter replaces the one in progress */
+  refilter_async_modulo = 2;
+  gtk_tree_model_filter_refilter_async (GTK_TREE_MODEL_FILTER (filter), NULL,
+                                        refilter_async_callback, &first);
+  refilter_async_modulo = 3;
+  gtk_tree_model_filter_refilter_async (GTK_TREE_MODEL_FILTER (filter), NULL,
+                                        refilter_async_callback, &second);
+
+  /* rows added while it runs are filtered too */
+  gtk_list_store_insert_with_values (store, NULL, 0, 0, 0, -1);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, 3000, -1);
+  while (!second.done)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert (first.done);
+  g_assert (!first.result);
+  g_assert_error (first.error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_clear_error (&first.error);
+
+  g_assert (second.result);
+  g_assert_no_error (second.error);
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 1002);
+  i = 0;
+  if (gtk_tree_model_get_iter_first (filter, &iter))
+    do
+      {
+        gtk_tree_model_get (filter, &iter, 0, &value, -1);
+        g_assert_cmpint (value % 3, ==, 0);
+        i++;
+      }
+    while (gtk_tree_model_iter_next (filter, &iter));
+  g_assert_cmpint (i, ==, 1002);
+
+  /* cancelling */
+  cancellable = g_cancellable_new ();
+  refilter_async_modulo = 1;
+  gtk_tree_model_filter_refilter_async (GTK_TREE_MODEL_FILTER (filter), cancellable,
+                                        refilter_async_callback, &third);
+  g_cancellable_cancel (cancellable);
+  while (!third.done)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert (!third.result);
+  g_assert_error (third.error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_clear_error (&third.error);
+
+  g_object_unref (cancellable);
+  g_object_unref (filter);
+  g_object_unref (store);
+}
+
 /* main */
 
 void
@@ -7143,4 +7251,6 @@ register_filter_model_tests (void)
                    specific_bug_659022_row_deleted_free_level);
   g_test_add_func ("/TreeModelFilter/specific/bug-679910",
                    specific_bug_679910);
+  g_test_add_func ("/TreeModelFilter/specific/refilter-async",
+                   specific_refilter_async);
 }
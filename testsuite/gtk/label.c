@@ -0,0 +1,158 @@
+/* GtkLabel tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+
+/* The measured sizes are cached, changing these properties must
+ * still change the size request.
+ */
+static void
+test_width_chars (void)
+{
+  GtkWidget *label;
+  gint min, nat;
+  gint min2, nat2;
+
+  label = gtk_label_new ("Hello");
+  g_object_ref_sink (label);
+
+  gtk_widget_get_preferred_width (label, &min, &nat);
+
+  gtk_label_set_width_chars (GTK_LABEL (label), 30);
+  gtk_widget_get_preferred_width (label, &min2, &nat2);
+  g_assert_cmpint (min2, >, min);
+  g_assert_cmpint (nat2, >=, min2);
+
+  gtk_label_set_width_chars (GTK_LABEL (label), -1);
+  gtk_widget_get_preferred_width (label, &min2, &nat2);
+  g_assert_cmpint (min2, ==, min);
+  g_assert_cmpint (nat2, ==, nat);
+
+  g_object_unref (label);
+}
+
+static void
+test_max_width_chars (void)
+{
+  GtkWidget *label;
+  gint min, nat;
+  gint min2, nat2;
+
+  label = gtk_label_new ("Lorem ipsum dolor sit amet, consectetur adipiscing elit, "
+                         "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua");
+  g_object_ref_sink (label);
+  gtk_label_set_line_wrap (GTK_LABEL (label), TRUE);
+  gtk_label_set_max_width_chars (GTK_LABEL (label), 10);
+
+  gtk_widget_get_preferred_width (label, &min, &nat);
+
+  gtk_label_set_max_width_chars (GTK_LABEL (label), 40);
+  gtk_widget_get_preferred_width (label, &min2, &nat2);
+  g_assert_cmpint (nat2, >, nat);
+
+  gtk_label_set_max_width_chars (GTK_LABEL (label), 10);
+  gtk_widget_get_preferred_width (label, &min2, &nat2);
+  g_assert_cmpint (min2, ==, min);
+  g_assert_cmpint (nat2, ==, nat);
+
+  g_object_unref (label);
+}
+
+static gboolean
+has_attribute (PangoAttrList *attrs,
+               PangoAttrType  type)
+{
+  PangoAttrIterator *iter;
+  gboolean found;
+
+  if (attrs == NULL)
+    return FALSE;
+
+  found = FALSE;
+  iter = pango_attr_list_get_iterator (attrs);
+  do
+    {
+      if (pango_attr_iterator_get (iter, type))
+        found = TRUE;
+    }
+  while (!found && pango_attr_iterator_next (iter));
+  pango_attr_iterator_destroy (iter);
+
+  return found;
+}
+
+/* Markup is only parsed when it is needed, which must not be
+ * visible through the API.
+ */
+static void
+test_markup_deferred (void)
+{
+  const gchar *markup = "<b>Hello</b> <i>world</i>";
+  GtkWidget *label, *label2, *label3;
+  PangoLayout *layout;
+  PangoAttrList *attrs;
+  gint start, end;
+
+  label = gtk_label_new (NULL);
+  g_object_ref_sink (label);
+  gtk_label_set_markup (GTK_LABEL (label), markup);
+  g_assert_cmpstr (gtk_label_get_label (GTK_LABEL (label)), ==, markup);
+  g_assert_cmpstr (gtk_label_get_text (GTK_LABEL (label)), ==, "Hello world");
+
+  label2 = gtk_label_new (NULL);
+  g_object_ref_sink (label2);
+  gtk_label_set_markup (GTK_LABEL (label2), markup);
+  layout = gtk_label_get_layout (GTK_LABEL (label2));
+  g_assert_cmpstr (pango_layout_get_text (layout), ==, "Hello world");
+  attrs = pango_layout_get_attributes (layout);
+  g_assert (has_attribute (attrs, PANGO_ATTR_WEIGHT));
+  g_assert (has_attribute (attrs, PANGO_ATTR_STYLE));
+
+  /* Both labels parsed the same markup, but changing the attributes
+   * of one of them doesn't change the other
+   */
+  layout = gtk_label_get_layout (GTK_LABEL (label));
+  pango_attr_list_insert (pango_layout_get_attributes (layout),
+                          pango_attr_underline_new (PANGO_UNDERLINE_SINGLE));
+  layout = gtk_label_get_layout (GTK_LABEL (label2));
+  g_assert (!has_attribute (pango_layout_get_attributes (layout), PANGO_ATTR_UNDERLINE));
+
+  /* Selections are in terms of the parsed text */
+  label3 = gtk_label_new (NULL);
+  g_object_ref_sink (label3);
+  gtk_label_set_markup (GTK_LABEL (label3), markup);
+  gtk_label_set_selectable (GTK_LABEL (label3), TRUE);
+  gtk_label_select_region (GTK_LABEL (label3), 6, -1);
+  g_assert (gtk_label_get_selection_bounds (GTK_LABEL (label3), &start, &end));
+  g_assert_cmpint (start, ==, 6);
+  g_assert_cmpint (end, ==, 11);
+
+  g_object_unref (label);
+  g_object_unref (label2);
+  g_object_unref (label3);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/label/width-chars", test_width_chars);
+  g_test_add_func ("/label/max-width-chars", test_max_width_chars);
+  g_test_add_func ("/label/markup-deferred", test_markup_deferred);
+
+  return g_test_run ();
+}
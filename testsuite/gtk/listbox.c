@@ -1,3 +1,4 @@
+#include <string.h>
 #include <gtk/gtk.h>
 
 static gint
@@ -434,6 +435,337 @@ test_header (void)
   g_object_unref (list);
 }
 
+static void
+group_header_func (GtkListBoxRow *row,
+                   GtkListBoxRow *before,
+                   gpointer       data)
+{
+  GtkWidget *label;
+  gint n1, n2;
+  gint *count = data;
+
+  (*count)++;
+
+  label = gtk_bin_get_child (GTK_BIN (row));
+  n1 = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (label), "data"));
+
+  if (before != NULL)
+    {
+      label = gtk_bin_get_child (GTK_BIN (before));
+      n2 = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (label), "data"));
+    }
+  else
+    n2 = -1;
+
+  if (n2 / 100 != n1 / 100)
+    {
+      if (gtk_list_box_row_get_header (row) == NULL)
+        gtk_list_box_row_set_header (row, gtk_separator_new (GTK_ORIENTATION_HORIZONTAL));
+    }
+  else
+    gtk_list_box_row_set_header (row, NULL);
+}
+
+static void
+test_sorted_insert (void)
+{
+  GtkListBox *list;
+  GtkWidget *label;
+  gint n = g_test_perf () ? 100000 : 1000;
+  gint sort_count;
+  gint header_count;
+  gdouble elapsed;
+  gint i, r;
+
+  list = GTK_LIST_BOX (gtk_list_box_new ());
+  g_object_ref_sink (list);
+  gtk_widget_show (GTK_WIDGET (list));
+
+  sort_count = 0;
+  header_count = 0;
+  gtk_list_box_set_sort_func (list, sort_list, &sort_count, NULL);
+  gtk_list_box_set_header_func (list, group_header_func, &header_count, NULL);
+
+  g_test_timer_start ();
+
+  /* Like a log, rows mostly come in order, but some arrive late */
+  for (i = 0; i < n; i++)
+    {
+      r = i % 7 == 0 ? MAX (i - 50, 0) : i;
+      label = gtk_label_new ("");
+      g_object_set_data (G_OBJECT (label), "data", GINT_TO_POINTER (r));
+      gtk_container_add (GTK_CONTAINER (list), label);
+    }
+
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed, "%d sorted inserts: %gsec", n, elapsed);
+
+  check_sorted (list);
+
+  /* Each insert updates the headers of the new row and the one after it */
+  g_assert_cmpint (header_count, <=, 2 * n);
+
+  /* The rows are sorted already, but the headers are still updated,
+   * in case they depend on the same external factor as the sorting
+   */
+  header_count = 0;
+  sort_count = 0;
+  gtk_list_box_invalidate_sort (list);
+  g_assert_cmpint (sort_count, <, n);
+  g_assert_cmpint (header_count, ==, n);
+
+  header_count = 0;
+  gtk_list_box_invalidate_headers (list);
+  g_assert_cmpint (header_count, ==, n);
+
+  g_object_unref (list);
+}
+
+typedef struct {
+  gboolean hidden[10];
+  gint header_count[10];
+} FilterHeaders;
+
+static gint
+get_row_data (GtkListBoxRow *row)
+{
+  GtkWidget *label;
+
+  label = gtk_bin_get_child (GTK_BIN (row));
+
+  return GPOINTER_TO_INT (g_object_get_data (G_OBJECT (label), "data"));
+}
+
+static gboolean
+hidden_filter_func (GtkListBoxRow *row,
+                    gpointer       data)
+{
+  FilterHeaders *fh = data;
+
+  return !fh->hidden[get_row_data (row)];
+}
+
+/* The header says which row comes before */
+static void
+before_header_func (GtkListBoxRow *row,
+                    GtkListBoxRow *before,
+                    gpointer       data)
+{
+  FilterHeaders *fh = data;
+  gchar *s;
+
+  fh->header_count[get_row_data (row)]++;
+
+  s = g_strdup_printf ("%d", before ? get_row_data (before) : -1);
+  gtk_list_box_row_set_header (row, gtk_label_new (s));
+  g_free (s);
+}
+
+static void
+check_filter_headers (GtkListBox    *list,
+                      FilterHeaders *fh,
+                      const gint    *expected_count)
+{
+  GtkListBoxRow *row;
+  GtkWidget *header;
+  gint before;
+  gchar *s;
+  gint i;
+
+  before = -1;
+  for (i = 0; i < 10; i++)
+    {
+      row = gtk_list_box_get_row_at_index (list, i);
+      header = gtk_list_box_row_get_header (row);
+
+      g_assert_cmpint (fh->header_count[i], ==, expected_count[i]);
+
+      if (fh->hidden[i])
+        {
+          g_assert (header == NULL);
+          continue;
+        }
+
+      s = g_strdup_printf ("%d", before);
+      g_assert_cmpstr (gtk_label_get_text (GTK_LABEL (header)), ==, s);
+      g_free (s);
+
+      before = i;
+    }
+
+  memset (fh->header_count, 0, sizeof (fh->header_count));
+}
+
+static void
+test_filter_headers (void)
+{
+  static const gint none[10] = { 0, };
+  static const gint after_hide[10] = { 0, 0, 0, 0, 0, 1, 0, 0, 0, 0 };
+  static const gint after_show[10] = { 0, 0, 0, 0, 1, 1, 0, 0, 0, 0 };
+  FilterHeaders fh = { { FALSE, }, { 0, } };
+  GtkListBox *list;
+  GtkWidget *label;
+  gint i;
+
+  list = GTK_LIST_BOX (gtk_list_box_new ());
+  g_object_ref_sink (list);
+  gtk_widget_show (GTK_WIDGET (list));
+
+  for (i = 0; i < 10; i++)
+    {
+      label = gtk_label_new ("");
+      g_object_set_data (G_OBJECT (label), "data", GINT_TO_POINTER (i));
+      gtk_container_add (GTK_CONTAINER (list), label);
+    }
+
+  gtk_list_box_set_filter_func (list, hidden_filter_func, &fh, NULL);
+  gtk_list_box_set_header_func (list, before_header_func, &fh, NULL);
+  memset (fh.header_count, 0, sizeof (fh.header_count));
+
+  /* Nothing changed, so no header is updated */
+  gtk_list_box_invalidate_filter (list);
+  check_filter_headers (list, &fh, none);
+
+  /* Only the row after the hidden ones gets a new previous row */
+  fh.hidden[3] = TRUE;
+  fh.hidden[4] = TRUE;
+  gtk_list_box_invalidate_filter (list);
+  check_filter_headers (list, &fh, after_hide);
+
+  /* A row that is shown again needs a header, and so does the
+   * row after it
+   */
+  fh.hidden[4] = FALSE;
+  gtk_list_box_invalidate_filter (list);
+  check_filter_headers (list, &fh, after_show);
+
+  g_object_unref (list);
+}
+
+static GtkWidget *
+create_widget (gpointer item,
+               gpointer data)
+{
+  gint *n_created = data;
+  GtkWidget *label;
+  gchar *s;
+
+  (*n_created)++;
+
+  s = g_strdup_printf ("%d", GPOINTER_TO_INT (g_object_get_data (item, "data")));
+  label = gtk_label_new (s);
+  g_free (s);
+
+  return label;
+}
+
+static void
+bind_widget (gpointer   item,
+             GtkWidget *widget,
+             gpointer   data)
+{
+  gchar *s;
+
+  s = g_strdup_printf ("%d", GPOINTER_TO_INT (g_object_get_data (item, "data")));
+  gtk_label_set_text (GTK_LABEL (widget), s);
+  g_free (s);
+}
+
+static void
+check_row_item (GtkListBox *list,
+                gint        index,
+                gint        data)
+{
+  GtkListBoxRow *row;
+  GtkWidget *label;
+  gchar *s;
+
+  row = gtk_list_box_get_row_at_index (list, index);
+  g_assert (row != NULL);
+  g_assert_cmpint (gtk_list_box_row_get_index (row), ==, index);
+
+  label = gtk_bin_get_child (GTK_BIN (row));
+  s = g_strdup_printf ("%d", data);
+  g_assert_cmpstr (gtk_label_get_text (GTK_LABEL (label)), ==, s);
+  g_free (s);
+}
+
+static void
+test_bind_model_recycled (void)
+{
+  GtkListBox *list;
+  GListStore *store;
+  GtkAdjustment *adjustment;
+  GtkListBoxRow *row;
+  GList *children;
+  GObject *item;
+  gint n_created;
+  gint n_rows;
+  gint height;
+  gint i;
+
+  store = g_list_store_new (G_TYPE_OBJECT);
+  for (i = 0; i < 10000; i++)
+    {
+      item = g_object_new (G_TYPE_OBJECT, NULL);
+      g_object_set_data (item, "data", GINT_TO_POINTER (i));
+      g_list_store_append (store, item);
+      g_object_unref (item);
+    }
+
+  list = GTK_LIST_BOX (gtk_list_box_new ());
+  g_object_ref_sink (list);
+  gtk_widget_show (GTK_WIDGET (list));
+
+  adjustment = gtk_adjustment_new (0, 0, 0, 10, 100, 100);
+  gtk_list_box_set_adjustment (list, adjustment);
+
+  n_created = 0;
+  gtk_list_box_bind_model_recycled (list, G_LIST_MODEL (store),
+                                    create_widget, bind_widget,
+                                    &n_created, NULL);
+
+  children = gtk_container_get_children (GTK_CONTAINER (list));
+  n_rows = g_list_length (children);
+  g_list_free (children);
+
+  g_assert_cmpint (n_rows, >, 0);
+  g_assert_cmpint (n_rows, <, 10000);
+  g_assert_cmpint (n_created, ==, n_rows);
+  check_row_item (list, 0, 0);
+  g_assert (gtk_list_box_get_row_at_index (list, 9999) == NULL);
+
+  /* Scroll to the middle, the rows there get reused */
+  row = gtk_list_box_get_row_at_index (list, 0);
+  gtk_widget_get_preferred_height (GTK_WIDGET (row), &height, NULL);
+  gtk_adjustment_configure (adjustment, 5000 * height, 0, 10000 * height, 10, 100, 100);
+  while (g_main_context_iteration (NULL, FALSE));
+
+  check_row_item (list, 5000, 5000);
+  g_assert (gtk_list_box_get_row_at_index (list, 0) == NULL);
+  g_assert_cmpint (n_created, <, 100);
+
+  /* Items before the rows move them */
+  g_list_store_remove (G_LIST_STORE (store), 0);
+  check_row_item (list, 5000, 5001);
+
+  /* Items in the middle of them rebind them */
+  item = g_object_new (G_TYPE_OBJECT, NULL);
+  g_object_set_data (item, "data", GINT_TO_POINTER (-1));
+  g_list_store_insert (store, 4999, item);
+  g_object_unref (item);
+  check_row_item (list, 4999, -1);
+  check_row_item (list, 5000, 5000);
+
+  gtk_list_box_bind_model (list, NULL, NULL, NULL, NULL);
+  g_assert (gtk_list_box_get_row_at_index (list, 0) == NULL);
+
+  g_object_unref (list);
+  g_object_unref (adjustment);
+  g_object_unref (store);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -444,6 +776,9 @@ main (int argc, char *argv[])
   g_test_add_func ("/listbox/multi-selection", test_multi_selection);
   g_test_add_func ("/listbox/filter", test_filter);
   g_test_add_func ("/listbox/header", test_header);
+  g_test_add_func ("/listbox/sorted-insert", test_sorted_insert);
+  g_test_add_func ("/listbox/filter-headers", test_filter_headers);
+  g_test_add_func ("/listbox/bind-model-recycled", test_bind_model_recycled);
 
   return g_test_run ();
 }
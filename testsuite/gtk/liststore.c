@@ -24,6 +24,7 @@
  */
 
 #include <gtk/gtk.h>
+#include <stdio.h>
 
 #include "treemodel.h"
 
@@ -472,6 +473,431 @@ list_store_set_gvalue_to_transform (void)
   gtk_list_store_set_value (store, &iter, 0, &value);
 }
 
+static void
+list_store_set_get_values (void)
+{
+  GtkListStore *store;
+  GtkTreeIter iter, iter2;
+  GObject *object;
+  gint i;
+  gchar *str, *str2;
+  gint64 i64;
+  gdouble d;
+  gfloat f;
+  gchar c;
+  gboolean b;
+  GObject *o;
+
+  object = g_object_new (G_TYPE_OBJECT, NULL);
+  store = gtk_list_store_new (7, G_TYPE_CHAR, G_TYPE_STRING, G_TYPE_INT64,
+                              G_TYPE_BOOLEAN, G_TYPE_DOUBLE, G_TYPE_OBJECT,
+                              G_TYPE_FLOAT);
+
+  /* Unset columns read back as defaults */
+  gtk_list_store_append (store, &iter);
+  gtk_list_store_set (store, &iter, 2, G_GINT64_CONSTANT (1) << 40, -1);
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter,
+                      0, &c, 1, &str, 2, &i64, 3, &b, 4, &d, 5, &o, 6, &f, -1);
+  g_assert_cmpint (c, ==, 0);
+  g_assert (str == NULL);
+  g_assert_cmpint (i64, ==, G_GINT64_CONSTANT (1) << 40);
+  g_assert (!b);
+  g_assert_cmpfloat (d, ==, 0.0);
+  g_assert (o == NULL);
+  g_assert_cmpfloat (f, ==, 0.0);
+
+  gtk_list_store_set (store, &iter,
+                      0, 'x', 1, "shared", 3, TRUE, 4, 0.5, 5, object, 6, 1.5f, -1);
+  gtk_list_store_insert_with_values (store, &iter2, -1, 1, "shared", -1);
+
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter,
+                      0, &c, 1, &str, 3, &b, 4, &d, 5, &o, 6, &f, -1);
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter2, 1, &str2, -1);
+  g_assert_cmpint (c, ==, 'x');
+  g_assert_cmpstr (str, ==, "shared");
+  g_assert_cmpstr (str2, ==, "shared");
+  g_assert (b);
+  g_assert_cmpfloat (d, ==, 0.5);
+  g_assert (o == object);
+  g_assert_cmpfloat (f, ==, 1.5);
+  g_free (str);
+  g_free (str2);
+  g_object_unref (o);
+
+  /* Overwriting a string must not affect the other rows using it */
+  for (i = 0; i < 3; i++)
+    gtk_list_store_set (store, &iter, 1, i == 1 ? NULL : "other", -1);
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 1, &str, -1);
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter2, 1, &str2, -1);
+  g_assert_cmpstr (str, ==, "other");
+  g_assert_cmpstr (str2, ==, "shared");
+  g_free (str);
+  g_free (str2);
+
+  gtk_list_store_set (store, &iter, 1, "shared", -1);
+  gtk_list_store_remove (store, &iter2);
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 1, &str, -1);
+  g_assert_cmpstr (str, ==, "shared");
+  g_free (str);
+
+  g_object_add_weak_pointer (object, (gpointer *) &object);
+  g_object_unref (object);
+  g_assert (object != NULL);
+  g_object_unref (store);
+  g_assert (object == NULL);
+}
+
+#define N_LARGE_COLUMNS 12
+
+static gsize
+get_resident_size (void)
+{
+  gchar *contents;
+  gsize pages, resident;
+  gsize size = 0;
+
+  /* Only available on Linux, we just don't report memory elsewhere */
+  if (g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL))
+    {
+      if (sscanf (contents, "%" G_GSIZE_FORMAT " %" G_GSIZE_FORMAT, &pages, &resident) == 2)
+        size = resident * 4096;
+      g_free (contents);
+    }
+
+  return size;
+}
+
+static void
+list_store_large (void)
+{
+  static const char *words[] = { "alpha", "beta", "gamma", "delta", "epsilon" };
+  GType types[N_LARGE_COLUMNS] = {
+    G_TYPE_INT, G_TYPE_UINT, G_TYPE_BOOLEAN, G_TYPE_CHAR,
+    G_TYPE_INT64, G_TYPE_DOUBLE, G_TYPE_FLOAT, G_TYPE_STRING,
+    G_TYPE_STRING, G_TYPE_POINTER, G_TYPE_OBJECT, G_TYPE_ULONG
+  };
+  gint columns[N_LARGE_COLUMNS];
+  GValue values[N_LARGE_COLUMNS] = { G_VALUE_INIT, };
+  guint n = g_test_perf () ? 1000000 : 1000;
+  GtkListStore *store;
+  GtkTreeIter iter;
+  GObject *object;
+  GValue value = G_VALUE_INIT;
+  gsize before, after;
+  gboolean valid;
+  double elapsed;
+  guint i, j;
+  gchar buf[32];
+
+  object = g_object_new (G_TYPE_OBJECT, NULL);
+  for (j = 0; j < N_LARGE_COLUMNS; j++)
+    {
+      columns[j] = j;
+      g_value_init (&values[j], types[j]);
+    }
+  g_value_set_object (&values[10], object);
+
+  before = get_resident_size ();
+
+  g_test_timer_start ();
+
+  store = gtk_list_store_newv (N_LARGE_COLUMNS, types);
+  for (i = 0; i < n; i++)
+    {
+      g_snprintf (buf, sizeof (buf), "row %u", i);
+
+      g_value_set_int (&values[0], i);
+      g_value_set_uint (&values[1], n - i);
+      g_value_set_boolean (&values[2], i & 1);
+      g_value_set_schar (&values[3], 'a' + i % 26);
+      g_value_set_int64 (&values[4], (gint64) i << 20);
+      g_value_set_double (&values[5], i / 2.0);
+      g_value_set_float (&values[6], i / 4.0f);
+      g_value_set_static_string (&values[7], words[i % G_N_ELEMENTS (words)]);
+      g_value_set_string (&values[8], buf);
+      g_value_set_pointer (&values[9], GUINT_TO_POINTER (i));
+      g_value_set_ulong (&values[11], i);
+
+      gtk_list_store_insert_with_valuesv (store, &iter, -1,
+                                          columns, values, N_LARGE_COLUMNS);
+    }
+
+  elapsed = g_test_timer_elapsed ();
+  after = get_resident_size ();
+
+  if (g_test_perf ())
+    {
+      g_test_minimized_result (elapsed, "filling %u rows with %d columns: %gsec",
+                               n, N_LARGE_COLUMNS, elapsed);
+      if (before && after)
+        g_test_minimized_result ((after - before) / (double) n,
+                                 "memory per row: %g bytes",
+                                 (after - before) / (double) n);
+    }
+
+  g_test_timer_start ();
+
+  for (valid = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter), i = 0;
+       valid;
+       valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter), i++)
+    {
+      for (j = 0; j < N_LARGE_COLUMNS; j++)
+        {
+          gtk_tree_model_get_value (GTK_TREE_MODEL (store), &iter, j, &value);
+          if (j == 0)
+            g_assert_cmpint (g_value_get_int (&value), ==, i);
+          g_value_unset (&value);
+        }
+    }
+  g_assert_cmpuint (i, ==, n);
+
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_maximized_result (n * N_LARGE_COLUMNS / elapsed,
+                             "get_value throughput: %g values/sec",
+                             n * N_LARGE_COLUMNS / elapsed);
+
+  g_object_unref (store);
+  for (j = 0; j < N_LARGE_COLUMNS; j++)
+    g_value_unset (&values[j]);
+  g_object_unref (object);
+}
+
+/* batches */
+/* The store must only contain the rows announced so far */
+static void
+count_row_inserted (GtkTreeModel *model,
+                    GtkTreePath  *path,
+                    GtkTreeIter  *iter,
+                    gpointer      data)
+{
+  GtkTreePath *iter_path;
+  gint *n_rows = data;
+
+  (*n_rows)++;
+  g_assert_cmpint (gtk_tree_model_iter_n_children (model, NULL), ==, *n_rows);
+
+  iter_path = gtk_tree_model_get_path (model, iter);
+  g_assert_cmpint (gtk_tree_path_compare (iter_path, path), ==, 0);
+  gtk_tree_path_free (iter_path);
+}
+
+static void
+check_sorted_ints (GtkListStore *store,
+                   const gint   *expected,
+                   gint          n_expected)
+{
+  GtkTreeIter iter;
+  gboolean valid;
+  gint i, v;
+
+  for (valid = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter), i = 0;
+       valid;
+       valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter), i++)
+    {
+      g_assert_cmpint (i, <, n_expected);
+      gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &v, -1);
+      g_assert_cmpint (v, ==, expected[i]);
+    }
+  g_assert_cmpint (i, ==, n_expected);
+}
+
+static void
+list_store_append_rows (void)
+{
+  static const gint ints[] = { 40, 20, 60, 0, 30 };
+  static const gchar *strs[] = { "d", "b", "f", "a", "new" };
+  static const gint sorted[] = { 0, 10, 20, 30, 30, 40, 50, 60 };
+  static const gint sorted2[] = { 0, 5, 10, 20, 30, 30, 40, 50, 60, 70 };
+  gint columns[2] = { 0, 1 };
+  GValue values[10] = { G_VALUE_INIT, };
+  GtkListStore *store;
+  GtkTreeRowReference *ref;
+  GtkTreePath *path;
+  GtkTreeIter iter, iter2, last;
+  gint n_inserted;
+  gchar *str;
+  gint i;
+
+  store = gtk_list_store_new (2, G_TYPE_INT, G_TYPE_STRING);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store), 0,
+                                        GTK_SORT_ASCENDING);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, 10, -1);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, 30, 1, "old", -1);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, 50, -1);
+
+  path = gtk_tree_path_new_from_indices (1, -1);
+  ref = gtk_tree_row_reference_new (GTK_TREE_MODEL (store), path);
+  gtk_tree_path_free (path);
+
+  /* Column-major values, sorted into the existing rows at once */
+  for (i = 0; i < 5; i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], ints[i]);
+      g_value_init (&values[5 + i], G_TYPE_STRING);
+      g_value_set_static_string (&values[5 + i], strs[i]);
+    }
+  gtk_list_store_append_rows (store, 5, columns, values, 2);
+  check_sorted_ints (store, sorted, G_N_ELEMENTS (sorted));
+
+  /* The existing row stays before the equal new one */
+  path = gtk_tree_row_reference_get_path (ref);
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, 3);
+  gtk_tree_model_get_iter (GTK_TREE_MODEL (store), &iter, path);
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 1, &str, -1);
+  g_assert_cmpstr (str, ==, "old");
+  g_free (str);
+  gtk_tree_path_free (path);
+
+  gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter);
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 2);
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 1, &str, -1);
+  g_assert_cmpstr (str, ==, "b");
+  g_free (str);
+
+  /* Values can be set on rows before they are sorted in, and other
+   * changes announce the pending rows first
+   */
+  gtk_list_store_begin_batch (store);
+  gtk_list_store_append (store, &iter);
+  gtk_list_store_set (store, &iter, 0, 70, -1);
+  gtk_list_store_begin_batch (store);
+  gtk_list_store_append (store, &iter2);
+  gtk_list_store_set (store, &iter2, 0, 5, -1);
+  gtk_list_store_end_batch (store);
+  gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter);
+  gtk_list_store_remove (store, &iter);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, 0, -1);
+  gtk_list_store_end_batch (store);
+  check_sorted_ints (store, sorted2, G_N_ELEMENTS (sorted2));
+
+  /* Pending rows are not part of the model yet */
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &last, NULL, 9);
+  gtk_list_store_begin_batch (store);
+  gtk_list_store_insert_with_values (store, &iter, -1, 0, 80, -1);
+  g_assert (gtk_list_store_iter_is_valid (store, &iter));
+  g_assert (gtk_tree_model_get_path (GTK_TREE_MODEL (store), &iter) == NULL);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (store), NULL), ==, 10);
+  g_assert (!gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter2, NULL, 10));
+  g_assert (!gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &last));
+  gtk_list_store_end_batch (store);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (store), NULL), ==, 11);
+  path = gtk_tree_model_get_path (GTK_TREE_MODEL (store), &iter);
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, 10);
+  gtk_tree_path_free (path);
+
+  /* Other listeners get ::row-inserted for every row, and only
+   * see the rows they were told about
+   */
+  n_inserted = 11;
+  g_signal_connect (store, "row-inserted",
+                    G_CALLBACK (count_row_inserted), &n_inserted);
+  gtk_list_store_append_rows (store, 5, columns, values, 2);
+  g_assert_cmpint (n_inserted, ==, 16);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (store), NULL), ==, 16);
+
+  for (i = 0; i < 10; i++)
+    g_value_unset (&values[i]);
+  gtk_tree_row_reference_free (ref);
+  g_object_unref (store);
+}
+
+static void
+check_reordered_by_index (GtkTreeModel *model,
+                          GtkTreePath  *path,
+                          GtkTreeIter  *iter,
+                          gint         *new_order,
+                          gpointer      data)
+{
+  GtkTreeIter row;
+  gboolean valid;
+  gint i, index;
+
+  for (valid = gtk_tree_model_get_iter_first (model, &row), i = 0;
+       valid;
+       valid = gtk_tree_model_iter_next (model, &row), i++)
+    {
+      gtk_tree_model_get (model, &row, 1, &index, -1);
+      g_assert_cmpint (new_order[i], ==, index);
+    }
+}
+
+static void
+check_sorted_strings (GtkTreeModel *model,
+                      GtkSortType   order)
+{
+  GtkTreeIter iter;
+  gboolean valid;
+  gchar *str, *prev_str = NULL;
+  gint index, prev_index = -1;
+  gint cmp;
+
+  for (valid = gtk_tree_model_get_iter_first (model, &iter);
+       valid;
+       valid = gtk_tree_model_iter_next (model, &iter))
+    {
+      gtk_tree_model_get (model, &iter, 0, &str, 2, &index, -1);
+
+      if (prev_index != -1)
+        {
+          cmp = g_utf8_collate (prev_str ? prev_str : "", str ? str : "");
+          if (order == GTK_SORT_DESCENDING)
+            cmp = -cmp;
+          g_assert_cmpint (cmp, <=, 0);
+          /* equal rows stay in the order they were inserted in */
+          if (cmp == 0)
+            g_assert_cmpint (prev_index, <, index);
+        }
+
+      g_free (prev_str);
+      prev_str = str;
+      prev_index = index;
+    }
+
+  g_free (prev_str);
+}
+
+static void
+list_store_sort_by_column (void)
+{
+  static const gchar *strs[] = { "b", "a", "\xc3\xa9", "e", NULL, "B", "z", "" };
+  guint n_rows = g_test_perf () ? 1000000 : 1000;
+  GtkListStore *store;
+  gulong handler;
+  double elapsed;
+  guint i;
+  gchar *str;
+
+  store = gtk_list_store_new (3, G_TYPE_STRING, G_TYPE_INT, G_TYPE_INT);
+  for (i = 0; i < n_rows; i++)
+    {
+      if (g_test_perf ())
+        str = g_strdup_printf ("%u", g_random_int ());
+      else
+        str = g_strdup (strs[(i * 7) % G_N_ELEMENTS (strs)]);
+      gtk_list_store_insert_with_values (store, NULL, -1, 0, str, 1, i, 2, i, -1);
+      g_free (str);
+    }
+
+  handler = g_signal_connect (store, "rows-reordered",
+                              G_CALLBACK (check_reordered_by_index), NULL);
+
+  g_test_timer_start ();
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store), 0, GTK_SORT_ASCENDING);
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed, "sorting %u rows by a string column: %gsec", n_rows, elapsed);
+
+  g_signal_handler_disconnect (store, handler);
+  check_sorted_strings (GTK_TREE_MODEL (store), GTK_SORT_ASCENDING);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store), 0, GTK_SORT_DESCENDING);
+  check_sorted_strings (GTK_TREE_MODEL (store), GTK_SORT_DESCENDING);
+
+  g_object_unref (store);
+}
+
 /* removal */
 static void
 list_store_test_remove_begin (ListStore     *fixture,
@@ -1037,6 +1463,14 @@ register_list_store_tests (void)
   /* setting values (FIXME) */
   g_test_add_func ("/ListStore/set-gvalue-to-transform",
                    list_store_set_gvalue_to_transform);
+  g_test_add_func ("/ListStore/set-get-values",
+                   list_store_set_get_values);
+  g_test_add_func ("/ListStore/large",
+                   list_store_large);
+  g_test_add_func ("/ListStore/append-rows",
+                   list_store_append_rows);
+  g_test_add_func ("/ListStore/sort-by-column",
+                   list_store_sort_by_column);
 
   /* removal */
   g_test_add ("/ListStore/remove-begin", ListStore, NULL,
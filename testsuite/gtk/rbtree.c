@@ -428,6 +428,212 @@ test_remove_root (void)
   _gtk_rbtree_free (tree);
 }
 
+static void
+test_insert_many (void)
+{
+  GtkRBTree *tree;
+  GtkRBNode *node, *first;
+  gint indices[50];
+  guint i, n;
+
+  tree = _gtk_rbtree_new ();
+
+  /* into an empty tree */
+  for (i = 0; i < 10; i++)
+    indices[i] = i;
+  _gtk_rbtree_insert_many (tree, indices, 10, 1, TRUE);
+  _gtk_rbtree_test (tree);
+  g_assert (tree->root->count == 10);
+  g_assert (tree->root->offset == 10);
+
+  first = _gtk_rbtree_first (tree);
+  GTK_RBNODE_SET_FLAG (first, GTK_RBNODE_IS_SELECTED);
+
+  /* scattered, the existing nodes end up at every 6th position */
+  for (i = 0, n = 0; i < 60; i++)
+    {
+      if (i % 6 != 0)
+        indices[n++] = i;
+    }
+  _gtk_rbtree_insert_many (tree, indices, 50, 2, FALSE);
+  _gtk_rbtree_test (tree);
+  g_assert (tree->root->count == 60);
+  g_assert (tree->root->offset == 10 + 50 * 2);
+  g_assert (GTK_RBNODE_FLAG_SET (tree->root, GTK_RBNODE_DESCENDANTS_INVALID));
+  g_assert (_gtk_rbtree_first (tree) == first);
+  g_assert (GTK_RBNODE_FLAG_SET (first, GTK_RBNODE_IS_SELECTED));
+
+  for (node = _gtk_rbtree_first (tree), i = 0, n = 0;
+       node != NULL;
+       node = _gtk_rbtree_next (tree, node), i++)
+    {
+      if (n < 50 && indices[n] == i)
+        {
+          g_assert (GTK_RBNODE_GET_HEIGHT (node) == 2);
+          g_assert (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_INVALID));
+          n++;
+        }
+      else
+        g_assert (GTK_RBNODE_GET_HEIGHT (node) == 1);
+    }
+
+  _gtk_rbtree_free (tree);
+}
+
+static void
+test_insert_many_children (void)
+{
+  GtkRBTree *tree;
+  GtkRBNode *node;
+  gint indices[5] = { 0, 2, 4, 6, 8 };
+
+  tree = create_rbtree (3, 4, FALSE);
+  node = _gtk_rbtree_find_count (tree, 2);
+  g_assert (node->children != NULL);
+
+  _gtk_rbtree_insert_many (node->children, indices, 5, 3, TRUE);
+  _gtk_rbtree_test (tree);
+  g_assert (node->children->root->count == 9);
+
+  _gtk_rbtree_free (tree);
+}
+
+static void
+test_build (void)
+{
+  guint n = g_test_perf () ? 1000000 : 1000;
+  GtkRBTree *tree;
+  GtkRBNode *node;
+  double elapsed;
+  guint i;
+
+  tree = _gtk_rbtree_new ();
+
+  g_test_timer_start ();
+
+  _gtk_rbtree_insert_many (tree, NULL, n, 2, TRUE);
+
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed, "building rbtree with %u items: %gsec", n, elapsed);
+
+  _gtk_rbtree_test (tree);
+  g_assert (tree->root->count == n);
+  g_assert (tree->root->offset == 2 * n);
+  g_assert (!GTK_RBNODE_FLAG_SET (tree->root, GTK_RBNODE_DESCENDANTS_INVALID));
+
+  /* appending to a tree that has children */
+  node = _gtk_rbtree_find_count (tree, n / 2);
+  node->children = _gtk_rbtree_new ();
+  node->children->parent_tree = tree;
+  node->children->parent_node = node;
+  _gtk_rbtree_insert_many (node->children, NULL, 10, 1, FALSE);
+  _gtk_rbtree_insert_many (tree, NULL, 10, 2, FALSE);
+  _gtk_rbtree_test (tree);
+  g_assert (tree->root->count == n + 10);
+  g_assert (tree->root->total_count == n + 20);
+  g_assert (tree->root->offset == 2 * n + 10 + 20);
+  g_assert (GTK_RBNODE_FLAG_SET (tree->root, GTK_RBNODE_DESCENDANTS_INVALID));
+  g_assert (_gtk_rbtree_find_count (tree, n / 2) == node);
+
+  _gtk_rbtree_free (tree);
+
+  if (g_test_perf ())
+    {
+      tree = _gtk_rbtree_new ();
+      node = NULL;
+
+      g_test_timer_start ();
+
+      for (i = 0; i < n; i++)
+        node = _gtk_rbtree_insert_after (tree, node, 2, TRUE);
+
+      elapsed = g_test_timer_elapsed ();
+      g_test_minimized_result (elapsed, "inserting %u items one by one: %gsec", n, elapsed);
+
+      _gtk_rbtree_free (tree);
+    }
+}
+
+/* What a tree view of 2M rows does when scrolling and when
+ * converting between paths and nodes.
+ */
+static void
+test_lookup (void)
+{
+  guint n = g_test_perf () ? 2000000 : 2000;
+  guint n_lookups = g_test_perf () ? 1000000 : 1000;
+  gint row_height = 20;
+  gint page_size = 50 * row_height;
+  GtkRBTree *tree, *new_tree;
+  GtkRBNode *node, *new_node;
+  double elapsed;
+  guint i, j, index;
+  gint offset;
+
+  tree = _gtk_rbtree_new ();
+  node = NULL;
+
+  /* One by one, like a view listening to ::row-inserted */
+  g_test_timer_start ();
+
+  for (i = 0; i < n; i++)
+    node = _gtk_rbtree_insert_after (tree, node, row_height, TRUE);
+
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed, "inserting %u rows: %gsec", n, elapsed);
+
+  /* Scrolling: find the row at the top of each page and walk
+   * the rows that are visible on it
+   */
+  g_test_timer_start ();
+
+  for (offset = 0, i = 0; offset < (gint) n * row_height; offset += page_size)
+    {
+      gint y = _gtk_rbtree_find_offset (tree, offset + row_height / 2,
+                                        &new_tree, &new_node);
+
+      g_assert (new_node != NULL);
+      g_assert (y == row_height / 2);
+
+      for (j = 0; j < 50 && new_node; j++, i++)
+        new_node = _gtk_rbtree_next (new_tree, new_node);
+    }
+  g_assert (i == n);
+
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed, "scrolling through %u rows by pages: %gsec",
+                             n, elapsed);
+
+  /* Paths to nodes and back */
+  g_test_timer_start ();
+
+  for (i = 0; i < n_lookups; i++)
+    {
+      index = (i * 7919u) % n;
+
+      node = _gtk_rbtree_find_count (tree, index + 1);
+      g_assert (_gtk_rbtree_node_get_index (tree, node) == index);
+      g_assert (_gtk_rbtree_node_find_offset (tree, node) == (gint) index * row_height);
+    }
+
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_maximized_result (n_lookups / elapsed,
+                             "path lookups in %u rows: %g lookups/sec",
+                             n, n_lookups / elapsed);
+
+  g_test_timer_start ();
+
+  _gtk_rbtree_free (tree);
+
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed, "freeing %u rows: %gsec", n, elapsed);
+}
+
 static gint *
 fisher_yates_shuffle (guint n_items)
 {
@@ -507,6 +713,73 @@ test_reorder (void)
   _gtk_rbtree_free (tree);
 }
 
+/* What fixed height mode and the height estimate do to a tree
+ * whose rows have not been measured yet.
+ */
+static void
+test_fixed_height (void)
+{
+  guint n = g_test_perf () ? 10000000 : 1000;
+  GtkRBTree *tree;
+  GtkRBNode *node, *child;
+  double elapsed;
+
+  tree = _gtk_rbtree_new ();
+  _gtk_rbtree_insert_many (tree, NULL, n, 0, FALSE);
+
+  /* a measured row keeps its height */
+  node = _gtk_rbtree_find_count (tree, 1);
+  _gtk_rbtree_node_set_height (tree, node, 30);
+  _gtk_rbtree_node_mark_valid (tree, node);
+
+  /* and so do the invalid rows of an expanded one, which get
+   * estimated like the others */
+  node = _gtk_rbtree_find_count (tree, n / 2);
+  node->children = _gtk_rbtree_new ();
+  node->children->parent_tree = tree;
+  node->children->parent_node = node;
+  _gtk_rbtree_insert_many (node->children, NULL, 10, 0, FALSE);
+  child = _gtk_rbtree_first (node->children);
+  _gtk_rbtree_node_set_height (node->children, child, 5);
+  _gtk_rbtree_node_mark_valid (node->children, child);
+  _gtk_rbtree_test (tree);
+
+  g_test_timer_start ();
+
+  _gtk_rbtree_set_fixed_height (tree, 20, FALSE);
+
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed, "estimating heights of %u rows: %gsec", n, elapsed);
+
+  _gtk_rbtree_test (tree);
+  g_assert (tree->root->offset == 30 + 20 * (n - 1) + 5 + 20 * 9);
+  g_assert (GTK_RBNODE_FLAG_SET (tree->root, GTK_RBNODE_DESCENDANTS_INVALID));
+  g_assert (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_INVALID));
+
+  g_test_timer_start ();
+
+  _gtk_rbtree_set_fixed_height (tree, 20, TRUE);
+
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed, "setting fixed height of %u rows: %gsec", n, elapsed);
+
+  _gtk_rbtree_test (tree);
+  g_assert (tree->root->offset == 30 + 20 * (n - 1) + 5 + 20 * 9);
+  g_assert (!GTK_RBNODE_FLAG_SET (tree->root, GTK_RBNODE_DESCENDANTS_INVALID));
+  g_assert (!GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_INVALID));
+
+  /* setting it on a child tree updates the parents */
+  _gtk_rbtree_node_mark_invalid (node->children, _gtk_rbtree_first (node->children));
+  _gtk_rbtree_set_fixed_height (node->children, 10, TRUE);
+  _gtk_rbtree_test (tree);
+  g_assert (tree->root->offset == 30 + 20 * (n - 1) + 10 + 20 * 9);
+  g_assert (!GTK_RBNODE_FLAG_SET (tree->root, GTK_RBNODE_DESCENDANTS_INVALID));
+
+  _gtk_rbtree_free (tree);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -519,7 +792,12 @@ main (int argc, char *argv[])
   g_test_add_func ("/rbtree/insert_before", test_insert_before);
   g_test_add_func ("/rbtree/remove_node", test_remove_node);
   g_test_add_func ("/rbtree/remove_root", test_remove_root);
+  g_test_add_func ("/rbtree/insert_many", test_insert_many);
+  g_test_add_func ("/rbtree/insert_many_children", test_insert_many_children);
+  g_test_add_func ("/rbtree/build", test_build);
   g_test_add_func ("/rbtree/reorder", test_reorder);
+  g_test_add_func ("/rbtree/lookup", test_lookup);
+  g_test_add_func ("/rbtree/fixed_height", test_fixed_height);
 
   return g_test_run ();
 }
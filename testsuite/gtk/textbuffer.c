@@ -22,6 +22,8 @@
 
 #include <gtk/gtk.h>
 #include "gtk/gtktexttypes.h" /* Private header, for UNKNOWN_CHAR */
+#define GTK_TEXT_USE_INTERNAL_UNSUPPORTED_API
+#include "gtk/gtktextlayout.h" /* Private header, to watch redisplays */
 
 static void
 gtk_text_iter_spew (const GtkTextIter *iter, const gchar *desc)
@@ -1325,6 +1327,773 @@ test_fill_empty (void)
   g_object_unref (buffer);
 }
 
+static void
+test_large_insert (void)
+{
+  /* Lines with multibyte characters and all kinds of separators */
+  const gchar *lines[] = {
+    "The quick brown fox jumps over the lazy dog\n",
+    "Gr\303\274\303\237e aus K\303\266ln\r\n",
+    "\342\202\254 \360\237\230\200\r",
+    "paragraph separator\342\200\251",
+    "\n"
+  };
+  gint n_lines = g_test_perf () ? 1000000 : 10000;
+  GtkTextBuffer *buffer;
+  GtkTextIter iter, end;
+  guint flags;
+  GString *text;
+  gint n_chars;
+  gdouble elapsed;
+  gchar *str;
+  gint i;
+
+  text = g_string_new (NULL);
+  n_chars = 0;
+  for (i = 0; i < n_lines; i++)
+    {
+      g_string_append (text, lines[i % G_N_ELEMENTS (lines)]);
+      n_chars += g_utf8_strlen (lines[i % G_N_ELEMENTS (lines)], -1);
+    }
+
+  buffer = gtk_text_buffer_new (NULL);
+
+  /* Don't time the consistency checks */
+  flags = gtk_get_debug_flags ();
+  if (g_test_perf ())
+    gtk_set_debug_flags (flags & ~GTK_DEBUG_TEXT);
+
+  g_test_timer_start ();
+  gtk_text_buffer_set_text (buffer, text->str, text->len);
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed, "inserting %" G_GSIZE_FORMAT " bytes: %gsec",
+                             text->len, elapsed);
+
+  gtk_set_debug_flags (flags);
+
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), ==, n_lines + 1);
+  g_assert_cmpint (gtk_text_buffer_get_char_count (buffer), ==, n_chars);
+
+  for (i = 0; i < n_lines; i += n_lines / 7)
+    {
+      gtk_text_buffer_get_iter_at_line (buffer, &iter, i);
+      end = iter;
+      gtk_text_iter_forward_line (&end);
+      str = gtk_text_iter_get_text (&iter, &end);
+      g_assert_cmpstr (str, ==, lines[i % G_N_ELEMENTS (lines)]);
+      g_free (str);
+    }
+
+  gtk_text_buffer_get_end_iter (buffer, &iter);
+  g_assert_cmpint (gtk_text_iter_get_offset (&iter), ==, n_chars);
+  g_assert_cmpint (gtk_text_iter_get_line (&iter), ==, n_lines);
+
+  g_string_free (text, TRUE);
+  g_object_unref (buffer);
+}
+
+static gint
+count_toggles (GtkTextBuffer *buffer,
+               GtkTextTag    *tag)
+{
+  GtkTextIter iter;
+  gint n_toggles;
+
+  n_toggles = 0;
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  while (gtk_text_iter_forward_to_tag_toggle (&iter, tag))
+    n_toggles++;
+
+  return n_toggles;
+}
+
+static void
+test_apply_tag_to_matches (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextTag *tag;
+  GtkTextTag *tag2;
+  GtkTextIter iter, start, end;
+  GString *text;
+  gint n_calls;
+  gint i;
+
+  text = g_string_new (NULL);
+  for (i = 0; i < 100; i++)
+    g_string_append (text, "foo bar foo\n");
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, text->str, -1);
+  tag = gtk_text_buffer_create_tag (buffer, NULL, NULL);
+  tag2 = gtk_text_buffer_create_tag (buffer, NULL, NULL);
+
+  /* All at once */
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  g_assert (!gtk_text_buffer_apply_tag_to_matches (buffer, tag, "bar", 0, &iter, NULL, -1));
+  g_assert (gtk_text_iter_is_end (&iter));
+  g_assert_cmpint (count_toggles (buffer, tag), ==, 2 * 100);
+
+  /* In chunks of a few lines */
+  n_calls = 0;
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  while (gtk_text_buffer_apply_tag_to_matches (buffer, tag2, "foo", 0, &iter, NULL, 7))
+    n_calls++;
+  g_assert_cmpint (n_calls, ==, 100 / 7);
+  g_assert_cmpint (count_toggles (buffer, tag2), ==, 2 * 200);
+
+  /* Matches that cross the ends of the chunks */
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  gtk_text_buffer_remove_all_tags (buffer, &start, &end);
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  while (gtk_text_buffer_apply_tag_to_matches (buffer, tag, "foo\nfoo", 0, &iter, NULL, 7))
+    ;
+  g_assert_cmpint (count_toggles (buffer, tag), ==, 2 * 99);
+
+  g_string_free (text, TRUE);
+  g_object_unref (buffer);
+}
+
+/* A tiny highlighter for the C-like text below. The text is ASCII,
+ * so byte offsets are character offsets.
+ */
+static void
+highlight_c (const gchar  *text,
+             GtkTextTag  **tags,
+             GArray       *span_tags,
+             GArray       *offsets)
+{
+  const gchar *keywords[] = { "static", "void", "int", "const", "char", "return", "if", "for" };
+  const gchar *p = text;
+  const gchar *start;
+  GtkTextTag *tag;
+  gint offset;
+  gint i;
+
+  while (*p)
+    {
+      start = p;
+      tag = NULL;
+
+      if (p[0] == '/' && p[1] == '*')
+        {
+          p = strstr (p, "*/") + 2;
+          tag = tags[0];
+        }
+      else if (*p == '"')
+        {
+          p = strchr (p + 1, '"') + 1;
+          tag = tags[1];
+        }
+      else if (g_ascii_isdigit (*p))
+        {
+          while (g_ascii_isdigit (*p))
+            p++;
+          tag = tags[2];
+        }
+      else if (g_ascii_isalpha (*p) || *p == '_')
+        {
+          while (g_ascii_isalnum (*p) || *p == '_')
+            p++;
+          for (i = 0; i < G_N_ELEMENTS (keywords); i++)
+            if (strlen (keywords[i]) == (gsize) (p - start) &&
+                strncmp (start, keywords[i], p - start) == 0)
+              tag = tags[3];
+        }
+      else
+        p++;
+
+      if (tag)
+        {
+          g_array_append_val (span_tags, tag);
+          offset = start - text;
+          g_array_append_val (offsets, offset);
+          offset = p - text;
+          g_array_append_val (offsets, offset);
+        }
+    }
+}
+
+static void
+create_highlight_tags (GtkTextBuffer  *buffer,
+                       GtkTextTag    **tags)
+{
+  tags[0] = gtk_text_buffer_create_tag (buffer, "comment", "foreground", "gray", NULL);
+  tags[1] = gtk_text_buffer_create_tag (buffer, "string", "foreground", "red", NULL);
+  tags[2] = gtk_text_buffer_create_tag (buffer, "number", "foreground", "blue", NULL);
+  tags[3] = gtk_text_buffer_create_tag (buffer, "keyword", "weight", PANGO_WEIGHT_BOLD, NULL);
+}
+
+static GtkTextBuffer *
+create_highlighted_buffer (const gchar  *text,
+                           GtkTextTag  **tags,
+                           GtkWidget   **window)
+{
+  GtkTextBuffer *buffer;
+  GtkWidget *view;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, text, -1);
+  create_highlight_tags (buffer, tags);
+
+  /* Put the buffer in a view, so that tagging has a layout to
+   * invalidate.
+   */
+  *window = gtk_offscreen_window_new ();
+  view = gtk_text_view_new_with_buffer (buffer);
+  gtk_container_add (GTK_CONTAINER (*window), view);
+  gtk_widget_show_all (*window);
+
+  return buffer;
+}
+
+typedef struct {
+  gint invalidated;
+  gint changed;
+} RedisplayCount;
+
+static void
+count_invalidated (GtkTextLayout  *layout,
+                   RedisplayCount *count)
+{
+  count->invalidated++;
+}
+
+static void
+count_changed (GtkTextLayout  *layout,
+               gint            y,
+               gint            old_height,
+               gint            new_height,
+               RedisplayCount *count)
+{
+  count->changed++;
+}
+
+/* Adds a second view to @buffer that only counts how often the
+ * buffer asks it to relayout or redraw.
+ */
+static GtkTextLayout *
+watch_redisplays (GtkTextBuffer  *buffer,
+                  RedisplayCount *count)
+{
+  GtkTextLayout *layout;
+
+  layout = gtk_text_layout_new ();
+  gtk_text_layout_set_buffer (layout, buffer);
+  g_signal_connect (layout, "invalidated", G_CALLBACK (count_invalidated), count);
+  g_signal_connect (layout, "changed", G_CALLBACK (count_changed), count);
+
+  return layout;
+}
+
+static void
+unwatch_redisplays (GtkTextLayout *layout)
+{
+  gtk_text_layout_set_buffer (layout, NULL);
+  g_object_unref (layout);
+}
+
+static void
+test_apply_tags (void)
+{
+  const gchar *lines[] = {
+    "/* Returns the sum of the first n numbers */\n",
+    "static int\n",
+    "sum (int n)\n",
+    "{\n",
+    "  int i, total = 0;\n",
+    "  for (i = 0; i < n; i++)\n",
+    "    total += i * 42;\n",
+    "  if (total > 1000)\n",
+    "    g_print (\"big: %d\\n\", total);\n",
+    "  return total;\n",
+    "}\n",
+    "\n"
+  };
+  gint n_lines = g_test_perf () ? 20000 : 2000;
+  GtkTextBuffer *buffer, *batch_buffer;
+  GtkTextTag *tags[4], *batch_tags[4];
+  GtkWidget *window, *batch_window;
+  GtkTextLayout *layout, *batch_layout;
+  RedisplayCount count = { 0, 0 };
+  RedisplayCount batch_count = { 0, 0 };
+  GArray *span_tags, *batch_span_tags;
+  GArray *offsets;
+  GtkTextIter start, end, iter, batch_iter;
+  GString *text;
+  gdouble elapsed;
+  guint flags;
+  guint i;
+
+  text = g_string_new (NULL);
+  for (i = 0; i < n_lines; i++)
+    g_string_append (text, lines[i % G_N_ELEMENTS (lines)]);
+
+  buffer = create_highlighted_buffer (text->str, tags, &window);
+  batch_buffer = create_highlighted_buffer (text->str, batch_tags, &batch_window);
+
+  span_tags = g_array_new (FALSE, FALSE, sizeof (GtkTextTag *));
+  batch_span_tags = g_array_new (FALSE, FALSE, sizeof (GtkTextTag *));
+  offsets = g_array_new (FALSE, FALSE, sizeof (gint));
+  highlight_c (text->str, tags, span_tags, offsets);
+  g_array_set_size (offsets, 0);
+  highlight_c (text->str, batch_tags, batch_span_tags, offsets);
+
+  layout = watch_redisplays (buffer, &count);
+  batch_layout = watch_redisplays (batch_buffer, &batch_count);
+
+  flags = gtk_get_debug_flags ();
+  if (g_test_perf ())
+    gtk_set_debug_flags (flags & ~GTK_DEBUG_TEXT);
+
+  g_test_timer_start ();
+  for (i = 0; i < span_tags->len; i++)
+    {
+      gtk_text_buffer_get_iter_at_offset (buffer, &start, g_array_index (offsets, gint, 2 * i));
+      gtk_text_buffer_get_iter_at_offset (buffer, &end, g_array_index (offsets, gint, 2 * i + 1));
+      gtk_text_buffer_apply_tag (buffer, g_array_index (span_tags, GtkTextTag *, i), &start, &end);
+    }
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed, "applying %u tags one by one: %gsec",
+                             span_tags->len, elapsed);
+
+  g_test_timer_start ();
+  gtk_text_buffer_apply_tags (batch_buffer,
+                              (GtkTextTag **) batch_span_tags->data,
+                              (const gint *) offsets->data,
+                              batch_span_tags->len);
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed, "applying %u tags in a batch: %gsec",
+                             batch_span_tags->len, elapsed);
+
+  gtk_set_debug_flags (flags);
+
+  /* The keywords change the size of the text and the other tags only
+   * its colors, so the batch relays out once and redraws once, where
+   * applying the tags one by one does so for every span.
+   */
+  g_assert_cmpint (batch_count.invalidated, ==, 1);
+  g_assert_cmpint (batch_count.changed, ==, 1);
+  g_assert_cmpint (count.invalidated, >, 1);
+  g_assert_cmpint (count.changed, >, 1);
+
+  unwatch_redisplays (layout);
+  unwatch_redisplays (batch_layout);
+
+  /* Both buffers end up with the same toggles */
+  for (i = 0; i < G_N_ELEMENTS (tags); i++)
+    {
+      g_assert_cmpint (count_toggles (buffer, tags[i]), >, 0);
+      gtk_text_buffer_get_start_iter (buffer, &iter);
+      gtk_text_buffer_get_start_iter (batch_buffer, &batch_iter);
+      while (gtk_text_iter_forward_to_tag_toggle (&iter, tags[i]))
+        {
+          g_assert (gtk_text_iter_forward_to_tag_toggle (&batch_iter, batch_tags[i]));
+          g_assert_cmpint (gtk_text_iter_get_offset (&iter), ==,
+                           gtk_text_iter_get_offset (&batch_iter));
+        }
+      g_assert (!gtk_text_iter_forward_to_tag_toggle (&batch_iter, batch_tags[i]));
+    }
+
+  g_array_free (span_tags, TRUE);
+  g_array_free (batch_span_tags, TRUE);
+  g_array_free (offsets, TRUE);
+  g_string_free (text, TRUE);
+  gtk_widget_destroy (window);
+  gtk_widget_destroy (batch_window);
+  g_object_unref (buffer);
+  g_object_unref (batch_buffer);
+}
+
+/* Overlapping spans, spans given backwards and empty spans */
+static void
+test_apply_tags_spans (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextTag *tag;
+  GtkTextTag *span[4];
+  gint span_offsets[8] = { 30, 10, 20, 40, 50, 50, 60, -1 };
+  GtkTextIter iter;
+  gint i;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer,
+                            "0123456789012345678901234567890123456789"
+                            "0123456789012345678901234567890123456789", -1);
+  tag = gtk_text_buffer_create_tag (buffer, "string", "foreground", "red", NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (span); i++)
+    span[i] = tag;
+  gtk_text_buffer_apply_tags (buffer, span, span_offsets, G_N_ELEMENTS (span));
+
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  g_assert (gtk_text_iter_forward_to_tag_toggle (&iter, tag));
+  g_assert_cmpint (gtk_text_iter_get_offset (&iter), ==, 10);
+  g_assert (gtk_text_iter_forward_to_tag_toggle (&iter, tag));
+  g_assert_cmpint (gtk_text_iter_get_offset (&iter), ==, 40);
+  g_assert (gtk_text_iter_forward_to_tag_toggle (&iter, tag));
+  g_assert_cmpint (gtk_text_iter_get_offset (&iter), ==, 60);
+
+  gtk_text_buffer_get_end_iter (buffer, &iter);
+  gtk_text_iter_backward_char (&iter);
+  g_assert (gtk_text_iter_has_tag (&iter, tag));
+
+  g_object_unref (buffer);
+}
+
+static void
+insert_before_tag (GtkTextBuffer *buffer,
+                   GtkTextTag    *tag,
+                   GtkTextIter   *start,
+                   GtkTextIter   *end,
+                   gpointer       data)
+{
+  GtkTextIter iter;
+
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  gtk_text_buffer_insert (buffer, &iter, "x", 1);
+}
+
+static gint
+count_marks (GtkTextBuffer *buffer)
+{
+  GtkTextIter iter;
+  GSList *marks;
+  gint count = 0;
+
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  do
+    {
+      marks = gtk_text_iter_get_marks (&iter);
+      count += g_slist_length (marks);
+      g_slist_free (marks);
+    }
+  while (gtk_text_iter_forward_char (&iter));
+
+  marks = gtk_text_iter_get_marks (&iter);
+  count += g_slist_length (marks);
+  g_slist_free (marks);
+
+  return count;
+}
+
+/* Handlers that edit the buffer while a batch of tags is applied */
+static void
+test_apply_tags_edit (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextTag *tags[4];
+  GtkTextTag *span[2];
+  gint span_offsets[4] = { 10, 20, 30, 40 };
+  GtkWidget *window;
+  GtkTextIter iter;
+  gint n_marks;
+
+  buffer = create_highlighted_buffer ("0123456789012345678901234567890123456789\n"
+                                      "0123456789012345678901234567890123456789\n",
+                                      tags, &window);
+  n_marks = count_marks (buffer);
+
+  g_signal_connect_after (buffer, "apply-tag", G_CALLBACK (insert_before_tag), NULL);
+  span[0] = tags[3];
+  span[1] = tags[0];
+  gtk_text_buffer_apply_tags (buffer, span, span_offsets, G_N_ELEMENTS (span));
+
+  /* Spans are applied in the order of tag priority, at the offsets
+   * given. The comment is applied first, and both spans are then
+   * moved by the insertions that follow them.
+   */
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, 10);
+  g_assert (!gtk_text_iter_has_tag (&iter, tags[3]));
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, 11);
+  g_assert (gtk_text_iter_has_tag (&iter, tags[3]));
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, 30);
+  g_assert (!gtk_text_iter_has_tag (&iter, tags[0]));
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, 31);
+  g_assert (gtk_text_iter_has_tag (&iter, tags[0]));
+  g_assert_cmpint (gtk_text_buffer_get_char_count (buffer), ==, 84);
+
+  /* Nothing is left of the pending redisplay */
+  g_assert_cmpint (count_marks (buffer), ==, n_marks);
+
+  gtk_widget_destroy (window);
+  g_object_unref (buffer);
+}
+
+static void
+got_async_result (GObject      *source,
+                  GAsyncResult *result,
+                  gpointer      data)
+{
+  GAsyncResult **result_out = data;
+
+  *result_out = g_object_ref (result);
+}
+
+static GAsyncResult *
+wait_for_async_result (GAsyncResult **result)
+{
+  while (*result == NULL)
+    g_main_context_iteration (NULL, TRUE);
+
+  return *result;
+}
+
+static void
+test_stream_serialize (void)
+{
+  const gchar *lines[] = {
+    "/* Returns the sum of the first n numbers */\n",
+    "static int\n",
+    "sum (int n)\n",
+    "{\n",
+    "  int i, total = 0;\n",
+    "  for (i = 0; i < n; i++)\n",
+    "    total += i * 42;\n",
+    "  if (total > 1000)\n",
+    "    g_print (\"big: %d\\n\", total);\n",
+    "  return total;\n",
+    "}\n",
+    "\n"
+  };
+  gsize size = g_test_perf () ? 50 * 1024 * 1024 : 256 * 1024;
+  GtkTextBuffer *buffer, *copy;
+  GtkTextTag *tags[4], *copy_tags[4];
+  GArray *span_tags, *offsets;
+  GtkTextIter start, end, iter, copy_iter;
+  GdkPixbuf *pixbuf;
+  GOutputStream *out;
+  GInputStream *in;
+  GAsyncResult *result;
+  GError *error = NULL;
+  GdkAtom format;
+  GString *text;
+  guint8 *data;
+  gsize length;
+  gchar *str, *copy_str;
+  gdouble elapsed;
+  guint flags;
+  guint i;
+
+  text = g_string_new (NULL);
+  for (i = 0; text->len < size; i++)
+    g_string_append (text, lines[i % G_N_ELEMENTS (lines)]);
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, text->str, text->len);
+  create_highlight_tags (buffer, tags);
+  span_tags = g_array_new (FALSE, FALSE, sizeof (GtkTextTag *));
+  offsets = g_array_new (FALSE, FALSE, sizeof (gint));
+  highlight_c (text->str, tags, span_tags, offsets);
+  gtk_text_buffer_apply_tags (buffer,
+                              (GtkTextTag **) span_tags->data,
+                              (const gint *) offsets->data,
+                              span_tags->len);
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 16, 16);
+  gdk_pixbuf_fill (pixbuf, 0xff0000ff);
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, 1000);
+  gtk_text_buffer_insert_pixbuf (buffer, &iter, pixbuf);
+
+  format = gtk_text_buffer_register_serialize_tagset (buffer, NULL);
+
+  flags = gtk_get_debug_flags ();
+  if (g_test_perf ())
+    gtk_set_debug_flags (flags & ~GTK_DEBUG_TEXT);
+
+  /* The stream contains what gtk_text_buffer_serialize() returns */
+  out = g_memory_output_stream_new_resizable ();
+  result = NULL;
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  g_test_timer_start ();
+  gtk_text_buffer_serialize_to_stream_async (buffer, buffer, format, &start, &end,
+                                             out, G_PRIORITY_DEFAULT, NULL,
+                                             got_async_result, &result);
+  g_assert (gtk_text_buffer_serialize_to_stream_finish (buffer,
+                                                        wait_for_async_result (&result),
+                                                        &error));
+  g_assert_no_error (error);
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed, "serializing %" G_GSIZE_FORMAT " bytes to a stream: %gsec",
+                             text->len, elapsed);
+  g_object_unref (result);
+  g_output_stream_close (out, NULL, NULL);
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  data = gtk_text_buffer_serialize (buffer, buffer, format, &start, &end, &length);
+  g_assert_cmpuint (g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (out)), ==, length);
+  g_assert (memcmp (g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (out)), data, length) == 0);
+
+  /* Reading it back gives the same text and tags */
+  copy = gtk_text_buffer_new (NULL);
+  create_highlight_tags (copy, copy_tags);
+  format = gtk_text_buffer_register_deserialize_tagset (copy, NULL);
+  in = g_memory_input_stream_new_from_data (data, length, g_free);
+  result = NULL;
+  gtk_text_buffer_get_start_iter (copy, &iter);
+  g_test_timer_start ();
+  gtk_text_buffer_deserialize_from_stream_async (copy, copy, format, &iter,
+                                                 in, G_PRIORITY_DEFAULT, NULL,
+                                                 got_async_result, &result);
+  g_assert (gtk_text_buffer_deserialize_from_stream_finish (copy,
+                                                            wait_for_async_result (&result),
+                                                            &error));
+  g_assert_no_error (error);
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed, "deserializing %" G_GSIZE_FORMAT " bytes from a stream: %gsec",
+                             length, elapsed);
+  g_object_unref (result);
+
+  gtk_set_debug_flags (flags);
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  str = gtk_text_buffer_get_slice (buffer, &start, &end, TRUE);
+  gtk_text_buffer_get_bounds (copy, &start, &end);
+  copy_str = gtk_text_buffer_get_slice (copy, &start, &end, TRUE);
+  g_assert_cmpstr (str, ==, copy_str);
+  g_free (str);
+  g_free (copy_str);
+
+  gtk_text_buffer_get_iter_at_offset (copy, &iter, 1000);
+  g_assert (gtk_text_iter_get_pixbuf (&iter) != NULL);
+  g_assert_cmpint (gdk_pixbuf_get_width (gtk_text_iter_get_pixbuf (&iter)), ==, 16);
+
+  for (i = 0; i < G_N_ELEMENTS (tags); i++)
+    {
+      gtk_text_buffer_get_start_iter (buffer, &iter);
+      gtk_text_buffer_get_start_iter (copy, &copy_iter);
+      while (gtk_text_iter_forward_to_tag_toggle (&iter, tags[i]))
+        {
+          g_assert (gtk_text_iter_forward_to_tag_toggle (&copy_iter, copy_tags[i]));
+          g_assert_cmpint (gtk_text_iter_get_offset (&iter), ==,
+                           gtk_text_iter_get_offset (&copy_iter));
+        }
+      g_assert (!gtk_text_iter_forward_to_tag_toggle (&copy_iter, copy_tags[i]));
+    }
+
+  /* Changing the buffer while it is written out is an error */
+  g_object_unref (out);
+  out = g_memory_output_stream_new_resizable ();
+  result = NULL;
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  gtk_text_buffer_serialize_to_stream_async (buffer, buffer, format, &start, &end,
+                                             out, G_PRIORITY_DEFAULT, NULL,
+                                             got_async_result, &result);
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  gtk_text_buffer_insert (buffer, &iter, "x", 1);
+  g_assert (!gtk_text_buffer_serialize_to_stream_finish (buffer,
+                                                         wait_for_async_result (&result),
+                                                         &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_FAILED);
+  g_clear_error (&error);
+  g_object_unref (result);
+
+  g_object_unref (out);
+  g_object_unref (in);
+  g_object_unref (pixbuf);
+  g_array_free (span_tags, TRUE);
+  g_array_free (offsets, TRUE);
+  g_string_free (text, TRUE);
+  g_object_unref (buffer);
+  g_object_unref (copy);
+}
+
+static void
+check_tags_at_offset (GtkTextBuffer  *buffer,
+                      GtkTextTag    **tags,
+                      gint            n_tags,
+                      gint            offset)
+{
+  GtkTextIter iter;
+  GSList *list, *l;
+  gint i;
+
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, offset);
+  list = gtk_text_iter_get_tags (&iter);
+
+  /* Tag i covers [10 * i, 10 * i + 200) and the list is sorted by
+   * priority, which is the order the tags were created in.
+   */
+  l = list;
+  for (i = 0; i < n_tags; i++)
+    {
+      if (offset < 10 * i || offset >= 10 * i + 200)
+        continue;
+
+      g_assert (l != NULL);
+      g_assert (l->data == tags[i]);
+      g_assert (gtk_text_iter_has_tag (&iter, tags[i]));
+      l = l->next;
+    }
+  g_assert (l == NULL);
+
+  g_slist_free (list);
+}
+
+static void
+test_many_tags (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextTag *tags[100];
+  GtkTextIter start, end, iter;
+  GString *text;
+  gint i;
+
+  text = g_string_new (NULL);
+  for (i = 0; i < 200; i++)
+    g_string_append (text, "0123456789\n");
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, text->str, -1);
+
+  /* More tags than bits in the node tag masks */
+  for (i = 0; i < G_N_ELEMENTS (tags); i++)
+    {
+      tags[i] = gtk_text_buffer_create_tag (buffer, NULL, NULL);
+      gtk_text_buffer_get_iter_at_offset (buffer, &start, 10 * i);
+      gtk_text_buffer_get_iter_at_offset (buffer, &end, 10 * i + 200);
+      gtk_text_buffer_apply_tag (buffer, tags[i], &start, &end);
+    }
+
+  for (i = 0; i < 1200; i += 7)
+    check_tags_at_offset (buffer, tags, G_N_ELEMENTS (tags), i);
+
+  for (i = 0; i < G_N_ELEMENTS (tags); i += 9)
+    {
+      gtk_text_buffer_get_start_iter (buffer, &iter);
+      g_assert (gtk_text_iter_forward_to_tag_toggle (&iter, tags[i]));
+      g_assert_cmpint (gtk_text_iter_get_offset (&iter), ==, 10 * i);
+      g_assert (gtk_text_iter_forward_to_tag_toggle (&iter, tags[i]));
+      g_assert_cmpint (gtk_text_iter_get_offset (&iter), ==, 10 * i + 200);
+      g_assert (!gtk_text_iter_forward_to_tag_toggle (&iter, tags[i]));
+
+      gtk_text_buffer_get_end_iter (buffer, &iter);
+      g_assert (gtk_text_iter_backward_to_tag_toggle (&iter, tags[i]));
+      g_assert_cmpint (gtk_text_iter_get_offset (&iter), ==, 10 * i + 200);
+    }
+
+  /* Take some of the tags off again */
+  for (i = 0; i < G_N_ELEMENTS (tags); i += 2)
+    {
+      gtk_text_buffer_get_bounds (buffer, &start, &end);
+      gtk_text_buffer_remove_tag (buffer, tags[i], &start, &end);
+      gtk_text_buffer_get_start_iter (buffer, &iter);
+      g_assert (!gtk_text_iter_forward_to_tag_toggle (&iter, tags[i]));
+    }
+
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, 505);
+  for (i = 0; i < G_N_ELEMENTS (tags); i++)
+    g_assert (gtk_text_iter_has_tag (&iter, tags[i]) ==
+              (i % 2 == 1 && 505 >= 10 * i && 505 < 10 * i + 200));
+
+  g_string_free (text, TRUE);
+  g_object_unref (buffer);
+}
+
 static void
 test_tag (void)
 {
@@ -1572,6 +2341,13 @@ main (int argc, char** argv)
   g_test_add_func ("/TextBuffer/Empty buffer", test_empty_buffer);
   g_test_add_func ("/TextBuffer/Get and Set", test_get_set);
   g_test_add_func ("/TextBuffer/Fill and Empty", test_fill_empty);
+  g_test_add_func ("/TextBuffer/Large insert", test_large_insert);
+  g_test_add_func ("/TextBuffer/Apply tag to matches", test_apply_tag_to_matches);
+  g_test_add_func ("/TextBuffer/Apply tags", test_apply_tags);
+  g_test_add_func ("/TextBuffer/Apply tags spans", test_apply_tags_spans);
+  g_test_add_func ("/TextBuffer/Apply tags edit", test_apply_tags_edit);
+  g_test_add_func ("/TextBuffer/Stream serialize", test_stream_serialize);
+  g_test_add_func ("/TextBuffer/Many tags", test_many_tags);
   g_test_add_func ("/TextBuffer/Tag", test_tag);
   g_test_add_func ("/TextBuffer/Clipboard", test_clipboard);
   g_test_add_func ("/TextBuffer/Get iter", test_get_iter);
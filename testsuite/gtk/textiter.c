@@ -267,6 +267,79 @@ test_search_caseless (void)
   check_found_backward ("This is some \303\200\n\303\200 text", "a\314\200\na\314\200", flags, 13, 16, "\303\200\n\303\200");
 }
 
+static void
+test_search_segments (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextTag *tag;
+  GdkPixbuf *pixbuf;
+  GtkTextIter i, s, e, limit;
+  gboolean res;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, "This is some foo text\nmore foo", -1);
+
+  /* A match spanning several segments */
+  tag = gtk_text_buffer_create_tag (buffer, NULL, NULL);
+  gtk_text_buffer_get_iter_at_offset (buffer, &s, 14);
+  gtk_text_buffer_get_iter_at_offset (buffer, &e, 15);
+  gtk_text_buffer_apply_tag (buffer, tag, &s, &e);
+
+  gtk_text_buffer_get_start_iter (buffer, &i);
+  res = gtk_text_iter_forward_search (&i, "foo", 0, &s, &e, NULL);
+  g_assert (res);
+  g_assert_cmpint (gtk_text_iter_get_offset (&s), ==, 13);
+  g_assert_cmpint (gtk_text_iter_get_offset (&e), ==, 16);
+
+  /* Starting in the middle of a line */
+  i = e;
+  res = gtk_text_iter_forward_search (&i, "foo", 0, &s, &e, NULL);
+  g_assert (res);
+  g_assert_cmpint (gtk_text_iter_get_offset (&s), ==, 27);
+  g_assert_cmpint (gtk_text_iter_get_offset (&e), ==, 30);
+
+  /* The match has to end before the limit */
+  gtk_text_buffer_get_start_iter (buffer, &i);
+  gtk_text_buffer_get_iter_at_offset (buffer, &limit, 15);
+  res = gtk_text_iter_forward_search (&i, "foo", 0, &s, &e, &limit);
+  g_assert (!res);
+
+  /* A match ending at the end of the line */
+  res = gtk_text_iter_forward_search (&i, "text", 0, &s, &e, NULL);
+  g_assert (res);
+  g_assert_cmpint (gtk_text_iter_get_offset (&s), ==, 17);
+  g_assert_cmpint (gtk_text_iter_get_offset (&e), ==, 21);
+
+  gtk_text_buffer_set_text (buffer, "a\rb", -1);
+  gtk_text_buffer_get_start_iter (buffer, &i);
+  res = gtk_text_iter_forward_search (&i, "a\r", 0, &s, &e, NULL);
+  g_assert (res);
+  g_assert_cmpint (gtk_text_iter_get_offset (&s), ==, 0);
+  g_assert_cmpint (gtk_text_iter_get_offset (&e), ==, 2);
+  g_assert_cmpint (gtk_text_iter_get_line (&e), ==, 1);
+
+  /* Pixbufs are in the slice, but not in the text */
+  gtk_text_buffer_set_text (buffer, "foobar", -1);
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, 1, 1);
+  gtk_text_buffer_get_iter_at_offset (buffer, &i, 3);
+  gtk_text_buffer_insert_pixbuf (buffer, &i, pixbuf);
+  g_object_unref (pixbuf);
+
+  gtk_text_buffer_get_start_iter (buffer, &i);
+  res = gtk_text_iter_forward_search (&i, "ob", 0, &s, &e, NULL);
+  g_assert (!res);
+  res = gtk_text_iter_forward_search (&i, "o\357\277\274b", 0, &s, &e, NULL);
+  g_assert (res);
+  g_assert_cmpint (gtk_text_iter_get_offset (&s), ==, 2);
+  g_assert_cmpint (gtk_text_iter_get_offset (&e), ==, 5);
+  res = gtk_text_iter_forward_search (&i, "ob", GTK_TEXT_SEARCH_TEXT_ONLY, &s, &e, NULL);
+  g_assert (res);
+  g_assert_cmpint (gtk_text_iter_get_offset (&s), ==, 2);
+  g_assert_cmpint (gtk_text_iter_get_offset (&e), ==, 5);
+
+  g_object_unref (buffer);
+}
+
 static void
 test_forward_to_tag_toggle (void)
 {
@@ -708,6 +781,7 @@ main (int argc, char** argv)
   g_test_add_func ("/TextIter/Search Full Buffer", test_search_full_buffer);
   g_test_add_func ("/TextIter/Search", test_search);
   g_test_add_func ("/TextIter/Search Caseless", test_search_caseless);
+  g_test_add_func ("/TextIter/Search Segments", test_search_segments);
   g_test_add_func ("/TextIter/Forward To Tag Toggle", test_forward_to_tag_toggle);
   g_test_add_func ("/TextIter/Word Boundaries", test_word_boundaries);
   g_test_add_func ("/TextIter/Visible Word Boundaries", test_visible_word_boundaries);